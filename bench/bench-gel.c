@@ -0,0 +1,171 @@
+/*
+ * bench/bench-gel.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bench.h"
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gel/gel.h>
+#include <gel/gel-io.h>
+
+// Files per directory in the synthetic tree
+#define FILES_PER_DIR 100
+
+/*
+ * gel_str_parser
+ */
+typedef struct {
+	gchar *artist, *album, *title;
+} Record;
+
+static gchar *
+record_parser_cb(gchar key, Record *r)
+{
+	switch (key)
+	{
+	case 'a':
+		return g_strdup(r->artist);
+	case 'b':
+		return g_strdup(r->album);
+	case 't':
+		return g_strdup(r->title);
+	default:
+		return NULL;
+	}
+}
+
+static void
+bench_str_parser(Bench *b, guint n)
+{
+	Record *records = g_new0(Record, n);
+	for (guint i = 0; i < n; i++)
+	{
+		// Leave some fields empty to exercise optional blocks
+		records[i].artist = (i % 3) ? g_strdup_printf("Artist %u", i % 97) : NULL;
+		records[i].album  = (i % 5) ? g_strdup_printf("Album %u",  i % 13) : NULL;
+		records[i].title  = g_strdup_printf("Track %u", i);
+	}
+
+	gchar *fmt = "{%a - }%t{ (%b)}";
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		bench_start(b);
+		for (guint i = 0; i < n; i++)
+			g_free(gel_str_parser(fmt, (GelStrParserFunc) record_parser_cb, &records[i]));
+		bench_stop(b, n);
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_free(records[i].artist);
+		g_free(records[i].album);
+		g_free(records[i].title);
+	}
+	g_free(records);
+}
+
+/*
+ * gel_io_scanner
+ */
+static gchar *
+tree_create(guint n)
+{
+	gchar *root = NULL;
+	gint fd = g_file_open_tmp("eina-bench-XXXXXX", &root, NULL);
+	if (fd < 0)
+		return NULL;
+	close(fd);
+	g_unlink(root);
+	g_mkdir(root, 0700);
+
+	for (guint i = 0; i < n; i++)
+	{
+		gchar *dir = g_strdup_printf("%s/dir-%u", root, i / FILES_PER_DIR);
+		if (i % FILES_PER_DIR == 0)
+			g_mkdir(dir, 0700);
+
+		gchar *file = g_strdup_printf("%s/track-%u.ogg", dir, i);
+		g_file_set_contents(file, "", 0, NULL);
+		g_free(file);
+		g_free(dir);
+	}
+	return root;
+}
+
+static void
+tree_remove(const gchar *path)
+{
+	GDir *dir = g_dir_open(path, 0, NULL);
+	if (dir)
+	{
+		const gchar *name;
+		while ((name = g_dir_read_name(dir)) != NULL)
+		{
+			gchar *child = g_build_filename(path, name, NULL);
+			tree_remove(child);
+			g_free(child);
+		}
+		g_dir_close(dir);
+		g_rmdir(path);
+	}
+	else
+		g_unlink(path);
+}
+
+static void
+scanner_finish_cb(GelIOScanner *scanner, GList *forest, GMainLoop *loop)
+{
+	g_main_loop_quit(loop);
+}
+
+static void
+bench_io_scanner(Bench *b, guint n)
+{
+	gchar *root = tree_create(n);
+	if (!root)
+		return;
+
+	gchar *uri = g_filename_to_uri(root, NULL, NULL);
+	GList *uris = g_list_prepend(NULL, uri);
+	GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		bench_start(b);
+		GelIOScanner *scanner = gel_io_scanner_new_full(uris, "standard::*", TRUE);
+		g_signal_connect(scanner, "finish", (GCallback) scanner_finish_cb, loop);
+		g_main_loop_run(loop);
+		bench_stop(b, n);
+
+		g_object_unref(scanner);
+	}
+
+	g_main_loop_unref(loop);
+	g_list_free(uris);
+	g_free(uri);
+
+	tree_remove(root);
+	g_free(root);
+}
+
+void
+bench_gel_register(void)
+{
+	bench_add("gel-str-parser/format", bench_str_parser);
+	bench_add("gel-io-scanner/scan",   bench_io_scanner);
+}
@@ -0,0 +1,227 @@
+/*
+ * bench/bench-lomo.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define LIBLOMO_USE_PRIVATE_API
+#include "bench.h"
+#include <gel/gel.h>
+#include <lomo/lomo-stream.h>
+#include <lomo/lomo-playlist.h>
+
+// Operations measured per round on a playlist of n streams
+#define N_EDITS   1000
+#define N_LOOKUPS 10000
+
+static GList*
+make_streams(guint n)
+{
+	GList *ret = NULL;
+	for (guint i = 0; i < n; i++)
+	{
+		gchar *uri = g_strdup_printf("file:///bench/artist-%u/album-%u/track-%u.ogg", i % 97, i % 13, i);
+		ret = g_list_prepend(ret, lomo_stream_new(uri));
+		g_free(uri);
+	}
+	return g_list_reverse(ret);
+}
+
+static LomoPlaylist*
+make_playlist(GList *streams)
+{
+	LomoPlaylist *pl = lomo_playlist_new();
+	lomo_playlist_insert_multi(pl, streams, -1);
+	return pl;
+}
+
+static void
+bench_playlist_insert(Bench *b, guint n)
+{
+	GList *base  = make_streams(n);
+	GList *extra = make_streams(N_EDITS);
+	GRand *rand  = bench_get_rand(b);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		LomoPlaylist *pl = make_playlist(base);
+
+		bench_start(b);
+		guint i = 0;
+		for (GList *l = extra; l; l = l->next, i++)
+			lomo_playlist_insert(pl, LOMO_STREAM(l->data), g_rand_int_range(rand, 0, n + i + 1));
+		bench_stop(b, N_EDITS);
+
+		g_object_unref(pl);
+	}
+
+	gel_list_deep_free(base,  g_object_unref);
+	gel_list_deep_free(extra, g_object_unref);
+}
+
+static void
+bench_playlist_remove(Bench *b, guint n)
+{
+	GList *base = make_streams(n);
+	GRand *rand = bench_get_rand(b);
+	guint  k    = MIN(N_EDITS, n / 2);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		LomoPlaylist *pl = make_playlist(base);
+
+		bench_start(b);
+		for (guint i = 0; i < k; i++)
+			lomo_playlist_remove(pl, g_rand_int_range(rand, 0, n - i));
+		bench_stop(b, k);
+
+		g_object_unref(pl);
+	}
+
+	gel_list_deep_free(base, g_object_unref);
+}
+
+static void
+bench_playlist_nth(Bench *b, guint n)
+{
+	GList *base = make_streams(n);
+	GRand *rand = bench_get_rand(b);
+	LomoPlaylist *pl = make_playlist(base);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		bench_start(b);
+		for (guint i = 0; i < N_LOOKUPS; i++)
+			lomo_playlist_get_nth_stream(pl, g_rand_int_range(rand, 0, n));
+		bench_stop(b, N_LOOKUPS);
+	}
+
+	g_object_unref(pl);
+	gel_list_deep_free(base, g_object_unref);
+}
+
+static void
+playlist_walk(Bench *b, guint n, gboolean random)
+{
+	GList *base = make_streams(n);
+	LomoPlaylist *pl = make_playlist(base);
+	lomo_playlist_set_repeat(pl, TRUE);
+	lomo_playlist_set_random(pl, random);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		lomo_playlist_set_current(pl, 0);
+
+		bench_start(b);
+		for (guint i = 0; i < N_LOOKUPS; i++)
+			lomo_playlist_go_next(pl);
+		bench_stop(b, N_LOOKUPS);
+	}
+
+	g_object_unref(pl);
+	gel_list_deep_free(base, g_object_unref);
+}
+
+static void
+bench_playlist_next(Bench *b, guint n)
+{
+	playlist_walk(b, n, FALSE);
+}
+
+static void
+bench_playlist_next_random(Bench *b, guint n)
+{
+	playlist_walk(b, n, TRUE);
+}
+
+static void
+bench_playlist_shuffle(Bench *b, guint n)
+{
+	GList *base = make_streams(n);
+	LomoPlaylist *pl = make_playlist(base);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		lomo_playlist_set_random(pl, FALSE);
+
+		bench_start(b);
+		lomo_playlist_set_random(pl, TRUE);
+		bench_stop(b, n);
+	}
+
+	g_object_unref(pl);
+	gel_list_deep_free(base, g_object_unref);
+}
+
+static void
+bench_stream_set_tag(Bench *b, guint n)
+{
+	GList *streams = make_streams(n);
+
+	GValue v = { 0 };
+	g_value_init(&v, G_TYPE_STRING);
+	g_value_set_static_string(&v, "Some title");
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		bench_start(b);
+		for (GList *l = streams; l; l = l->next)
+			lomo_stream_set_tag(LOMO_STREAM(l->data), LOMO_TAG_TITLE, &v);
+		bench_stop(b, n);
+	}
+
+	g_value_unset(&v);
+	gel_list_deep_free(streams, g_object_unref);
+}
+
+static void
+bench_stream_get_tag(Bench *b, guint n)
+{
+	GList *streams = make_streams(n);
+
+	GValue v = { 0 };
+	g_value_init(&v, G_TYPE_STRING);
+	g_value_set_static_string(&v, "Some title");
+	for (GList *l = streams; l; l = l->next)
+		lomo_stream_set_tag(LOMO_STREAM(l->data), LOMO_TAG_TITLE, &v);
+	g_value_unset(&v);
+
+	for (guint r = 0; r < bench_get_rounds(b); r++)
+	{
+		bench_start(b);
+		for (GList *l = streams; l; l = l->next)
+		{
+			lomo_stream_get_tag(LOMO_STREAM(l->data), LOMO_TAG_TITLE);
+			lomo_stream_get_tag(LOMO_STREAM(l->data), LOMO_TAG_ARTIST);
+		}
+		bench_stop(b, 2 * n);
+	}
+
+	gel_list_deep_free(streams, g_object_unref);
+}
+
+void
+bench_lomo_register(void)
+{
+	bench_add("lomo-playlist/insert",      bench_playlist_insert);
+	bench_add("lomo-playlist/remove",      bench_playlist_remove);
+	bench_add("lomo-playlist/nth",         bench_playlist_nth);
+	bench_add("lomo-playlist/next",        bench_playlist_next);
+	bench_add("lomo-playlist/next-random", bench_playlist_next_random);
+	bench_add("lomo-playlist/shuffle",     bench_playlist_shuffle);
+	bench_add("lomo-stream/set-tag",       bench_stream_set_tag);
+	bench_add("lomo-stream/get-tag",       bench_stream_get_tag);
+}
@@ -0,0 +1,225 @@
+/*
+ * bench/bench.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Microbenchmark runner. Every registered benchmark runs at each scale and
+ * results are written as JSON:
+ *
+ * {
+ *   "suite": "eina-bench",
+ *   "version": "0.13.0",
+ *   "rounds": 5,
+ *   "results": [
+ *     { "name": "lomo-playlist/nth", "n": 1000, "ops": 10000,
+ *       "min_ns": 10.1, "median_ns": 10.4, "mean_ns": 10.6 },
+ *     ...
+ *   ]
+ * }
+ *
+ * Times are nanoseconds per operation.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <lomo/lomo-util.h>
+#include "bench.h"
+
+#define DEFAULT_ROUNDS 5
+#define DEFAULT_SCALES "1000,10000,100000"
+
+typedef struct {
+	gchar    *name;
+	BenchFunc func;
+} BenchEntry;
+
+struct _Bench {
+	guint    rounds;
+	GRand   *rand;
+	GTimer  *timer;
+	GArray  *samples; // <gdouble> ns per op of each round
+	guint64  ops;
+};
+
+static GList *benchs = NULL; // <BenchEntry>
+
+void
+bench_add(const gchar *name, BenchFunc func)
+{
+	BenchEntry *e = g_new0(BenchEntry, 1);
+	e->name = g_strdup(name);
+	e->func = func;
+	benchs = g_list_append(benchs, e);
+}
+
+guint
+bench_get_rounds(Bench *b)
+{
+	return b->rounds;
+}
+
+GRand*
+bench_get_rand(Bench *b)
+{
+	return b->rand;
+}
+
+void
+bench_start(Bench *b)
+{
+	g_timer_start(b->timer);
+}
+
+void
+bench_stop(Bench *b, guint64 ops)
+{
+	g_timer_stop(b->timer);
+	gdouble ns = g_timer_elapsed(b->timer, NULL) * 1e9 / MAX(ops, 1);
+	g_array_append_val(b->samples, ns);
+	b->ops = ops;
+}
+
+static gint
+double_cmp(const gdouble *a, const gdouble *b)
+{
+	return (*a > *b) - (*a < *b);
+}
+
+static void
+json_string(FILE *fp, const gchar *str)
+{
+	fputc('"', fp);
+	for (const gchar *p = str; *p; p++)
+	{
+		if ((*p == '"') || (*p == '\\'))
+			fputc('\\', fp);
+		fputc(*p, fp);
+	}
+	fputc('"', fp);
+}
+
+gint
+main(gint argc, gchar *argv[])
+{
+	gchar   *filter = NULL;
+	gchar   *scales_str = NULL;
+	gchar   *output = NULL;
+	gint     rounds = DEFAULT_ROUNDS;
+	gboolean list = FALSE;
+
+	GOptionEntry entries[] = {
+		{ "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,     "Only run benchmarks containing STR", "STR" },
+		{ "scales", 's', 0, G_OPTION_ARG_STRING, &scales_str, "Comma separated scales (default: " DEFAULT_SCALES ")", "N,..." },
+		{ "rounds", 'r', 0, G_OPTION_ARG_INT,    &rounds,     "Rounds per benchmark and scale", "N" },
+		{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output,   "Write JSON to FILE instead of stdout", "FILE" },
+		{ "list",   'l', 0, G_OPTION_ARG_NONE,   &list,       "List benchmarks and exit", NULL },
+		{ NULL }
+	};
+
+	g_type_init();
+	lomo_init(&argc, &argv);
+
+	GError *error = NULL;
+	GOptionContext *ctx = g_option_context_new("- benchmark lomo and gel data structures");
+	g_option_context_add_main_entries(ctx, entries, NULL);
+	if (!g_option_context_parse(ctx, &argc, &argv, &error))
+	{
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(ctx);
+
+	if (rounds < 1)
+		rounds = 1;
+
+	bench_lomo_register();
+	bench_gel_register();
+
+	if (list)
+	{
+		for (GList *l = benchs; l; l = l->next)
+			g_print("%s\n", ((BenchEntry *) l->data)->name);
+		return EXIT_SUCCESS;
+	}
+
+	gchar **scales = g_strsplit(scales_str ? scales_str : DEFAULT_SCALES, ",", 0);
+
+	FILE *fp = stdout;
+	if (output && !(fp = fopen(output, "w")))
+	{
+		g_printerr("Unable to open '%s' for writing\n", output);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(fp, "{\n  \"suite\": \"eina-bench\",\n  \"version\": \"%s\",\n  \"rounds\": %d,\n  \"results\": [", PACKAGE_VERSION, rounds);
+
+	gboolean first = TRUE;
+	for (GList *l = benchs; l; l = l->next)
+	{
+		BenchEntry *e = (BenchEntry *) l->data;
+		if (filter && !strstr(e->name, filter))
+			continue;
+
+		for (guint i = 0; scales[i]; i++)
+		{
+			guint n = (guint) strtoul(scales[i], NULL, 10);
+			if (n == 0)
+				continue;
+
+			Bench b = { rounds, g_rand_new_with_seed(n), g_timer_new(), g_array_new(FALSE, FALSE, sizeof(gdouble)), 0 };
+
+			g_printerr("%-32s n=%-8u ", e->name, n);
+			e->func(&b, n);
+
+			if (b.samples->len)
+			{
+				g_array_sort(b.samples, (GCompareFunc) double_cmp);
+				gdouble mean = 0;
+				for (guint j = 0; j < b.samples->len; j++)
+					mean += g_array_index(b.samples, gdouble, j);
+				mean /= b.samples->len;
+				gdouble min    = g_array_index(b.samples, gdouble, 0);
+				gdouble median = g_array_index(b.samples, gdouble, b.samples->len / 2);
+
+				g_printerr("%12.1f ns/op\n", median);
+
+				fprintf(fp, "%s\n    { \"name\": ", first ? "" : ",");
+				json_string(fp, e->name);
+				fprintf(fp, ", \"n\": %u, \"ops\": %" G_GUINT64_FORMAT ", \"min_ns\": %.2f, \"median_ns\": %.2f, \"mean_ns\": %.2f }",
+					n, b.ops, min, median, mean);
+				first = FALSE;
+			}
+			else
+				g_printerr("skipped\n");
+
+			g_rand_free(b.rand);
+			g_timer_destroy(b.timer);
+			g_array_free(b.samples, TRUE);
+		}
+	}
+	fprintf(fp, "\n  ]\n}\n");
+
+	if (fp != stdout)
+		fclose(fp);
+	g_strfreev(scales);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,48 @@
+/*
+ * bench/bench.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _Bench Bench;
+
+/*
+ * A benchmark is called once per scale. It builds its fixture for @n
+ * elements and runs bench_get_rounds() rounds, wrapping only the measured
+ * code between bench_start() and bench_stop().
+ */
+typedef void (*BenchFunc) (Bench *b, guint n);
+
+void   bench_add(const gchar *name, BenchFunc func);
+
+guint  bench_get_rounds(Bench *b);
+GRand* bench_get_rand  (Bench *b);
+void   bench_start     (Bench *b);
+void   bench_stop      (Bench *b, guint64 ops);
+
+void bench_lomo_register(void);
+void bench_gel_register (void);
+
+G_END_DECLS
+
+#endif /* _BENCH_H */
@@ -0,0 +1,450 @@
+/*
+ * bench/import-bench.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * End to end import benchmark. Generates tagged audio files with
+ * audiotestsrc and an encoder, then for every file runs the same path a
+ * stream follows when added to Eina:
+ *
+ *   sid:   eina_adb_lomo_stream_attach_sid(), as the register insert hook
+ *   parse: LomoMetadataParser, from parse() to LomoMetadataParser::all-tags
+ *   store: adb_register_store_metadata(), as the register all-tags handler,
+ *          plus the eina_adb_flush() that executes the queued queries
+ *
+ * Files are generated in a child process so the encoding pipelines don't
+ * count towards the reported peak RSS.
+ * Nothing is played, so neither a display nor a sound card are needed.
+ * Results go to stderr in human form and as JSON to stdout or --output.
+ */
+
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <gel/gel.h>
+#include <lomo/lomo-util.h>
+#include <lomo/lomo-metadata-parser.h>
+#include <eina/adb/eina-adb.h>
+#include <eina/adb/register.h>
+
+#define DEFAULT_FILES   500
+#define DEFAULT_ENCODER "vorbisenc ! oggmux"
+#define DEFAULT_EXT     "ogg"
+
+enum {
+	STAGE_SID,
+	STAGE_PARSE,
+	STAGE_STORE,
+	N_STAGES
+};
+static const gchar *stage_names[N_STAGES] = { "sid", "parse", "store" };
+
+typedef struct {
+	LomoStream *stream;
+	gint64      dispatched;
+} Item;
+
+typedef struct {
+	EinaAdb   *adb;
+	GMainLoop *loop;
+	Item      *items;
+	guint      n_items;
+	guint      next, done, failed;
+	GArray    *latencies[N_STAGES]; // <gdouble> milliseconds
+} Run;
+
+/*
+ * Generator
+ */
+static gboolean
+generate_file(const gchar *path, const gchar *encoder, guint i, GError **error)
+{
+	gchar *desc = g_strdup_printf("audiotestsrc num-buffers=4 freq=%u ! audioconvert ! %s ! filesink name=sink",
+		220 + (i % 440), encoder);
+	GstElement *pipeline = gst_parse_launch(desc, error);
+	g_free(desc);
+	if (!pipeline)
+		return FALSE;
+
+	GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+	g_object_set(sink, "location", path, NULL);
+	gst_object_unref(sink);
+
+	GstElement *tagger = gst_bin_get_by_interface(GST_BIN(pipeline), GST_TYPE_TAG_SETTER);
+	if (tagger)
+	{
+		gchar *title  = g_strdup_printf("Track %u", i);
+		gchar *artist = g_strdup_printf("Artist %u", i % 97);
+		gchar *album  = g_strdup_printf("Album %u", i % 13);
+
+		GstTagList *tags = gst_tag_list_new();
+		gst_tag_list_add(tags, GST_TAG_MERGE_REPLACE,
+			GST_TAG_TITLE,  title,
+			GST_TAG_ARTIST, artist,
+			GST_TAG_ALBUM,  album,
+			GST_TAG_GENRE,  "Synthetic",
+			GST_TAG_TRACK_NUMBER, (guint) (i % 20) + 1,
+			NULL);
+		gst_tag_setter_merge_tags(GST_TAG_SETTER(tagger), tags, GST_TAG_MERGE_REPLACE);
+
+		gst_tag_list_free(tags);
+		g_free(title);
+		g_free(artist);
+		g_free(album);
+		gst_object_unref(tagger);
+	}
+
+	gst_element_set_state(pipeline, GST_STATE_PLAYING);
+	GstBus *bus = gst_element_get_bus(pipeline);
+	GstMessage *msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+
+	gboolean ret = TRUE;
+	if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR)
+	{
+		gst_message_parse_error(msg, error, NULL);
+		ret = FALSE;
+	}
+
+	gst_message_unref(msg);
+	gst_object_unref(bus);
+	gst_element_set_state(pipeline, GST_STATE_NULL);
+	gst_object_unref(pipeline);
+
+	return ret;
+}
+
+/*
+ * Runs generate_file() for every missing path in a forked child, the
+ * parent only waits for it.
+ */
+static gboolean
+generate_files(gchar **paths, const gchar *encoder, gboolean reuse)
+{
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		g_printerr("Unable to fork generator: %s\n", g_strerror(errno));
+		return FALSE;
+	}
+
+	if (pid == 0)
+	{
+		for (guint i = 0; paths[i] != NULL; i++)
+		{
+			if (reuse && g_file_test(paths[i], G_FILE_TEST_EXISTS))
+				continue;
+
+			GError *error = NULL;
+			if (!generate_file(paths[i], encoder, i, &error))
+			{
+				g_printerr("Unable to generate '%s': %s\n", paths[i], error ? error->message : "unknown error");
+				_exit(EXIT_FAILURE);
+			}
+		}
+		_exit(EXIT_SUCCESS);
+	}
+
+	gint status;
+	while (waitpid(pid, &status, 0) < 0)
+	{
+		if (errno != EINTR)
+			return FALSE;
+	}
+	return WIFEXITED(status) && (WEXITSTATUS(status) == EXIT_SUCCESS);
+}
+
+static void
+tree_remove(const gchar *path)
+{
+	GDir *dir = g_dir_open(path, 0, NULL);
+	if (dir)
+	{
+		const gchar *name;
+		while ((name = g_dir_read_name(dir)) != NULL)
+		{
+			gchar *child = g_build_filename(path, name, NULL);
+			tree_remove(child);
+			g_free(child);
+		}
+		g_dir_close(dir);
+		g_rmdir(path);
+	}
+	else
+		g_unlink(path);
+}
+
+/*
+ * Stages
+ */
+static inline gdouble
+elapsed_ms(gint64 since)
+{
+	return (g_get_monotonic_time() - since) / 1000.0;
+}
+
+static void
+run_dispatch(Run *run, LomoMetadataParser *parser)
+{
+	if (run->next >= run->n_items)
+		return;
+
+	Item *item = &run->items[run->next++];
+	item->dispatched = g_get_monotonic_time();
+	lomo_metadata_parser_parse(parser, item->stream, LOMO_METADATA_PARSER_PRIO_DEFAULT);
+}
+
+static void
+parser_all_tags_cb(LomoMetadataParser *parser, LomoStream *stream, Run *run)
+{
+	Item *item = g_object_get_data((GObject *) stream, "import-bench-item");
+	gdouble ms = elapsed_ms(item->dispatched);
+	g_array_append_val(run->latencies[STAGE_PARSE], ms);
+
+	if (lomo_stream_get_failed_flag(stream))
+		run->failed++;
+
+	gint64 t = g_get_monotonic_time();
+	adb_register_store_metadata(run->adb, stream);
+	ms = elapsed_ms(t);
+	g_array_append_val(run->latencies[STAGE_STORE], ms);
+
+	if (++run->done == run->n_items)
+		g_main_loop_quit(run->loop);
+	else
+		run_dispatch(run, parser);
+}
+
+/*
+ * Report
+ */
+static gint
+double_cmp(const gdouble *a, const gdouble *b)
+{
+	return (*a > *b) - (*a < *b);
+}
+
+static gdouble
+percentile(GArray *sorted, gdouble p)
+{
+	if (sorted->len == 0)
+		return 0;
+	guint i = (guint) (p * (sorted->len - 1) + 0.5);
+	return g_array_index(sorted, gdouble, i);
+}
+
+static glong
+peak_rss_kb(void)
+{
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return -1;
+	return usage.ru_maxrss;
+}
+
+gint
+main(gint argc, gchar *argv[])
+{
+	gint     n_files = DEFAULT_FILES;
+	gint     n_jobs  = 1;
+	gchar   *encoder = NULL;
+	gchar   *ext     = NULL;
+	gchar   *dir     = NULL;
+	gchar   *output  = NULL;
+	gboolean keep    = FALSE;
+
+	GOptionEntry entries[] = {
+		{ "files",   'n', 0, G_OPTION_ARG_INT,      &n_files, "Number of files to generate (default: 500)", "N" },
+		{ "jobs",    'j', 0, G_OPTION_ARG_INT,      &n_jobs,  "Parsers working in parallel (default: 1)", "N" },
+		{ "encoder", 'e', 0, G_OPTION_ARG_STRING,   &encoder, "Encoder pipeline (default: '" DEFAULT_ENCODER "')", "PIPELINE" },
+		{ "ext",     'x', 0, G_OPTION_ARG_STRING,   &ext,     "Extension for generated files (default: " DEFAULT_EXT ")", "EXT" },
+		{ "dir",     'd', 0, G_OPTION_ARG_FILENAME, &dir,     "Reuse files generated in DIR with --keep", "DIR" },
+		{ "keep",    'k', 0, G_OPTION_ARG_NONE,     &keep,    "Don't remove generated files", NULL },
+		{ "output",  'o', 0, G_OPTION_ARG_FILENAME, &output,  "Write JSON to FILE instead of stdout", "FILE" },
+		{ NULL }
+	};
+
+	g_type_init();
+	lomo_init(&argc, &argv);
+
+	GError *error = NULL;
+	GOptionContext *ctx = g_option_context_new("- benchmark metadata parsing and adb ingestion");
+	g_option_context_add_main_entries(ctx, entries, NULL);
+	if (!g_option_context_parse(ctx, &argc, &argv, &error))
+	{
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		return EXIT_FAILURE;
+	}
+	g_option_context_free(ctx);
+
+	n_files = MAX(n_files, 1);
+	n_jobs  = MAX(n_jobs,  1);
+
+	// Files
+	gboolean reuse = (dir != NULL);
+	if (!reuse)
+	{
+		gint fd = g_file_open_tmp("eina-import-bench-XXXXXX", &dir, &error);
+		if (fd < 0)
+		{
+			g_printerr("%s\n", error->message);
+			return EXIT_FAILURE;
+		}
+		close(fd);
+		g_unlink(dir);
+		g_mkdir(dir, 0700);
+	}
+
+	gint64 t = g_get_monotonic_time();
+	gchar **paths = g_new0(gchar *, n_files + 1);
+	for (gint i = 0; i < n_files; i++)
+	{
+		gchar *name = g_strdup_printf("track-%06d.%s", i, ext ? ext : DEFAULT_EXT);
+		paths[i] = g_build_filename(dir, name, NULL);
+		g_free(name);
+	}
+	if (!generate_files(paths, encoder ? encoder : DEFAULT_ENCODER, reuse))
+		return EXIT_FAILURE;
+	gdouble generate_s = (g_get_monotonic_time() - t) / 1e6;
+	g_printerr("Generated %d files in %.2fs at %s\n", n_files, generate_s, dir);
+
+	// Database
+	gchar *db_path = g_build_filename(dir, "adb.db", NULL);
+	g_unlink(db_path);
+
+	Run run = { 0 };
+	run.adb = eina_adb_new();
+	if (!eina_adb_set_db_filename(run.adb, db_path) || !adb_register_upgrade_schema(run.adb, &error))
+	{
+		g_printerr("Unable to setup database '%s': %s\n", db_path, error ? error->message : "unknown error");
+		return EXIT_FAILURE;
+	}
+	for (guint s = 0; s < N_STAGES; s++)
+		run.latencies[s] = g_array_sized_new(FALSE, FALSE, sizeof(gdouble), n_files);
+
+	gint64 start = g_get_monotonic_time();
+
+	// Stage: sid
+	run.n_items = n_files;
+	run.items = g_new0(Item, n_files);
+	for (gint i = 0; i < n_files; i++)
+	{
+		gchar *uri = g_filename_to_uri(paths[i], NULL, NULL);
+		run.items[i].stream = lomo_stream_new(uri);
+		g_object_set_data((GObject *) run.items[i].stream, "import-bench-item", &run.items[i]);
+		g_free(uri);
+
+		t = g_get_monotonic_time();
+		eina_adb_lomo_stream_attach_sid(run.adb, run.items[i].stream);
+		gdouble ms = elapsed_ms(t);
+		g_array_append_val(run.latencies[STAGE_SID], ms);
+	}
+
+	// Stages: parse and store
+	run.loop = g_main_loop_new(NULL, FALSE);
+	LomoMetadataParser **parsers = g_new0(LomoMetadataParser *, n_jobs);
+	for (gint j = 0; j < n_jobs; j++)
+	{
+		parsers[j] = lomo_metadata_parser_new();
+		lomo_metadata_parser_set_coalesce(parsers[j], LOMO_METADATA_PARSER_COALESCE_STREAM);
+		g_signal_connect(parsers[j], "all-tags", (GCallback) parser_all_tags_cb, &run);
+		run_dispatch(&run, parsers[j]);
+	}
+	g_main_loop_run(run.loop);
+
+	// Stage: store, flush of the queued queries
+	t = g_get_monotonic_time();
+	eina_adb_flush(run.adb);
+	gdouble flush_s = (g_get_monotonic_time() - t) / 1e6;
+
+	gdouble total_s = (g_get_monotonic_time() - start) / 1e6;
+	glong rss = peak_rss_kb();
+
+	// Report
+	FILE *fp = stdout;
+	if (output && !(fp = fopen(output, "w")))
+	{
+		g_printerr("Unable to open '%s' for writing\n", output);
+		return EXIT_FAILURE;
+	}
+
+	g_printerr("%d files (%u failed) in %.2fs: %.1f files/s, peak RSS %ld KiB\n",
+		n_files, run.failed, total_s, n_files / total_s, rss);
+	fprintf(fp, "{\n  \"suite\": \"eina-import-bench\",\n  \"version\": \"%s\",\n", PACKAGE_VERSION);
+	fprintf(fp, "  \"files\": %d,\n  \"jobs\": %d,\n  \"failed\": %u,\n", n_files, n_jobs, run.failed);
+	fprintf(fp, "  \"generate_s\": %.3f,\n  \"total_s\": %.3f,\n  \"files_per_sec\": %.2f,\n  \"peak_rss_kb\": %ld,\n",
+		generate_s, total_s, n_files / total_s, rss);
+	fprintf(fp, "  \"stages\": {\n");
+	for (guint s = 0; s < N_STAGES; s++)
+	{
+		GArray *l = run.latencies[s];
+		g_array_sort(l, (GCompareFunc) double_cmp);
+		gdouble sum = 0;
+		for (guint i = 0; i < l->len; i++)
+			sum += g_array_index(l, gdouble, i);
+
+		// Per item latencies of store only cover queueing, its total adds the flush
+		gdouble total = sum / 1000;
+		if (s == STAGE_STORE)
+			total += flush_s;
+
+		g_printerr("  %-6s p50 %8.3fms  p90 %8.3fms  p99 %8.3fms  max %8.3fms  total %.3fs\n", stage_names[s],
+			percentile(l, 0.5), percentile(l, 0.9), percentile(l, 0.99), percentile(l, 1.0), total);
+		fprintf(fp, "    \"%s\": { \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f, ",
+			stage_names[s], percentile(l, 0.5), percentile(l, 0.9), percentile(l, 0.99), percentile(l, 1.0));
+		if (s == STAGE_STORE)
+			fprintf(fp, "\"flush_s\": %.3f, ", flush_s);
+		fprintf(fp, "\"total_s\": %.3f }%s\n", total, (s + 1 < N_STAGES) ? "," : "");
+	}
+	g_printerr("  (store total includes a %.3fs flush)\n", flush_s);
+	fprintf(fp, "  }\n}\n");
+
+	if (fp != stdout)
+		fclose(fp);
+
+	// Cleanup
+	for (gint j = 0; j < n_jobs; j++)
+	{
+		lomo_metadata_parser_clear(parsers[j]);
+		g_object_unref(parsers[j]);
+	}
+	g_free(parsers);
+	for (gint i = 0; i < n_files; i++)
+		g_object_unref(run.items[i].stream);
+	g_free(run.items);
+	for (guint s = 0; s < N_STAGES; s++)
+		g_array_free(run.latencies[s], TRUE);
+	g_main_loop_unref(run.loop);
+	g_object_unref(run.adb);
+
+	if (keep || reuse)
+		g_unlink(db_path);
+	else
+		tree_remove(dir);
+	g_free(db_path);
+	g_strfreev(paths);
+	g_free(dir);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,809 @@
+/*
+ * eina/adb/eina-adb-importer.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:eina-adb-importer
+ * @short_description: Bulk import of music into #EinaAdb
+ * @see_also: #EinaAdb, #LomoMetadataParser
+ *
+ * #EinaAdbImporter walks directories with #GelIOScanner and parses every
+ * supported file, storing its tags into the 'metadata' table.
+ *
+ * Files are spread across several #LomoMetadataParser, one per CPU by
+ * default, each of them with a single stream in flight so GStreamer
+ * pipelines run in parallel. Results are written in batches, one transaction
+ * per batch. Files whose modification time and size match the values stored
+ * on the previous import are skipped without parsing.
+ *
+ * eina_adb_importer_rescan() does the same over the library roots and also
+ * removes, in one transaction, the streams below them whose files are gone.
+ * When nothing changed a rescan is only a directory walk plus one query.
+ */
+
+#define LIBLOMO_USE_PRIVATE_API
+#include "eina-adb-importer.h"
+#include "eina-adb-lomo.h"
+#include <unistd.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#include <gel/gel.h>
+#include <gel/gel-io.h>
+#include <lomo/lomo-metadata-parser.h>
+#include <eina/core/eina-file-utils.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaAdbImporter"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// Parsed streams per transaction
+#define BATCH_SIZE 256
+
+// Upper limit for the default number of parsers
+#define MAX_DEFAULT_WORKERS 8
+
+// Only what the scanner and the mtime/size check need, 'standard::*' would
+// guess content types
+#define SCAN_ATTRIBUTES "standard::type,standard::name,standard::size,time::modified"
+
+// Missing streams removed per statement
+#define PRUNE_CHUNK 512
+
+G_DEFINE_TYPE (EinaAdbImporter, eina_adb_importer, G_TYPE_OBJECT)
+
+typedef struct {
+	gchar  *uri;
+	guint64 mtime;
+	gint64  size;
+} Candidate;
+
+/*
+ * Streams already in the database, read at once. URIs live in the result,
+ * or in canon if their canonical form differs. The index maps them to
+ * row + 1.
+ */
+typedef struct {
+	EinaAdbResult  *res;
+	const gchar   **uris;
+	GStringChunk   *canon;
+	const gint64   *mtimes, *sizes, *sids;
+	guint           n;
+	guint8         *seen;
+	GHashTable     *index;
+} Known;
+
+struct _EinaAdbImporterPrivate {
+	EinaAdb      *adb;
+	guint         n_workers;
+
+	gboolean      running;
+	GelIOScanner *scanner;
+	GPtrArray    *parsers;   // <LomoMetadataParser>
+	GQueue       *pending;   // <Candidate>
+	GPtrArray    *batch;     // <LomoStream>
+	GTimer       *timer;
+
+	// Rescan
+	gboolean      prune;
+	gchar       **roots;
+	GList        *scan_errors; // <gchar*> URIs that couldn't be read
+
+	guint total, done, in_flight;
+	guint imported, skipped, removed;
+};
+
+enum {
+	PROGRESS,
+	FINISHED,
+	SCANNED,
+	LAST_SIGNAL
+};
+static guint importer_signals[LAST_SIGNAL] = { 0 };
+
+static void
+importer_release_parsers(EinaAdbImporter *self);
+static void
+importer_finish(EinaAdbImporter *self);
+
+static void
+candidate_free(Candidate *c)
+{
+	g_free(c->uri);
+	g_slice_free(Candidate, c);
+}
+
+static void
+eina_adb_importer_dispose (GObject *object)
+{
+	EinaAdbImporter *self = EINA_ADB_IMPORTER(object);
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	if (priv->running)
+		eina_adb_importer_cancel(self);
+	importer_release_parsers(self);
+
+	gel_free_and_invalidate(priv->parsers, NULL, g_ptr_array_unref);
+	gel_free_and_invalidate(priv->batch,   NULL, g_ptr_array_unref);
+	gel_free_and_invalidate(priv->timer,   NULL, g_timer_destroy);
+	gel_free_and_invalidate(priv->roots,   NULL, g_strfreev);
+	if (priv->scan_errors)
+	{
+		gel_list_deep_free(priv->scan_errors, g_free);
+		priv->scan_errors = NULL;
+	}
+	if (priv->pending)
+	{
+		g_queue_foreach(priv->pending, (GFunc) candidate_free, NULL);
+		g_queue_free(priv->pending);
+		priv->pending = NULL;
+	}
+	gel_free_and_invalidate(priv->adb, NULL, g_object_unref);
+
+	G_OBJECT_CLASS (eina_adb_importer_parent_class)->dispose (object);
+}
+
+static void
+eina_adb_importer_class_init (EinaAdbImporterClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (EinaAdbImporterPrivate));
+
+	object_class->dispose = eina_adb_importer_dispose;
+
+	/**
+	 * EinaAdbImporter::progress:
+	 * @importer: The #EinaAdbImporter
+	 * @done: Files parsed so far
+	 * @total: Files to parse
+	 * @files_per_sec: Throughput since the import started
+	 *
+	 * Emitted after each batch is written
+	 */
+	importer_signals[PROGRESS] = g_signal_new("progress",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbImporterClass, progress),
+		NULL, NULL,
+		gel_marshal_VOID__UINT_UINT_DOUBLE,
+		G_TYPE_NONE,
+		3,
+		G_TYPE_UINT, G_TYPE_UINT, G_TYPE_DOUBLE);
+
+	/**
+	 * EinaAdbImporter::finished:
+	 * @importer: The #EinaAdbImporter
+	 * @imported: Files written to the database
+	 * @skipped: Files skipped because they didn't change
+	 *
+	 * Emitted when import finishes or is cancelled
+	 */
+	importer_signals[FINISHED] = g_signal_new("finished",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbImporterClass, finished),
+		NULL, NULL,
+		gel_marshal_VOID__UINT_UINT,
+		G_TYPE_NONE,
+		2,
+		G_TYPE_UINT, G_TYPE_UINT);
+
+	/**
+	 * EinaAdbImporter::scanned:
+	 * @importer: The #EinaAdbImporter
+	 * @forest: (element-type GNode) (transfer none): Result of the walk, see
+	 *          #GelIOScanner::finish
+	 *
+	 * Emitted once the files to import have been walked, before parsing
+	 * them. Lets others reuse the walk instead of doing their own.
+	 */
+	importer_signals[SCANNED] = g_signal_new("scanned",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbImporterClass, scanned),
+		NULL, NULL,
+		g_cclosure_marshal_VOID__POINTER,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_POINTER);
+}
+
+static void
+eina_adb_importer_init (EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_ADB_IMPORTER, EinaAdbImporterPrivate));
+
+	glong n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	priv->n_workers = CLAMP(n_cpus, 1, MAX_DEFAULT_WORKERS);
+
+	priv->parsers = g_ptr_array_new_with_free_func(g_object_unref);
+	priv->batch   = g_ptr_array_new_with_free_func(g_object_unref);
+	priv->pending = g_queue_new();
+	priv->timer   = g_timer_new();
+}
+
+/**
+ * eina_adb_importer_new:
+ * @adb: An #EinaAdb
+ *
+ * Creates a new #EinaAdbImporter writing into @adb
+ *
+ * Returns: (transfer full): The #EinaAdbImporter
+ */
+EinaAdbImporter*
+eina_adb_importer_new (EinaAdb *adb)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+
+	EinaAdbImporter *self = g_object_new (EINA_TYPE_ADB_IMPORTER, NULL);
+	self->priv->adb = g_object_ref(adb);
+	return self;
+}
+
+/**
+ * eina_adb_importer_get_n_workers:
+ * @self: An #EinaAdbImporter
+ *
+ * Gets the number of parsers working in parallel
+ *
+ * Returns: Number of workers
+ */
+guint
+eina_adb_importer_get_n_workers(EinaAdbImporter *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_IMPORTER(self), 0);
+	return self->priv->n_workers;
+}
+
+/**
+ * eina_adb_importer_set_n_workers:
+ * @self: An #EinaAdbImporter
+ * @n_workers: Number of parsers, defaults to the number of CPUs
+ *
+ * Sets the number of parsers used by the next import
+ */
+void
+eina_adb_importer_set_n_workers(EinaAdbImporter *self, guint n_workers)
+{
+	g_return_if_fail(EINA_IS_ADB_IMPORTER(self));
+	g_return_if_fail(n_workers > 0);
+	self->priv->n_workers = n_workers;
+}
+
+/**
+ * eina_adb_importer_is_running:
+ * @self: An #EinaAdbImporter
+ *
+ * Checks if an import is in progress
+ *
+ * Returns: %TRUE if running
+ */
+gboolean
+eina_adb_importer_is_running(EinaAdbImporter *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_IMPORTER(self), FALSE);
+	return self->priv->running;
+}
+
+/*
+ * Writer
+ */
+static void
+importer_write_stream(EinaAdbImporter *self, LomoStream *stream)
+{
+	EinaAdb *adb = self->priv->adb;
+
+	// Files without tags (only 'uri' is found) are stored too, otherwise they
+	// would be parsed again by every import and rescan
+	gint sid = eina_adb_lomo_stream_attach_sid(adb, stream);
+	if (sid < 0)
+		return;
+
+	// Re-imported files may have lost tags
+	eina_adb_query_exec(adb, "DELETE FROM metadata WHERE sid=%d;", sid);
+
+	GList *tags = lomo_stream_get_tags(stream);
+	for (GList *l = tags; l; l = l->next)
+	{
+		const gchar *tag = (const gchar *) l->data;
+		if (g_str_equal(tag, LOMO_TAG_URI))
+			continue;
+
+		switch (G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(lomo_stream_get_tag(stream, tag))))
+		{
+		case G_TYPE_STRING:
+		case G_TYPE_INT:
+		case G_TYPE_UINT:
+		case G_TYPE_BOOLEAN:
+			break;
+		default:
+			continue;
+		}
+
+		gchar *value = lomo_stream_strdup_tag_value(stream, tag);
+		eina_adb_query_exec(adb, "INSERT OR REPLACE INTO metadata (sid,key,value) VALUES(%d,'%q','%q');",
+			sid, tag, value);
+		g_free(value);
+	}
+	gel_list_deep_free(tags, g_free);
+
+	Candidate *c = g_object_get_data((GObject *) stream, "eina-adb-importer-candidate");
+	eina_adb_query_exec(adb, "UPDATE streams SET mtime=%lld, size=%lld WHERE sid=%d;",
+		(sqlite3_int64) c->mtime, (sqlite3_int64) c->size, sid);
+
+	self->priv->imported++;
+}
+
+static void
+importer_flush(EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+	if (priv->batch->len == 0)
+		return;
+
+	// One transaction per batch, SID creation included
+	eina_adb_query_exec(priv->adb, "BEGIN TRANSACTION;");
+	for (guint i = 0; i < priv->batch->len; i++)
+		importer_write_stream(self, LOMO_STREAM(g_ptr_array_index(priv->batch, i)));
+	eina_adb_query_exec(priv->adb, "END TRANSACTION;");
+
+	g_ptr_array_set_size(priv->batch, 0);
+
+	gdouble elapsed = g_timer_elapsed(priv->timer, NULL);
+	gdouble rate = (elapsed > 0) ? priv->done / elapsed : 0;
+	debug("%u/%u files, %.1f files/s", priv->done, priv->total, rate);
+	g_signal_emit(self, importer_signals[PROGRESS], 0, priv->done, priv->total, rate);
+}
+
+/*
+ * Workers
+ */
+static gboolean
+importer_dispatch(EinaAdbImporter *self, LomoMetadataParser *parser)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	Candidate *c = g_queue_pop_head(priv->pending);
+	if (!c)
+		return FALSE;
+
+	LomoStream *stream = lomo_stream_new(c->uri);
+	g_object_set_data_full((GObject *) stream, "eina-adb-importer-candidate", c, (GDestroyNotify) candidate_free);
+	lomo_metadata_parser_parse(parser, stream, LOMO_METADATA_PARSER_PRIO_DEFAULT);
+	g_object_unref(stream);
+
+	priv->in_flight++;
+	return TRUE;
+}
+
+static void
+importer_all_tags_cb(LomoMetadataParser *parser, LomoStream *stream, EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	priv->in_flight--;
+	priv->done++;
+
+	g_ptr_array_add(priv->batch, g_object_ref(stream));
+	if (priv->batch->len >= BATCH_SIZE)
+		importer_flush(self);
+
+	// Cancelled from a "progress" handler, already finished
+	if (!priv->running)
+		return;
+
+	if (!importer_dispatch(self, parser) && (priv->in_flight == 0))
+		importer_finish(self);
+}
+
+static void
+importer_disconnect_parsers(EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	for (guint i = 0; i < priv->parsers->len; i++)
+		g_signal_handlers_disconnect_by_func(g_ptr_array_index(priv->parsers, i), importer_all_tags_cb, self);
+}
+
+static void
+importer_release_parsers(EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	importer_disconnect_parsers(self);
+	for (guint i = 0; i < priv->parsers->len; i++)
+		lomo_metadata_parser_clear(g_ptr_array_index(priv->parsers, i));
+	g_ptr_array_set_size(priv->parsers, 0);
+}
+
+static gboolean
+importer_release_parsers_idle(EinaAdbImporter *self)
+{
+	// Parsers can't be destroyed from their own signal handlers
+	if (!self->priv->running)
+		importer_release_parsers(self);
+	g_object_unref(self);
+	return FALSE;
+}
+
+static void
+importer_finish(EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	importer_flush(self);
+	priv->running = FALSE;
+	g_timer_stop(priv->timer);
+
+	if (priv->parsers->len)
+		g_idle_add((GSourceFunc) importer_release_parsers_idle, g_object_ref(self));
+
+	debug("Finished: %u imported, %u skipped in %.2fs", priv->imported, priv->skipped, g_timer_elapsed(priv->timer, NULL));
+	g_signal_emit(self, importer_signals[FINISHED], 0, priv->imported, priv->skipped);
+}
+
+/*
+ * Scanner
+ */
+static void
+known_free(Known *known)
+{
+	g_object_unref(known->res);
+	g_hash_table_destroy(known->index);
+	g_string_chunk_free(known->canon);
+	g_free(known->uris);
+	g_free(known->seen);
+	g_free(known);
+}
+
+static Known *
+known_load(EinaAdbImporter *self)
+{
+	EinaAdbResult *res = eina_adb_query_raw(self->priv->adb, "SELECT uri,mtime,size,sid FROM streams;");
+	if (!res)
+		return NULL;
+
+	// Single chunk, no per row allocations
+	Known *known = g_new0(Known, 1);
+	known->res    = res;
+	known->n      = MAX(eina_adb_result_fetch(res, G_MAXUINT), 0);
+	known->mtimes = eina_adb_result_get_int64_column (res, 1, NULL);
+	known->sizes  = eina_adb_result_get_int64_column (res, 2, NULL);
+	known->sids   = eina_adb_result_get_int64_column (res, 3, NULL);
+	known->uris   = g_new0(const gchar *, known->n);
+	known->canon  = g_string_chunk_new(4096);
+	known->seen   = g_new0(guint8, known->n);
+	known->index  = g_hash_table_new(g_str_hash, g_str_equal);
+
+	// Scanned URIs are canonical, streams added by other means (playlists,
+	// command line) may not be
+	const gchar* const *uris = eina_adb_result_get_string_column(res, 0, NULL);
+	for (guint i = 0; i < known->n; i++)
+	{
+		if (uris[i] == NULL)
+			continue;
+
+		GFile *f = g_file_new_for_uri(uris[i]);
+		gchar *canon = g_file_get_uri(f);
+		g_object_unref(f);
+
+		known->uris[i] = g_str_equal(canon, uris[i]) ? uris[i] : g_string_chunk_insert(known->canon, canon);
+		g_free(canon);
+
+		g_hash_table_insert(known->index, (gpointer) known->uris[i], GUINT_TO_POINTER(i + 1));
+	}
+
+	return known;
+}
+
+static gint
+known_lookup(Known *known, const gchar *uri)
+{
+	return known ? (gint) GPOINTER_TO_UINT(g_hash_table_lookup(known->index, uri)) - 1 : -1;
+}
+
+static gboolean
+uri_is_below(const gchar *uri, const gchar *dir)
+{
+	gsize len = strlen(dir);
+	return (strncmp(uri, dir, len) == 0) && ((uri[len] == '\0') || (uri[len] == '/'));
+}
+
+/*
+ * Removes streams below the roots not seen by the scanner. Files below
+ * unreadable directories or empty roots (ex. unmounted disks) are kept.
+ */
+static void
+importer_prune(EinaAdbImporter *self, Known *known)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	GArray *missing = g_array_new(FALSE, FALSE, sizeof(gint64));
+	for (guint i = 0; i < known->n; i++)
+	{
+		const gchar *uri = known->uris[i];
+		if (known->seen[i] || !uri)
+			continue;
+
+		gboolean below_root = FALSE;
+		for (guint j = 0; !below_root && priv->roots[j]; j++)
+			below_root = uri_is_below(uri, priv->roots[j]);
+		if (!below_root)
+			continue;
+
+		gboolean unreadable = FALSE;
+		for (GList *l = priv->scan_errors; !unreadable && l; l = l->next)
+			unreadable = uri_is_below(uri, (const gchar *) l->data);
+		if (unreadable)
+			continue;
+
+		g_array_append_val(missing, known->sids[i]);
+	}
+
+	if (missing->len == 0)
+	{
+		g_array_free(missing, TRUE);
+		return;
+	}
+
+	EinaAdb *adb = priv->adb;
+	guint removed = 0;
+	gboolean ok = eina_adb_query_exec(adb, "BEGIN TRANSACTION;");
+	for (guint i = 0; ok && (i < missing->len); i += PRUNE_CHUNK)
+	{
+		GString *cond = g_string_new("sid IN (");
+		for (guint j = i; j < MIN(i + PRUNE_CHUNK, missing->len); j++)
+			g_string_append_printf(cond, "%s%" G_GINT64_FORMAT, (j > i) ? "," : "", g_array_index(missing, gint64, j));
+		g_string_append_c(cond, ')');
+
+		ok = eina_adb_remove_streams(adb, cond->str, &removed);
+		g_string_free(cond, TRUE);
+	}
+
+	if (ok && eina_adb_query_exec(adb, "END TRANSACTION;"))
+		priv->removed = removed;
+	else
+	{
+		g_warning(N_("Unable to remove %u missing files from the database"), missing->len);
+		eina_adb_query_exec(adb, "ROLLBACK;");
+	}
+	debug("%u missing files removed", priv->removed);
+
+	g_array_free(missing, TRUE);
+}
+
+static gboolean
+importer_unref_scanner_idle(GelIOScanner *scanner)
+{
+	g_object_unref(scanner);
+	return FALSE;
+}
+
+static void
+importer_scanner_finish_cb(GelIOScanner *scanner, GList *forest, EinaAdbImporter *self)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	g_signal_emit(self, importer_signals[SCANNED], 0, forest);
+
+	// Roots with nothing below are likely unmounted disks or their empty
+	// mount points, don't take their files as deleted
+	for (GList *l = forest; priv->prune && l; l = l->next)
+	{
+		GNode *root = (GNode *) l->data;
+		if (g_node_first_child(root))
+			continue;
+
+		gchar *uri = g_file_get_uri(G_FILE(root->data));
+		debug("Root '%s' is empty, its streams are kept", uri);
+		priv->scan_errors = g_list_prepend(priv->scan_errors, uri);
+	}
+
+	Known *known = known_load(self);
+	GList *flatten = gel_io_scanner_flatten_result(forest);
+	for (GList *l = flatten; l; l = l->next)
+	{
+		GFile     *file = G_FILE(l->data);
+		GFileInfo *info = g_object_get_data((GObject *) file, "g-file-info");
+		if (!info || (g_file_info_get_file_type(info) != G_FILE_TYPE_REGULAR))
+			continue;
+
+		gchar *uri = g_file_get_uri(file);
+		gint row = known_lookup(known, uri);
+		if (row >= 0)
+			known->seen[row] = TRUE;
+
+		if (!eina_file_utils_is_supported_extension(uri))
+		{
+			g_free(uri);
+			continue;
+		}
+
+		Candidate *c = g_slice_new0(Candidate);
+		c->uri   = uri;
+		c->mtime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+		c->size  = g_file_info_get_size(info);
+
+		if ((row >= 0) && ((guint64) known->mtimes[row] == c->mtime) && (known->sizes[row] == c->size))
+		{
+			priv->skipped++;
+			candidate_free(c);
+			continue;
+		}
+		g_queue_push_tail(priv->pending, c);
+	}
+	g_list_free(flatten);
+
+	if (priv->prune && known)
+		importer_prune(self, known);
+	gel_free_and_invalidate(known, NULL, known_free);
+
+	// Scanner owns the forest, drop it once out of its signal
+	priv->scanner = NULL;
+	g_idle_add((GSourceFunc) importer_unref_scanner_idle, scanner);
+
+	priv->total = g_queue_get_length(priv->pending);
+	debug("%u files to parse, %u unchanged", priv->total, priv->skipped);
+	if (priv->total == 0)
+	{
+		importer_finish(self);
+		return;
+	}
+
+	importer_release_parsers(self);
+	for (guint i = 0; i < MIN(priv->n_workers, priv->total); i++)
+	{
+		LomoMetadataParser *parser = lomo_metadata_parser_new();
+		lomo_metadata_parser_set_coalesce(parser, LOMO_METADATA_PARSER_COALESCE_STREAM);
+		g_signal_connect(parser, "all-tags", (GCallback) importer_all_tags_cb, self);
+		g_ptr_array_add(priv->parsers, parser);
+		importer_dispatch(self, parser);
+	}
+}
+
+static void
+importer_scanner_error_cb(GelIOScanner *scanner, GFile *source, GError *error, EinaAdbImporter *self)
+{
+	gchar *uri = g_file_get_uri(source);
+	g_warning(_("'%s' throw an error: %s"), uri, error->message);
+
+	// Don't take files below it as deleted
+	self->priv->scan_errors = g_list_prepend(self->priv->scan_errors, uri);
+}
+
+static void
+importer_start(EinaAdbImporter *self, const gchar *const *uris, gboolean prune)
+{
+	EinaAdbImporterPrivate *priv = self->priv;
+
+	priv->running  = TRUE;
+	priv->prune    = prune;
+	priv->total    = priv->done    = priv->in_flight = 0;
+	priv->imported = priv->skipped = priv->removed   = 0;
+	gel_list_deep_free(priv->scan_errors, g_free);
+	priv->scan_errors = NULL;
+	g_timer_start(priv->timer);
+
+	// Roots are compared against URIs in the database, use the canonical form
+	gel_free_and_invalidate(priv->roots, NULL, g_strfreev);
+	priv->roots = g_new0(gchar *, g_strv_length((gchar **) uris) + 1);
+	GList *uri_list = NULL;
+	for (guint i = 0; uris[i]; i++)
+	{
+		GFile *f = g_file_new_for_uri(uris[i]);
+		priv->roots[i] = g_file_get_uri(f);
+		g_object_unref(f);
+		uri_list = g_list_prepend(uri_list, priv->roots[i]);
+	}
+	uri_list = g_list_reverse(uri_list);
+
+	priv->scanner = gel_io_scanner_new_full(uri_list, SCAN_ATTRIBUTES, TRUE);
+	g_signal_connect(priv->scanner, "finish", (GCallback) importer_scanner_finish_cb, self);
+	g_signal_connect(priv->scanner, "error",  (GCallback) importer_scanner_error_cb,  self);
+
+	g_list_free(uri_list);
+}
+
+/**
+ * eina_adb_importer_import:
+ * @self: An #EinaAdbImporter
+ * @uris: (array zero-terminated=1) (transfer none): URIs to import,
+ *        directories are walked recursively
+ *
+ * Starts importing @uris, see #EinaAdbImporter::progress and
+ * #EinaAdbImporter::finished
+ */
+void
+eina_adb_importer_import(EinaAdbImporter *self, const gchar *const *uris)
+{
+	g_return_if_fail(EINA_IS_ADB_IMPORTER(self));
+	g_return_if_fail(uris && uris[0]);
+	g_return_if_fail(!self->priv->running);
+
+	importer_start(self, uris, FALSE);
+}
+
+/**
+ * eina_adb_importer_rescan:
+ * @self: An #EinaAdbImporter
+ * @roots: (array zero-terminated=1) (transfer none): URIs of the library
+ *         roots
+ *
+ * Like eina_adb_importer_import() but streams below @roots whose files no
+ * longer exist are removed too, see eina_adb_importer_get_n_removed()
+ */
+void
+eina_adb_importer_rescan(EinaAdbImporter *self, const gchar *const *roots)
+{
+	g_return_if_fail(EINA_IS_ADB_IMPORTER(self));
+	g_return_if_fail(roots && roots[0]);
+	g_return_if_fail(!self->priv->running);
+
+	importer_start(self, roots, TRUE);
+}
+
+/**
+ * eina_adb_importer_get_n_removed:
+ * @self: An #EinaAdbImporter
+ *
+ * Gets how many missing streams the last rescan removed
+ *
+ * Returns: Number of streams
+ */
+guint
+eina_adb_importer_get_n_removed(EinaAdbImporter *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_IMPORTER(self), 0);
+	return self->priv->removed;
+}
+
+/**
+ * eina_adb_importer_cancel:
+ * @self: An #EinaAdbImporter
+ *
+ * Stops the import in progress. Files already parsed are written.
+ */
+void
+eina_adb_importer_cancel(EinaAdbImporter *self)
+{
+	g_return_if_fail(EINA_IS_ADB_IMPORTER(self));
+	EinaAdbImporterPrivate *priv = self->priv;
+	if (!priv->running)
+		return;
+
+	if (priv->scanner)
+	{
+		g_signal_handlers_disconnect_by_func(priv->scanner, importer_scanner_finish_cb, self);
+		g_signal_handlers_disconnect_by_func(priv->scanner, importer_scanner_error_cb,  self);
+		gel_free_and_invalidate(priv->scanner, NULL, g_object_unref);
+	}
+
+	// Cancel may be called from handlers of a parser's signals ("progress"
+	// and "finished" are emitted from them). Parsers stop reporting now and
+	// are released from an idle by importer_finish().
+	importer_disconnect_parsers(self);
+	g_queue_foreach(priv->pending, (GFunc) candidate_free, NULL);
+	g_queue_clear(priv->pending);
+	priv->in_flight = 0;
+
+	importer_finish(self);
+}
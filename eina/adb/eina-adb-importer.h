@@ -0,0 +1,66 @@
+/*
+ * eina/adb/eina-adb-importer.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EINA_ADB_IMPORTER
+#define _EINA_ADB_IMPORTER
+
+#include <glib-object.h>
+#include <eina/adb/eina-adb.h>
+
+G_BEGIN_DECLS
+
+#define EINA_TYPE_ADB_IMPORTER eina_adb_importer_get_type()
+
+#define EINA_ADB_IMPORTER(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), EINA_TYPE_ADB_IMPORTER, EinaAdbImporter))
+#define EINA_ADB_IMPORTER_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), EINA_TYPE_ADB_IMPORTER, EinaAdbImporterClass))
+#define EINA_IS_ADB_IMPORTER(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EINA_TYPE_ADB_IMPORTER))
+#define EINA_IS_ADB_IMPORTER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EINA_TYPE_ADB_IMPORTER))
+#define EINA_ADB_IMPORTER_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), EINA_TYPE_ADB_IMPORTER, EinaAdbImporterClass))
+
+typedef struct _EinaAdbImporterPrivate EinaAdbImporterPrivate;
+typedef struct {
+	/*<private>*/
+	GObject parent;
+	EinaAdbImporterPrivate *priv;
+} EinaAdbImporter;
+
+typedef struct {
+	/*<private>*/
+	GObjectClass parent_class;
+	void (*progress) (EinaAdbImporter *self, guint done, guint total, gdouble files_per_sec);
+	void (*finished) (EinaAdbImporter *self, guint imported, guint skipped);
+	void (*scanned)  (EinaAdbImporter *self, GList *forest);
+} EinaAdbImporterClass;
+
+GType eina_adb_importer_get_type (void);
+
+EinaAdbImporter* eina_adb_importer_new (EinaAdb *adb);
+
+void     eina_adb_importer_import(EinaAdbImporter *self, const gchar *const *uris);
+void     eina_adb_importer_rescan(EinaAdbImporter *self, const gchar *const *roots);
+void     eina_adb_importer_cancel(EinaAdbImporter *self);
+gboolean eina_adb_importer_is_running(EinaAdbImporter *self);
+guint    eina_adb_importer_get_n_removed(EinaAdbImporter *self);
+
+guint eina_adb_importer_get_n_workers(EinaAdbImporter *self);
+void  eina_adb_importer_set_n_workers(EinaAdbImporter *self, guint n_workers);
+
+G_END_DECLS
+
+#endif /* _EINA_ADB_IMPORTER */
@@ -19,6 +19,7 @@
 
 #include "eina-adb-plugin.h"
 #include "register.h"
+#include "eina-adb-watcher.h"
 #include <eina/lomo/eina-lomo-plugin.h>
 
 #define EINA_TYPE_ADB_PLUGIN         (eina_adb_plugin_get_type ())
@@ -75,6 +76,10 @@ eina_adb_plugin_activate(EinaActivatable *activatable, EinaApplication *app, GEr
 
 	adb_register_start(priv->adb, eina_application_get_lomo(app));
 
+	// Keep the library in sync with the disk, catching up with changes made
+	// while not running
+	eina_adb_watcher_rescan(eina_adb_get_watcher(priv->adb));
+
 	return ret;
 }
 
@@ -24,14 +24,43 @@ G_DEFINE_TYPE (EinaAdbResult, eina_adb_result, G_TYPE_OBJECT)
 
 struct _EinaAdbResultPrivate {
 	sqlite3_stmt *stmt;
+
+	// Chunk of rows copied by eina_adb_result_fetch() or
+	// eina_adb_result_new_batch(), stored by column
+	gint64        **ints; // Values as integers, one array per column
+	const gchar  ***strs; // Values as text in 'strings', NULL for SQL NULL
+	gboolean       *dedup; // Per column, text is shared across rows
+	GStringChunk   *strings;
+	guint           n_columns, n_rows, capacity;
+	gint            row;     // Cursor of eina_adb_result_step() on batches
+	gboolean        fetched; // Batch already returned by eina_adb_result_fetch()
 };
 
+// Initial rows allocated per chunk, arrays grow as needed
+#define CHUNK_MIN_ROWS 256
+
+static void
+result_free_chunk(EinaAdbResultPrivate *priv)
+{
+	for (guint i = 0; priv->ints && (i < priv->n_columns); i++)
+	{
+		g_free(priv->ints[i]);
+		g_free(priv->strs[i]);
+	}
+	gel_free_and_invalidate(priv->ints,    NULL, g_free);
+	gel_free_and_invalidate(priv->strs,    NULL, g_free);
+	gel_free_and_invalidate(priv->dedup,   NULL, g_free);
+	gel_free_and_invalidate(priv->strings, NULL, g_string_chunk_free);
+	priv->n_rows = priv->capacity = 0;
+}
+
 static void
 eina_adb_result_dispose (GObject *object)
 {
 	EinaAdbResult *self = EINA_ADB_RESULT(object);
 
 	gel_free_and_invalidate(self->priv->stmt, NULL, sqlite3_finalize);
+	result_free_chunk(self->priv);
 
 	G_OBJECT_CLASS (eina_adb_result_parent_class)->dispose (object);
 }
@@ -68,6 +97,150 @@ eina_adb_result_new (sqlite3_stmt *stmt)
 	return self;
 }
 
+/*
+ * Columns whose values are unique per row, interning them would only fill
+ * the chunk's lookup table
+ */
+static gboolean
+result_column_is_unique(sqlite3_stmt *stmt, guint column)
+{
+	const gchar *name = sqlite3_column_name(stmt, column);
+	return name && (!g_ascii_strcasecmp(name, "uri") || !g_ascii_strcasecmp(name, "title"));
+}
+
+/*
+ * Copies up to max_rows rows from stmt into the chunk, replacing the previous
+ * one. Returns the code of the last sqlite3_step() call.
+ */
+static int
+result_fill_chunk(EinaAdbResultPrivate *priv, sqlite3_stmt *stmt, guint max_rows)
+{
+	if (priv->ints == NULL)
+	{
+		priv->n_columns = sqlite3_column_count(stmt);
+		priv->ints      = g_new0(gint64 *, priv->n_columns);
+		priv->strs      = g_new0(const gchar **, priv->n_columns);
+		priv->dedup     = g_new0(gboolean, priv->n_columns);
+		priv->strings   = g_string_chunk_new(4096);
+		for (guint i = 0; i < priv->n_columns; i++)
+			priv->dedup[i] = !result_column_is_unique(stmt, i);
+	}
+	else
+		g_string_chunk_clear(priv->strings);
+
+	priv->n_rows = 0;
+	priv->row    = -1;
+
+	int code = SQLITE_ROW;
+	while ((priv->n_rows < max_rows) && ((code = sqlite3_step(stmt)) == SQLITE_ROW))
+	{
+		if (priv->n_rows == priv->capacity)
+		{
+			priv->capacity = priv->capacity ? priv->capacity * 2 : MIN(max_rows, CHUNK_MIN_ROWS);
+			for (guint i = 0; i < priv->n_columns; i++)
+			{
+				priv->ints[i] = g_renew(gint64, priv->ints[i], priv->capacity);
+				priv->strs[i] = g_renew(const gchar *, priv->strs[i], priv->capacity);
+			}
+		}
+
+		for (guint i = 0; i < priv->n_columns; i++)
+		{
+			gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+			const gchar *text = NULL;
+			gint64 value = 0;
+			gboolean repeated = FALSE;
+
+			// Convert numbers here so sqlite doesn't allocate text for them
+			switch (sqlite3_column_type(stmt, i))
+			{
+			case SQLITE_NULL:
+				break;
+			case SQLITE_INTEGER:
+				value = sqlite3_column_int64(stmt, i);
+				g_snprintf(buffer, sizeof(buffer), "%" G_GINT64_FORMAT, value);
+				text = buffer;
+				break;
+			case SQLITE_FLOAT:
+				value = (gint64) sqlite3_column_double(stmt, i);
+				text = g_ascii_dtostr(buffer, sizeof(buffer), sqlite3_column_double(stmt, i));
+				break;
+			default:
+				// Artists, albums, genres... repeat a lot across rows
+				value    = sqlite3_column_int64(stmt, i);
+				text     = (const gchar *) sqlite3_column_text(stmt, i);
+				repeated = priv->dedup[i];
+			}
+
+			if (text == NULL)
+				priv->strs[i][priv->n_rows] = NULL;
+			else if (repeated)
+				priv->strs[i][priv->n_rows] = g_string_chunk_insert_const(priv->strings, text);
+			else
+				priv->strs[i][priv->n_rows] = g_string_chunk_insert(priv->strings, text);
+			priv->ints[i][priv->n_rows] = value;
+		}
+		priv->n_rows++;
+	}
+
+	return code;
+}
+
+/**
+ * eina_adb_result_new_batch: (skip):
+ * @stmt: SQLite3 stament
+ * @max_rows: Maximum number of rows to copy
+ * @code: (out) (allow-none): Return location for the code of the last
+ *        sqlite3_step() call, %SQLITE_ROW if there may be more rows
+ *
+ * Steps @stmt up to @max_rows times and copies the rows into a new result,
+ * which doesn't depend on @stmt nor its connection. Can be called from any
+ * thread.
+ *
+ * Returns: The new object
+ */
+EinaAdbResult*
+eina_adb_result_new_batch(sqlite3_stmt *stmt, guint max_rows, gint *code)
+{
+	g_return_val_if_fail(stmt != NULL, NULL);
+
+	EinaAdbResult *self = g_object_new (EINA_TYPE_ADB_RESULT, NULL);
+
+	int ret = result_fill_chunk(self->priv, stmt, max_rows);
+	if (code)
+		*code = ret;
+
+	return self;
+}
+
+static inline gboolean
+result_check_cell(EinaAdbResult *result, gint column)
+{
+	EinaAdbResultPrivate *priv = result->priv;
+	g_return_val_if_fail((priv->row >= 0) && ((guint) priv->row < priv->n_rows), FALSE);
+	g_return_val_if_fail((guint) column < priv->n_columns, FALSE);
+
+	return TRUE;
+}
+
+static inline const gchar*
+result_column_text(EinaAdbResult *result, gint column)
+{
+	if (result->priv->stmt)
+		return (const gchar *) sqlite3_column_text(result->priv->stmt, column);
+
+	return result_check_cell(result, column) ? result->priv->strs[column][result->priv->row] : NULL;
+}
+
+static inline gint64
+result_column_int64(EinaAdbResult *result, gint column)
+{
+	if (result->priv->stmt)
+		return (gint64) sqlite3_column_int64(result->priv->stmt, column);
+
+	return result_check_cell(result, column) ? result->priv->ints[column][result->priv->row] : 0;
+}
+
 /**
  * eina_adb_result_column_count:
  * @result: an #EinaAdbResult
@@ -80,6 +253,8 @@ gint
 eina_adb_result_column_count(EinaAdbResult *result)
 {
 	g_return_val_if_fail(EINA_IS_ADB_RESULT(result), -1);
+	if (result->priv->stmt == NULL)
+		return result->priv->n_columns;
 	return sqlite3_column_count(result->priv->stmt);
 }
 
@@ -95,8 +270,16 @@ gboolean
 eina_adb_result_step(EinaAdbResult *result)
 {
 	g_return_val_if_fail(EINA_IS_ADB_RESULT(result), FALSE);
+	EinaAdbResultPrivate *priv = result->priv;
 
-	int ret = sqlite3_step(result->priv->stmt);
+	if (priv->stmt == NULL)
+	{
+		if ((guint) (priv->row + 1) <= priv->n_rows)
+			priv->row++;
+		return ((guint) priv->row < priv->n_rows);
+	}
+
+	int ret = sqlite3_step(priv->stmt);
 	if (ret == SQLITE_DONE)
 		return FALSE;
 
@@ -120,8 +303,6 @@ eina_adb_result_get_valist(EinaAdbResult *result, va_list var_args)
 {
 	g_return_if_fail(EINA_IS_ADB_RESULT(result));
 
-	sqlite3_stmt *stmt = result->priv->stmt;
-
 	gint column = va_arg(var_args, gint);
 	while (column >= 0)
 	{
@@ -129,20 +310,25 @@ eina_adb_result_get_valist(EinaAdbResult *result, va_list var_args)
 		gchar **str;
 		gint   *i;
 		guint  *u;
+		gint64 *i64;
 
 		switch (type)
 		{
 		case G_TYPE_STRING:
 			str = va_arg(var_args, gchar**);
-			*str = g_strdup((gchar *) sqlite3_column_text(stmt, column));
+			*str = g_strdup(result_column_text(result, column));
 			break;
 		case G_TYPE_INT:
 			i = va_arg(var_args, gint*);
-			*i = (gint) sqlite3_column_int(stmt, column);
+			*i = (gint) result_column_int64(result, column);
 			break;
 		case G_TYPE_UINT:
 			u = va_arg(var_args, guint*);
-			*u = (guint) sqlite3_column_int(stmt, column);
+			*u = (guint) result_column_int64(result, column);
+			break;
+		case G_TYPE_INT64:
+			i64 = va_arg(var_args, gint64*);
+			*i64 = result_column_int64(result, column);
 			break;
 		default:
 			g_warning("Unhandled type '%s' in %s. Aborting", g_type_name(type), __FUNCTION__);
@@ -189,23 +375,25 @@ eina_adb_result_get_value(EinaAdbResult *result, gint column, GType type)
 	g_return_val_if_fail(EINA_IS_ADB_RESULT(result), NULL);
 	g_return_val_if_fail(column >= 0, NULL);
 
-	sqlite3_stmt *stmt = result->priv->stmt;
-
 	GValue *ret = g_new0(GValue, 1);
 
 	switch (type)
 	{
 	case G_TYPE_STRING:
 		g_value_init(ret, type);
-		g_value_set_string(ret, (gchar *) sqlite3_column_text(stmt, column));
+		g_value_set_string(ret, result_column_text(result, column));
 		break;
 	case G_TYPE_INT:
 		g_value_init(ret, type);
-		g_value_set_int(ret, (gint) sqlite3_column_int(stmt, column));
+		g_value_set_int(ret, (gint) result_column_int64(result, column));
 		break;
 	case G_TYPE_UINT:
 		g_value_init(ret, type);
-		g_value_set_uint(ret, (guint) sqlite3_column_int(stmt, column));
+		g_value_set_uint(ret, (guint) result_column_int64(result, column));
+		break;
+	case G_TYPE_INT64:
+		g_value_init(ret, type);
+		g_value_set_int64(ret, result_column_int64(result, column));
 		break;
 	default:
 		g_warning("Unhandled type '%s' in %s. Aborting", g_type_name(type), __FUNCTION__);
@@ -215,3 +403,92 @@ eina_adb_result_get_value(EinaAdbResult *result, gint column, GType type)
 	return ret;
 }
 
+
+/**
+ * eina_adb_result_fetch:
+ * @result: an #EinaAdbResult
+ * @max_rows: Maximum number of rows to fetch
+ *
+ * Fetches the next chunk of up to @max_rows rows at once. Values are read
+ * by column with eina_adb_result_get_int64_column() and
+ * eina_adb_result_get_string_column(), which is way cheaper than stepping
+ * and getting row by row for big results. Strings live in a single buffer
+ * owned by @result until the next call.
+ *
+ * Don't mix this with eina_adb_result_step(). On results delivered by
+ * eina_adb_query_async() the first call returns the whole batch.
+ *
+ * Returns: Number of rows fetched, 0 if there are no more rows or -1 on
+ *          errors
+ */
+gint
+eina_adb_result_fetch(EinaAdbResult *result, guint max_rows)
+{
+	g_return_val_if_fail(EINA_IS_ADB_RESULT(result), -1);
+	EinaAdbResultPrivate *priv = result->priv;
+
+	if (priv->stmt == NULL)
+	{
+		if (priv->fetched)
+			return 0;
+		priv->fetched = TRUE;
+		return priv->n_rows;
+	}
+
+	if (priv->fetched)
+		return 0;
+
+	int code = result_fill_chunk(priv, priv->stmt, max_rows);
+	if (code != SQLITE_ROW)
+		priv->fetched = TRUE;
+
+	g_return_val_if_fail((code == SQLITE_ROW) || (code == SQLITE_DONE), -1);
+
+	return priv->n_rows;
+}
+
+/**
+ * eina_adb_result_get_int64_column:
+ * @result: an #EinaAdbResult
+ * @column: Result column to read
+ * @n_rows: (out) (allow-none): Return location for the number of rows
+ *
+ * Reads @column from the chunk fetched by eina_adb_result_fetch()
+ *
+ * Returns: (array length=n_rows) (transfer none): Values as integers, SQL
+ *          NULLs are 0
+ */
+const gint64*
+eina_adb_result_get_int64_column(EinaAdbResult *result, gint column, guint *n_rows)
+{
+	g_return_val_if_fail(EINA_IS_ADB_RESULT(result), NULL);
+	EinaAdbResultPrivate *priv = result->priv;
+	g_return_val_if_fail((column >= 0) && ((guint) column < priv->n_columns), NULL);
+
+	if (n_rows)
+		*n_rows = priv->n_rows;
+	return priv->ints[column];
+}
+
+/**
+ * eina_adb_result_get_string_column:
+ * @result: an #EinaAdbResult
+ * @column: Result column to read
+ * @n_rows: (out) (allow-none): Return location for the number of rows
+ *
+ * Reads @column from the chunk fetched by eina_adb_result_fetch()
+ *
+ * Returns: (array length=n_rows) (element-type utf8) (transfer none): Values
+ *          as strings, %NULL for SQL NULLs
+ */
+const gchar* const*
+eina_adb_result_get_string_column(EinaAdbResult *result, gint column, guint *n_rows)
+{
+	g_return_val_if_fail(EINA_IS_ADB_RESULT(result), NULL);
+	EinaAdbResultPrivate *priv = result->priv;
+	g_return_val_if_fail((column >= 0) && ((guint) column < priv->n_columns), NULL);
+
+	if (n_rows)
+		*n_rows = priv->n_rows;
+	return (const gchar* const*) priv->strs[column];
+}
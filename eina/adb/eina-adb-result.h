@@ -47,7 +47,8 @@ typedef struct {
 
 GType eina_adb_result_get_type (void);
 
-EinaAdbResult* eina_adb_result_new (sqlite3_stmt *stmt);
+EinaAdbResult* eina_adb_result_new      (sqlite3_stmt *stmt);
+EinaAdbResult* eina_adb_result_new_batch(sqlite3_stmt *stmt, guint max_rows, gint *code);
 
 gint     eina_adb_result_column_count(EinaAdbResult *result);
 gboolean eina_adb_result_step        (EinaAdbResult *result);
@@ -55,6 +56,10 @@ void eina_adb_result_get         (EinaAdbResult *result, ...);
 void eina_adb_result_get_valist  (EinaAdbResult *result, va_list var_args);
 GValue *eina_adb_result_get_value(EinaAdbResult *result, gint column, GType type);
 
+gint                eina_adb_result_fetch            (EinaAdbResult *result, guint max_rows);
+const gint64*       eina_adb_result_get_int64_column (EinaAdbResult *result, gint column, guint *n_rows);
+const gchar* const* eina_adb_result_get_string_column(EinaAdbResult *result, gint column, guint *n_rows);
+
 G_END_DECLS
 
 #endif /* _EINA_ADB_RESULT */
@@ -0,0 +1,550 @@
+/*
+ * eina/adb/eina-adb-sampler.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:eina-adb-sampler
+ * @short_description: Random selection of streams
+ * @see_also: #EinaAdb
+ *
+ * #EinaAdbSampler picks random SIDs from the streams known by #EinaAdb
+ * without sorting the whole library in SQL.
+ *
+ * It keeps an in-memory index of every SID bucketed by rating (read from
+ * the 'stars' table if it exists) along with its play count. The index is
+ * loaded once and then kept up to date: new streams and their ratings are
+ * fetched by SID on each sample, plays and ratings are pushed with
+ * eina_adb_sampler_add_play() and eina_adb_sampler_set_rating().
+ *
+ * Uniform picks use Floyd's algorithm over the selected buckets, O(n) for n
+ * picks. Weighted picks use a Fenwick tree over the candidates, O(n log m).
+ */
+
+#include "eina-adb-sampler.h"
+#include <gel/gel.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaAdbSampler"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+#define N_BUCKETS (EINA_ADB_SAMPLER_MAX_RATING + 1)
+
+// SIDs per 'IN (...)' query when resolving URIs
+#define URI_CHUNK 256
+
+G_DEFINE_TYPE (EinaAdbSampler, eina_adb_sampler, G_TYPE_OBJECT)
+
+typedef struct {
+	guint rating;
+	guint pos;
+	guint plays;
+} Entry;
+
+struct _EinaAdbSamplerPrivate {
+	EinaAdb    *adb;
+	gboolean    loaded;
+	gint        max_sid;
+	GArray     *buckets[N_BUCKETS]; // <gint>, SIDs by rating
+	GHashTable *entries;            // <gint, Entry>
+};
+
+static void
+entry_free(Entry *entry)
+{
+	g_slice_free(Entry, entry);
+}
+
+static void
+eina_adb_sampler_dispose (GObject *object)
+{
+	EinaAdbSampler *self = EINA_ADB_SAMPLER(object);
+	EinaAdbSamplerPrivate *priv = self->priv;
+
+	for (guint i = 0; i < N_BUCKETS; i++)
+		gel_free_and_invalidate(priv->buckets[i], NULL, g_array_unref);
+	gel_free_and_invalidate(priv->entries, NULL, g_hash_table_destroy);
+
+	G_OBJECT_CLASS (eina_adb_sampler_parent_class)->dispose (object);
+}
+
+static void
+eina_adb_sampler_class_init (EinaAdbSamplerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (EinaAdbSamplerPrivate));
+
+	object_class->dispose = eina_adb_sampler_dispose;
+}
+
+static void
+eina_adb_sampler_init (EinaAdbSampler *self)
+{
+	EinaAdbSamplerPrivate *priv = self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_ADB_SAMPLER, EinaAdbSamplerPrivate));
+
+	for (guint i = 0; i < N_BUCKETS; i++)
+		priv->buckets[i] = g_array_new(FALSE, FALSE, sizeof(gint));
+	priv->entries = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify) entry_free);
+}
+
+/**
+ * eina_adb_get_sampler:
+ * @adb: An #EinaAdb
+ *
+ * Gets the #EinaAdbSampler for @adb, it's created on first use and lives
+ * as long as @adb. Index is not loaded until the first sample.
+ *
+ * Returns: (transfer none): The #EinaAdbSampler
+ */
+EinaAdbSampler*
+eina_adb_get_sampler(EinaAdb *adb)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+
+	EinaAdbSampler *self = g_object_get_data((GObject *) adb, "eina-adb-sampler");
+	if (self)
+		return self;
+
+	self = g_object_new(EINA_TYPE_ADB_SAMPLER, NULL);
+	self->priv->adb = adb;
+	g_object_set_data_full((GObject *) adb, "eina-adb-sampler", self, g_object_unref);
+
+	return self;
+}
+
+/*
+ * Index
+ */
+static void
+sampler_bucket_remove(EinaAdbSampler *self, Entry *entry)
+{
+	EinaAdbSamplerPrivate *priv = self->priv;
+	GArray *bucket = priv->buckets[entry->rating];
+
+	// Last element takes the hole
+	g_array_remove_index_fast(bucket, entry->pos);
+	if (entry->pos < bucket->len)
+	{
+		Entry *moved = g_hash_table_lookup(priv->entries, GINT_TO_POINTER(g_array_index(bucket, gint, entry->pos)));
+		moved->pos = entry->pos;
+	}
+}
+
+static void
+sampler_bucket_append(EinaAdbSampler *self, gint sid, Entry *entry)
+{
+	GArray *bucket = self->priv->buckets[entry->rating];
+	entry->pos = bucket->len;
+	g_array_append_val(bucket, sid);
+}
+
+static Entry *
+sampler_ensure_entry(EinaAdbSampler *self, gint sid)
+{
+	EinaAdbSamplerPrivate *priv = self->priv;
+
+	Entry *entry = g_hash_table_lookup(priv->entries, GINT_TO_POINTER(sid));
+	if (!entry)
+	{
+		entry = g_slice_new0(Entry);
+		g_hash_table_insert(priv->entries, GINT_TO_POINTER(sid), entry);
+		sampler_bucket_append(self, sid, entry);
+	}
+	return entry;
+}
+
+static void
+sampler_entry_set_rating(EinaAdbSampler *self, gint sid, Entry *entry, gint rating)
+{
+	guint r = CLAMP(rating, 0, EINA_ADB_SAMPLER_MAX_RATING);
+	if (r == entry->rating)
+		return;
+
+	sampler_bucket_remove(self, entry);
+	entry->rating = r;
+	sampler_bucket_append(self, sid, entry);
+}
+
+static void
+sampler_add(EinaAdbSampler *self, gint sid, guint plays, gint rating)
+{
+	Entry *entry = sampler_ensure_entry(self, sid);
+	entry->plays = plays;
+	sampler_entry_set_rating(self, sid, entry, rating);
+	self->priv->max_sid = MAX(self->priv->max_sid, sid);
+}
+
+static void
+sampler_remove(EinaAdbSampler *self, gint sid)
+{
+	Entry *entry = g_hash_table_lookup(self->priv->entries, GINT_TO_POINTER(sid));
+	if (!entry)
+		return;
+
+	sampler_bucket_remove(self, entry);
+	g_hash_table_remove(self->priv->entries, GINT_TO_POINTER(sid));
+}
+
+static void
+sampler_add_from_result(EinaAdbSampler *self, EinaAdbResult *res)
+{
+	if (!res)
+		return;
+
+	gint sid, plays, rating;
+	while (eina_adb_result_step(res))
+	{
+		eina_adb_result_get(res, 0, G_TYPE_INT, &sid, 1, G_TYPE_INT, &plays, 2, G_TYPE_INT, &rating, -1);
+		sampler_add(self, sid, MAX(plays, 0), rating);
+	}
+	g_object_unref(res);
+}
+
+static gboolean
+sampler_has_table(EinaAdbSampler *self, const gchar *table)
+{
+	EinaAdbResult *res = eina_adb_query(self->priv->adb,
+		"SELECT 1 FROM sqlite_master WHERE type='table' AND name='%q';", table);
+	if (!res)
+		return FALSE;
+
+	gboolean ret = eina_adb_result_step(res);
+	g_object_unref(res);
+	return ret;
+}
+
+static void
+sampler_sync(EinaAdbSampler *self)
+{
+	EinaAdbSamplerPrivate *priv = self->priv;
+
+	// Streams are never renumbered, new ones are above max_sid (0 until the
+	// index is loaded). Their ratings come along, set_rating() can't see
+	// streams that aren't indexed yet.
+	if (sampler_has_table(self, "stars"))
+		sampler_add_from_result(self, eina_adb_query(priv->adb,
+			"SELECT s.sid,s.count,COALESCE(t.rating,0) FROM streams AS s "
+			"LEFT JOIN stars AS t ON t.sid = s.sid WHERE s.sid > %d;", priv->max_sid));
+	else
+		sampler_add_from_result(self, eina_adb_query(priv->adb,
+			"SELECT sid,count,0 FROM streams WHERE sid > %d;", priv->max_sid));
+
+	if (!priv->loaded)
+	{
+		priv->loaded = TRUE;
+		debug("Index loaded: %u streams", g_hash_table_size(priv->entries));
+	}
+}
+
+/**
+ * eina_adb_sampler_invalidate:
+ * @self: An #EinaAdbSampler
+ *
+ * Drops the index, it will be fully reloaded on next sample. Use it after
+ * bulk changes on the database that the sampler can't see, like deleting
+ * streams.
+ */
+void
+eina_adb_sampler_invalidate(EinaAdbSampler *self)
+{
+	g_return_if_fail(EINA_IS_ADB_SAMPLER(self));
+	EinaAdbSamplerPrivate *priv = self->priv;
+
+	g_hash_table_remove_all(priv->entries);
+	for (guint i = 0; i < N_BUCKETS; i++)
+		g_array_set_size(priv->buckets[i], 0);
+	priv->max_sid = 0;
+	priv->loaded  = FALSE;
+}
+
+/**
+ * eina_adb_sampler_set_rating:
+ * @self: An #EinaAdbSampler
+ * @sid: A SID
+ * @rating: New rating for @sid, 0 for unrated
+ *
+ * Updates the rating of @sid in the index, the database is not touched.
+ * Streams added after the index was loaded get their entry here, their play
+ * count is filled on the next sample.
+ */
+void
+eina_adb_sampler_set_rating(EinaAdbSampler *self, gint sid, gint rating)
+{
+	g_return_if_fail(EINA_IS_ADB_SAMPLER(self));
+	g_return_if_fail(sid > 0);
+
+	// Not loaded yet, the rating will be read along with the index
+	if (!self->priv->loaded)
+		return;
+
+	// max_sid is left alone, the stream is picked up by the next sync
+	sampler_entry_set_rating(self, sid, sampler_ensure_entry(self, sid), rating);
+}
+
+/**
+ * eina_adb_sampler_add_play:
+ * @self: An #EinaAdbSampler
+ * @sid: A SID
+ *
+ * Increments the play count of @sid in the index, the database is not
+ * touched.
+ */
+void
+eina_adb_sampler_add_play(EinaAdbSampler *self, gint sid)
+{
+	g_return_if_fail(EINA_IS_ADB_SAMPLER(self));
+
+	Entry *entry = g_hash_table_lookup(self->priv->entries, GINT_TO_POINTER(sid));
+	if (entry)
+		entry->plays++;
+}
+
+/*
+ * Sampling
+ */
+static void
+sampler_shuffle(GArray *sids)
+{
+	for (guint i = sids->len; i > 1; i--)
+	{
+		guint j = g_random_int_range(0, i);
+		gint tmp = g_array_index(sids, gint, i - 1);
+		g_array_index(sids, gint, i - 1) = g_array_index(sids, gint, j);
+		g_array_index(sids, gint, j) = tmp;
+	}
+}
+
+static gint
+sampler_nth(EinaAdbSampler *self, gint min_rating, gint max_rating, guint index)
+{
+	for (gint r = min_rating; r <= max_rating; r++)
+	{
+		GArray *bucket = self->priv->buckets[r];
+		if (index < bucket->len)
+			return g_array_index(bucket, gint, index);
+		index -= bucket->len;
+	}
+	g_return_val_if_reached(-1);
+}
+
+static GArray *
+sampler_sample_uniform(EinaAdbSampler *self, gint min_rating, gint max_rating, guint n)
+{
+	EinaAdbSamplerPrivate *priv = self->priv;
+
+	guint total = 0;
+	for (gint r = min_rating; r <= max_rating; r++)
+		total += priv->buckets[r]->len;
+	if ((n == 0) || (n > total))
+		n = total;
+
+	GArray *ret = g_array_sized_new(FALSE, FALSE, sizeof(gint), n);
+	if (n == total)
+	{
+		for (gint r = min_rating; r <= max_rating; r++)
+			g_array_append_vals(ret, priv->buckets[r]->data, priv->buckets[r]->len);
+	}
+	else
+	{
+		// Floyd's algorithm: n distinct indexes in n iterations
+		GHashTable *picked = g_hash_table_new(NULL, NULL);
+		for (guint j = total - n; j < total; j++)
+		{
+			guint t = g_random_int_range(0, j + 1);
+			if (g_hash_table_lookup(picked, GUINT_TO_POINTER(t + 1)))
+				t = j;
+			g_hash_table_insert(picked, GUINT_TO_POINTER(t + 1), GINT_TO_POINTER(1));
+
+			gint sid = sampler_nth(self, min_rating, max_rating, t);
+			g_array_append_val(ret, sid);
+		}
+		g_hash_table_destroy(picked);
+	}
+
+	sampler_shuffle(ret);
+	return ret;
+}
+
+static guint64
+sampler_weight(Entry *entry)
+{
+	// Rating dominates, plays add logarithmically
+	return (entry->rating + 1) * (g_bit_storage(entry->plays) + 1);
+}
+
+static GArray *
+sampler_sample_weighted(EinaAdbSampler *self, gint min_rating, gint max_rating, guint n)
+{
+	EinaAdbSamplerPrivate *priv = self->priv;
+
+	GArray *candidates = g_array_new(FALSE, FALSE, sizeof(gint));
+	for (gint r = min_rating; r <= max_rating; r++)
+		g_array_append_vals(candidates, priv->buckets[r]->data, priv->buckets[r]->len);
+
+	guint m = candidates->len;
+	if ((n == 0) || (n > m))
+		n = m;
+
+	// Fenwick tree (1-based) of weights, picked candidates drop to zero
+	guint64 *tree = g_new0(guint64, m + 1);
+	for (guint i = 1; i <= m; i++)
+	{
+		Entry *entry = g_hash_table_lookup(priv->entries, GINT_TO_POINTER(g_array_index(candidates, gint, i - 1)));
+		tree[i] += sampler_weight(entry);
+		guint parent = i + (i & -i);
+		if (parent <= m)
+			tree[parent] += tree[i];
+	}
+
+	guint top = 1;
+	while ((top << 1) <= m)
+		top <<= 1;
+
+	GArray *ret = g_array_sized_new(FALSE, FALSE, sizeof(gint), n);
+	for (guint k = 0; k < n; k++)
+	{
+		guint64 total = 0;
+		for (guint i = m; i > 0; i -= (i & -i))
+			total += tree[i];
+		if (total == 0)
+			break;
+
+		// Find the candidate covering r
+		guint64 r = (guint64) g_random_double_range(0, (gdouble) total);
+		guint pos = 0;
+		for (guint step = top; step > 0; step >>= 1)
+		{
+			if ((pos + step <= m) && (tree[pos + step] <= r))
+			{
+				pos += step;
+				r   -= tree[pos];
+			}
+		}
+
+		gint sid = g_array_index(candidates, gint, pos);
+		g_array_append_val(ret, sid);
+
+		// pos + 1 is the 1-based index of the pick, remove its weight
+		Entry *entry = g_hash_table_lookup(priv->entries, GINT_TO_POINTER(sid));
+		guint64 w = sampler_weight(entry);
+		for (guint i = pos + 1; i <= m; i += (i & -i))
+			tree[i] -= w;
+	}
+
+	g_free(tree);
+	g_array_free(candidates, TRUE);
+	return ret;
+}
+
+/**
+ * eina_adb_sampler_sample:
+ * @self: An #EinaAdbSampler
+ * @min_rating: Minimum rating, inclusive
+ * @max_rating: Maximum rating, inclusive
+ * @weighted: Favour streams with higher rating and play count
+ * @n: Number of SIDs to pick, 0 for all candidates
+ *
+ * Picks up to @n distinct SIDs with rating between @min_rating and
+ * @max_rating in random order. Unrated streams have rating 0.
+ *
+ * Returns: (transfer full) (element-type gint): The SIDs
+ */
+GArray*
+eina_adb_sampler_sample(EinaAdbSampler *self, gint min_rating, gint max_rating, gboolean weighted, guint n)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SAMPLER(self), NULL);
+
+	min_rating = CLAMP(min_rating, 0, EINA_ADB_SAMPLER_MAX_RATING);
+	max_rating = CLAMP(max_rating, 0, EINA_ADB_SAMPLER_MAX_RATING);
+	if (min_rating > max_rating)
+		return g_array_new(FALSE, FALSE, sizeof(gint));
+
+	sampler_sync(self);
+
+	return weighted ?
+		sampler_sample_weighted(self, min_rating, max_rating, n) :
+		sampler_sample_uniform (self, min_rating, max_rating, n);
+}
+
+/**
+ * eina_adb_sampler_sample_uris:
+ * @self: An #EinaAdbSampler
+ * @min_rating: Minimum rating, inclusive
+ * @max_rating: Maximum rating, inclusive
+ * @weighted: Favour streams with higher rating and play count
+ * @n: Number of streams to pick, 0 for all candidates
+ *
+ * Like eina_adb_sampler_sample() but resolves SIDs to URIs, keeping the
+ * order. SIDs no longer in the database are dropped from the index.
+ *
+ * Returns: (transfer full) (array zero-terminated=1): The URIs
+ */
+gchar**
+eina_adb_sampler_sample_uris(EinaAdbSampler *self, gint min_rating, gint max_rating, gboolean weighted, guint n)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SAMPLER(self), NULL);
+
+	GArray *sids = eina_adb_sampler_sample(self, min_rating, max_rating, weighted, n);
+	GHashTable *uris = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+
+	for (guint i = 0; i < sids->len; i += URI_CHUNK)
+	{
+		GString *q = g_string_new("SELECT sid,uri FROM streams WHERE sid IN (");
+		for (guint j = i; (j < sids->len) && (j < i + URI_CHUNK); j++)
+			g_string_append_printf(q, (j == i) ? "%d" : ",%d", g_array_index(sids, gint, j));
+		g_string_append(q, ");");
+
+		EinaAdbResult *res = eina_adb_query_raw(self->priv->adb, q->str);
+		g_string_free(q, TRUE);
+		if (!res)
+			continue;
+
+		gint   sid;
+		gchar *uri;
+		while (eina_adb_result_step(res))
+		{
+			eina_adb_result_get(res, 0, G_TYPE_INT, &sid, 1, G_TYPE_STRING, &uri, -1);
+			g_hash_table_insert(uris, GINT_TO_POINTER(sid), uri);
+		}
+		g_object_unref(res);
+	}
+
+	gchar **ret = g_new0(gchar *, sids->len + 1);
+	guint n_ret = 0;
+	for (guint i = 0; i < sids->len; i++)
+	{
+		gint sid = g_array_index(sids, gint, i);
+		gchar *uri = NULL;
+		if (g_hash_table_lookup_extended(uris, GINT_TO_POINTER(sid), NULL, (gpointer *) &uri) && uri)
+		{
+			ret[n_ret++] = uri;
+			g_hash_table_steal(uris, GINT_TO_POINTER(sid));
+		}
+		else
+			sampler_remove(self, sid);
+	}
+
+	g_hash_table_destroy(uris);
+	g_array_free(sids, TRUE);
+
+	return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ * eina/adb/eina-adb-sampler.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EINA_ADB_SAMPLER
+#define _EINA_ADB_SAMPLER
+
+#include <glib-object.h>
+#include <eina/adb/eina-adb.h>
+
+G_BEGIN_DECLS
+
+#define EINA_TYPE_ADB_SAMPLER eina_adb_sampler_get_type()
+
+#define EINA_ADB_SAMPLER(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), EINA_TYPE_ADB_SAMPLER, EinaAdbSampler))
+#define EINA_ADB_SAMPLER_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), EINA_TYPE_ADB_SAMPLER, EinaAdbSamplerClass))
+#define EINA_IS_ADB_SAMPLER(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EINA_TYPE_ADB_SAMPLER))
+#define EINA_IS_ADB_SAMPLER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EINA_TYPE_ADB_SAMPLER))
+#define EINA_ADB_SAMPLER_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), EINA_TYPE_ADB_SAMPLER, EinaAdbSamplerClass))
+
+typedef struct _EinaAdbSamplerPrivate EinaAdbSamplerPrivate;
+typedef struct {
+	/*<private>*/
+	GObject parent;
+	EinaAdbSamplerPrivate *priv;
+} EinaAdbSampler;
+
+typedef struct {
+	/*<private>*/
+	GObjectClass parent_class;
+} EinaAdbSamplerClass;
+
+/**
+ * EINA_ADB_SAMPLER_MAX_RATING:
+ *
+ * Highest rating tracked by #EinaAdbSampler, higher ratings are clamped
+ */
+#define EINA_ADB_SAMPLER_MAX_RATING 5
+
+GType eina_adb_sampler_get_type (void);
+
+EinaAdbSampler* eina_adb_get_sampler(EinaAdb *adb);
+
+void eina_adb_sampler_invalidate(EinaAdbSampler *self);
+void eina_adb_sampler_set_rating(EinaAdbSampler *self, gint sid, gint rating);
+void eina_adb_sampler_add_play  (EinaAdbSampler *self, gint sid);
+
+GArray* eina_adb_sampler_sample     (EinaAdbSampler *self, gint min_rating, gint max_rating, gboolean weighted, guint n);
+gchar** eina_adb_sampler_sample_uris(EinaAdbSampler *self, gint min_rating, gint max_rating, gboolean weighted, guint n);
+
+G_END_DECLS
+
+#endif /* _EINA_ADB_SAMPLER */
@@ -0,0 +1,1037 @@
+/*
+ * eina/adb/eina-adb-smart-playlist.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:eina-adb-smart-playlist
+ * @short_description: Rule based playlists over #EinaAdb
+ * @see_also: #EinaAdb
+ *
+ * An #EinaAdbSmartPlaylist holds the streams matching a tree of
+ * #EinaAdbRule. The tree is compiled once into a parameterised SQL statement
+ * which is kept prepared; tag rules use the (key,value) index on 'metadata'.
+ *
+ * Results are cached and kept up to date by listening to #EinaAdb::changed.
+ * When possible (insertion or random order, no limit) only the modified
+ * streams are checked again and #EinaAdbSmartPlaylist::stream-added or
+ * #EinaAdbSmartPlaylist::stream-removed are emitted, otherwise the whole
+ * statement runs again.
+ *
+ * |[
+ * // Rated 4 or more and not played in the last week
+ * EinaAdbRule *rule   = eina_adb_rule_new_group(EINA_ADB_RULE_ALL);
+ * EinaAdbRule *rated  = eina_adb_rule_new_number(EINA_ADB_RULE_RATING, EINA_ADB_RULE_OP_GE, 4);
+ * EinaAdbRule *played = eina_adb_rule_new_number(EINA_ADB_RULE_LAST_PLAYED, EINA_ADB_RULE_OP_WITHIN, 7 * 24 * 3600);
+ * EinaAdbRule *fresh  = eina_adb_rule_new_not(played);
+ * eina_adb_rule_add(rule, rated);
+ * eina_adb_rule_add(rule, fresh);
+ *
+ * EinaAdbSmartPlaylist *pl = eina_adb_smart_playlist_new(adb, rule);
+ * eina_adb_smart_playlist_feed(pl, lomo, -1);
+ * ]|
+ */
+
+#include "eina-adb-smart-playlist.h"
+#include <string.h>
+#include <gel/gel.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaAdbSmartPlaylist"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// URIs inserted into LomoPlayer per idle
+#define FEED_BATCH_SIZE 256
+
+/*
+ * Rules
+ */
+struct _EinaAdbRule {
+	gint              refs;
+	EinaAdbRuleField  field;
+	EinaAdbRuleOp     op;
+	gchar            *tag;
+	gchar            *str;
+	gint64            number;
+	GList            *children;
+};
+
+G_DEFINE_BOXED_TYPE(EinaAdbRule, eina_adb_rule, eina_adb_rule_ref, eina_adb_rule_unref)
+
+static EinaAdbRule*
+rule_new(EinaAdbRuleField field, EinaAdbRuleOp op)
+{
+	EinaAdbRule *rule = g_slice_new0(EinaAdbRule);
+	rule->refs  = 1;
+	rule->field = field;
+	rule->op    = op;
+	return rule;
+}
+
+/**
+ * eina_adb_rule_new_group:
+ * @field: %EINA_ADB_RULE_ALL or %EINA_ADB_RULE_ANY
+ *
+ * Creates an empty group of rules, see eina_adb_rule_add(). An empty
+ * %EINA_ADB_RULE_ALL group matches every stream, an empty %EINA_ADB_RULE_ANY
+ * group matches none.
+ *
+ * Returns: (transfer full): The new #EinaAdbRule
+ */
+EinaAdbRule*
+eina_adb_rule_new_group(EinaAdbRuleField field)
+{
+	g_return_val_if_fail((field == EINA_ADB_RULE_ALL) || (field == EINA_ADB_RULE_ANY), NULL);
+	return rule_new(field, EINA_ADB_RULE_OP_EQ);
+}
+
+/**
+ * eina_adb_rule_new_not:
+ * @rule: (transfer none): An #EinaAdbRule
+ *
+ * Creates a rule negating @rule
+ *
+ * Returns: (transfer full): The new #EinaAdbRule
+ */
+EinaAdbRule*
+eina_adb_rule_new_not(EinaAdbRule *rule)
+{
+	g_return_val_if_fail(rule != NULL, NULL);
+
+	EinaAdbRule *self = rule_new(EINA_ADB_RULE_NOT, EINA_ADB_RULE_OP_EQ);
+	self->children = g_list_prepend(NULL, eina_adb_rule_ref(rule));
+	return self;
+}
+
+/**
+ * eina_adb_rule_new_tag:
+ * @tag: Tag to check, like %LOMO_TAG_ARTIST
+ * @op: Comparison, %EINA_ADB_RULE_OP_WITHIN is not valid for tags
+ * @value: Value to compare to
+ *
+ * Creates a rule comparing the value of @tag. Streams without @tag never
+ * match except for %EINA_ADB_RULE_OP_NE.
+ *
+ * Returns: (transfer full): The new #EinaAdbRule
+ */
+EinaAdbRule*
+eina_adb_rule_new_tag(const gchar *tag, EinaAdbRuleOp op, const gchar *value)
+{
+	g_return_val_if_fail(tag != NULL, NULL);
+	g_return_val_if_fail(value != NULL, NULL);
+	g_return_val_if_fail(op != EINA_ADB_RULE_OP_WITHIN, NULL);
+
+	EinaAdbRule *self = rule_new(EINA_ADB_RULE_TAG, op);
+	self->tag = g_strdup(tag);
+	self->str = g_strdup(value);
+	return self;
+}
+
+/**
+ * eina_adb_rule_new_number:
+ * @field: One of %EINA_ADB_RULE_RATING, %EINA_ADB_RULE_PLAY_COUNT,
+ *         %EINA_ADB_RULE_LAST_PLAYED or %EINA_ADB_RULE_ADDED
+ * @op: Comparison, %EINA_ADB_RULE_OP_WITHIN is only valid for dates and
+ *      %EINA_ADB_RULE_OP_CONTAINS is not valid
+ * @value: Value to compare to, in seconds for %EINA_ADB_RULE_OP_WITHIN
+ *
+ * Creates a rule comparing a numeric field
+ *
+ * Returns: (transfer full): The new #EinaAdbRule
+ */
+EinaAdbRule*
+eina_adb_rule_new_number(EinaAdbRuleField field, EinaAdbRuleOp op, gint64 value)
+{
+	g_return_val_if_fail((field >= EINA_ADB_RULE_RATING) && (field <= EINA_ADB_RULE_ADDED), NULL);
+	g_return_val_if_fail(op != EINA_ADB_RULE_OP_CONTAINS, NULL);
+	g_return_val_if_fail((op != EINA_ADB_RULE_OP_WITHIN) ||
+		(field == EINA_ADB_RULE_LAST_PLAYED) || (field == EINA_ADB_RULE_ADDED), NULL);
+
+	EinaAdbRule *self = rule_new(field, op);
+	self->number = value;
+	return self;
+}
+
+/**
+ * eina_adb_rule_add:
+ * @group: An #EinaAdbRule created with eina_adb_rule_new_group()
+ * @rule: (transfer none): Rule to add
+ *
+ * Adds @rule to @group
+ */
+void
+eina_adb_rule_add(EinaAdbRule *group, EinaAdbRule *rule)
+{
+	g_return_if_fail(group != NULL);
+	g_return_if_fail((group->field == EINA_ADB_RULE_ALL) || (group->field == EINA_ADB_RULE_ANY));
+	g_return_if_fail(rule != NULL);
+	g_return_if_fail(rule != group);
+
+	group->children = g_list_append(group->children, eina_adb_rule_ref(rule));
+}
+
+/**
+ * eina_adb_rule_ref:
+ * @rule: An #EinaAdbRule
+ *
+ * Adds a reference to @rule
+ *
+ * Returns: (transfer full): @rule
+ */
+EinaAdbRule*
+eina_adb_rule_ref(EinaAdbRule *rule)
+{
+	g_return_val_if_fail(rule != NULL, NULL);
+	g_atomic_int_inc(&rule->refs);
+	return rule;
+}
+
+/**
+ * eina_adb_rule_unref:
+ * @rule: An #EinaAdbRule
+ *
+ * Removes a reference from @rule, freeing it and its children when it drops
+ * to zero
+ */
+void
+eina_adb_rule_unref(EinaAdbRule *rule)
+{
+	g_return_if_fail(rule != NULL);
+	if (!g_atomic_int_dec_and_test(&rule->refs))
+		return;
+
+	gel_list_deep_free(rule->children, eina_adb_rule_unref);
+	g_free(rule->tag);
+	g_free(rule->str);
+	g_slice_free(EinaAdbRule, rule);
+}
+
+/*
+ * Compiler
+ */
+enum {
+	DEP_STREAMS  = 1 << 0,
+	DEP_METADATA = 1 << 1,
+	DEP_STARS    = 1 << 2
+};
+
+typedef struct {
+	gchar  *str;    // NULL for numbers
+	gint64  number;
+} Param;
+
+static const gchar *op_sql[] = {
+	[EINA_ADB_RULE_OP_EQ] = "=",
+	[EINA_ADB_RULE_OP_NE] = "<>",
+	[EINA_ADB_RULE_OP_LT] = "<",
+	[EINA_ADB_RULE_OP_LE] = "<=",
+	[EINA_ADB_RULE_OP_GT] = ">",
+	[EINA_ADB_RULE_OP_GE] = ">="
+};
+
+static void
+params_free(GArray *params)
+{
+	for (guint i = 0; i < params->len; i++)
+		g_free(g_array_index(params, Param, i).str);
+	g_array_free(params, TRUE);
+}
+
+static void
+params_add_str(GArray *params, gchar *str)
+{
+	Param p = { str, 0 };
+	g_array_append_val(params, p);
+}
+
+static void
+params_add_number(GArray *params, gint64 number)
+{
+	Param p = { NULL, number };
+	g_array_append_val(params, p);
+}
+
+static gchar *
+like_escape(const gchar *str)
+{
+	GString *ret = g_string_new("%");
+	for (const gchar *p = str; *p; p++)
+	{
+		if ((*p == '%') || (*p == '_') || (*p == '\\'))
+			g_string_append_c(ret, '\\');
+		g_string_append_c(ret, *p);
+	}
+	g_string_append_c(ret, '%');
+	return g_string_free(ret, FALSE);
+}
+
+// Whether an unrated stream (rating 0) matches a rating rule
+static gboolean
+rating_matches_unrated(EinaAdbRule *rule)
+{
+	switch (rule->op)
+	{
+	case EINA_ADB_RULE_OP_EQ:
+		return rule->number == 0;
+	case EINA_ADB_RULE_OP_NE:
+		return rule->number != 0;
+	case EINA_ADB_RULE_OP_LT:
+		return rule->number > 0;
+	case EINA_ADB_RULE_OP_LE:
+		return rule->number >= 0;
+	case EINA_ADB_RULE_OP_GT:
+		return rule->number < 0;
+	case EINA_ADB_RULE_OP_GE:
+		return rule->number <= 0;
+	default:
+		return FALSE;
+	}
+}
+
+static void
+rule_compile(EinaAdbRule *rule, GString *sql, GArray *params, guint *deps, gboolean has_stars)
+{
+	const gchar *column;
+
+	switch (rule->field)
+	{
+	case EINA_ADB_RULE_ALL:
+	case EINA_ADB_RULE_ANY:
+		if (!rule->children)
+		{
+			g_string_append(sql, (rule->field == EINA_ADB_RULE_ALL) ? "1" : "0");
+			break;
+		}
+		g_string_append_c(sql, '(');
+		for (GList *l = rule->children; l; l = l->next)
+		{
+			if (l != rule->children)
+				g_string_append(sql, (rule->field == EINA_ADB_RULE_ALL) ? " AND " : " OR ");
+			rule_compile((EinaAdbRule *) l->data, sql, params, deps, has_stars);
+		}
+		g_string_append_c(sql, ')');
+		break;
+
+	case EINA_ADB_RULE_NOT:
+		g_string_append(sql, "NOT (");
+		rule_compile((EinaAdbRule *) rule->children->data, sql, params, deps, has_stars);
+		g_string_append_c(sql, ')');
+		break;
+
+	case EINA_ADB_RULE_TAG:
+		*deps |= DEP_METADATA;
+		params_add_str(params, g_strdup(rule->tag));
+		if (rule->op == EINA_ADB_RULE_OP_CONTAINS)
+		{
+			g_string_append(sql, "s.sid IN (SELECT sid FROM metadata WHERE key = ? AND value LIKE ? ESCAPE '\\')");
+			params_add_str(params, like_escape(rule->str));
+		}
+		else if (rule->op == EINA_ADB_RULE_OP_NE)
+		{
+			g_string_append(sql, "s.sid NOT IN (SELECT sid FROM metadata WHERE key = ? AND value = ?)");
+			params_add_str(params, g_strdup(rule->str));
+		}
+		else
+		{
+			g_string_append_printf(sql, "s.sid IN (SELECT sid FROM metadata WHERE key = ? AND value %s ?)", op_sql[rule->op]);
+			params_add_str(params, g_strdup(rule->str));
+		}
+		break;
+
+	case EINA_ADB_RULE_RATING:
+		// Without the stars plugin everything is unrated. Depend on 'stars'
+		// anyway, the rule is compiled again once the table shows up
+		*deps |= DEP_STARS;
+		// Rules that leave unrated streams out are looked up from 'stars'
+		// instead of checking every stream
+		if (has_stars && !rating_matches_unrated(rule))
+			g_string_append_printf(sql, "s.sid IN (SELECT sid FROM stars WHERE rating %s ?)", op_sql[rule->op]);
+		else if (has_stars)
+			g_string_append_printf(sql, "COALESCE((SELECT rating FROM stars WHERE sid = s.sid), 0) %s ?", op_sql[rule->op]);
+		else
+			g_string_append_printf(sql, "0 %s ?", op_sql[rule->op]);
+		params_add_number(params, rule->number);
+		break;
+
+	case EINA_ADB_RULE_PLAY_COUNT:
+	case EINA_ADB_RULE_LAST_PLAYED:
+	case EINA_ADB_RULE_ADDED:
+		column = (rule->field == EINA_ADB_RULE_PLAY_COUNT)  ? "count"  :
+		         (rule->field == EINA_ADB_RULE_LAST_PLAYED) ? "played" : "timestamp";
+		if (rule->op == EINA_ADB_RULE_OP_WITHIN)
+			g_string_append_printf(sql, "s.%s >= STRFTIME('%%s', 'now') - ?", column);
+		else
+			g_string_append_printf(sql, "s.%s %s ?", column, op_sql[rule->op]);
+		params_add_number(params, rule->number);
+		break;
+	}
+}
+
+/*
+ * Smart playlist
+ */
+G_DEFINE_TYPE (EinaAdbSmartPlaylist, eina_adb_smart_playlist, G_TYPE_OBJECT)
+
+struct _EinaAdbSmartPlaylistPrivate {
+	EinaAdb     *adb;
+	EinaAdbRule *rule;
+	EinaAdbSmartPlaylistOrder order;
+	guint        limit;
+
+	// Compiled rule
+	gchar        *where;
+	GArray       *params; // <Param>
+	guint         deps;
+	gboolean      has_stars;
+
+	// Prepared statements
+	gchar        *sql;
+	sqlite3_stmt *stmt;
+	sqlite3_stmt *sid_stmt;
+
+	// Results
+	gboolean   loaded;
+	GArray    *sids; // <gint>
+	GPtrArray *uris; // <gchar*> NULL terminated
+
+	// Feed
+	LomoPlayer *feed_lomo;
+	gchar     **feed_uris;
+	guint       feed_pos;
+	gint        feed_index;
+	guint       feed_id;
+};
+
+enum {
+	CHANGED,
+	STREAM_ADDED,
+	STREAM_REMOVED,
+	LAST_SIGNAL
+};
+static guint smart_playlist_signals[LAST_SIGNAL] = { 0 };
+
+static void
+adb_changed_cb(EinaAdb *adb, const gchar *table, GArray *rowids, EinaAdbSmartPlaylist *self);
+
+static void
+playlist_finalize_stmts(EinaAdbSmartPlaylist *self)
+{
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	gel_free_and_invalidate(priv->stmt,     NULL, sqlite3_finalize);
+	gel_free_and_invalidate(priv->sid_stmt, NULL, sqlite3_finalize);
+	gel_free_and_invalidate(priv->sql,      NULL, g_free);
+}
+
+static void
+eina_adb_smart_playlist_dispose (GObject *object)
+{
+	EinaAdbSmartPlaylist *self = EINA_ADB_SMART_PLAYLIST(object);
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	eina_adb_smart_playlist_cancel_feed(self);
+	playlist_finalize_stmts(self);
+
+	if (priv->adb)
+	{
+		g_signal_handlers_disconnect_by_func(priv->adb, adb_changed_cb, self);
+		gel_free_and_invalidate(priv->adb, NULL, g_object_unref);
+	}
+	gel_free_and_invalidate(priv->rule,   NULL, eina_adb_rule_unref);
+	gel_free_and_invalidate(priv->where,  NULL, g_free);
+	gel_free_and_invalidate(priv->params, NULL, params_free);
+	gel_free_and_invalidate(priv->sids,   NULL, g_array_unref);
+	gel_free_and_invalidate(priv->uris,   NULL, g_ptr_array_unref);
+
+	G_OBJECT_CLASS (eina_adb_smart_playlist_parent_class)->dispose (object);
+}
+
+static void
+eina_adb_smart_playlist_class_init (EinaAdbSmartPlaylistClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (EinaAdbSmartPlaylistPrivate));
+
+	object_class->dispose = eina_adb_smart_playlist_dispose;
+
+	/**
+	 * EinaAdbSmartPlaylist::changed:
+	 * @smart_playlist: The #EinaAdbSmartPlaylist
+	 *
+	 * Emitted after the results are updated, positions obtained before may
+	 * be no longer valid
+	 */
+	smart_playlist_signals[CHANGED] = g_signal_new("changed",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbSmartPlaylistClass, changed),
+		NULL, NULL,
+		g_cclosure_marshal_VOID__VOID,
+		G_TYPE_NONE,
+		0);
+	/**
+	 * EinaAdbSmartPlaylist::stream-added:
+	 * @smart_playlist: The #EinaAdbSmartPlaylist
+	 * @position: Position of the new stream
+	 *
+	 * Emitted when a stream starts matching the rules on an incremental
+	 * update
+	 */
+	smart_playlist_signals[STREAM_ADDED] = g_signal_new("stream-added",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbSmartPlaylistClass, stream_added),
+		NULL, NULL,
+		g_cclosure_marshal_VOID__UINT,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_UINT);
+	/**
+	 * EinaAdbSmartPlaylist::stream-removed:
+	 * @smart_playlist: The #EinaAdbSmartPlaylist
+	 * @position: Position the stream had
+	 *
+	 * Emitted when a stream no longer matches the rules on an incremental
+	 * update
+	 */
+	smart_playlist_signals[STREAM_REMOVED] = g_signal_new("stream-removed",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbSmartPlaylistClass, stream_removed),
+		NULL, NULL,
+		g_cclosure_marshal_VOID__UINT,
+		G_TYPE_NONE,
+		1,
+		G_TYPE_UINT);
+}
+
+static void
+eina_adb_smart_playlist_init (EinaAdbSmartPlaylist *self)
+{
+	EinaAdbSmartPlaylistPrivate *priv = self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_ADB_SMART_PLAYLIST, EinaAdbSmartPlaylistPrivate));
+
+	priv->sids = g_array_new(FALSE, FALSE, sizeof(gint));
+	priv->uris = g_ptr_array_new_with_free_func(g_free);
+	g_ptr_array_add(priv->uris, NULL);
+}
+
+/**
+ * eina_adb_smart_playlist_new:
+ * @adb: An #EinaAdb
+ * @rule: (transfer none): Rules to match
+ *
+ * Creates a new #EinaAdbSmartPlaylist. Results are loaded on first access.
+ *
+ * Returns: (transfer full): The #EinaAdbSmartPlaylist
+ */
+EinaAdbSmartPlaylist*
+eina_adb_smart_playlist_new (EinaAdb *adb, EinaAdbRule *rule)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+	g_return_val_if_fail(rule != NULL, NULL);
+
+	EinaAdbSmartPlaylist *self = g_object_new (EINA_TYPE_ADB_SMART_PLAYLIST, NULL);
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	priv->adb  = g_object_ref(adb);
+	priv->rule = eina_adb_rule_ref(rule);
+	g_signal_connect(adb, "changed", (GCallback) adb_changed_cb, self);
+
+	return self;
+}
+
+static gboolean
+playlist_has_table(EinaAdbSmartPlaylist *self, const gchar *table)
+{
+	EinaAdbResult *res = eina_adb_query(self->priv->adb,
+		"SELECT 1 FROM sqlite_master WHERE type='table' AND name='%q';", table);
+	if (!res)
+		return FALSE;
+
+	gboolean ret = eina_adb_result_step(res);
+	g_object_unref(res);
+	return ret;
+}
+
+static void
+playlist_bind(sqlite3_stmt *stmt, GArray *params, gint first)
+{
+	for (guint i = 0; i < params->len; i++)
+	{
+		Param *p = &g_array_index(params, Param, i);
+		if (p->str)
+			sqlite3_bind_text(stmt, first + i, p->str, -1, SQLITE_STATIC);
+		else
+			sqlite3_bind_int64(stmt, first + i, p->number);
+	}
+}
+
+static gboolean
+playlist_prepare(EinaAdbSmartPlaylist *self)
+{
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+	if (priv->stmt)
+		return TRUE;
+
+	// Rating rules compiled before the stars plugin created its table
+	if (priv->where && (priv->deps & DEP_STARS) && !priv->has_stars && playlist_has_table(self, "stars"))
+	{
+		gel_free_and_invalidate(priv->where,  NULL, g_free);
+		gel_free_and_invalidate(priv->params, NULL, params_free);
+	}
+
+	if (!priv->where)
+	{
+		GString *where = g_string_new(NULL);
+		priv->params    = g_array_new(FALSE, FALSE, sizeof(Param));
+		priv->deps      = DEP_STREAMS;
+		priv->has_stars = playlist_has_table(self, "stars");
+		rule_compile(priv->rule, where, priv->params, &priv->deps, priv->has_stars);
+		priv->where = g_string_free(where, FALSE);
+	}
+
+	const gchar *order = NULL;
+	switch (priv->order)
+	{
+	case EINA_ADB_SMART_PLAYLIST_ORDER_NONE:
+		order = "s.sid";
+		break;
+	case EINA_ADB_SMART_PLAYLIST_ORDER_RANDOM:
+		order = "RANDOM()";
+		break;
+	case EINA_ADB_SMART_PLAYLIST_ORDER_MOST_PLAYED:
+		order = "s.count DESC, s.sid";
+		break;
+	case EINA_ADB_SMART_PLAYLIST_ORDER_RECENTLY_PLAYED:
+		order = "s.played DESC, s.sid";
+		break;
+	case EINA_ADB_SMART_PLAYLIST_ORDER_RECENTLY_ADDED:
+		order = "s.timestamp DESC, s.sid DESC";
+		break;
+	}
+
+	sqlite3 *db = eina_adb_get_handler(priv->adb);
+	priv->sql = g_strdup_printf("SELECT s.sid, s.uri FROM streams AS s WHERE %s ORDER BY %s%s;",
+		priv->where, order, priv->limit ? " LIMIT ?" : "");
+	if (sqlite3_prepare_v2(db, priv->sql, -1, &priv->stmt, NULL) != SQLITE_OK)
+	{
+		g_warning("Unable to prepare '%s': %s", priv->sql, sqlite3_errmsg(db));
+		playlist_finalize_stmts(self);
+		return FALSE;
+	}
+	playlist_bind(priv->stmt, priv->params, 1);
+	if (priv->limit)
+		sqlite3_bind_int(priv->stmt, priv->params->len + 1, (gint) priv->limit);
+
+	gchar *sid_sql = g_strdup_printf("SELECT s.sid, s.uri FROM streams AS s WHERE s.sid = ? AND %s;", priv->where);
+	if (sqlite3_prepare_v2(db, sid_sql, -1, &priv->sid_stmt, NULL) != SQLITE_OK)
+	{
+		g_warning("Unable to prepare '%s': %s", sid_sql, sqlite3_errmsg(db));
+		g_free(sid_sql);
+		playlist_finalize_stmts(self);
+		return FALSE;
+	}
+	playlist_bind(priv->sid_stmt, priv->params, 2);
+	g_free(sid_sql);
+
+	debug("Compiled to: %s", priv->sql);
+	return TRUE;
+}
+
+static void
+playlist_invalidate(EinaAdbSmartPlaylist *self)
+{
+	playlist_finalize_stmts(self);
+	if (self->priv->loaded)
+		eina_adb_smart_playlist_refresh(self);
+}
+
+/**
+ * eina_adb_smart_playlist_set_order:
+ * @self: An #EinaAdbSmartPlaylist
+ * @order: An #EinaAdbSmartPlaylistOrder
+ *
+ * Sets the order of the results
+ */
+void
+eina_adb_smart_playlist_set_order(EinaAdbSmartPlaylist *self, EinaAdbSmartPlaylistOrder order)
+{
+	g_return_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self));
+	if (self->priv->order == order)
+		return;
+
+	self->priv->order = order;
+	playlist_invalidate(self);
+}
+
+/**
+ * eina_adb_smart_playlist_get_order:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Gets the order of the results
+ *
+ * Returns: The #EinaAdbSmartPlaylistOrder
+ */
+EinaAdbSmartPlaylistOrder
+eina_adb_smart_playlist_get_order(EinaAdbSmartPlaylist *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self), EINA_ADB_SMART_PLAYLIST_ORDER_NONE);
+	return self->priv->order;
+}
+
+/**
+ * eina_adb_smart_playlist_set_limit:
+ * @self: An #EinaAdbSmartPlaylist
+ * @limit: Maximum number of streams, 0 for no limit
+ *
+ * Limits the number of results
+ */
+void
+eina_adb_smart_playlist_set_limit(EinaAdbSmartPlaylist *self, guint limit)
+{
+	g_return_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self));
+	if (self->priv->limit == limit)
+		return;
+
+	self->priv->limit = limit;
+	playlist_invalidate(self);
+}
+
+/**
+ * eina_adb_smart_playlist_get_limit:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Gets the maximum number of results
+ *
+ * Returns: The limit, 0 if there is none
+ */
+guint
+eina_adb_smart_playlist_get_limit(EinaAdbSmartPlaylist *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self), 0);
+	return self->priv->limit;
+}
+
+/**
+ * eina_adb_smart_playlist_get_sql:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Gets the SQL the rules were compiled to, mostly for debugging
+ *
+ * Returns: (transfer full): The SQL statement or %NULL if rules can't be
+ *          compiled
+ */
+gchar*
+eina_adb_smart_playlist_get_sql(EinaAdbSmartPlaylist *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self), NULL);
+	if (!playlist_prepare(self))
+		return NULL;
+	return g_strdup(self->priv->sql);
+}
+
+/**
+ * eina_adb_smart_playlist_refresh:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Runs the query again, there is no need to call this function since
+ * results are kept up to date.
+ */
+void
+eina_adb_smart_playlist_refresh(EinaAdbSmartPlaylist *self)
+{
+	g_return_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self));
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	g_array_set_size(priv->sids, 0);
+	g_ptr_array_set_size(priv->uris, 0);
+
+	if (playlist_prepare(self))
+	{
+		sqlite3_reset(priv->stmt);
+		while (sqlite3_step(priv->stmt) == SQLITE_ROW)
+		{
+			gint sid = sqlite3_column_int(priv->stmt, 0);
+			g_array_append_val(priv->sids, sid);
+			g_ptr_array_add(priv->uris, g_strdup((const gchar *) sqlite3_column_text(priv->stmt, 1)));
+		}
+	}
+	g_ptr_array_add(priv->uris, NULL);
+	priv->loaded = TRUE;
+
+	debug("Refreshed: %u streams", priv->sids->len);
+	g_signal_emit(self, smart_playlist_signals[CHANGED], 0);
+}
+
+static void
+playlist_ensure_loaded(EinaAdbSmartPlaylist *self)
+{
+	if (!self->priv->loaded)
+		eina_adb_smart_playlist_refresh(self);
+}
+
+/**
+ * eina_adb_smart_playlist_get_n_streams:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Gets the number of matching streams
+ *
+ * Returns: The number of streams
+ */
+guint
+eina_adb_smart_playlist_get_n_streams(EinaAdbSmartPlaylist *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self), 0);
+	playlist_ensure_loaded(self);
+	return self->priv->sids->len;
+}
+
+/**
+ * eina_adb_smart_playlist_get_sid:
+ * @self: An #EinaAdbSmartPlaylist
+ * @position: Position of the stream
+ *
+ * Gets the SID of the stream at @position
+ *
+ * Returns: The SID or -1
+ */
+gint
+eina_adb_smart_playlist_get_sid(EinaAdbSmartPlaylist *self, guint position)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self), -1);
+	playlist_ensure_loaded(self);
+	g_return_val_if_fail(position < self->priv->sids->len, -1);
+
+	return g_array_index(self->priv->sids, gint, position);
+}
+
+/**
+ * eina_adb_smart_playlist_get_uris:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Gets the URIs of the matching streams
+ *
+ * Returns: (transfer none) (array zero-terminated=1): The URIs, valid until
+ *          results change
+ */
+const gchar* const*
+eina_adb_smart_playlist_get_uris(EinaAdbSmartPlaylist *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self), NULL);
+	playlist_ensure_loaded(self);
+	return (const gchar* const*) self->priv->uris->pdata;
+}
+
+/*
+ * Incremental updates
+ */
+static gint
+playlist_find_sid(EinaAdbSmartPlaylist *self, gint sid, guint *insert_at)
+{
+	GArray *sids = self->priv->sids;
+
+	// Random order: unsorted, new streams go to the end
+	if (self->priv->order != EINA_ADB_SMART_PLAYLIST_ORDER_NONE)
+	{
+		*insert_at = sids->len;
+		for (guint i = 0; i < sids->len; i++)
+			if (g_array_index(sids, gint, i) == sid)
+				return i;
+		return -1;
+	}
+
+	guint lo = 0, hi = sids->len;
+	while (lo < hi)
+	{
+		guint mid = lo + (hi - lo) / 2;
+		gint v = g_array_index(sids, gint, mid);
+		if (v == sid)
+			return mid;
+		if (v < sid)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	*insert_at = lo;
+	return -1;
+}
+
+static gboolean
+playlist_update_sid(EinaAdbSmartPlaylist *self, gint sid)
+{
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	sqlite3_reset(priv->sid_stmt);
+	sqlite3_bind_int(priv->sid_stmt, 1, sid);
+	gboolean matches = (sqlite3_step(priv->sid_stmt) == SQLITE_ROW);
+
+	// Copy the URI and reset right away, an active statement keeps a read
+	// transaction open on the database
+	gchar *uri = matches ? g_strdup((const gchar *) sqlite3_column_text(priv->sid_stmt, 1)) : NULL;
+	sqlite3_reset(priv->sid_stmt);
+
+	guint insert_at = 0;
+	gint pos = playlist_find_sid(self, sid, &insert_at);
+
+	if (matches && (pos < 0))
+	{
+		g_array_insert_val(priv->sids, insert_at, sid);
+		g_ptr_array_add(priv->uris, NULL);
+		memmove(priv->uris->pdata + insert_at + 1, priv->uris->pdata + insert_at,
+			(priv->uris->len - 1 - insert_at) * sizeof(gpointer));
+		priv->uris->pdata[insert_at] = uri;
+
+		g_signal_emit(self, smart_playlist_signals[STREAM_ADDED], 0, insert_at);
+		return TRUE;
+	}
+	else if (!matches && (pos >= 0))
+	{
+		g_array_remove_index(priv->sids, pos);
+		g_ptr_array_remove_index(priv->uris, pos);
+
+		g_signal_emit(self, smart_playlist_signals[STREAM_REMOVED], 0, (guint) pos);
+		return TRUE;
+	}
+	g_free(uri);
+	return FALSE;
+}
+
+static void
+adb_changed_cb(EinaAdb *adb, const gchar *table, GArray *rowids, EinaAdbSmartPlaylist *self)
+{
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+	if (!priv->loaded)
+		return;
+
+	guint dep = 0;
+	if (g_str_equal(table, "streams"))
+		dep = DEP_STREAMS;
+	else if (g_str_equal(table, "metadata"))
+		dep = DEP_METADATA;
+	else if (g_str_equal(table, "stars"))
+		dep = DEP_STARS;
+	if (!(priv->deps & dep))
+		return;
+
+	// First ratings ever, statements are built again with the stars table
+	if ((dep == DEP_STARS) && !priv->has_stars)
+	{
+		playlist_invalidate(self);
+		return;
+	}
+
+	// 'streams' ROWIDs are SIDs, plays only touch a few of them
+	gboolean incremental = (dep == DEP_STREAMS) && rowids && (priv->limit == 0) &&
+		((priv->order == EINA_ADB_SMART_PLAYLIST_ORDER_NONE) || (priv->order == EINA_ADB_SMART_PLAYLIST_ORDER_RANDOM));
+	if (!incremental || !playlist_prepare(self))
+	{
+		eina_adb_smart_playlist_refresh(self);
+		return;
+	}
+
+	gboolean changed = FALSE;
+	for (guint i = 0; i < rowids->len; i++)
+		changed |= playlist_update_sid(self, (gint) g_array_index(rowids, gint64, i));
+	if (changed)
+		g_signal_emit(self, smart_playlist_signals[CHANGED], 0);
+}
+
+/*
+ * Feed
+ */
+static gboolean
+feed_idle(EinaAdbSmartPlaylist *self)
+{
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	gchar **batch = priv->feed_uris + priv->feed_pos;
+	guint n = 0;
+	while ((n < FEED_BATCH_SIZE) && batch[n])
+		n++;
+
+	gchar *saved = batch[n];
+	batch[n] = NULL;
+	lomo_player_insert_strv(priv->feed_lomo, (const gchar *const *) batch,
+		(priv->feed_index < 0) ? -1 : priv->feed_index + (gint) priv->feed_pos);
+	batch[n] = saved;
+
+	priv->feed_pos += n;
+	if (priv->feed_uris[priv->feed_pos])
+		return TRUE;
+
+	priv->feed_id = 0;
+	eina_adb_smart_playlist_cancel_feed(self);
+	return FALSE;
+}
+
+/**
+ * eina_adb_smart_playlist_feed:
+ * @self: An #EinaAdbSmartPlaylist
+ * @lomo: A #LomoPlayer
+ * @index: Position in @lomo to insert at, -1 to append
+ *
+ * Inserts the current results into @lomo in batches from the main loop, so
+ * large playlists don't block the UI. Any previous feed is cancelled.
+ */
+void
+eina_adb_smart_playlist_feed(EinaAdbSmartPlaylist *self, LomoPlayer *lomo, gint index)
+{
+	g_return_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self));
+	g_return_if_fail(LOMO_IS_PLAYER(lomo));
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	eina_adb_smart_playlist_cancel_feed(self);
+
+	playlist_ensure_loaded(self);
+	if (priv->sids->len == 0)
+		return;
+
+	priv->feed_lomo  = g_object_ref(lomo);
+	priv->feed_uris  = g_strdupv((gchar **) priv->uris->pdata);
+	priv->feed_pos   = 0;
+	priv->feed_index = index;
+
+	// First batch now, so playback can start right away
+	if (feed_idle(self))
+		priv->feed_id = g_idle_add((GSourceFunc) feed_idle, self);
+}
+
+/**
+ * eina_adb_smart_playlist_cancel_feed:
+ * @self: An #EinaAdbSmartPlaylist
+ *
+ * Stops inserting streams started by eina_adb_smart_playlist_feed()
+ */
+void
+eina_adb_smart_playlist_cancel_feed(EinaAdbSmartPlaylist *self)
+{
+	g_return_if_fail(EINA_IS_ADB_SMART_PLAYLIST(self));
+	EinaAdbSmartPlaylistPrivate *priv = self->priv;
+
+	if (priv->feed_id)
+	{
+		g_source_remove(priv->feed_id);
+		priv->feed_id = 0;
+	}
+	gel_free_and_invalidate(priv->feed_uris, NULL, g_strfreev);
+	gel_free_and_invalidate(priv->feed_lomo, NULL, g_object_unref);
+}
@@ -0,0 +1,152 @@
+/*
+ * eina/adb/eina-adb-smart-playlist.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EINA_ADB_SMART_PLAYLIST
+#define _EINA_ADB_SMART_PLAYLIST
+
+#include <glib-object.h>
+#include <eina/adb/eina-adb.h>
+
+G_BEGIN_DECLS
+
+/**
+ * EinaAdbRuleField:
+ * @EINA_ADB_RULE_ALL: Group, matches if all children match
+ * @EINA_ADB_RULE_ANY: Group, matches if any child matches
+ * @EINA_ADB_RULE_NOT: Matches if its only child doesn't
+ * @EINA_ADB_RULE_TAG: Value of a tag
+ * @EINA_ADB_RULE_RATING: Rating from the stars plugin, 0 if unrated
+ * @EINA_ADB_RULE_PLAY_COUNT: Number of times the stream was played
+ * @EINA_ADB_RULE_LAST_PLAYED: Last time the stream was played, as a UNIX timestamp
+ * @EINA_ADB_RULE_ADDED: Time the stream was added, as a UNIX timestamp
+ *
+ * What a #EinaAdbRule checks
+ */
+typedef enum {
+	EINA_ADB_RULE_ALL = 0,
+	EINA_ADB_RULE_ANY,
+	EINA_ADB_RULE_NOT,
+	EINA_ADB_RULE_TAG,
+	EINA_ADB_RULE_RATING,
+	EINA_ADB_RULE_PLAY_COUNT,
+	EINA_ADB_RULE_LAST_PLAYED,
+	EINA_ADB_RULE_ADDED
+} EinaAdbRuleField;
+
+/**
+ * EinaAdbRuleOp:
+ * @EINA_ADB_RULE_OP_EQ: Equal to
+ * @EINA_ADB_RULE_OP_NE: Not equal to
+ * @EINA_ADB_RULE_OP_LT: Less than
+ * @EINA_ADB_RULE_OP_LE: Less than or equal to
+ * @EINA_ADB_RULE_OP_GT: Greater than
+ * @EINA_ADB_RULE_OP_GE: Greater than or equal to
+ * @EINA_ADB_RULE_OP_CONTAINS: Tag value contains the string, case insensitive
+ * @EINA_ADB_RULE_OP_WITHIN: Date is within the last given seconds
+ *
+ * Comparison done by a #EinaAdbRule
+ */
+typedef enum {
+	EINA_ADB_RULE_OP_EQ = 0,
+	EINA_ADB_RULE_OP_NE,
+	EINA_ADB_RULE_OP_LT,
+	EINA_ADB_RULE_OP_LE,
+	EINA_ADB_RULE_OP_GT,
+	EINA_ADB_RULE_OP_GE,
+	EINA_ADB_RULE_OP_CONTAINS,
+	EINA_ADB_RULE_OP_WITHIN
+} EinaAdbRuleOp;
+
+/**
+ * EinaAdbSmartPlaylistOrder:
+ * @EINA_ADB_SMART_PLAYLIST_ORDER_NONE: Order of insertion into the database
+ * @EINA_ADB_SMART_PLAYLIST_ORDER_RANDOM: Shuffled
+ * @EINA_ADB_SMART_PLAYLIST_ORDER_MOST_PLAYED: Higher play counts first
+ * @EINA_ADB_SMART_PLAYLIST_ORDER_RECENTLY_PLAYED: Last played first
+ * @EINA_ADB_SMART_PLAYLIST_ORDER_RECENTLY_ADDED: Last added first
+ *
+ * Order of the streams in a #EinaAdbSmartPlaylist
+ */
+typedef enum {
+	EINA_ADB_SMART_PLAYLIST_ORDER_NONE = 0,
+	EINA_ADB_SMART_PLAYLIST_ORDER_RANDOM,
+	EINA_ADB_SMART_PLAYLIST_ORDER_MOST_PLAYED,
+	EINA_ADB_SMART_PLAYLIST_ORDER_RECENTLY_PLAYED,
+	EINA_ADB_SMART_PLAYLIST_ORDER_RECENTLY_ADDED
+} EinaAdbSmartPlaylistOrder;
+
+#define EINA_TYPE_ADB_RULE eina_adb_rule_get_type()
+
+typedef struct _EinaAdbRule EinaAdbRule;
+
+GType        eina_adb_rule_get_type (void);
+
+EinaAdbRule* eina_adb_rule_new_group (EinaAdbRuleField field);
+EinaAdbRule* eina_adb_rule_new_not   (EinaAdbRule *rule);
+EinaAdbRule* eina_adb_rule_new_tag   (const gchar *tag, EinaAdbRuleOp op, const gchar *value);
+EinaAdbRule* eina_adb_rule_new_number(EinaAdbRuleField field, EinaAdbRuleOp op, gint64 value);
+
+void         eina_adb_rule_add  (EinaAdbRule *group, EinaAdbRule *rule);
+EinaAdbRule* eina_adb_rule_ref  (EinaAdbRule *rule);
+void         eina_adb_rule_unref(EinaAdbRule *rule);
+
+#define EINA_TYPE_ADB_SMART_PLAYLIST eina_adb_smart_playlist_get_type()
+
+#define EINA_ADB_SMART_PLAYLIST(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), EINA_TYPE_ADB_SMART_PLAYLIST, EinaAdbSmartPlaylist))
+#define EINA_ADB_SMART_PLAYLIST_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), EINA_TYPE_ADB_SMART_PLAYLIST, EinaAdbSmartPlaylistClass))
+#define EINA_IS_ADB_SMART_PLAYLIST(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EINA_TYPE_ADB_SMART_PLAYLIST))
+#define EINA_IS_ADB_SMART_PLAYLIST_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EINA_TYPE_ADB_SMART_PLAYLIST))
+#define EINA_ADB_SMART_PLAYLIST_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), EINA_TYPE_ADB_SMART_PLAYLIST, EinaAdbSmartPlaylistClass))
+
+typedef struct _EinaAdbSmartPlaylistPrivate EinaAdbSmartPlaylistPrivate;
+typedef struct {
+	/*<private>*/
+	GObject parent;
+	EinaAdbSmartPlaylistPrivate *priv;
+} EinaAdbSmartPlaylist;
+
+typedef struct {
+	/*<private>*/
+	GObjectClass parent_class;
+	void (*changed)       (EinaAdbSmartPlaylist *self);
+	void (*stream_added)  (EinaAdbSmartPlaylist *self, guint position);
+	void (*stream_removed)(EinaAdbSmartPlaylist *self, guint position);
+} EinaAdbSmartPlaylistClass;
+
+GType eina_adb_smart_playlist_get_type (void);
+
+EinaAdbSmartPlaylist* eina_adb_smart_playlist_new (EinaAdb *adb, EinaAdbRule *rule);
+
+void                      eina_adb_smart_playlist_set_order(EinaAdbSmartPlaylist *self, EinaAdbSmartPlaylistOrder order);
+EinaAdbSmartPlaylistOrder eina_adb_smart_playlist_get_order(EinaAdbSmartPlaylist *self);
+void                      eina_adb_smart_playlist_set_limit(EinaAdbSmartPlaylist *self, guint limit);
+guint                     eina_adb_smart_playlist_get_limit(EinaAdbSmartPlaylist *self);
+
+gchar*              eina_adb_smart_playlist_get_sql  (EinaAdbSmartPlaylist *self);
+void                eina_adb_smart_playlist_refresh  (EinaAdbSmartPlaylist *self);
+guint               eina_adb_smart_playlist_get_n_streams(EinaAdbSmartPlaylist *self);
+gint                eina_adb_smart_playlist_get_sid  (EinaAdbSmartPlaylist *self, guint position);
+const gchar* const* eina_adb_smart_playlist_get_uris (EinaAdbSmartPlaylist *self);
+
+void eina_adb_smart_playlist_feed       (EinaAdbSmartPlaylist *self, LomoPlayer *lomo, gint index);
+void eina_adb_smart_playlist_cancel_feed(EinaAdbSmartPlaylist *self);
+
+G_END_DECLS
+
+#endif /* _EINA_ADB_SMART_PLAYLIST */
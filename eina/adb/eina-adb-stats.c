@@ -0,0 +1,224 @@
+/*
+ * eina/adb/eina-adb-stats.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:eina-adb-stats
+ * @short_description: Play counters
+ * @see_also: #EinaAdb
+ *
+ * Play counts rolled up per SID so top-N and recency queries are answered
+ * from indexes instead of aggregating 'recent_plays'.
+ *
+ * All time counters and last played timestamps are the 'count' and
+ * 'played' columns of 'streams'. Counters per day and per week live in
+ * 'play_buckets', one row per SID, span and bucket. Both are updated by
+ * eina_adb_stats_add_play() along with 'recent_plays'.
+ */
+
+#include "eina-adb-stats.h"
+#include <gel/gel.h>
+#include <glib/gi18n.h>
+
+// 1970-01-01 was a thursday, weeks start on monday
+#define SECS_PER_DAY    86400
+#define EPOCH_DAY_SHIFT 3
+
+/**
+ * eina_adb_stats_get_bucket:
+ * @span: An #EinaAdbStatsSpan
+ * @timestamp: Unix timestamp
+ *
+ * Gets the bucket of @span holding @timestamp: days or weeks since epoch
+ *
+ * Returns: The bucket, 0 for %EINA_ADB_STATS_SPAN_ALL
+ */
+gint64
+eina_adb_stats_get_bucket(EinaAdbStatsSpan span, gint64 timestamp)
+{
+	switch (span)
+	{
+	case EINA_ADB_STATS_SPAN_DAY:
+		return timestamp / SECS_PER_DAY;
+	case EINA_ADB_STATS_SPAN_WEEK:
+		return (timestamp / SECS_PER_DAY + EPOCH_DAY_SHIFT) / 7;
+	case EINA_ADB_STATS_SPAN_ALL:
+		return 0;
+	}
+	g_return_val_if_reached(0);
+}
+
+/**
+ * eina_adb_stats_add_play:
+ * @adb: An #EinaAdb
+ * @sid: SID of the played stream
+ * @timestamp: Unix timestamp of the play
+ *
+ * Records a play of @sid, all counters are updated in one transaction
+ *
+ * Returns: %TRUE on success, %FALSE otherwise
+ */
+gboolean
+eina_adb_stats_add_play(EinaAdb *adb, gint sid, gint64 timestamp)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), FALSE);
+	g_return_val_if_fail(sid >= 0, FALSE);
+
+	gint64 day  = eina_adb_stats_get_bucket(EINA_ADB_STATS_SPAN_DAY,  timestamp);
+	gint64 week = eina_adb_stats_get_bucket(EINA_ADB_STATS_SPAN_WEEK, timestamp);
+	gchar *qs[] = {
+		sqlite3_mprintf("UPDATE streams SET played = MAX(played, %lld), count = (count + 1) WHERE sid = %d;",
+			(long long) timestamp, sid),
+		sqlite3_mprintf("INSERT OR IGNORE INTO recent_plays (sid,timestamp) VALUES(%d, %lld);",
+			sid, (long long) timestamp),
+		sqlite3_mprintf("INSERT OR IGNORE INTO play_buckets (sid,span,bucket) VALUES(%d, %d, %lld);",
+			sid, EINA_ADB_STATS_SPAN_DAY, (long long) day),
+		sqlite3_mprintf("UPDATE play_buckets SET count = (count + 1) WHERE span = %d AND bucket = %lld AND sid = %d;",
+			EINA_ADB_STATS_SPAN_DAY, (long long) day, sid),
+		sqlite3_mprintf("INSERT OR IGNORE INTO play_buckets (sid,span,bucket) VALUES(%d, %d, %lld);",
+			sid, EINA_ADB_STATS_SPAN_WEEK, (long long) week),
+		sqlite3_mprintf("UPDATE play_buckets SET count = (count + 1) WHERE span = %d AND bucket = %lld AND sid = %d;",
+			EINA_ADB_STATS_SPAN_WEEK, (long long) week, sid),
+		NULL
+	};
+
+	GError *error = NULL;
+	gboolean ret = eina_adb_query_block_exec(adb, qs, &error);
+	if (!ret)
+	{
+		g_warning(N_("Unable to record play of SID %d: %s"), sid, error->message);
+		g_error_free(error);
+	}
+
+	for (guint i = 0; qs[i] != NULL; i++)
+		sqlite3_free(qs[i]);
+
+	return ret;
+}
+
+/**
+ * eina_adb_stats_get_plays:
+ * @adb: An #EinaAdb
+ * @sid: SID of the stream
+ * @span: An #EinaAdbStatsSpan
+ * @timestamp: Unix timestamp inside the wanted bucket, ignored for
+ *             %EINA_ADB_STATS_SPAN_ALL
+ * @count: (out) (allow-none): Return location for the number of plays
+ * @last_played: (out) (allow-none): Return location for the timestamp of
+ *               the last play, 0 if never played
+ *
+ * Gets the play counters of @sid
+ *
+ * Returns: %TRUE if @sid is known, %FALSE otherwise
+ */
+gboolean
+eina_adb_stats_get_plays(EinaAdb *adb, gint sid, EinaAdbStatsSpan span, gint64 timestamp,
+	guint *count, gint64 *last_played)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), FALSE);
+
+	EinaAdbResult *r = (span == EINA_ADB_STATS_SPAN_ALL) ?
+		eina_adb_query(adb, "SELECT count,played FROM streams WHERE sid = %d;", sid) :
+		eina_adb_query(adb,
+			"SELECT IFNULL((SELECT count FROM play_buckets WHERE span = %d AND bucket = %lld AND sid = %d), 0),played "
+			"FROM streams WHERE sid = %d;",
+			span, (long long) eina_adb_stats_get_bucket(span, timestamp), sid, sid);
+
+	guint  c = 0;
+	gint64 t = 0;
+	gboolean found = r && eina_adb_result_step(r);
+	if (found)
+		eina_adb_result_get(r, 0, G_TYPE_UINT, &c, 1, G_TYPE_INT64, &t, -1);
+	gel_free_and_invalidate(r, NULL, g_object_unref);
+
+	if (count)
+		*count = c;
+	if (last_played)
+		*last_played = t;
+
+	return found;
+}
+
+static GArray*
+stats_collect_sids(EinaAdbResult *r)
+{
+	GArray *ret = g_array_new(FALSE, FALSE, sizeof(gint));
+	if (r == NULL)
+		return ret;
+
+	gint n;
+	while ((n = eina_adb_result_fetch(r, 256)) > 0)
+	{
+		const gint64 *sids = eina_adb_result_get_int64_column(r, 0, NULL);
+		for (gint i = 0; i < n; i++)
+		{
+			gint sid = (gint) sids[i];
+			g_array_append_val(ret, sid);
+		}
+	}
+	g_object_unref(r);
+
+	return ret;
+}
+
+/**
+ * eina_adb_stats_top:
+ * @adb: An #EinaAdb
+ * @span: An #EinaAdbStatsSpan
+ * @timestamp: Unix timestamp inside the wanted bucket, ignored for
+ *             %EINA_ADB_STATS_SPAN_ALL
+ * @n: Number of SIDs to get, 0 for all
+ *
+ * Gets the most played SIDs in the bucket of @span holding @timestamp
+ *
+ * Returns: (transfer full) (element-type gint): The SIDs, most played first
+ */
+GArray*
+eina_adb_stats_top(EinaAdb *adb, EinaAdbStatsSpan span, gint64 timestamp, guint n)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+
+	gint limit = n ? (gint) MIN(n, G_MAXINT) : -1;
+	EinaAdbResult *r = (span == EINA_ADB_STATS_SPAN_ALL) ?
+		eina_adb_query(adb, "SELECT sid FROM streams WHERE count > 0 ORDER BY count DESC LIMIT %d;", limit) :
+		eina_adb_query(adb, "SELECT sid FROM play_buckets WHERE span = %d AND bucket = %lld ORDER BY count DESC LIMIT %d;",
+			span, (long long) eina_adb_stats_get_bucket(span, timestamp), limit);
+
+	return stats_collect_sids(r);
+}
+
+/**
+ * eina_adb_stats_recent:
+ * @adb: An #EinaAdb
+ * @since: Unix timestamp, older plays are ignored
+ * @n: Number of SIDs to get, 0 for all
+ *
+ * Gets the SIDs played since @since
+ *
+ * Returns: (transfer full) (element-type gint): The SIDs, last played first
+ */
+GArray*
+eina_adb_stats_recent(EinaAdb *adb, gint64 since, guint n)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+
+	gint limit = n ? (gint) MIN(n, G_MAXINT) : -1;
+	return stats_collect_sids(eina_adb_query(adb,
+		"SELECT sid FROM streams WHERE played > 0 AND played >= %lld ORDER BY played DESC LIMIT %d;",
+		(long long) since, limit));
+}
@@ -0,0 +1,52 @@
+/*
+ * eina/adb/eina-adb-stats.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EINA_ADB_STATS_H__
+#define __EINA_ADB_STATS_H__
+
+#include <eina/adb/eina-adb.h>
+
+G_BEGIN_DECLS
+
+/**
+ * EinaAdbStatsSpan:
+ * @EINA_ADB_STATS_SPAN_ALL: Whole history
+ * @EINA_ADB_STATS_SPAN_DAY: Day (UTC) of the timestamp
+ * @EINA_ADB_STATS_SPAN_WEEK: Week, starting on monday, of the timestamp
+ *
+ * Period covered by eina_adb_stats_top()
+ */
+typedef enum {
+	EINA_ADB_STATS_SPAN_ALL = 0,
+	EINA_ADB_STATS_SPAN_DAY,
+	EINA_ADB_STATS_SPAN_WEEK
+} EinaAdbStatsSpan;
+
+gint64   eina_adb_stats_get_bucket(EinaAdbStatsSpan span, gint64 timestamp);
+
+gboolean eina_adb_stats_add_play (EinaAdb *adb, gint sid, gint64 timestamp);
+gboolean eina_adb_stats_get_plays(EinaAdb *adb, gint sid, EinaAdbStatsSpan span, gint64 timestamp,
+	guint *count, gint64 *last_played);
+
+GArray*  eina_adb_stats_top   (EinaAdb *adb, EinaAdbStatsSpan span, gint64 timestamp, guint n);
+GArray*  eina_adb_stats_recent(EinaAdb *adb, gint64 since, guint n);
+
+G_END_DECLS
+
+#endif
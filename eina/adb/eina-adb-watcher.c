@@ -0,0 +1,903 @@
+/*
+ * eina/adb/eina-adb-watcher.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:eina-adb-watcher
+ * @short_description: Keeps #EinaAdb in sync with the library on disk
+ * @see_also: #EinaAdb, #EinaAdbImporter
+ *
+ * #EinaAdbWatcher monitors every directory below the library roots with a
+ * #GFileMonitor. Events are coalesced until the library has been quiet for
+ * a moment, then flushed at once: new and changed files are handed to an
+ * #EinaAdbImporter, which only parses files whose modification time or size
+ * changed, deleted files or directories are removed from 'streams' and
+ * every table referencing it, and renamed ones keep their stream with the
+ * new URI, all in one transaction.
+ *
+ * Roots are stored in the database and watched again the next time the
+ * watcher is created. Changes made while nobody was watching are picked
+ * by eina_adb_watcher_rescan(), whose walk also sets up the monitors when
+ * it's called right after creating the watcher.
+ */
+
+#include "eina-adb-watcher.h"
+#include "eina-adb-importer.h"
+#include <string.h>
+#include <glib/gi18n.h>
+#include <gel/gel.h>
+#include <gel/gel-io.h>
+#include <eina/core/eina-file-utils.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaAdbWatcher"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// Seconds without events before flushing, and upper limit while events
+// keep coming
+#define FLUSH_DELAY     2
+#define FLUSH_MAX_DELAY 30
+
+// Removed files and directories per statement
+#define REMOVE_CHUNK      512
+#define REMOVE_TREE_CHUNK 64
+
+G_DEFINE_TYPE (EinaAdbWatcher, eina_adb_watcher, G_TYPE_OBJECT)
+
+typedef enum {
+	ACTION_UPDATE = 1,
+	ACTION_REMOVE,
+	ACTION_REMOVE_TREE
+} Action;
+
+typedef struct {
+	gchar    *from;
+	gchar    *to;
+	gboolean  tree;
+} Move;
+
+struct _EinaAdbWatcherPrivate {
+	EinaAdb         *adb;       // Not owned, the watcher lives in its data
+	GPtrArray       *roots;     // <gchar*> URIs
+	GHashTable      *monitors;  // Directory URI -> GFileMonitor
+	GList           *scanners;  // <GelIOScanner> walking directories
+	guint            monitor_errors;
+	guint            watch_id;  // Initial walk, unless a rescan does it
+
+	GHashTable      *pending;   // URI -> Action, last event wins
+	GQueue          *moves;     // <Move>, applied in order before pending
+	GTimer          *pending_timer;
+	guint            flush_id;
+
+	EinaAdbImporter *importer;  // Only while importing, it refs adb
+	guint            removed;
+	gboolean         rescan;    // Requested while importing
+};
+
+enum {
+	FLUSHED,
+	LAST_SIGNAL
+};
+static guint watcher_signals[LAST_SIGNAL] = { 0 };
+
+static void
+watcher_scan(EinaAdbWatcher *self, const gchar *uri, gboolean import);
+static void
+watcher_scanner_finish_cb(GelIOScanner *scanner, GList *forest, EinaAdbWatcher *self);
+static void
+watcher_scanner_error_cb(GelIOScanner *scanner, GFile *source, GError *error, EinaAdbWatcher *self);
+static void
+watcher_monitor_changed_cb(GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, EinaAdbWatcher *self);
+static void
+watcher_importer_finished_cb(EinaAdbImporter *importer, guint imported, guint skipped, EinaAdbWatcher *self);
+static void
+watcher_importer_scanned_cb(EinaAdbImporter *importer, GList *forest, EinaAdbWatcher *self);
+
+static gboolean
+watcher_unref_idle(GObject *object)
+{
+	g_object_unref(object);
+	return FALSE;
+}
+
+static void
+move_free(Move *move)
+{
+	g_free(move->from);
+	g_free(move->to);
+	g_slice_free(Move, move);
+}
+
+static void
+monitor_free(GFileMonitor *monitor)
+{
+	// May be called from its own signal handler
+	g_signal_handlers_disconnect_matched(monitor, G_SIGNAL_MATCH_FUNC, 0, 0, NULL, watcher_monitor_changed_cb, NULL);
+	g_file_monitor_cancel(monitor);
+	g_idle_add((GSourceFunc) watcher_unref_idle, monitor);
+}
+
+static void
+watcher_drop_scanner(GelIOScanner *scanner, EinaAdbWatcher *self)
+{
+	g_signal_handlers_disconnect_by_func(scanner, watcher_scanner_finish_cb, self);
+	g_signal_handlers_disconnect_by_func(scanner, watcher_scanner_error_cb,  self);
+	g_idle_add((GSourceFunc) watcher_unref_idle, scanner);
+}
+
+static void
+eina_adb_watcher_dispose (GObject *object)
+{
+	EinaAdbWatcher *self = EINA_ADB_WATCHER(object);
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	if (priv->flush_id)
+	{
+		g_source_remove(priv->flush_id);
+		priv->flush_id = 0;
+	}
+	if (priv->watch_id)
+	{
+		g_source_remove(priv->watch_id);
+		priv->watch_id = 0;
+	}
+	if (priv->scanners)
+	{
+		g_list_foreach(priv->scanners, (GFunc) watcher_drop_scanner, self);
+		g_list_free(priv->scanners);
+		priv->scanners = NULL;
+	}
+	if (priv->importer)
+	{
+		g_signal_handlers_disconnect_by_func(priv->importer, watcher_importer_finished_cb, self);
+		g_signal_handlers_disconnect_by_func(priv->importer, watcher_importer_scanned_cb,  self);
+		eina_adb_importer_cancel(priv->importer);
+		gel_free_and_invalidate(priv->importer, NULL, g_object_unref);
+	}
+	gel_free_and_invalidate(priv->monitors,      NULL, g_hash_table_destroy);
+	gel_free_and_invalidate(priv->pending,       NULL, g_hash_table_destroy);
+	if (priv->moves)
+	{
+		g_queue_foreach(priv->moves, (GFunc) move_free, NULL);
+		gel_free_and_invalidate(priv->moves, NULL, g_queue_free);
+	}
+	gel_free_and_invalidate(priv->pending_timer, NULL, g_timer_destroy);
+	gel_free_and_invalidate(priv->roots,         NULL, g_ptr_array_unref);
+
+	G_OBJECT_CLASS (eina_adb_watcher_parent_class)->dispose (object);
+}
+
+static void
+eina_adb_watcher_class_init (EinaAdbWatcherClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (EinaAdbWatcherPrivate));
+
+	object_class->dispose = eina_adb_watcher_dispose;
+
+	/**
+	 * EinaAdbWatcher::flushed:
+	 * @watcher: The #EinaAdbWatcher
+	 * @updated: Files written to the database
+	 * @removed: Streams removed from the database
+	 *
+	 * Emitted after a batch of changes has been applied
+	 */
+	watcher_signals[FLUSHED] = g_signal_new("flushed",
+		G_OBJECT_CLASS_TYPE(object_class),
+		G_SIGNAL_RUN_LAST,
+		G_STRUCT_OFFSET(EinaAdbWatcherClass, flushed),
+		NULL, NULL,
+		gel_marshal_VOID__UINT_UINT,
+		G_TYPE_NONE,
+		2,
+		G_TYPE_UINT, G_TYPE_UINT);
+}
+
+static void
+eina_adb_watcher_init (EinaAdbWatcher *self)
+{
+	EinaAdbWatcherPrivate *priv = self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_ADB_WATCHER, EinaAdbWatcherPrivate));
+
+	priv->roots         = g_ptr_array_new_with_free_func(g_free);
+	priv->monitors      = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) monitor_free);
+	priv->pending       = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	priv->moves         = g_queue_new();
+	priv->pending_timer = g_timer_new();
+}
+
+static gboolean
+upgrade_1(EinaAdb *adb, GError **error)
+{
+	gchar *qs[] = {
+		"CREATE TABLE IF NOT EXISTS library_roots ("
+		"	uri VARCHAR(1024) PRIMARY KEY"
+		");",
+		NULL
+	};
+	return eina_adb_query_block_exec(adb, qs, error);
+}
+
+static EinaAdbFunc upgrade_funcs[] = { upgrade_1, NULL };
+
+static gboolean
+watcher_watch_roots_cb(EinaAdbWatcher *self)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	priv->watch_id = 0;
+	for (guint i = 0; i < priv->roots->len; i++)
+		watcher_scan(self, g_ptr_array_index(priv->roots, i), FALSE);
+	return FALSE;
+}
+
+/**
+ * eina_adb_get_watcher:
+ * @adb: An #EinaAdb
+ *
+ * Gets the #EinaAdbWatcher for @adb, it's created on first use and lives
+ * as long as @adb. Stored roots are watched from then on, the walk is left
+ * to eina_adb_watcher_rescan() if it's called before returning to the main
+ * loop.
+ *
+ * Returns: (transfer none): The #EinaAdbWatcher
+ */
+EinaAdbWatcher*
+eina_adb_get_watcher(EinaAdb *adb)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+
+	EinaAdbWatcher *self = g_object_get_data((GObject *) adb, "eina-adb-watcher");
+	if (self)
+		return self;
+
+	self = g_object_new(EINA_TYPE_ADB_WATCHER, NULL);
+	self->priv->adb = adb;
+	g_object_set_data_full((GObject *) adb, "eina-adb-watcher", self, g_object_unref);
+
+	GError *error = NULL;
+	if (!eina_adb_upgrade_schema(adb, "watcher", upgrade_funcs, &error))
+	{
+		g_warning(N_("Unable to upgrade watcher schema: %s"), error ? error->message : N_("No error message"));
+		if (error)
+			g_error_free(error);
+		return self;
+	}
+
+	EinaAdbResult *r = eina_adb_query_raw(adb, "SELECT uri FROM library_roots;");
+	gchar *uri;
+	while (r && eina_adb_result_step(r))
+	{
+		eina_adb_result_get(r, 0, G_TYPE_STRING, &uri, -1);
+		g_ptr_array_add(self->priv->roots, uri);
+	}
+	gel_free_and_invalidate(r, NULL, g_object_unref);
+
+	if (self->priv->roots->len)
+		self->priv->watch_id = g_idle_add((GSourceFunc) watcher_watch_roots_cb, self);
+
+	return self;
+}
+
+/*
+ * Roots
+ */
+static gboolean
+uri_is_below(const gchar *uri, const gchar *dir)
+{
+	gsize len = strlen(dir);
+	return (strncmp(uri, dir, len) == 0) && ((uri[len] == '\0') || (uri[len] == '/'));
+}
+
+static gboolean
+watcher_unwatch_cb(const gchar *uri, GFileMonitor *monitor, const gchar *dir)
+{
+	return uri_is_below(uri, dir);
+}
+
+static void
+watcher_unwatch_tree(EinaAdbWatcher *self, const gchar *dir)
+{
+	g_hash_table_foreach_remove(self->priv->monitors, (GHRFunc) watcher_unwatch_cb, (gpointer) dir);
+}
+
+/**
+ * eina_adb_watcher_add_root:
+ * @self: An #EinaAdbWatcher
+ * @uri: URI of a directory
+ *
+ * Watches @uri and everything below it. Existing files are not imported,
+ * use #EinaAdbImporter for that.
+ */
+void
+eina_adb_watcher_add_root(EinaAdbWatcher *self, const gchar *uri)
+{
+	g_return_if_fail(EINA_IS_ADB_WATCHER(self));
+	g_return_if_fail(uri != NULL);
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	for (guint i = 0; i < priv->roots->len; i++)
+		if (g_str_equal(uri, g_ptr_array_index(priv->roots, i)))
+			return;
+
+	g_ptr_array_add(priv->roots, g_strdup(uri));
+	eina_adb_query_exec(priv->adb, "INSERT OR IGNORE INTO library_roots (uri) VALUES('%q');", uri);
+	watcher_scan(self, uri, FALSE);
+}
+
+/**
+ * eina_adb_watcher_remove_root:
+ * @self: An #EinaAdbWatcher
+ * @uri: URI of a root
+ *
+ * Stops watching @uri. Its streams are kept in the database.
+ */
+void
+eina_adb_watcher_remove_root(EinaAdbWatcher *self, const gchar *uri)
+{
+	g_return_if_fail(EINA_IS_ADB_WATCHER(self));
+	g_return_if_fail(uri != NULL);
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	for (guint i = 0; i < priv->roots->len; i++)
+	{
+		if (!g_str_equal(uri, g_ptr_array_index(priv->roots, i)))
+			continue;
+
+		eina_adb_query_exec(priv->adb, "DELETE FROM library_roots WHERE uri='%q';", uri);
+		watcher_unwatch_tree(self, uri);
+		g_ptr_array_remove_index(priv->roots, i);
+		break;
+	}
+
+	// Another root may still cover it
+	for (guint i = 0; i < priv->roots->len; i++)
+		if (uri_is_below(uri, g_ptr_array_index(priv->roots, i)))
+			watcher_scan(self, g_ptr_array_index(priv->roots, i), FALSE);
+}
+
+/**
+ * eina_adb_watcher_get_roots:
+ * @self: An #EinaAdbWatcher
+ *
+ * Gets the watched roots
+ *
+ * Returns: (transfer full) (array zero-terminated=1): The URIs
+ */
+gchar**
+eina_adb_watcher_get_roots(EinaAdbWatcher *self)
+{
+	g_return_val_if_fail(EINA_IS_ADB_WATCHER(self), NULL);
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	gchar **ret = g_new0(gchar *, priv->roots->len + 1);
+	for (guint i = 0; i < priv->roots->len; i++)
+		ret[i] = g_strdup(g_ptr_array_index(priv->roots, i));
+	return ret;
+}
+
+/*
+ * Monitors
+ */
+static void
+watcher_watch_dir(EinaAdbWatcher *self, GFile *dir)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	gchar *uri = g_file_get_uri(dir);
+	if (g_hash_table_lookup(priv->monitors, uri))
+	{
+		g_free(uri);
+		return;
+	}
+
+	GError *error = NULL;
+	GFileMonitor *monitor = g_file_monitor_directory(dir, G_FILE_MONITOR_SEND_MOVED, NULL, &error);
+	if (monitor == NULL)
+	{
+		// Likely out of inotify watches, don't flood the log
+		if (priv->monitor_errors++ == 0)
+			g_warning(N_("Unable to watch '%s': %s"), uri, error->message);
+		else
+			debug("Unable to watch '%s': %s", uri, error->message);
+		g_error_free(error);
+		g_free(uri);
+		return;
+	}
+
+	g_signal_connect(monitor, "changed", (GCallback) watcher_monitor_changed_cb, self);
+	g_hash_table_insert(priv->monitors, uri, monitor);
+}
+
+static void
+watcher_scan(EinaAdbWatcher *self, const gchar *uri, gboolean import)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	GList *uris = g_list_prepend(NULL, (gpointer) uri);
+	GelIOScanner *scanner = gel_io_scanner_new_full(uris, "standard::type,standard::name", TRUE);
+	g_list_free(uris);
+
+	g_object_set_data((GObject *) scanner, "eina-adb-watcher-import", GINT_TO_POINTER(import));
+	g_signal_connect(scanner, "finish", (GCallback) watcher_scanner_finish_cb, self);
+	g_signal_connect(scanner, "error",  (GCallback) watcher_scanner_error_cb,  self);
+	priv->scanners = g_list_prepend(priv->scanners, scanner);
+}
+
+static void
+watcher_queue(EinaAdbWatcher *self, const gchar *uri, Action action);
+static void
+watcher_queue_move(EinaAdbWatcher *self, const gchar *from, const gchar *to, gboolean tree);
+
+/*
+ * Watches directories of a scan result, files are queued for import if
+ * requested
+ */
+static void
+watcher_watch_forest(EinaAdbWatcher *self, GList *forest, gboolean import)
+{
+	GList *flatten = gel_io_scanner_flatten_result(forest);
+	for (GList *l = flatten; l; l = l->next)
+	{
+		GFile     *file = G_FILE(l->data);
+		GFileInfo *info = g_object_get_data((GObject *) file, "g-file-info");
+		if (!info)
+			continue;
+
+		switch (g_file_info_get_file_type(info))
+		{
+		case G_FILE_TYPE_DIRECTORY:
+			watcher_watch_dir(self, file);
+			break;
+
+		case G_FILE_TYPE_REGULAR:
+			if (import)
+			{
+				gchar *uri = g_file_get_uri(file);
+				if (eina_file_utils_is_supported_extension(uri))
+					watcher_queue(self, uri, ACTION_UPDATE);
+				g_free(uri);
+			}
+			break;
+
+		default:
+			break;
+		}
+	}
+	g_list_free(flatten);
+	debug("%u directories watched", g_hash_table_size(self->priv->monitors));
+}
+
+static void
+watcher_scanner_finish_cb(GelIOScanner *scanner, GList *forest, EinaAdbWatcher *self)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+	gboolean import = GPOINTER_TO_INT(g_object_get_data((GObject *) scanner, "eina-adb-watcher-import"));
+
+	watcher_watch_forest(self, forest, import);
+
+	// Scanner owns the forest, drop it once out of its signal
+	priv->scanners = g_list_remove(priv->scanners, scanner);
+	watcher_drop_scanner(scanner, self);
+}
+
+static void
+watcher_scanner_error_cb(GelIOScanner *scanner, GFile *source, GError *error, EinaAdbWatcher *self)
+{
+	gchar *uri = g_file_get_uri(source);
+	g_warning(_("'%s' throw an error: %s"), uri, error->message);
+	g_free(uri);
+}
+
+static void
+watcher_monitor_changed_cb(GFileMonitor *monitor, GFile *file, GFile *other, GFileMonitorEvent event, EinaAdbWatcher *self)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+	gchar *uri = g_file_get_uri(file);
+	debug("Event %d on '%s'", event, uri);
+
+	switch (event)
+	{
+	case G_FILE_MONITOR_EVENT_CREATED:
+		// Created or moved in directory, everything inside is new
+		if (g_file_query_file_type(file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL) == G_FILE_TYPE_DIRECTORY)
+		{
+			watcher_scan(self, uri, TRUE);
+			break;
+		}
+		// Fall through
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+		if (eina_file_utils_is_supported_extension(uri))
+			watcher_queue(self, uri, ACTION_UPDATE);
+		break;
+
+	case G_FILE_MONITOR_EVENT_MOVED:
+	{
+		// Renamed in place, streams keep their SID and everything attached
+		gchar *to = other ? g_file_get_uri(other) : NULL;
+		gboolean watched = FALSE;
+		for (guint i = 0; to && !watched && (i < priv->roots->len); i++)
+			watched = uri_is_below(to, g_ptr_array_index(priv->roots, i));
+
+		if (!watched)
+			watcher_monitor_changed_cb(monitor, file, NULL, G_FILE_MONITOR_EVENT_DELETED, self);
+		else if (g_hash_table_lookup(priv->monitors, uri))
+		{
+			watcher_unwatch_tree(self, uri);
+			watcher_queue_move(self, uri, to, TRUE);
+			watcher_scan(self, to, FALSE);
+		}
+		else if (!eina_file_utils_is_supported_extension(to))
+			watcher_monitor_changed_cb(monitor, file, NULL, G_FILE_MONITOR_EVENT_DELETED, self);
+		else if (eina_file_utils_is_supported_extension(uri))
+			watcher_queue_move(self, uri, to, FALSE);
+		else
+			watcher_queue(self, to, ACTION_UPDATE);
+
+		g_free(to);
+		break;
+	}
+
+	case G_FILE_MONITOR_EVENT_DELETED:
+		// Deleted or moved out, directories are only known by their monitor
+		if (g_hash_table_lookup(priv->monitors, uri))
+		{
+			watcher_unwatch_tree(self, uri);
+			watcher_queue(self, uri, ACTION_REMOVE_TREE);
+		}
+		else if (eina_file_utils_is_supported_extension(uri))
+			watcher_queue(self, uri, ACTION_REMOVE);
+		break;
+
+	default:
+		break;
+	}
+
+	g_free(uri);
+}
+
+/*
+ * Flush
+ */
+static gboolean
+watcher_flush_cb(EinaAdbWatcher *self)
+{
+	self->priv->flush_id = 0;
+	eina_adb_watcher_flush(self);
+	return FALSE;
+}
+
+static gboolean
+watcher_has_pending(EinaAdbWatcherPrivate *priv)
+{
+	return (g_hash_table_size(priv->pending) > 0) || !g_queue_is_empty(priv->moves);
+}
+
+static void
+watcher_schedule_flush(EinaAdbWatcher *self)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+	if (!watcher_has_pending(priv) || priv->importer)
+		return;
+
+	// Restart the quiet period unless events have been waiting too long
+	if (priv->flush_id)
+	{
+		if (g_timer_elapsed(priv->pending_timer, NULL) >= FLUSH_MAX_DELAY)
+			return;
+		g_source_remove(priv->flush_id);
+	}
+	priv->flush_id = g_timeout_add_seconds(FLUSH_DELAY, (GSourceFunc) watcher_flush_cb, self);
+}
+
+static void
+watcher_queue(EinaAdbWatcher *self, const gchar *uri, Action action)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	if (!watcher_has_pending(priv))
+		g_timer_start(priv->pending_timer);
+	g_hash_table_insert(priv->pending, g_strdup(uri), GINT_TO_POINTER(action));
+
+	watcher_schedule_flush(self);
+}
+
+/*
+ * Pending events name files by their old URI. Events for the source now
+ * belong to the destination, and those for the destination are replaced by
+ * what is moved over it.
+ */
+static void
+watcher_queue_move(EinaAdbWatcher *self, const gchar *from, const gchar *to, gboolean tree)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	if (!watcher_has_pending(priv))
+		g_timer_start(priv->pending_timer);
+
+	GList *renamed = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+	g_hash_table_iter_init(&iter, priv->pending);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const gchar *uri = (const gchar *) key;
+		if (tree ? uri_is_below(uri, to) : g_str_equal(uri, to))
+			g_hash_table_iter_remove(&iter);
+		else if (tree ? uri_is_below(uri, from) : g_str_equal(uri, from))
+		{
+			renamed = g_list_prepend(renamed, g_strconcat(to, uri + strlen(from), NULL));
+			renamed = g_list_prepend(renamed, value);
+			g_hash_table_iter_remove(&iter);
+		}
+	}
+	for (GList *l = renamed; l; l = l->next->next)
+		g_hash_table_insert(priv->pending, l->next->data, l->data);
+	g_list_free(renamed);
+
+	Move *move = g_slice_new(Move);
+	move->from = g_strdup(from);
+	move->to   = g_strdup(to);
+	move->tree = tree;
+	g_queue_push_tail(priv->moves, move);
+
+	watcher_schedule_flush(self);
+}
+
+/*
+ * Anything previously at the destination is replaced, 'uri' is unique
+ */
+static gboolean
+watcher_apply_move(EinaAdb *adb, Move *move, guint *removed)
+{
+	if (move->tree)
+	{
+		// URIs in the range use the index on 'uri', '0' follows '/'. URIs
+		// are escaped ASCII, so substr() counts bytes.
+		gchar *cond = sqlite3_mprintf("uri >= '%q/' AND uri < '%q0'", move->to, move->to);
+		gboolean ret = eina_adb_remove_streams(adb, cond, removed) &&
+			eina_adb_query_exec(adb, "UPDATE streams SET uri = '%q' || substr(uri, %d) WHERE uri >= '%q/' AND uri < '%q0';",
+				move->to, (gint) strlen(move->from) + 1, move->from, move->from);
+		sqlite3_free(cond);
+		return ret;
+	}
+	else
+	{
+		gchar *cond = sqlite3_mprintf("uri = '%q'", move->to);
+		gboolean ret = eina_adb_remove_streams(adb, cond, removed) &&
+			eina_adb_query_exec(adb, "UPDATE streams SET uri = '%q' WHERE uri = '%q';", move->to, move->from);
+		sqlite3_free(cond);
+		return ret;
+	}
+}
+
+static void
+watcher_importer_finished_cb(EinaAdbImporter *importer, guint imported, guint skipped, EinaAdbWatcher *self)
+{
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	// Importer releases the adb once out of its signal
+	priv->removed += eina_adb_importer_get_n_removed(importer);
+	g_signal_handlers_disconnect_by_func(importer, watcher_importer_finished_cb, self);
+	g_signal_handlers_disconnect_by_func(importer, watcher_importer_scanned_cb,  self);
+	g_idle_add((GSourceFunc) watcher_unref_idle, importer);
+	priv->importer = NULL;
+
+	debug("Flushed: %u updated, %u unchanged, %u removed", imported, skipped, priv->removed);
+	g_signal_emit(self, watcher_signals[FLUSHED], 0, imported, priv->removed);
+	priv->removed = 0;
+
+	// Requests received while importing
+	if (priv->rescan)
+		eina_adb_watcher_rescan(self);
+	else
+		watcher_schedule_flush(self);
+}
+
+static void
+watcher_importer_scanned_cb(EinaAdbImporter *importer, GList *forest, EinaAdbWatcher *self)
+{
+	// The rescan walked every root, no need to walk them again
+	watcher_watch_forest(self, forest, FALSE);
+}
+
+/**
+ * eina_adb_watcher_flush:
+ * @self: An #EinaAdbWatcher
+ *
+ * Applies the pending changes now instead of waiting for the library to be
+ * quiet. Nothing is done while the previous batch is still being imported,
+ * pending changes are applied after it.
+ */
+void
+eina_adb_watcher_flush(EinaAdbWatcher *self)
+{
+	g_return_if_fail(EINA_IS_ADB_WATCHER(self));
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	if (priv->flush_id)
+	{
+		g_source_remove(priv->flush_id);
+		priv->flush_id = 0;
+	}
+	if (!watcher_has_pending(priv) || priv->importer)
+		return;
+
+	GPtrArray *updates = g_ptr_array_new_with_free_func(g_free);
+	gboolean in_transaction = FALSE;
+	gboolean ok = TRUE;
+
+	Move *move;
+	while ((move = g_queue_pop_head(priv->moves)) != NULL)
+	{
+		if (!in_transaction)
+			in_transaction = eina_adb_query_exec(priv->adb, "BEGIN TRANSACTION;");
+		ok = ok && watcher_apply_move(priv->adb, move, &priv->removed);
+		move_free(move);
+	}
+
+	// Removals are grouped in a few conditions, each one costs a statement
+	// per table referencing streams
+	GPtrArray *conds = g_ptr_array_new_with_free_func(g_free);
+	GString *files = NULL, *trees = NULL;
+	guint n_files = 0, n_trees = 0;
+
+	GHashTableIter iter;
+	gpointer key, value;
+	g_hash_table_iter_init(&iter, priv->pending);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+	{
+		const gchar *uri = (const gchar *) key;
+		gchar *part = NULL;
+
+		switch ((Action) GPOINTER_TO_INT(value))
+		{
+		case ACTION_UPDATE:
+			g_ptr_array_add(updates, g_strdup(uri));
+			break;
+
+		case ACTION_REMOVE:
+			if (!files)
+				files = g_string_new("uri IN (");
+			part = sqlite3_mprintf("%s'%q'", n_files ? "," : "", uri);
+			g_string_append(files, part);
+			if (++n_files == REMOVE_CHUNK)
+			{
+				g_string_append_c(files, ')');
+				g_ptr_array_add(conds, g_string_free(files, FALSE));
+				files = NULL;
+				n_files = 0;
+			}
+			break;
+
+		case ACTION_REMOVE_TREE:
+			// URIs in the range use the index on 'uri', '0' follows '/'
+			if (!trees)
+				trees = g_string_new(NULL);
+			part = sqlite3_mprintf("%s(uri >= '%q/' AND uri < '%q0')", n_trees ? " OR " : "", uri, uri);
+			g_string_append(trees, part);
+			if (++n_trees == REMOVE_TREE_CHUNK)
+			{
+				g_ptr_array_add(conds, g_string_free(trees, FALSE));
+				trees = NULL;
+				n_trees = 0;
+			}
+			break;
+		}
+		sqlite3_free(part);
+	}
+	g_hash_table_remove_all(priv->pending);
+
+	if (files)
+	{
+		g_string_append_c(files, ')');
+		g_ptr_array_add(conds, g_string_free(files, FALSE));
+	}
+	if (trees)
+		g_ptr_array_add(conds, g_string_free(trees, FALSE));
+
+	for (guint i = 0; ok && (i < conds->len); i++)
+	{
+		if (!in_transaction)
+			in_transaction = eina_adb_query_exec(priv->adb, "BEGIN TRANSACTION;");
+		ok = eina_adb_remove_streams(priv->adb, g_ptr_array_index(conds, i), &priv->removed);
+	}
+	g_ptr_array_free(conds, TRUE);
+
+	if (in_transaction)
+	{
+		if (ok)
+			eina_adb_query_exec(priv->adb, "END TRANSACTION;");
+		else
+		{
+			g_warning(N_("Unable to remove deleted or moved files from the database"));
+			eina_adb_query_exec(priv->adb, "ROLLBACK;");
+			priv->removed = 0;
+		}
+	}
+
+	if (updates->len == 0)
+	{
+		debug("Flushed: %u removed", priv->removed);
+		g_signal_emit(self, watcher_signals[FLUSHED], 0, 0, priv->removed);
+		priv->removed = 0;
+	}
+	else
+	{
+		g_ptr_array_add(updates, NULL);
+		priv->importer = eina_adb_importer_new(priv->adb);
+		g_signal_connect(priv->importer, "finished", (GCallback) watcher_importer_finished_cb, self);
+		eina_adb_importer_import(priv->importer, (const gchar *const *) updates->pdata);
+	}
+	g_ptr_array_free(updates, TRUE);
+}
+
+/**
+ * eina_adb_watcher_rescan:
+ * @self: An #EinaAdbWatcher
+ *
+ * Walks all the roots: new and changed files are imported and streams
+ * whose files are gone are removed, see eina_adb_importer_rescan(). Pending
+ * events are dropped since the rescan covers them. If an import is running
+ * the rescan starts after it. #EinaAdbWatcher::flushed is emitted at the
+ * end.
+ */
+void
+eina_adb_watcher_rescan(EinaAdbWatcher *self)
+{
+	g_return_if_fail(EINA_IS_ADB_WATCHER(self));
+	EinaAdbWatcherPrivate *priv = self->priv;
+
+	if (priv->importer)
+	{
+		priv->rescan = TRUE;
+		return;
+	}
+	priv->rescan = FALSE;
+
+	if (priv->roots->len == 0)
+		return;
+
+	if (priv->flush_id)
+	{
+		g_source_remove(priv->flush_id);
+		priv->flush_id = 0;
+	}
+	g_hash_table_remove_all(priv->pending);
+	g_queue_foreach(priv->moves, (GFunc) move_free, NULL);
+	g_queue_clear(priv->moves);
+
+	// The rescan walk sets up the monitors
+	if (priv->watch_id)
+	{
+		g_source_remove(priv->watch_id);
+		priv->watch_id = 0;
+	}
+
+	g_ptr_array_add(priv->roots, NULL);
+	priv->importer = eina_adb_importer_new(priv->adb);
+	g_signal_connect(priv->importer, "finished", (GCallback) watcher_importer_finished_cb, self);
+	g_signal_connect(priv->importer, "scanned",  (GCallback) watcher_importer_scanned_cb,  self);
+	eina_adb_importer_rescan(priv->importer, (const gchar *const *) priv->roots->pdata);
+	g_ptr_array_remove_index(priv->roots, priv->roots->len - 1);
+}
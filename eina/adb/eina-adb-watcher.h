@@ -0,0 +1,62 @@
+/*
+ * eina/adb/eina-adb-watcher.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EINA_ADB_WATCHER
+#define _EINA_ADB_WATCHER
+
+#include <glib-object.h>
+#include <eina/adb/eina-adb.h>
+
+G_BEGIN_DECLS
+
+#define EINA_TYPE_ADB_WATCHER eina_adb_watcher_get_type()
+
+#define EINA_ADB_WATCHER(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), EINA_TYPE_ADB_WATCHER, EinaAdbWatcher))
+#define EINA_ADB_WATCHER_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), EINA_TYPE_ADB_WATCHER, EinaAdbWatcherClass))
+#define EINA_IS_ADB_WATCHER(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EINA_TYPE_ADB_WATCHER))
+#define EINA_IS_ADB_WATCHER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), EINA_TYPE_ADB_WATCHER))
+#define EINA_ADB_WATCHER_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), EINA_TYPE_ADB_WATCHER, EinaAdbWatcherClass))
+
+typedef struct _EinaAdbWatcherPrivate EinaAdbWatcherPrivate;
+typedef struct {
+	/*<private>*/
+	GObject parent;
+	EinaAdbWatcherPrivate *priv;
+} EinaAdbWatcher;
+
+typedef struct {
+	/*<private>*/
+	GObjectClass parent_class;
+	void (*flushed) (EinaAdbWatcher *self, guint updated, guint removed);
+} EinaAdbWatcherClass;
+
+GType eina_adb_watcher_get_type (void);
+
+EinaAdbWatcher* eina_adb_get_watcher(EinaAdb *adb);
+
+void    eina_adb_watcher_add_root   (EinaAdbWatcher *self, const gchar *uri);
+void    eina_adb_watcher_remove_root(EinaAdbWatcher *self, const gchar *uri);
+gchar** eina_adb_watcher_get_roots  (EinaAdbWatcher *self);
+
+void    eina_adb_watcher_flush (EinaAdbWatcher *self);
+void    eina_adb_watcher_rescan(EinaAdbWatcher *self);
+
+G_END_DECLS
+
+#endif /* _EINA_ADB_WATCHER */
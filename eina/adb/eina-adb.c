@@ -38,7 +38,64 @@ struct _EinaAdbPrivate {
 	GQueue     *queue;
 	GList      *playlist;
 	guint       flush_id;
+
+	GHashTable *changes; // table name -> GArray of rowids, NULL if too many
+	guint       changes_id;
+
+	struct _AdbReader *reader; // Started by the first eina_adb_query_async()
+};
+
+// Rows tracked per table before giving up and reporting the whole table
+#define MAX_TRACKED_CHANGES 512
+
+/*
+ * Async queries run on a thread with its own read-only connection, rows are
+ * copied in batches and delivered to the main loop. The reader waits if the
+ * main loop falls behind so memory stays bounded.
+ */
+#define ASYNC_BATCH_SIZE    256
+#define ASYNC_MAX_PENDING   4
+#define ASYNC_PROGRESS_OPS  1000 // VM instructions between cancellation checks
+#define ASYNC_BUSY_TIMEOUT  5000 // ms
+
+typedef struct _AdbReader {
+	gchar       *db_file;
+	GThread     *thread;
+	GAsyncQueue *jobs;
+	GMutex      *mutex;
+	GCond       *cond;
+} AdbReader;
+
+typedef struct {
+	AdbReader        *reader;
+	EinaAdb          *adb;
+	gchar            *query;
+	GCancellable     *cancellable;
+	EinaAdbQueryFunc  callback;
+	gpointer          data;
+	GDestroyNotify    notify;
+
+	volatile gint     stopped; // Callback returned FALSE
+	guint             pending; // Batches not yet dispatched, protected by reader->mutex
+} AsyncJob;
+
+typedef struct {
+	AsyncJob      *job;
+	EinaAdbResult *rows; // NULL for the final message
+	GError        *error;
+} AsyncBatch;
+
+// Pushed by dispose to stop the reader thread
+static AsyncJob reader_quit;
+
+static void
+adb_reader_free(AdbReader *reader);
+
+enum {
+	SIGNAL_CHANGED,
+	LAST_SIGNAL
 };
+static guint adb_signals[LAST_SIGNAL] = { 0 };
 
 enum {
 	PROPERTY_DB_FILE = 1,
@@ -75,6 +132,10 @@ static gboolean
 adb_flush(EinaAdb *self);
 static void
 adb_schedule_flush(EinaAdb *self);
+static void
+adb_update_hook(EinaAdb *self, int op, const char *db, const char *table, sqlite3_int64 rowid);
+static void
+adb_changes_free(GArray *rowids);
 
 static void
 eina_adb_get_property (GObject *object, guint property_id,
@@ -118,6 +179,13 @@ eina_adb_dispose (GObject *object)
 		g_queue_free(priv->queue);
 		priv->queue = NULL;
 	}
+	if (priv->changes_id)
+	{
+		g_source_remove(priv->changes_id);
+		priv->changes_id = 0;
+	}
+	gel_free_and_invalidate(priv->changes, NULL, g_hash_table_destroy);
+	gel_free_and_invalidate(priv->reader,  NULL, adb_reader_free);
 	G_OBJECT_CLASS (eina_adb_parent_class)->dispose (object);
 }
 
@@ -135,6 +203,29 @@ eina_adb_class_init (EinaAdbClass *klass)
 	g_object_class_install_property(object_class, PROPERTY_DB_FILE,
 		g_param_spec_string("db-filename", "db-filename",  "db-filename",
 		NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_CONSTRUCT_ONLY));
+
+	/**
+	 * EinaAdb::changed:
+	 * @adb: The #EinaAdb
+	 * @table: Name of the modified table
+	 * @rowids: (type GLib.Array) (element-type gint64) (allow-none): ROWIDs
+	 *          of the inserted, updated or deleted rows, %NULL if too many rows
+	 *          changed
+	 *
+	 * Emitted from the main loop after rows of @table were modified, changes
+	 * are coalesced until then. The detail is the name of the table so
+	 * "changed::metadata" only gets changes in 'metadata'.
+	 */
+	adb_signals[SIGNAL_CHANGED] = g_signal_new ("changed",
+		G_OBJECT_CLASS_TYPE (object_class),
+		G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+		0,
+		NULL, NULL,
+		gel_marshal_VOID__STRING_POINTER,
+		G_TYPE_NONE,
+		2,
+		G_TYPE_STRING,
+		G_TYPE_POINTER);
 }
 
 static void
@@ -142,6 +233,7 @@ eina_adb_init (EinaAdb *self)
 {
 	EinaAdbPrivate *priv = GET_PRIVATE(self);
 	priv->queue = g_queue_new();
+	priv->changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) adb_changes_free);
 }
 
 /**
@@ -214,6 +306,12 @@ eina_adb_set_db_filename(EinaAdb *self, const gchar *path)
 		return FALSE;
 	}
 
+	// Let async readers and the main connection work concurrently
+	sqlite3_busy_timeout(priv->db, ASYNC_BUSY_TIMEOUT);
+	eina_adb_query_exec_raw(self, "PRAGMA journal_mode=WAL;");
+
+	sqlite3_update_hook(priv->db, (void (*)(void *, int, const char *, const char *, sqlite3_int64)) adb_update_hook, self);
+
 	return TRUE;
 }
 
@@ -280,6 +378,257 @@ eina_adb_query_raw(EinaAdb *self, gchar *query)
 	return eina_adb_result_new(res);
 }
 
+//
+// Async queries
+//
+static gboolean
+async_job_is_stopped(AsyncJob *job)
+{
+	return g_atomic_int_get(&job->stopped) || g_cancellable_is_cancelled(job->cancellable);
+}
+
+static void
+async_job_free(AsyncJob *job)
+{
+	if (job->notify)
+		job->notify(job->data);
+	gel_free_and_invalidate(job->cancellable, NULL, g_object_unref);
+	g_object_unref(job->adb);
+	g_free(job->query);
+	g_slice_free(AsyncJob, job);
+}
+
+static gboolean
+async_batch_dispatch(AsyncBatch *batch)
+{
+	AsyncJob *job = batch->job;
+
+	if (batch->rows)
+	{
+		if (!async_job_is_stopped(job) && !job->callback(job->adb, batch->rows, NULL, job->data))
+			g_atomic_int_set(&job->stopped, 1);
+		g_object_unref(batch->rows);
+
+		g_mutex_lock(job->reader->mutex);
+		job->pending--;
+		g_cond_broadcast(job->reader->cond);
+		g_mutex_unlock(job->reader->mutex);
+	}
+	else
+	{
+		// The reader may have finished before the job was cancelled from
+		// the main loop, callers rely on the error to know their data is gone
+		if ((batch->error == NULL) && async_job_is_stopped(job))
+			batch->error = g_error_new(G_IO_ERROR, G_IO_ERROR_CANCELLED, N_("Query was cancelled"));
+		job->callback(job->adb, NULL, batch->error, job->data);
+		if (batch->error)
+			g_error_free(batch->error);
+		async_job_free(job);
+	}
+
+	g_slice_free(AsyncBatch, batch);
+	return FALSE;
+}
+
+static void
+async_deliver(AsyncJob *job, EinaAdbResult *rows, GError *error)
+{
+	AsyncBatch *batch = g_slice_new(AsyncBatch);
+	batch->job   = job;
+	batch->rows  = rows;
+	batch->error = error;
+	g_idle_add((GSourceFunc) async_batch_dispatch, batch);
+}
+
+static void
+reader_run_job(AdbReader *reader, sqlite3 *db, AsyncJob *job)
+{
+	GError *error = NULL;
+	sqlite3_stmt *stmt = NULL;
+
+	if (db == NULL)
+		error = g_error_new(eina_adb_quark(), EINA_ADB_ERROR_QUERY_FAILED,
+			N_("Unable to open '%s' for reading"), reader->db_file);
+	else if (async_job_is_stopped(job))
+		stmt = NULL;
+	else if (sqlite3_prepare_v2(db, job->query, -1, &stmt, NULL) != SQLITE_OK)
+		error = g_error_new(eina_adb_quark(), EINA_ADB_ERROR_QUERY_FAILED,
+			N_("Query failed: %s. Query was: %s"), sqlite3_errmsg(db), job->query);
+	else
+	{
+		sqlite3_progress_handler(db, ASYNC_PROGRESS_OPS, (int (*)(void *)) async_job_is_stopped, job);
+
+		gint code = SQLITE_ROW;
+		while ((code == SQLITE_ROW) && !async_job_is_stopped(job))
+		{
+			EinaAdbResult *rows = eina_adb_result_new_batch(stmt, ASYNC_BATCH_SIZE, &code);
+
+			g_mutex_lock(reader->mutex);
+			while ((job->pending >= ASYNC_MAX_PENDING) && !async_job_is_stopped(job))
+				g_cond_wait(reader->cond, reader->mutex);
+			job->pending++;
+			g_mutex_unlock(reader->mutex);
+
+			async_deliver(job, rows, NULL);
+		}
+
+		if ((code != SQLITE_ROW) && (code != SQLITE_DONE) && !async_job_is_stopped(job))
+			error = g_error_new(eina_adb_quark(), EINA_ADB_ERROR_QUERY_FAILED,
+				N_("Query failed: %s. Query was: %s"), sqlite3_errmsg(db), job->query);
+
+		sqlite3_progress_handler(db, 0, NULL, NULL);
+		sqlite3_finalize(stmt);
+	}
+
+	if ((error == NULL) && async_job_is_stopped(job))
+		error = g_error_new(G_IO_ERROR, G_IO_ERROR_CANCELLED, N_("Query was cancelled"));
+
+	async_deliver(job, NULL, error);
+}
+
+static gpointer
+reader_thread(AdbReader *reader)
+{
+	sqlite3 *db = NULL;
+	int code = sqlite3_open_v2(reader->db_file, &db, SQLITE_OPEN_READONLY, NULL);
+	if (code != SQLITE_OK)
+	{
+		g_warning("Unable to open sqlite3 database '%s' for reading: %d", reader->db_file, code);
+		gel_free_and_invalidate(db, NULL, sqlite3_close);
+	}
+	else
+		sqlite3_busy_timeout(db, ASYNC_BUSY_TIMEOUT);
+
+	AsyncJob *job;
+	while ((job = g_async_queue_pop(reader->jobs)) != &reader_quit)
+		reader_run_job(reader, db, job);
+
+	gel_free_and_invalidate(db, NULL, sqlite3_close);
+	return NULL;
+}
+
+static AdbReader*
+adb_reader_new(const gchar *db_file)
+{
+	GError *error = NULL;
+	AdbReader *reader = g_new0(AdbReader, 1);
+	reader->db_file = g_strdup(db_file);
+	reader->jobs    = g_async_queue_new();
+	reader->mutex   = g_mutex_new();
+	reader->cond    = g_cond_new();
+
+	if (!g_thread_supported() || !(reader->thread = g_thread_create((GThreadFunc) reader_thread, reader, TRUE, &error)))
+	{
+		g_warning(N_("Unable to start database reader thread: %s"), error ? error->message : N_("No error message"));
+		if (error)
+			g_error_free(error);
+		adb_reader_free(reader);
+		return NULL;
+	}
+
+	return reader;
+}
+
+static void
+adb_reader_free(AdbReader *reader)
+{
+	if (reader->thread)
+	{
+		g_async_queue_push(reader->jobs, &reader_quit);
+		g_thread_join(reader->thread);
+	}
+	g_async_queue_unref(reader->jobs);
+	g_mutex_free(reader->mutex);
+	g_cond_free(reader->cond);
+	g_free(reader->db_file);
+	g_free(reader);
+}
+
+/**
+ * eina_adb_query_async: (skip):
+ * @self: An #EinaAdb
+ * @cancellable: (allow-none): A #GCancellable
+ * @callback: Function to call with each batch of rows
+ * @data: (closure): Data for @callback
+ * @notify: (allow-none): Destroy notify for @data
+ * @query: Query to execute in sqlite format, see %sqlite3_vmprintf
+ *
+ * Builds @query and runs it on a separate read-only connection, see
+ * eina_adb_query_async_raw()
+ */
+void
+eina_adb_query_async(EinaAdb *self, GCancellable *cancellable,
+	EinaAdbQueryFunc callback, gpointer data, GDestroyNotify notify,
+	const gchar *query, ...)
+{
+	g_return_if_fail(EINA_IS_ADB(self));
+	g_return_if_fail(query != NULL);
+
+	va_list args;
+	va_start(args, query);
+	gchar *q = sqlite3_vmprintf(query, args);
+	va_end(args);
+
+	g_return_if_fail(q != NULL);
+
+	eina_adb_query_async_raw(self, q, cancellable, callback, data, notify);
+	sqlite3_free(q);
+}
+
+/**
+ * eina_adb_query_async_raw:
+ * @self: An #EinaAdb
+ * @query: Query to execute, must only read from the database
+ * @cancellable: (allow-none): A #GCancellable
+ * @callback: (scope notified): Function to call with each batch of rows
+ * @data: (closure): Data for @callback
+ * @notify: (allow-none): Destroy notify for @data
+ *
+ * Runs @query on a thread with its own read-only connection. Rows are
+ * delivered in batches from the main loop: @callback gets each batch as an
+ * #EinaAdbResult which can be stepped like the ones from eina_adb_query()
+ * but is only valid during the call. Returning %FALSE from @callback
+ * stops the query.
+ *
+ * @callback is called one last time with a %NULL result and the error, if
+ * any. The error is %G_IO_ERROR_CANCELLED if @cancellable was cancelled or
+ * @callback returned %FALSE.
+ */
+void
+eina_adb_query_async_raw(EinaAdb *self, const gchar *query, GCancellable *cancellable,
+	EinaAdbQueryFunc callback, gpointer data, GDestroyNotify notify)
+{
+	g_return_if_fail(EINA_IS_ADB(self));
+	g_return_if_fail(query != NULL);
+	g_return_if_fail(callback != NULL);
+	g_return_if_fail(!cancellable || G_IS_CANCELLABLE(cancellable));
+
+	EinaAdbPrivate *priv = GET_PRIVATE(self);
+	g_return_if_fail(priv->db_file != NULL);
+
+	if (!priv->reader && !(priv->reader = adb_reader_new(priv->db_file)))
+	{
+		GError *error = g_error_new(eina_adb_quark(), EINA_ADB_ERROR_QUERY_FAILED,
+			N_("Unable to start database reader thread"));
+		callback(self, NULL, error, data);
+		g_error_free(error);
+		if (notify)
+			notify(data);
+		return;
+	}
+
+	AsyncJob *job = g_slice_new0(AsyncJob);
+	job->reader      = priv->reader;
+	job->adb         = g_object_ref(self);
+	job->query       = g_strdup(query);
+	job->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+	job->callback    = callback;
+	job->data        = data;
+	job->notify      = notify;
+
+	g_async_queue_push(priv->reader->jobs, job);
+}
+
 /**
  * eina_adb_query_exec_raw:
  * @self: A #EinaAdb
@@ -382,6 +731,65 @@ eina_adb_changes(EinaAdb *self)
 	return (gint) sqlite3_changes(GET_PRIVATE(self)->db);
 }
 
+/**
+ * eina_adb_remove_streams:
+ * @self: An #EinaAdb
+ * @condition: SQL condition on the 'streams' table, already escaped
+ * @removed: (out) (allow-none): Return location for the number of streams
+ *           removed, added to its current value
+ *
+ * Removes the streams matching @condition and their rows in every table
+ * referencing streams(sid), including those created by plugins. Foreign
+ * keys aren't enforced by sqlite so the cascades declared by those tables
+ * never run.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+eina_adb_remove_streams(EinaAdb *self, const gchar *condition, guint *removed)
+{
+	g_return_val_if_fail(EINA_IS_ADB(self), FALSE);
+	g_return_val_if_fail(condition != NULL, FALSE);
+
+	GPtrArray *tables = g_ptr_array_new_with_free_func(g_free);
+	EinaAdbResult *r = eina_adb_query_raw(self, "SELECT name FROM sqlite_master WHERE type = 'table' AND name <> 'streams';");
+	gchar *name;
+	while (r && eina_adb_result_step(r))
+	{
+		eina_adb_result_get(r, 0, G_TYPE_STRING, &name, -1);
+		g_ptr_array_add(tables, name);
+	}
+	gel_free_and_invalidate(r, NULL, g_object_unref);
+
+	gboolean ret = TRUE;
+	for (guint i = 0; ret && (i < tables->len); i++)
+	{
+		// Columns: id, seq, table, from, to...
+		const gchar *table = g_ptr_array_index(tables, i);
+		r = eina_adb_query(self, "PRAGMA foreign_key_list('%q');", table);
+		while (ret && r && eina_adb_result_step(r))
+		{
+			gchar *parent = NULL, *column = NULL;
+			eina_adb_result_get(r,
+				2, G_TYPE_STRING, &parent,
+				3, G_TYPE_STRING, &column,
+				-1);
+			if (parent && column && g_str_equal(parent, "streams"))
+				ret = eina_adb_query_exec(self, "DELETE FROM \"%w\" WHERE \"%w\" IN (SELECT sid FROM streams WHERE %s);",
+					table, column, condition);
+			g_free(parent);
+			g_free(column);
+		}
+		gel_free_and_invalidate(r, NULL, g_object_unref);
+	}
+	g_ptr_array_free(tables, TRUE);
+
+	ret = ret && eina_adb_query_exec(self, "DELETE FROM streams WHERE %s;", condition);
+	if (ret && removed)
+		*removed += eina_adb_changes(self);
+	return ret;
+}
+
 // --
 // Queue querys
 // --
@@ -401,6 +809,26 @@ eina_adb_queue_query(EinaAdb *self, gchar *query, ...)
 	adb_schedule_flush(self);
 }
 
+/**
+ * eina_adb_flush:
+ * @self: An #EinaAdb
+ *
+ * Executes now the queries queued with eina_adb_queue_query()
+ */
+void
+eina_adb_flush(EinaAdb *self)
+{
+	g_return_if_fail(EINA_IS_ADB(self));
+	EinaAdbPrivate *priv = GET_PRIVATE(self);
+
+	if (priv->flush_id)
+	{
+		g_source_remove(priv->flush_id);
+		priv->flush_id = 0;
+	}
+	adb_flush(self);
+}
+
 static gboolean
 adb_flush(EinaAdb *self)
 {
@@ -438,6 +866,66 @@ adb_schedule_flush(EinaAdb *self)
 	priv->flush_id = g_timeout_add_seconds(5, (GSourceFunc) adb_flush, self);
 }
 
+// --
+// Change notification
+// --
+static void
+adb_changes_free(GArray *rowids)
+{
+	if (rowids)
+		g_array_free(rowids, TRUE);
+}
+
+static gboolean
+adb_emit_changes(EinaAdb *self)
+{
+	EinaAdbPrivate *priv = GET_PRIVATE(self);
+
+	// Steal the table so handlers can trigger new changes
+	GHashTable *changes = priv->changes;
+	priv->changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) adb_changes_free);
+	priv->changes_id = 0;
+
+	GHashTableIter iter;
+	gchar  *table;
+	GArray *rowids;
+	g_hash_table_iter_init(&iter, changes);
+	while (g_hash_table_iter_next(&iter, (gpointer *) &table, (gpointer *) &rowids))
+		g_signal_emit(self, adb_signals[SIGNAL_CHANGED], g_quark_from_string(table), table, rowids);
+
+	g_hash_table_destroy(changes);
+	return FALSE;
+}
+
+// Called by sqlite in the middle of a statement, the database can't be
+// touched from here
+static void
+adb_update_hook(EinaAdb *self, int op, const char *db, const char *table, sqlite3_int64 rowid)
+{
+	EinaAdbPrivate *priv = GET_PRIVATE(self);
+
+	GArray *rowids = NULL;
+	if (!g_hash_table_lookup_extended(priv->changes, table, NULL, (gpointer *) &rowids))
+	{
+		rowids = g_array_new(FALSE, FALSE, sizeof(gint64));
+		g_hash_table_insert(priv->changes, g_strdup(table), rowids);
+	}
+
+	if (rowids)
+	{
+		if (rowids->len < MAX_TRACKED_CHANGES)
+		{
+			gint64 r = rowid;
+			g_array_append_val(rowids, r);
+		}
+		else
+			g_hash_table_insert(priv->changes, g_strdup(table), NULL);
+	}
+
+	if (!priv->changes_id)
+		priv->changes_id = g_idle_add((GSourceFunc) adb_emit_changes, self);
+}
+
 // --
 // Variable mini-API
 // --
@@ -21,6 +21,7 @@
 #define __EINA_ADB_H__
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <lomo/lomo-player.h>
 #include <sqlite3.h>
 #include <eina/adb/eina-adb-result.h>
@@ -47,6 +48,19 @@ typedef struct {
 
 typedef gboolean (*EinaAdbFunc)(EinaAdb *adb, GError **error);
 
+/**
+ * EinaAdbQueryFunc:
+ * @adb: The #EinaAdb
+ * @rows: (allow-none): A batch of rows, %NULL when the query has finished
+ * @error: (allow-none): Error of the finished query, if any
+ * @data: User data
+ *
+ * Callback for eina_adb_query_async()
+ *
+ * Returns: %FALSE to stop the query, ignored for the final call
+ */
+typedef gboolean (*EinaAdbQueryFunc)(EinaAdb *adb, EinaAdbResult *rows, const GError *error, gpointer data);
+
 enum {
 	EINA_ADB_NO_ERROR = 0,
 	EINA_ADB_ERROR_OBJECT_IS_NOT_ADB,
@@ -79,8 +93,16 @@ gboolean       eina_adb_query_exec(EinaAdb *self, const gchar *query, ...);
 gboolean       eina_adb_query_exec_raw(EinaAdb *self, const gchar *query);
 gboolean       eina_adb_query_block_exec(EinaAdb *self, gchar *queries[], GError **error);
 
+void eina_adb_query_async    (EinaAdb *self, GCancellable *cancellable,
+	EinaAdbQueryFunc callback, gpointer data, GDestroyNotify notify,
+	const gchar *query, ...);
+void eina_adb_query_async_raw(EinaAdb *self, const gchar *query, GCancellable *cancellable,
+	EinaAdbQueryFunc callback, gpointer data, GDestroyNotify notify);
+
 gint eina_adb_changes(EinaAdb *self);
 
+gboolean eina_adb_remove_streams(EinaAdb *self, const gchar *condition, guint *removed);
+
 gchar    *eina_adb_get_variable(EinaAdb *self, gchar *variable);
 gboolean  eina_adb_set_variable(EinaAdb *self, gchar *variable, gchar *value);
 
@@ -19,6 +19,8 @@
 
 #include "register.h"
 #include "eina-adb.h"
+#include "eina-adb-sampler.h"
+#include "eina-adb-stats.h"
 #include <string.h>
 #include <sys/time.h>
 #include <lomo/lomo-player.h>
@@ -162,7 +164,62 @@ upgrade_4(EinaAdb *self, GError **error)
 	return eina_adb_query_block_exec(self, qs, error);
 };
 
-static EinaAdbFunc upgrade_funcs[] = { upgrade_1, upgrade_2, upgrade_3, upgrade_4, NULL };
+// Modification time and size of the file on last import, used to skip
+// unchanged files
+static gboolean
+upgrade_5(EinaAdb *self, GError **error)
+{
+	gchar *qs[] = {
+		"ALTER TABLE streams ADD COLUMN mtime INTEGER DEFAULT 0;",
+		"ALTER TABLE streams ADD COLUMN size INTEGER DEFAULT 0;",
+		NULL
+	};
+	return eina_adb_query_block_exec(self, qs, error);
+};
+
+// Indexes for smart playlists: tag lookups and play based ordering
+static gboolean
+upgrade_6(EinaAdb *self, GError **error)
+{
+	gchar *qs[] = {
+		"CREATE INDEX IF NOT EXISTS metadata_key_value_idx ON metadata(key,value);",
+		"CREATE INDEX IF NOT EXISTS streams_played_idx ON streams(played);",
+		"CREATE INDEX IF NOT EXISTS streams_count_idx ON streams(count);",
+		NULL
+	};
+	return eina_adb_query_block_exec(self, qs, error);
+};
+
+// Play counters per day and week, see eina-adb-stats.c. Buckets are filled
+// from the plays still in 'recent_plays'
+static gboolean
+upgrade_7(EinaAdb *self, GError **error)
+{
+	gchar *qs[] = {
+		"DROP TABLE IF EXISTS play_buckets;",
+		"CREATE TABLE play_buckets ("
+		"	sid INTEGER NOT NULL,"
+		"	span INTEGER NOT NULL,"
+		"	bucket INTEGER NOT NULL,"
+		"	count INTEGER NOT NULL DEFAULT 0,"
+		"	CONSTRAINT play_buckets_pk PRIMARY KEY(span,bucket,sid),"
+		"	CONSTRAINT play_buckets_fk FOREIGN KEY(sid) REFERENCES streams(sid) ON DELETE CASCADE ON UPDATE CASCADE"
+		");",
+		"CREATE INDEX play_buckets_count_idx ON play_buckets(span,bucket,count);",
+		"CREATE INDEX play_buckets_sid_idx ON play_buckets(sid);",
+
+		"INSERT INTO play_buckets (sid,span,bucket,count)"
+		"  SELECT sid, 1, CAST(timestamp AS INTEGER) / 86400, COUNT(*) FROM recent_plays"
+		"  GROUP BY sid, CAST(timestamp AS INTEGER) / 86400;",
+		"INSERT INTO play_buckets (sid,span,bucket,count)"
+		"  SELECT sid, 2, (CAST(timestamp AS INTEGER) / 86400 + 3) / 7, COUNT(*) FROM recent_plays"
+		"  GROUP BY sid, (CAST(timestamp AS INTEGER) / 86400 + 3) / 7;",
+		NULL
+	};
+	return eina_adb_query_block_exec(self, qs, error);
+};
+
+static EinaAdbFunc upgrade_funcs[] = { upgrade_1, upgrade_2, upgrade_3, upgrade_4, upgrade_5, upgrade_6, upgrade_7, NULL };
 
 
 // Our data
@@ -191,13 +248,20 @@ struct {
 	{ NULL, NULL }
 };
 
+gboolean
+adb_register_upgrade_schema(EinaAdb *self, GError **error)
+{
+	g_return_val_if_fail(EINA_IS_ADB(self), FALSE);
+	return eina_adb_upgrade_schema(self, "register", upgrade_funcs, error);
+}
+
 void
 adb_register_start(EinaAdb *self, LomoPlayer *lomo)
 {
 	g_return_if_fail(EINA_IS_ADB(self));
 	g_return_if_fail(LOMO_IS_PLAYER(lomo));
 
-	g_return_if_fail(eina_adb_upgrade_schema(self, "register", upgrade_funcs, NULL));
+	g_return_if_fail(adb_register_upgrade_schema(self, NULL));
 
 	g_object_ref(lomo);
 	g_object_weak_ref((GObject *) lomo, adb_register_weak_ref_cb, NULL);
@@ -299,8 +363,8 @@ lomo_eos_cb(LomoPlayer *lomo, EinaAdb *adb)
 		debug("Submit to lastfm");
 		gint sid = eina_adb_lomo_stream_get_sid(adb, lomo_player_get_current_stream(lomo));
 		g_return_if_fail(sid >= 0);
-		eina_adb_query_exec(adb, "UPDATE streams SET played = STRFTIME('%%s', 'NOW'), count = (count + 1) WHERE sid=%d;", sid);
-		eina_adb_query_exec(adb, "INSERT INTO recent_plays (sid,timestamp) VALUES(%d,STRFTIME('%%s', 'NOW'))", sid);
+		eina_adb_stats_add_play(adb, sid, (gint64) time(NULL));
+		eina_adb_sampler_add_play(eina_adb_get_sampler(adb), sid);
 		__markers.submited = TRUE;
 	}
 	else
@@ -364,29 +428,36 @@ lomo_clear_cb(LomoPlayer *lomo, EinaAdb *self)
 	__playlist = NULL;
 }
 
-static void
-lomo_all_tags_cb(LomoPlayer *lomo, LomoStream *stream, EinaAdb *self)
+void
+adb_register_store_metadata(EinaAdb *self, LomoStream *stream)
 {
 	g_return_if_fail(EINA_IS_ADB(self));
+	g_return_if_fail(LOMO_IS_STREAM(stream));
 
-	gchar *uri = (gchar *) lomo_stream_get_tag(stream, LOMO_TAG_URI);
+	const gchar *uri = lomo_stream_get_uri(stream);
 	GList *tags = lomo_stream_get_tags(stream);
 	GList *iter = tags;
 	while (iter)
 	{
 		gchar *tag = iter->data;
-		if (lomo_tag_get_gtype(tag) != G_TYPE_STRING)
+		const GValue *v = lomo_stream_get_tag(stream, tag);
+		if (!v || !G_VALUE_HOLDS_STRING(v))
 		{
 			iter = iter->next;
 			continue;
 		}
 
-		gchar *value = (gchar *) lomo_stream_get_tag(stream, iter->data);
 		eina_adb_queue_query(self, "INSERT OR IGNORE INTO metadata "
-			"VALUES((SELECT sid FROM streams WHERE uri='%q'), '%q', '%q');", uri, tag, value);
+			"VALUES((SELECT sid FROM streams WHERE uri='%q'), '%q', '%q');", uri, tag, g_value_get_string(v));
 		iter = iter->next;
 	}
 	gel_list_deep_free(tags, (GFunc) g_free);
 }
 
+static void
+lomo_all_tags_cb(LomoPlayer *lomo, LomoStream *stream, EinaAdb *self)
+{
+	adb_register_store_metadata(self, stream);
+}
+
 
@@ -22,6 +22,9 @@
 
 G_BEGIN_DECLS
 
+gboolean adb_register_upgrade_schema(EinaAdb *adb, GError **error);
+void     adb_register_store_metadata(EinaAdb *adb, LomoStream *stream);
+
 void adb_register_start(EinaAdb *adb, LomoPlayer *lomo);
 void adb_register_stop (EinaAdb *adb, LomoPlayer *lomo);
 
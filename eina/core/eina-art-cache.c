@@ -0,0 +1,602 @@
+/*
+ * eina/core/eina-art-cache.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "eina-art-cache.h"
+#include <string.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <gel/gel.h>
+#include <gel/gel-ui.h>
+#include <eina/core/eina-fs.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaArtCache"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// Number of decoded pixbufs kept in memory
+#define MEMORY_CACHE_SIZE 64
+
+// Object data key used to memoize content hashes on input streams
+#define STREAM_KEY_DATA "eina-art-cache-key"
+
+typedef struct {
+	gchar     *key;
+	GdkPixbuf *pixbuf;
+} ArtCacheEntry;
+
+static GQueue     *_lru   = NULL; // <ArtCacheEntry *, most recent first
+static GHashTable *_index = NULL; // <key, GList * link into _lru>
+
+static void
+art_cache_entry_free(ArtCacheEntry *entry)
+{
+	g_free(entry->key);
+	g_object_unref(entry->pixbuf);
+	g_free(entry);
+}
+
+/*
+ * Drops every size of @key from memory
+ */
+static void
+memory_remove(const gchar *key)
+{
+	if (!_index)
+		return;
+
+	gsize len = strlen(key);
+	GList *l = _lru->head;
+	while (l)
+	{
+		GList *next = l->next;
+		ArtCacheEntry *entry = (ArtCacheEntry *) l->data;
+		if (g_str_has_prefix(entry->key, key) && (entry->key[len] == '@'))
+		{
+			g_hash_table_remove(_index, entry->key);
+			g_queue_delete_link(_lru, l);
+			art_cache_entry_free(entry);
+		}
+		l = next;
+	}
+}
+
+static GdkPixbuf *
+memory_lookup(const gchar *key)
+{
+	if (!_index)
+		return NULL;
+
+	GList *link = g_hash_table_lookup(_index, key);
+	if (!link)
+		return NULL;
+
+	// Promote to head
+	g_queue_unlink(_lru, link);
+	g_queue_push_head_link(_lru, link);
+
+	return g_object_ref(((ArtCacheEntry *) link->data)->pixbuf);
+}
+
+static void
+memory_insert(const gchar *key, GdkPixbuf *pixbuf)
+{
+	if (!_index)
+	{
+		_lru   = g_queue_new();
+		_index = g_hash_table_new(g_str_hash, g_str_equal);
+	}
+
+	if (g_hash_table_lookup(_index, key))
+		return;
+
+	ArtCacheEntry *entry = g_new0(ArtCacheEntry, 1);
+	entry->key    = g_strdup(key);
+	entry->pixbuf = g_object_ref(pixbuf);
+
+	g_queue_push_head(_lru, entry);
+	g_hash_table_insert(_index, entry->key, _lru->head);
+
+	while (g_queue_get_length(_lru) > MEMORY_CACHE_SIZE)
+	{
+		ArtCacheEntry *old = g_queue_pop_tail(_lru);
+		g_hash_table_remove(_index, old->key);
+		art_cache_entry_free(old);
+	}
+}
+
+/*
+ * Hashes the contents of @stream. The result is memoized on the stream so
+ * subsequent lookups for the same embedded image are free. Embedded images
+ * are memory streams so this never touches the disk.
+ */
+static const gchar *
+stream_get_key(GInputStream *stream)
+{
+	const gchar *memo = g_object_get_data((GObject *) stream, STREAM_KEY_DATA);
+	if (memo)
+		return memo;
+
+	if (!G_IS_SEEKABLE(stream) || !g_seekable_seek((GSeekable *) stream, 0, G_SEEK_SET, NULL, NULL))
+		return NULL;
+
+	GChecksum *checksum = g_checksum_new(G_CHECKSUM_MD5);
+	guchar buffer[16 * 1024];
+	gssize n;
+	GError *error = NULL;
+	while ((n = g_input_stream_read(stream, buffer, sizeof(buffer), NULL, &error)) > 0)
+		g_checksum_update(checksum, buffer, n);
+	g_seekable_seek((GSeekable *) stream, 0, G_SEEK_SET, NULL, NULL);
+
+	if (n < 0)
+	{
+		g_warning(_("Cannot hash image from input stream %p: %s"), stream, error->message);
+		g_error_free(error);
+		g_checksum_free(checksum);
+		return NULL;
+	}
+
+	gchar *key = g_strdup(g_checksum_get_string(checksum));
+	g_checksum_free(checksum);
+
+	g_object_set_data_full((GObject *) stream, STREAM_KEY_DATA, key, g_free);
+	return key;
+}
+
+/*
+ * Resolves @value into a cache key. For URIs and files the key is the MD5 of
+ * the URI, as mandated by the thumbnail spec, and *uri is filled for
+ * validation. Embedded images are keyed by the MD5 of their contents.
+ */
+static gchar *
+value_get_key(const GValue *value, gchar **uri)
+{
+	GType type = G_VALUE_TYPE(value);
+
+	*uri = NULL;
+
+	if (type == G_TYPE_STRING)
+		*uri = g_value_dup_string(value);
+
+	else if (type == G_TYPE_FILE)
+		*uri = g_file_get_uri((GFile *) g_value_get_object(value));
+
+	else if (type == G_TYPE_INPUT_STREAM)
+		return g_strdup(stream_get_key((GInputStream *) g_value_get_object(value)));
+
+	else
+		return NULL;
+
+	return g_compute_checksum_for_string(G_CHECKSUM_MD5, *uri, -1);
+}
+
+/*
+ * Disk access and decoding run in order on a single worker thread, so
+ * thumbnails are never read while being written and embedded images are
+ * read by one thread at a time.
+ */
+typedef struct {
+	GFunc    func;
+	gpointer data;
+} ArtCacheTask;
+
+static GThreadPool *_pool = NULL;
+
+static void
+art_cache_task_run(ArtCacheTask *task, gpointer unused)
+{
+	task->func(task->data, NULL);
+	g_free(task);
+}
+
+static void
+art_cache_push(GFunc func, gpointer data)
+{
+	ArtCacheTask *task = g_new0(ArtCacheTask, 1);
+	task->func = func;
+	task->data = data;
+
+	GError *error = NULL;
+	if (!_pool && g_thread_supported())
+		_pool = g_thread_pool_new((GFunc) art_cache_task_run, NULL, 1, FALSE, &error);
+	if (!_pool)
+	{
+		if (error)
+		{
+			g_warning(_("Unable to create art cache thread: %s"), error->message);
+			g_error_free(error);
+		}
+		art_cache_task_run(task, NULL);
+		return;
+	}
+
+	g_thread_pool_push(_pool, task, NULL);
+}
+
+/*
+ * Source mtimes are checked off the main loop: thumbnails are served right
+ * away and dropped from both caches if the check finds them stale, fresh
+ * thumbnails are written once the mtime to stamp them with is known.
+ */
+typedef struct {
+	gchar     *key;
+	gchar     *path;
+	gchar     *uri;
+	guint64    mtime;  // Stored in the thumbnail, for validation
+	GdkPixbuf *thumb;  // To store, %NULL for validation
+} ArtCacheCheck;
+
+static void
+art_cache_check_free(ArtCacheCheck *check)
+{
+	g_free(check->key);
+	g_free(check->path);
+	g_free(check->uri);
+	gel_free_and_invalidate(check->thumb, NULL, g_object_unref);
+	g_free(check);
+}
+
+static void disk_store(const gchar *path, GdkPixbuf *thumb, const gchar *uri, guint64 mtime);
+
+static void
+art_cache_store_task(ArtCacheCheck *check, gpointer unused)
+{
+	disk_store(check->path, check->thumb, check->uri, check->mtime);
+	art_cache_check_free(check);
+}
+
+static void
+art_cache_unlink_task(gchar *path, gpointer unused)
+{
+	g_unlink(path);
+	g_free(path);
+}
+
+static void
+art_cache_check_cb(GFile *file, GAsyncResult *res, ArtCacheCheck *check)
+{
+	GFileInfo *info = g_file_query_info_finish(file, res, NULL);
+	guint64 mtime = info ? g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED) : 0;
+	gel_free_and_invalidate(info, NULL, g_object_unref);
+	g_object_unref(file);
+
+	if (check->thumb)
+	{
+		check->mtime = mtime;
+		art_cache_push((GFunc) art_cache_store_task, check);
+		return;
+	}
+
+	if (mtime && (mtime != check->mtime))
+	{
+		debug("Stale thumbnail %s", check->path);
+		art_cache_push((GFunc) art_cache_unlink_task, g_strdup(check->path));
+		memory_remove(check->key);
+	}
+
+	art_cache_check_free(check);
+}
+
+static void
+art_cache_check(const gchar *key, const gchar *path, const gchar *uri, guint64 mtime, GdkPixbuf *thumb)
+{
+	ArtCacheCheck *check = g_new0(ArtCacheCheck, 1);
+	check->key   = g_strdup(key);
+	check->path  = g_strdup(path);
+	check->uri   = g_strdup(uri);
+	check->mtime = mtime;
+	check->thumb = thumb ? g_object_ref(thumb) : NULL;
+
+	g_file_query_info_async(g_file_new_for_uri(uri), G_FILE_ATTRIBUTE_TIME_MODIFIED,
+		G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW, NULL,
+		(GAsyncReadyCallback) art_cache_check_cb, check);
+}
+
+static gint
+size_to_bucket(gint size, const gchar **name)
+{
+	if (size <= EINA_ART_CACHE_SIZE_NORMAL)
+	{
+		*name = "normal";
+		return EINA_ART_CACHE_SIZE_NORMAL;
+	}
+	if (size <= EINA_ART_CACHE_SIZE_LARGE)
+	{
+		*name = "large";
+		return EINA_ART_CACHE_SIZE_LARGE;
+	}
+	if (size <= EINA_ART_CACHE_SIZE_XLARGE)
+	{
+		*name = "x-large";
+		return EINA_ART_CACHE_SIZE_XLARGE;
+	}
+	*name = "xx-large";
+	return EINA_ART_CACHE_SIZE_XXLARGE;
+}
+
+/*
+ * Scales @pixbuf down to fit in a @size x @size box, keeping aspect ratio.
+ * Never upscales.
+ */
+static GdkPixbuf *
+scale_to_fit(GdkPixbuf *pixbuf, gint size)
+{
+	gint w = gdk_pixbuf_get_width(pixbuf);
+	gint h = gdk_pixbuf_get_height(pixbuf);
+
+	if ((w <= size) && (h <= size))
+		return g_object_ref(pixbuf);
+
+	gdouble scale = MIN((gdouble) size / w, (gdouble) size / h);
+	return gdk_pixbuf_scale_simple(pixbuf,
+		MAX(1, (gint) (w * scale)), MAX(1, (gint) (h * scale)),
+		GDK_INTERP_BILINEAR);
+}
+
+/*
+ * Loads the thumbnail at @path, *mtime is set to the source mtime stored in
+ * it or 0
+ */
+static GdkPixbuf *
+disk_lookup(const gchar *path, guint64 *mtime)
+{
+	*mtime = 0;
+	if (!g_file_test(path, G_FILE_TEST_IS_REGULAR))
+		return NULL;
+
+	GdkPixbuf *ret = gdk_pixbuf_new_from_file(path, NULL);
+	if (!ret)
+		return NULL;
+
+	const gchar *stored = gdk_pixbuf_get_option(ret, "tEXt::Thumb::MTime");
+	if (stored)
+		*mtime = g_ascii_strtoull(stored, NULL, 10);
+
+	return ret;
+}
+
+static void
+disk_store(const gchar *path, GdkPixbuf *thumb, const gchar *uri, guint64 mtime)
+{
+	gchar *dirname = g_path_get_dirname(path);
+	if (g_mkdir_with_parents(dirname, 0700) < 0)
+	{
+		g_warning(_("Cannot create thumbnail directory '%s'"), dirname);
+		g_free(dirname);
+		return;
+	}
+	g_free(dirname);
+
+	gchar *mtime_str = g_strdup_printf("%" G_GUINT64_FORMAT, mtime);
+	gchar *keys[3]   = { NULL };
+	gchar *values[3] = { NULL };
+	guint n = 0;
+	if (uri)
+	{
+		keys[n]   = "tEXt::Thumb::URI";
+		values[n] = (gchar *) uri;
+		n++;
+	}
+	if (mtime)
+	{
+		keys[n]   = "tEXt::Thumb::MTime";
+		values[n] = mtime_str;
+		n++;
+	}
+
+	// Write to a temporary file and rename, readers must never see a
+	// partially written thumbnail
+	gchar *tmp = g_strconcat(path, ".tmp", NULL);
+	GError *error = NULL;
+	if (!gdk_pixbuf_savev(thumb, tmp, "png", keys, values, &error))
+	{
+		g_warning(_("Cannot save thumbnail '%s': %s"), tmp, error->message);
+		g_error_free(error);
+		g_unlink(tmp);
+	}
+	else if (g_rename(tmp, path) < 0)
+		g_unlink(tmp);
+
+	g_free(tmp);
+	g_free(mtime_str);
+}
+
+/*
+ * Lookups
+ */
+typedef struct {
+	gchar           *key;     // %NULL if the art can't be cached
+	gchar           *mem_key;
+	gchar           *path;    // Thumbnail
+	gchar           *uri;     // Source, %NULL for embedded images
+	GValue           value;   // Unset on memory hits
+	gint             size;
+	gint             bucket;
+	GCancellable    *cancellable;
+	EinaArtCacheFunc callback;
+	gpointer         data;
+	GDestroyNotify   notify;
+
+	// Filled by the worker
+	GdkPixbuf *pixbuf;
+	GdkPixbuf *thumb;     // Decoded from the source, stored once its mtime is known
+	gboolean   from_disk;
+	guint64    mtime;     // Stored in the thumbnail
+} ArtCacheJob;
+
+static void
+art_cache_job_free(ArtCacheJob *job)
+{
+	g_free(job->key);
+	g_free(job->mem_key);
+	g_free(job->path);
+	g_free(job->uri);
+	if (G_IS_VALUE(&job->value))
+		g_value_unset(&job->value);
+	gel_free_and_invalidate(job->cancellable, NULL, g_object_unref);
+	gel_free_and_invalidate(job->pixbuf,      NULL, g_object_unref);
+	gel_free_and_invalidate(job->thumb,       NULL, g_object_unref);
+	if (job->notify)
+		job->notify(job->data);
+	g_free(job);
+}
+
+static gboolean
+art_cache_job_done(ArtCacheJob *job)
+{
+	if (job->pixbuf && job->mem_key)
+		memory_insert(job->mem_key, job->pixbuf);
+	if (job->uri && job->from_disk)
+		art_cache_check(job->key, job->path, job->uri, job->mtime, NULL);
+	else if (job->uri && job->thumb)
+		art_cache_check(job->key, job->path, job->uri, 0, job->thumb);
+
+	GError *error = NULL;
+	if (g_cancellable_set_error_if_cancelled(job->cancellable, &error))
+	{
+		job->callback(NULL, error, job->data);
+		g_error_free(error);
+	}
+	else
+		job->callback(job->pixbuf, NULL, job->data);
+
+	art_cache_job_free(job);
+	return FALSE;
+}
+
+static void
+art_cache_job_load(ArtCacheJob *job)
+{
+	GdkPixbuf *thumb = job->path ? disk_lookup(job->path, &job->mtime) : NULL;
+	if (thumb)
+		job->from_disk = TRUE;
+	else
+	{
+		debug("Miss for %s, decoding source", job->path);
+		GdkPixbuf *full = gel_ui_pixbuf_from_value(&job->value);
+		if (full && job->path)
+		{
+			thumb = scale_to_fit(full, job->bucket);
+			if (job->uri)
+				job->thumb = g_object_ref(thumb);
+			else
+				disk_store(job->path, thumb, NULL, 0);
+		}
+		else if (full)
+			thumb = g_object_ref(full);
+		gel_free_and_invalidate(full, NULL, g_object_unref);
+	}
+
+	if (thumb)
+	{
+		job->pixbuf = scale_to_fit(thumb, job->size);
+		g_object_unref(thumb);
+	}
+}
+
+static void
+art_cache_job_run(ArtCacheJob *job, gpointer unused)
+{
+	if (!g_cancellable_is_cancelled(job->cancellable))
+		art_cache_job_load(job);
+	g_idle_add((GSourceFunc) art_cache_job_done, job);
+}
+
+/**
+ * eina_art_cache_lookup_async:
+ * @value: (transfer none): A #GValue as found in LOMO_STREAM_EM_ART_DATA
+ * @size: Maximum width and height of the returned pixbuf
+ * @cancellable: (allow-none): A #GCancellable
+ * @callback: (scope async): Function to call with the result
+ * @data: (closure): User data for @callback
+ * @notify: (allow-none): Called on @data after @callback
+ *
+ * Loads art from @value scaled down to fit in @size x @size. Results are
+ * served from an in-memory LRU, then from the on-disk thumbnail cache under
+ * eina_fs_get_cache_dir() and finally by decoding the source, which
+ * populates both caches. Disk access and decoding happen on a worker
+ * thread.
+ *
+ * Thumbnails of files are validated against the source mtime
+ * asynchronously, a stale one is served once and replaced on the next
+ * lookup.
+ *
+ * @callback is always called from the main loop, never before this function
+ * returns. If @cancellable is cancelled it gets %G_IO_ERROR_CANCELLED.
+ */
+void
+eina_art_cache_lookup_async(const GValue *value, gint size, GCancellable *cancellable,
+	EinaArtCacheFunc callback, gpointer data, GDestroyNotify notify)
+{
+	g_return_if_fail(G_IS_VALUE(value));
+	g_return_if_fail(size > 0);
+	g_return_if_fail(callback != NULL);
+
+	ArtCacheJob *job = g_new0(ArtCacheJob, 1);
+	job->size        = size;
+	job->cancellable = cancellable ? g_object_ref(cancellable) : NULL;
+	job->callback    = callback;
+	job->data        = data;
+	job->notify      = notify;
+
+	job->key = value_get_key(value, &job->uri);
+	if (job->key)
+	{
+		job->mem_key = g_strdup_printf("%s@%d", job->key, size);
+		if ((job->pixbuf = memory_lookup(job->mem_key)) != NULL)
+		{
+			g_idle_add((GSourceFunc) art_cache_job_done, job);
+			return;
+		}
+
+		const gchar *bucket_name = NULL;
+		job->bucket = size_to_bucket(size, &bucket_name);
+
+		gchar *basename = g_strconcat(job->key, ".png", NULL);
+		job->path = g_build_filename(eina_fs_get_cache_dir(), "thumbnails", bucket_name, basename, NULL);
+		g_free(basename);
+	}
+
+	g_value_init(&job->value, G_VALUE_TYPE(value));
+	g_value_copy(value, &job->value);
+
+	art_cache_push((GFunc) art_cache_job_run, job);
+}
+
+/**
+ * eina_art_cache_purge_memory:
+ *
+ * Drops all decoded pixbufs held in memory. The on-disk cache is untouched.
+ */
+void
+eina_art_cache_purge_memory(void)
+{
+	if (!_index)
+		return;
+
+	g_hash_table_destroy(_index);
+	g_queue_foreach(_lru, (GFunc) art_cache_entry_free, NULL);
+	g_queue_free(_lru);
+
+	_index = NULL;
+	_lru   = NULL;
+}
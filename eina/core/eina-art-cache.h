@@ -0,0 +1,53 @@
+/*
+ * eina/core/eina-art-cache.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EINA_ART_CACHE_H
+#define _EINA_ART_CACHE_H
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Thumbnail sizes as defined by the freedesktop thumbnail spec, requests are
+ * served from the smallest bucket that fits them.
+ */
+#define EINA_ART_CACHE_SIZE_NORMAL   128
+#define EINA_ART_CACHE_SIZE_LARGE    256
+#define EINA_ART_CACHE_SIZE_XLARGE   512
+#define EINA_ART_CACHE_SIZE_XXLARGE 1024
+
+/**
+ * EinaArtCacheFunc:
+ * @pixbuf: (allow-none) (transfer none): The art, %NULL if it can't be loaded
+ * @error: (allow-none): Set if the lookup was cancelled
+ * @data: User data
+ *
+ * Callback for eina_art_cache_lookup_async()
+ */
+typedef void (*EinaArtCacheFunc)(GdkPixbuf *pixbuf, const GError *error, gpointer data);
+
+void eina_art_cache_lookup_async(const GValue *value, gint size, GCancellable *cancellable,
+	EinaArtCacheFunc callback, gpointer data, GDestroyNotify notify);
+void eina_art_cache_purge_memory(void);
+
+G_END_DECLS
+
+#endif
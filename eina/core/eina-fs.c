@@ -34,6 +34,7 @@
 #include <gel/gel-io.h>
 #include <lomo/lomo.h>
 #include "eina-file-utils.h"
+#include "eina-playlist-loader.h"
 #include "eina-stock.h"
 
 static void
@@ -90,7 +91,7 @@ eina_fs_load_uri_strv(EinaApplication *app,  const gchar *const *uris)
  * @app: An #EinaApplication
  * @playlist: Pathname to playlist file
  *
- * Loads playlist into @app
+ * Loads playlist into @app asynchronously, see eina_playlist_loader_load()
  */
 void
 eina_fs_load_playlist(EinaApplication *app, const gchar *playlist)
@@ -98,38 +99,9 @@ eina_fs_load_playlist(EinaApplication *app, const gchar *playlist)
 	g_return_if_fail(EINA_IS_APPLICATION(app));
 	g_return_if_fail(g_file_test(playlist, G_FILE_TEST_IS_REGULAR));
 
-	gchar *buffer = NULL;
-	GError *error = NULL;
-	gsize   reads = -1;
-	if (!g_file_get_contents(playlist, &buffer, &reads, &error))
-	{
-		g_warning("%s", error->message);
-		g_error_free(error);
-		return;
-	}
-	if (reads == 0)
-	{
-		g_free(buffer);
-		return;
-	}
-
-	gchar **lines = g_strsplit_set(buffer, "\n\r", 0);
-	g_free(buffer);
-
-	g_return_if_fail(lines && lines[0]);
-
-	GFile **gfiles = g_new0(GFile*, g_strv_length(lines));
-
-	guint n = 0;
-	for (guint i = 0; lines[i]; i++)
-		if (lines[i] && (lines[i][0] != '\0'))
-			gfiles[n++] = g_file_new_for_commandline_arg(lines[i]);
-	g_strfreev(lines);
-
-	eina_fs_load_gfile_array(app, gfiles, n);
-	for (guint i = 0; i < n; i++)
-		g_object_unref(gfiles[i]);
-	g_free(gfiles);
+	GFile *file = g_file_new_for_path(playlist);
+	eina_playlist_loader_load(app, file, NULL);
+	g_object_unref(file);
 }
 
 static void
@@ -584,9 +556,26 @@ eina_fs_mkdir(const gchar *pathname, gint mode, GError **error)
 const gchar*
 eina_fs_get_cache_dir(void)
 {
-	const gchar *ret = NULL;
+	static gchar *ret = NULL;
 	if (!ret)
 		ret = g_build_filename(g_get_user_cache_dir(), gel_get_package_name(), NULL);
 	return ret;
 }
 
+/**
+ * eina_fs_get_data_dir:
+ *
+ * Get the data dir for the current user. Unlike the cache dir, files here
+ * can't be recreated if lost.
+ *
+ * Returns: The data directory
+ */
+const gchar*
+eina_fs_get_data_dir(void)
+{
+	static gchar *ret = NULL;
+	if (!ret)
+		ret = g_build_filename(g_get_user_data_dir(), gel_get_package_name(), NULL);
+	return ret;
+}
+
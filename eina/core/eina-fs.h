@@ -47,6 +47,7 @@ gboolean eina_fs_file_test(const gchar *utf8_path, GFileTest test);
 gboolean eina_fs_mkdir    (const gchar *pathname, gint mode, GError **error);
 
 const gchar* eina_fs_get_cache_dir(void);
+const gchar* eina_fs_get_data_dir (void);
 
 #endif
 
@@ -0,0 +1,611 @@
+/*
+ * eina/core/eina-playlist-loader.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define LIBLOMO_USE_PRIVATE_API
+#include "eina-playlist-loader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gi18n.h>
+#include <gel/gel.h>
+#include <lomo/lomo.h>
+#include "eina-file-utils.h"
+#include "eina-fs.h"
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaPlaylistLoader"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// Bytes read per main loop iteration
+#define CHUNK_SIZE (64 * 1024)
+
+// Streams are handed to LomoPlayer in batches of this size
+#define BATCH_SIZE 512
+
+/*
+ * Loading is driven by g_input_stream_read_async(): each chunk is fed to the
+ * parser for the detected format, which pushes complete entries into a batch
+ * that is inserted into the player as it fills up.
+ */
+typedef struct {
+	EinaApplication *app;
+	GFile           *file;
+	GFile           *parent;
+	GCancellable    *cancellable;
+	GInputStream    *input;
+	guchar           buffer[CHUNK_SIZE];
+
+	EinaPlaylistFormat format;
+	GList *batch;   // <LomoStream, reversed
+	guint  n_batch;
+	guint  n_total;
+
+	// Line based formats (M3U, PLS)
+	GString *carry;
+
+	// M3U: pending #EXTINF data
+	gchar  *extinf_title;
+	gchar  *extinf_artist;
+	gint64  extinf_length;
+
+	// PLS: current entry
+	gint    pls_index;
+	gchar  *pls_file;
+	gchar  *pls_title;
+	gint64  pls_length;
+
+	// XSPF
+	GMarkupParseContext *markup;
+	gboolean in_track;
+	GString *text;
+	gchar   *xspf_location;
+	gchar   *xspf_title;
+	gchar   *xspf_creator;
+	gchar   *xspf_album;
+	gint64   xspf_length;
+} Loader;
+
+static void
+loader_read_cb(GInputStream *input, GAsyncResult *res, Loader *self);
+
+static void
+loader_free(Loader *self)
+{
+	gel_free_and_invalidate(self->input,       NULL, g_object_unref);
+	gel_free_and_invalidate(self->cancellable, NULL, g_object_unref);
+	gel_free_and_invalidate(self->parent,      NULL, g_object_unref);
+	g_object_unref(self->file);
+	g_object_unref(self->app);
+
+	gel_list_deep_free(self->batch, g_object_unref);
+	if (self->carry)
+		g_string_free(self->carry, TRUE);
+	if (self->text)
+		g_string_free(self->text, TRUE);
+	if (self->markup)
+		g_markup_parse_context_free(self->markup);
+
+	g_free(self->extinf_title);
+	g_free(self->extinf_artist);
+	g_free(self->pls_file);
+	g_free(self->pls_title);
+	g_free(self->xspf_location);
+	g_free(self->xspf_title);
+	g_free(self->xspf_creator);
+	g_free(self->xspf_album);
+	g_free(self);
+}
+
+/*
+ * Entries
+ */
+static gchar *
+loader_to_utf8(const gchar *str)
+{
+	if (!str || !str[0])
+		return NULL;
+	if (g_utf8_validate(str, -1, NULL))
+		return g_strdup(str);
+
+	// Plain .m3u files are usually latin1
+	return g_convert(str, -1, "UTF-8", "ISO-8859-1", NULL, NULL, NULL);
+}
+
+static gchar *
+loader_resolve_uri(Loader *self, const gchar *location)
+{
+	gchar *scheme = g_uri_parse_scheme(location);
+	if (scheme)
+	{
+		g_free(scheme);
+		return g_strdup(location);
+	}
+
+	if (g_path_is_absolute(location))
+		return g_filename_to_uri(location, NULL, NULL);
+
+	if (!self->parent)
+		return NULL;
+
+	GFile *f = g_file_resolve_relative_path(self->parent, location);
+	gchar *ret = g_file_get_uri(f);
+	g_object_unref(f);
+	return ret;
+}
+
+static void
+loader_flush(Loader *self)
+{
+	if (!self->batch)
+		return;
+
+	GList *streams = g_list_reverse(self->batch);
+	self->batch   = NULL;
+	self->n_batch = 0;
+
+	LomoPlayer *lomo = eina_application_get_interface(self->app, "lomo");
+	if (LOMO_IS_PLAYER(lomo))
+		lomo_player_insert_multiple(lomo, streams, -1);
+	else
+		g_warn_if_fail(LOMO_IS_PLAYER(lomo));
+
+	gel_list_deep_free(streams, g_object_unref);
+}
+
+/*
+ * Creates a stream for @location pre-seeded with the data found in the
+ * playlist. These tags are provisional, LomoPlayer still queues the stream
+ * for metadata parsing behind anything already waiting. Local entries
+ * without a known extension may be directories, those are expanded with
+ * eina_fs_load_uri_strv() and appended once scanned.
+ */
+static void
+loader_add_entry(Loader *self, const gchar *location,
+	const gchar *title, const gchar *artist, const gchar *album, gint64 length)
+{
+	if (!location || !location[0])
+		return;
+
+	gchar *uri = loader_resolve_uri(self, location);
+	if (!uri)
+		return;
+
+	if (g_str_has_prefix(uri, "file:") && !eina_file_utils_is_supported_extension(uri))
+	{
+		// Keep previous entries ahead of the scanned ones
+		loader_flush(self);
+
+		const gchar *uris[] = { uri, NULL };
+		eina_fs_load_uri_strv(self->app, uris);
+		g_free(uri);
+		return;
+	}
+
+	LomoStream *stream = lomo_stream_new(uri);
+	g_free(uri);
+	if (!stream)
+		return;
+
+	const gchar *keys[]   = { LOMO_TAG_TITLE, LOMO_TAG_ARTIST, LOMO_TAG_ALBUM };
+	const gchar *values[] = { title, artist, album };
+	GValue v = { 0 };
+	g_value_init(&v, G_TYPE_STRING);
+	for (guint i = 0; i < G_N_ELEMENTS(keys); i++)
+	{
+		gchar *utf8 = loader_to_utf8(values[i]);
+		if (!utf8)
+			continue;
+		g_value_take_string(&v, utf8);
+		lomo_stream_set_tag(stream, keys[i], &v);
+	}
+	g_value_unset(&v);
+
+	if (length >= 0)
+		lomo_stream_set_length(stream, length);
+
+	self->batch = g_list_prepend(self->batch, stream);
+	self->n_total++;
+	if (++self->n_batch >= BATCH_SIZE)
+		loader_flush(self);
+}
+
+/*
+ * M3U / EXTM3U
+ */
+static void
+m3u_parse_line(Loader *self, gchar *line)
+{
+	if (g_str_has_prefix(line, "#EXTINF:"))
+	{
+		// #EXTINF:<seconds>[ attributes],<artist> - <title>
+		gchar *p = line + strlen("#EXTINF:");
+		gint64 secs = g_ascii_strtoll(p, NULL, 10);
+		gchar *display = strchr(p, ',');
+
+		g_free(self->extinf_title);
+		g_free(self->extinf_artist);
+		self->extinf_title  = NULL;
+		self->extinf_artist = NULL;
+		self->extinf_length = (secs > 0) ? LOMO_SECS_TO_NANOSECS(secs) : -1;
+
+		if (!display)
+			return;
+		display++;
+
+		gchar *sep = strstr(display, " - ");
+		if (sep)
+		{
+			self->extinf_artist = g_strndup(display, sep - display);
+			self->extinf_title  = g_strdup(sep + 3);
+		}
+		else
+			self->extinf_title = g_strdup(display);
+		return;
+	}
+
+	// #EXTM3U and other comments
+	if (line[0] == '#')
+		return;
+
+	loader_add_entry(self, line, self->extinf_title, self->extinf_artist, NULL, self->extinf_length);
+
+	gel_free_and_invalidate(self->extinf_title,  NULL, g_free);
+	gel_free_and_invalidate(self->extinf_artist, NULL, g_free);
+	self->extinf_length = -1;
+}
+
+/*
+ * PLS
+ */
+static void
+pls_emit(Loader *self)
+{
+	loader_add_entry(self, self->pls_file, self->pls_title, NULL, NULL, self->pls_length);
+
+	gel_free_and_invalidate(self->pls_file,  NULL, g_free);
+	gel_free_and_invalidate(self->pls_title, NULL, g_free);
+	self->pls_length = -1;
+}
+
+static void
+pls_parse_line(Loader *self, gchar *line)
+{
+	gchar *eq = strchr(line, '=');
+	if ((line[0] == '[') || !eq)
+		return;
+
+	*eq = '\0';
+	const gchar *key   = line;
+	const gchar *value = eq + 1;
+
+	const gchar *prefixes[] = { "File", "Title", "Length" };
+	for (guint i = 0; i < G_N_ELEMENTS(prefixes); i++)
+	{
+		if (!g_str_has_prefix(key, prefixes[i]))
+			continue;
+
+		// Entries are grouped by index, a new index closes the previous one
+		gint index = atoi(key + strlen(prefixes[i]));
+		if ((index != self->pls_index) && (self->pls_file || self->pls_title))
+			pls_emit(self);
+		self->pls_index = index;
+
+		switch (i)
+		{
+		case 0:
+			g_free(self->pls_file);
+			self->pls_file = g_strdup(value);
+			break;
+		case 1:
+			g_free(self->pls_title);
+			self->pls_title = g_strdup(value);
+			break;
+		case 2:
+			self->pls_length = (atoi(value) > 0) ? LOMO_SECS_TO_NANOSECS((gint64) atoi(value)) : -1;
+			break;
+		}
+		return;
+	}
+}
+
+/*
+ * XSPF
+ */
+static void
+xspf_start_element(GMarkupParseContext *context, const gchar *element,
+	const gchar **names, const gchar **values, gpointer data, GError **error)
+{
+	Loader *self = (Loader *) data;
+	if (g_str_equal(element, "track"))
+	{
+		self->in_track = TRUE;
+		self->xspf_length = -1;
+	}
+	g_string_truncate(self->text, 0);
+}
+
+static void
+xspf_end_element(GMarkupParseContext *context, const gchar *element, gpointer data, GError **error)
+{
+	Loader *self = (Loader *) data;
+	if (!self->in_track)
+		return;
+
+	gchar **target = NULL;
+	if (g_str_equal(element, "location") && !self->xspf_location)
+		target = &self->xspf_location;
+	else if (g_str_equal(element, "title"))
+		target = &self->xspf_title;
+	else if (g_str_equal(element, "creator"))
+		target = &self->xspf_creator;
+	else if (g_str_equal(element, "album"))
+		target = &self->xspf_album;
+	else if (g_str_equal(element, "duration"))
+	{
+		// Milliseconds
+		gint64 ms = g_ascii_strtoll(self->text->str, NULL, 10);
+		self->xspf_length = (ms > 0) ? ms * 1000000L : -1;
+	}
+	else if (g_str_equal(element, "track"))
+	{
+		loader_add_entry(self, self->xspf_location,
+			self->xspf_title, self->xspf_creator, self->xspf_album, self->xspf_length);
+
+		gel_free_and_invalidate(self->xspf_location, NULL, g_free);
+		gel_free_and_invalidate(self->xspf_title,    NULL, g_free);
+		gel_free_and_invalidate(self->xspf_creator,  NULL, g_free);
+		gel_free_and_invalidate(self->xspf_album,    NULL, g_free);
+		self->in_track = FALSE;
+	}
+
+	if (target)
+	{
+		g_free(*target);
+		*target = g_strstrip(g_strdup(self->text->str));
+	}
+}
+
+static void
+xspf_text(GMarkupParseContext *context, const gchar *text, gsize len, gpointer data, GError **error)
+{
+	Loader *self = (Loader *) data;
+	if (self->in_track)
+		g_string_append_len(self->text, text, len);
+}
+
+static GMarkupParser xspf_parser = {
+	xspf_start_element,
+	xspf_end_element,
+	xspf_text,
+	NULL,
+	NULL
+};
+
+/*
+ * Driver
+ */
+static EinaPlaylistFormat
+loader_detect_format(Loader *self, const gchar *data, gsize len)
+{
+	gchar *basename = g_file_get_basename(self->file);
+	gchar *lc = g_ascii_strdown(basename ? basename : "", -1);
+	g_free(basename);
+
+	EinaPlaylistFormat ret = EINA_PLAYLIST_FORMAT_UNKNOWN;
+	if (g_str_has_suffix(lc, ".pls"))
+		ret = EINA_PLAYLIST_FORMAT_PLS;
+	else if (g_str_has_suffix(lc, ".xspf"))
+		ret = EINA_PLAYLIST_FORMAT_XSPF;
+	else if (g_str_has_suffix(lc, ".m3u") || g_str_has_suffix(lc, ".m3u8"))
+		ret = EINA_PLAYLIST_FORMAT_M3U;
+	g_free(lc);
+
+	if (ret != EINA_PLAYLIST_FORMAT_UNKNOWN)
+		return ret;
+
+	// Sniff content, plain URI lists are handled as M3U
+	gchar *head = g_strndup(data, MIN(len, 256));
+	g_strchug(head);
+	if (g_str_has_prefix(head, "[playlist]"))
+		ret = EINA_PLAYLIST_FORMAT_PLS;
+	else if (g_str_has_prefix(head, "<?xml") || g_str_has_prefix(head, "<playlist"))
+		ret = EINA_PLAYLIST_FORMAT_XSPF;
+	else
+		ret = EINA_PLAYLIST_FORMAT_M3U;
+	g_free(head);
+
+	return ret;
+}
+
+static void
+loader_feed_lines(Loader *self, const gchar *data, gsize len, gboolean eof)
+{
+	g_string_append_len(self->carry, data, len);
+
+	gchar *start = self->carry->str;
+	gchar *nl;
+	while ((nl = memchr(start, '\n', self->carry->str + self->carry->len - start)) || (eof && *start))
+	{
+		if (nl)
+			*nl = '\0';
+
+		gchar *line = g_strstrip(start);
+		if (line[0])
+		{
+			if (self->format == EINA_PLAYLIST_FORMAT_PLS)
+				pls_parse_line(self, line);
+			else
+				m3u_parse_line(self, line);
+		}
+
+		if (!nl)
+		{
+			start = self->carry->str + self->carry->len;
+			break;
+		}
+		start = nl + 1;
+	}
+	g_string_erase(self->carry, 0, start - self->carry->str);
+}
+
+static gboolean
+loader_feed(Loader *self, const gchar *data, gsize len, gboolean eof)
+{
+	if (self->format == EINA_PLAYLIST_FORMAT_UNKNOWN)
+	{
+		// .m3u8 files from Windows tools often start with an UTF-8 BOM, it
+		// would end up glued to the first line (#EXTM3U or an URI)
+		if ((len >= 3) && !memcmp(data, "\xef\xbb\xbf", 3))
+		{
+			data += 3;
+			len  -= 3;
+		}
+
+		self->format = loader_detect_format(self, data, len);
+		debug("Format detected: %d", self->format);
+
+		if (self->format == EINA_PLAYLIST_FORMAT_XSPF)
+		{
+			self->text   = g_string_new(NULL);
+			self->markup = g_markup_parse_context_new(&xspf_parser, 0, self, NULL);
+		}
+		else
+			self->carry = g_string_new(NULL);
+	}
+
+	if (self->format != EINA_PLAYLIST_FORMAT_XSPF)
+	{
+		loader_feed_lines(self, data, len, eof);
+		if (eof && (self->format == EINA_PLAYLIST_FORMAT_PLS) && (self->pls_file || self->pls_title))
+			pls_emit(self);
+		return TRUE;
+	}
+
+	GError *error = NULL;
+	if ((len && !g_markup_parse_context_parse(self->markup, data, len, &error)) ||
+		(eof && !g_markup_parse_context_end_parse(self->markup, &error)))
+	{
+		gchar *uri = g_file_get_uri(self->file);
+		g_warning(_("Unable to parse playlist '%s': %s"), uri, error->message);
+		g_free(uri);
+		g_error_free(error);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+loader_finish(Loader *self)
+{
+	loader_flush(self);
+	debug("Loaded %u streams", self->n_total);
+
+	if (self->input)
+		g_input_stream_close_async(self->input, G_PRIORITY_LOW, NULL, NULL, NULL);
+	loader_free(self);
+}
+
+static void
+loader_read_next(Loader *self)
+{
+	g_input_stream_read_async(self->input, self->buffer, sizeof(self->buffer),
+		G_PRIORITY_LOW, self->cancellable,
+		(GAsyncReadyCallback) loader_read_cb, self);
+}
+
+static void
+loader_read_cb(GInputStream *input, GAsyncResult *res, Loader *self)
+{
+	GError *error = NULL;
+	gssize n = g_input_stream_read_finish(input, res, &error);
+
+	if (n < 0)
+	{
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		{
+			gchar *uri = g_file_get_uri(self->file);
+			g_warning(_("Unable to read playlist '%s': %s"), uri, error->message);
+			g_free(uri);
+		}
+		g_error_free(error);
+		loader_finish(self);
+		return;
+	}
+
+	if (!loader_feed(self, (const gchar *) self->buffer, n, n == 0) || (n == 0))
+	{
+		loader_finish(self);
+		return;
+	}
+
+	loader_read_next(self);
+}
+
+static void
+loader_open_cb(GFile *file, GAsyncResult *res, Loader *self)
+{
+	GError *error = NULL;
+	self->input = (GInputStream *) g_file_read_finish(file, res, &error);
+	if (!self->input)
+	{
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		{
+			gchar *uri = g_file_get_uri(file);
+			g_warning(_("Unable to open playlist '%s': %s"), uri, error->message);
+			g_free(uri);
+		}
+		g_error_free(error);
+		loader_free(self);
+		return;
+	}
+
+	loader_read_next(self);
+}
+
+/**
+ * eina_playlist_loader_load:
+ * @app: An #EinaApplication
+ * @file: (transfer none): Playlist file to load
+ * @cancellable: (allow-none): A #GCancellable
+ *
+ * Asynchronously reads @file in chunks and appends its entries to the
+ * #LomoPlayer of @app in batches. M3U (with #EXTINF), PLS and XSPF are
+ * supported, anything else is read as a plain list of URIs or paths, relative
+ * paths are resolved against the directory of @file.
+ */
+void
+eina_playlist_loader_load(EinaApplication *app, GFile *file, GCancellable *cancellable)
+{
+	g_return_if_fail(EINA_IS_APPLICATION(app));
+	g_return_if_fail(G_IS_FILE(file));
+
+	Loader *self = g_new0(Loader, 1);
+	self->app    = g_object_ref(app);
+	self->file   = g_object_ref(file);
+	self->parent = g_file_get_parent(file);
+	self->cancellable   = cancellable ? g_object_ref(cancellable) : NULL;
+	self->extinf_length = -1;
+	self->pls_length    = -1;
+	self->pls_index     = -1;
+
+	g_file_read_async(file, G_PRIORITY_LOW, cancellable, (GAsyncReadyCallback) loader_open_cb, self);
+}
@@ -0,0 +1,39 @@
+/*
+ * eina/core/eina-playlist-loader.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _EINA_PLAYLIST_LOADER_H
+#define _EINA_PLAYLIST_LOADER_H
+
+#include <gio/gio.h>
+#include <eina/core/eina-application.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+	EINA_PLAYLIST_FORMAT_UNKNOWN = 0,
+	EINA_PLAYLIST_FORMAT_M3U,
+	EINA_PLAYLIST_FORMAT_PLS,
+	EINA_PLAYLIST_FORMAT_XSPF
+} EinaPlaylistFormat;
+
+void eina_playlist_loader_load(EinaApplication *app, GFile *file, GCancellable *cancellable);
+
+G_END_DECLS
+
+#endif
@@ -104,11 +104,25 @@ app_command_line_cb (EinaApplication *self, GApplicationCommandLine *command_lin
 		g_free(gfiles);
 		g_strfreev(opt_uris);
 	}
-	else
+	// Only bring back the saved playlist into an empty player, restoring
+	// replaces the playlist and would stop whatever is playing when a remote
+	// instance is just sending --pause or similar
+	else if (!opt_clear && (lomo_player_get_n_streams(lomo) == 0))
 	{
-		gchar *playlist = g_build_filename(g_get_user_config_dir(), PACKAGE, "playlist", NULL);
-		eina_fs_load_playlist(self, playlist);
-		g_free(playlist);
+		// Snapshot restores a fully tagged playlist, plain list is the fallback
+		gchar *snapshot = g_build_filename(g_get_user_config_dir(), PACKAGE, "playlist.snapshot", NULL);
+		GError *error = NULL;
+		if (!lomo_player_restore_snapshot(lomo, snapshot, &error))
+		{
+			if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+				g_warning(_("Unable to restore playlist snapshot: %s"), error->message);
+			g_error_free(error);
+
+			gchar *playlist = g_build_filename(g_get_user_config_dir(), PACKAGE, "playlist", NULL);
+			eina_fs_load_playlist(self, playlist);
+			g_free(playlist);
+		}
+		g_free(snapshot);
 	}
 
 	return 0;
@@ -6,6 +6,7 @@
 #include <time.h>
 #include <gel/gel-ui.h>
 #include <eina/core/eina-extension.h>
+#include <eina/core/eina-fs.h>
 #include <eina/lomo/eina-lomo-plugin.h>
 #include <eina/preferences/eina-preferences-plugin.h>
 #include <glib/gstdio.h>
@@ -66,7 +67,21 @@ eina_clastfm_plugin_activate (EinaActivatable *plugin, EinaApplication *app, GEr
 	g_signal_connect_swapped ((GObject *) priv->lomo, "eos",        (GCallback) clastfm_plugin_submit_stream,  self);
 	g_signal_connect_swapped ((GObject *) priv->lomo, "pre-change", (GCallback) clastfm_plugin_submit_stream,  self);
 
-	priv->th = lastfm_thread_new();
+	// Scrobbles survive crashes and offline periods in this journal. Unsent
+	// scrobbles are user data, older versions kept them in the cache dir.
+	gchar *spool     = g_build_filename(eina_fs_get_data_dir(),  "hipster", "spool", NULL);
+	gchar *old_spool = g_build_filename(eina_fs_get_cache_dir(), "hipster", "spool", NULL);
+	if (!g_file_test(spool, G_FILE_TEST_EXISTS) && g_file_test(old_spool, G_FILE_TEST_EXISTS))
+	{
+		gchar *dirname = g_path_get_dirname(spool);
+		g_mkdir_with_parents(dirname, 0700);
+		g_free(dirname);
+		if (g_rename(old_spool, spool) < 0)
+			g_warning("Unable to move spool '%s' to '%s'", old_spool, spool);
+	}
+	priv->th = lastfm_thread_new_with_spool(spool);
+	g_free(old_spool);
+	g_free(spool);
 
 	gchar *datadir = peas_extension_base_get_data_dir (PEAS_EXTENSION_BASE(plugin));
 	gchar *prefs_ui_path = g_build_filename (datadir, "preferences.ui", NULL);
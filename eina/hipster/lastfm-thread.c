@@ -1,14 +1,65 @@
 #include "lastfm-thread.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <string.h>
+#include <glib/gstdio.h>
 #include <clastfm.h>
 
 G_DEFINE_TYPE (LastFMThread, lastfm_thread, G_TYPE_OBJECT)
 
+/*
+ * Scrobbles are kept in an append-only journal: 'S' records add an entry,
+ * 'D' records mark it as submitted. Appends are fsync'ed once per worker
+ * pass and the journal is rewritten with just the pending entries when it's
+ * drained or gets too many 'D' records.
+ *
+ * Scrobbles the server keeps refusing while others are accepted, or refuses
+ * SPOOL_MAX_REFUSALS times in a row, are moved to '<spool>.rejected' in the
+ * same format so they can be inspected or sent by hand.
+ */
+#define SPOOL_BATCH_SIZE    50
+#define SPOOL_COMPACT_AFTER 1024
+#define SPOOL_MAX_REFUSALS  5
+
+// Back-off between failed submissions, in seconds
+#define BACKOFF_MIN   15
+#define BACKOFF_MAX 1800
+
+enum {
+	PROPERTY_SPOOL_PATH = 1
+};
+
+typedef struct {
+	guint64 seq;
+	gint64  spooled;  // <Wall clock, usecs
+	guint   refusals; // In a row, not kept across restarts
+	LastFMThreadMethodCall *call;
+} SpoolEntry;
+
 struct _LastFMThreadPrivate {
 	LASTFM_SESSION *sess;
+	gboolean        logged_in;
 	GQueue         *queue;
 	GThread        *worker_thread;
 	GMutex *sess_mutex, *queue_mutex, *subthread_mutex;
-
+	GCond  *queue_cond;
+	gboolean quit;
+
+	LastFMThreadSubmitFunc submit_func;
+	gpointer               submit_data;
+
+	// Worker thread only
+	gchar   *spool_path;
+	FILE    *journal;
+	gboolean journal_dirty;
+	guint    journal_done;
+	GQueue  *spool;
+	guint64  next_seq;
+	guint    backoff;
+	gint64   next_attempt;
+
+	// Protected by queue_mutex
+	LastFMThreadStats stats;
 };
 
 typedef struct {
@@ -26,43 +77,99 @@ gpointer _lastfm_thread_worker(LastFMThread *self);
 ThreadFuncData* thread_data_create  (LastFMThread *self, const LastFMThreadMethodCall *call, GCallback callback, gpointer user_data, GDestroyNotify notify);
 void            thread_call_destroy (ThreadFuncData *call);
 
+static LastFMThreadMethodCall* method_call_copy(const LastFMThreadMethodCall *call);
+static void                    method_call_free(LastFMThreadMethodCall *call);
+
+static void spool_entry_free(SpoolEntry *entry);
+static guint default_submit_func(LastFMThreadMethodCall **calls, guint n_calls, LastFMThreadSubmitResult *results, LastFMThread *self);
+
+static void
+lastfm_thread_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	switch (property_id) {
+	case PROPERTY_SPOOL_PATH:
+		g_value_set_string(value, LASTFM_THREAD(object)->priv->spool_path);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
+static void
+lastfm_thread_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	switch (property_id) {
+	case PROPERTY_SPOOL_PATH:
+		LASTFM_THREAD(object)->priv->spool_path = g_value_dup_string(value);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
 static void
 lastfm_thread_dispose (GObject *object)
 {
 	LastFMThread *self = LASTFM_THREAD(object);
 	LastFMThreadPrivate *priv = self->priv;
 
-	g_mutex_lock(priv->queue_mutex);
-	if (!g_queue_is_empty(priv->queue))
+	// Stop worker, anything not submitted is already in the journal
+	g_mutex_lock(priv->subthread_mutex);
+	if (priv->worker_thread)
 	{
 		g_mutex_lock(priv->queue_mutex);
+		priv->quit = TRUE;
+		g_cond_signal(priv->queue_cond);
+		g_mutex_unlock(priv->queue_mutex);
+
+		g_thread_join(priv->worker_thread);
+		priv->worker_thread = NULL;
+	}
+	g_mutex_unlock(priv->subthread_mutex);
 
+	if (priv->queue)
+	{
 		g_queue_foreach(priv->queue, (GFunc) thread_call_destroy, NULL);
 		g_queue_free(priv->queue);
 		priv->queue = NULL;
+	}
 
-		g_mutex_unlock(priv->queue_mutex);
+	if (priv->spool)
+	{
+		g_queue_foreach(priv->spool, (GFunc) spool_entry_free, NULL);
+		g_queue_free(priv->spool);
+		priv->spool = NULL;
+	}
 
-		GMutex *m = priv->queue_mutex; // not sure why I'm doing this, but sounds good
-		priv->queue_mutex  = NULL;
-		g_mutex_free(m);
+	if (priv->journal)
+	{
+		fclose(priv->journal);
+		priv->journal = NULL;
 	}
 
 	if (priv->sess)
 	{
-		g_mutex_lock(priv->sess_mutex);
 		LASTFM_dinit(priv->sess);
 		priv->sess = NULL;
-		g_mutex_unlock(priv->sess_mutex);
-
-		GMutex *m = priv->sess_mutex; // not sure why I'm doing this, but sounds good
-		priv->sess_mutex = NULL;
-		g_mutex_free(m);
 	}
 
 	G_OBJECT_CLASS (lastfm_thread_parent_class)->dispose (object);
 }
 
+static void
+lastfm_thread_finalize (GObject *object)
+{
+	LastFMThreadPrivate *priv = LASTFM_THREAD(object)->priv;
+
+	g_free(priv->spool_path);
+	g_cond_free(priv->queue_cond);
+	g_mutex_free(priv->sess_mutex);
+	g_mutex_free(priv->queue_mutex);
+	g_mutex_free(priv->subthread_mutex);
+
+	G_OBJECT_CLASS (lastfm_thread_parent_class)->finalize (object);
+}
+
 static void
 lastfm_thread_class_init (LastFMThreadClass *klass)
 {
@@ -70,7 +177,14 @@ lastfm_thread_class_init (LastFMThreadClass *klass)
 
 	g_type_class_add_private (klass, sizeof (LastFMThreadPrivate));
 
-	object_class->dispose = lastfm_thread_dispose;
+	object_class->get_property = lastfm_thread_get_property;
+	object_class->set_property = lastfm_thread_set_property;
+	object_class->dispose  = lastfm_thread_dispose;
+	object_class->finalize = lastfm_thread_finalize;
+
+	g_object_class_install_property(object_class, PROPERTY_SPOOL_PATH,
+		g_param_spec_string("spool-path", "Spool path", "Path to the scrobble journal",
+		NULL, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -80,7 +194,11 @@ lastfm_thread_init (LastFMThread *self)
 	priv->sess_mutex      = g_mutex_new();
 	priv->queue_mutex     = g_mutex_new();
 	priv->subthread_mutex = g_mutex_new();
+	priv->queue_cond      = g_cond_new();
 	priv->queue = g_queue_new();
+	priv->spool = g_queue_new();
+	priv->submit_func = (LastFMThreadSubmitFunc) default_submit_func;
+	priv->submit_data = self;
 }
 
 LastFMThread*
@@ -89,6 +207,79 @@ lastfm_thread_new (void)
 	return g_object_new (LASTFM_TYPE_THREAD, NULL);
 }
 
+static void
+worker_ensure(LastFMThread *self)
+{
+	LastFMThreadPrivate *priv = self->priv;
+
+	g_mutex_lock(priv->subthread_mutex);
+	if (!priv->worker_thread)
+		priv->worker_thread = g_thread_create((GThreadFunc) _lastfm_thread_worker, self, TRUE, NULL);
+	g_mutex_unlock(priv->subthread_mutex);
+}
+
+/*
+ * lastfm_thread_new_with_spool:
+ * @spool_path: Path to the journal file
+ *
+ * Creates a new #LastFMThread whose scrobbles are persisted in @spool_path.
+ * Scrobbles left from previous runs are loaded and submitted after login.
+ *
+ * Returns: The new #LastFMThread
+ */
+LastFMThread*
+lastfm_thread_new_with_spool(const gchar *spool_path)
+{
+	LastFMThread *self = g_object_new (LASTFM_TYPE_THREAD, "spool-path", spool_path, NULL);
+
+	// Start worker now so the journal gets loaded
+	worker_ensure(self);
+
+	return self;
+}
+
+/*
+ * lastfm_thread_set_submit_func:
+ * @self: A #LastFMThread
+ * @func: (allow-none): A #LastFMThreadSubmitFunc or %NULL for the default
+ * @user_data: Data for @func
+ *
+ * Replaces the function used to submit batches of scrobbles. The default
+ * uses the libclastfm session set up by the "init" and "login" calls; a
+ * custom one can point the spool at any other endpoint.
+ */
+void
+lastfm_thread_set_submit_func(LastFMThread *self, LastFMThreadSubmitFunc func, gpointer user_data)
+{
+	g_return_if_fail(LASTFM_IS_THREAD(self));
+	LastFMThreadPrivate *priv = self->priv;
+
+	g_mutex_lock(priv->queue_mutex);
+	priv->submit_func = func ? func : (LastFMThreadSubmitFunc) default_submit_func;
+	priv->submit_data = func ? user_data : self;
+	priv->next_attempt = 0;
+	g_cond_signal(priv->queue_cond);
+	g_mutex_unlock(priv->queue_mutex);
+}
+
+/*
+ * lastfm_thread_get_stats:
+ * @self: A #LastFMThread
+ * @stats: (out caller-allocates): Location to store the counters
+ *
+ * Gets a snapshot of the spool counters
+ */
+void
+lastfm_thread_get_stats(LastFMThread *self, LastFMThreadStats *stats)
+{
+	g_return_if_fail(LASTFM_IS_THREAD(self));
+	g_return_if_fail(stats != NULL);
+
+	g_mutex_lock(self->priv->queue_mutex);
+	*stats = self->priv->stats;
+	g_mutex_unlock(self->priv->queue_mutex);
+}
+
 void
 lastfm_thread_call (LastFMThread *self, const LastFMThreadMethodCall *call)
 {
@@ -106,12 +297,10 @@ lastfm_thread_call_full (LastFMThread *self, const LastFMThreadMethodCall *call,
 
 	g_mutex_lock      (priv->queue_mutex);
 	g_queue_push_tail (priv->queue, packed_call);
+	g_cond_signal     (priv->queue_cond);
 	g_mutex_unlock    (priv->queue_mutex);
 
-	g_mutex_lock(priv->subthread_mutex);
-	if (!priv->worker_thread)
-		priv->worker_thread = g_thread_create((GThreadFunc) _lastfm_thread_worker, self, FALSE, NULL);
-	g_mutex_unlock(priv->subthread_mutex);
+	worker_ensure(self);
 }
 
 typedef void(*callback_t)(gpointer user_data);
@@ -130,15 +319,386 @@ callback_wrapper(ThreadFuncData *tdata)
 	return FALSE;
 }
 
+/*
+ * Spool, all functions below run in the worker thread
+ */
+static gchar *
+spool_escape(const gchar *str)
+{
+	return str ? g_strescape(str, NULL) : g_strdup("");
+}
+
+static gchar *
+spool_unescape(const gchar *str)
+{
+	return (str && str[0]) ? g_strcompress(str) : NULL;
+}
+
+static void
+spool_entry_free(SpoolEntry *entry)
+{
+	method_call_free(entry->call);
+	g_free(entry);
+}
+
+static void
+spool_write_entry(FILE *fp, SpoolEntry *entry)
+{
+	gchar *title  = spool_escape(entry->call->title);
+	gchar *artist = spool_escape(entry->call->artist);
+	gchar *album  = spool_escape(entry->call->album);
+
+	fprintf(fp, "S\t%" G_GUINT64_FORMAT "\t%" G_GINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%" G_GUINT64_FORMAT "\t%s\t%s\t%s\n",
+		entry->seq, entry->spooled, entry->call->start_stamp, entry->call->length,
+		title, artist, album);
+
+	g_free(title);
+	g_free(artist);
+	g_free(album);
+}
+
+static void
+spool_sync(LastFMThread *self)
+{
+	LastFMThreadPrivate *priv = self->priv;
+	if (!priv->journal || !priv->journal_dirty)
+		return;
+
+	fflush(priv->journal);
+	fsync(fileno(priv->journal));
+	priv->journal_dirty = FALSE;
+}
+
+/*
+ * Rewrites the journal with only the pending entries
+ */
+static void
+spool_compact(LastFMThread *self)
+{
+	LastFMThreadPrivate *priv = self->priv;
+	if (!priv->spool_path)
+		return;
+
+	gchar *tmp = g_strconcat(priv->spool_path, ".tmp", NULL);
+	FILE *fp = g_fopen(tmp, "w");
+	if (!fp)
+	{
+		g_warning("Unable to write spool '%s'", tmp);
+		g_free(tmp);
+		return;
+	}
+
+	for (GList *l = priv->spool->head; l; l = l->next)
+		spool_write_entry(fp, (SpoolEntry *) l->data);
+	fflush(fp);
+	fsync(fileno(fp));
+	fclose(fp);
+
+	if (priv->journal)
+		fclose(priv->journal);
+
+	if (g_rename(tmp, priv->spool_path) < 0)
+		g_warning("Unable to replace spool '%s'", priv->spool_path);
+	g_free(tmp);
+
+	priv->journal = g_fopen(priv->spool_path, "a");
+	priv->journal_dirty = FALSE;
+	priv->journal_done  = 0;
+}
+
+static void
+spool_load(LastFMThread *self)
+{
+	LastFMThreadPrivate *priv = self->priv;
+	if (!priv->spool_path)
+		return;
+
+	gchar *dirname = g_path_get_dirname(priv->spool_path);
+	g_mkdir_with_parents(dirname, 0700);
+	g_free(dirname);
+
+	gchar *contents = NULL;
+	if (g_file_get_contents(priv->spool_path, &contents, NULL, NULL))
+	{
+		GHashTable *index = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+		gchar **lines = g_strsplit(contents, "\n", 0);
+		for (guint i = 0; lines[i]; i++)
+		{
+			gchar **f = g_strsplit(lines[i], "\t", 8);
+			guint n = g_strv_length(f);
+
+			// Truncated records from a crash are just skipped
+			if ((n == 8) && g_str_equal(f[0], "S"))
+			{
+				SpoolEntry *entry = g_new0(SpoolEntry, 1);
+				entry->seq     = g_ascii_strtoull(f[1], NULL, 10);
+				entry->spooled = g_ascii_strtoll (f[2], NULL, 10);
+				entry->call    = g_new0(LastFMThreadMethodCall, 1);
+				entry->call->method_name = g_strdup("track_scrobble");
+				entry->call->start_stamp = g_ascii_strtoull(f[3], NULL, 10);
+				entry->call->length      = g_ascii_strtoull(f[4], NULL, 10);
+				entry->call->title  = spool_unescape(f[5]);
+				entry->call->artist = spool_unescape(f[6]);
+				entry->call->album  = spool_unescape(f[7]);
+
+				g_queue_push_tail(priv->spool, entry);
+				g_hash_table_insert(index, &entry->seq, priv->spool->tail);
+				priv->next_seq = MAX(priv->next_seq, entry->seq + 1);
+			}
+			else if ((n == 2) && g_str_equal(f[0], "D"))
+			{
+				guint64 seq = g_ascii_strtoull(f[1], NULL, 10);
+				GList *link = g_hash_table_lookup(index, &seq);
+				if (link)
+				{
+					g_hash_table_remove(index, &seq);
+					spool_entry_free((SpoolEntry *) link->data);
+					g_queue_delete_link(priv->spool, link);
+				}
+			}
+			g_strfreev(f);
+		}
+		g_strfreev(lines);
+		g_hash_table_destroy(index);
+		g_free(contents);
+	}
+
+	// Start with a clean journal
+	spool_compact(self);
+
+	g_mutex_lock(priv->queue_mutex);
+	priv->stats.queue_depth = g_queue_get_length(priv->spool);
+	g_mutex_unlock(priv->queue_mutex);
+}
+
+static void
+spool_append(LastFMThread *self, const LastFMThreadMethodCall *call)
+{
+	LastFMThreadPrivate *priv = self->priv;
+
+	SpoolEntry *entry = g_new0(SpoolEntry, 1);
+	entry->seq     = priv->next_seq++;
+	entry->spooled = g_get_real_time();
+	entry->call    = method_call_copy(call);
+	g_queue_push_tail(priv->spool, entry);
+
+	if (priv->journal)
+	{
+		spool_write_entry(priv->journal, entry);
+		priv->journal_dirty = TRUE;
+	}
+
+	g_mutex_lock(priv->queue_mutex);
+	priv->stats.queue_depth++;
+	g_mutex_unlock(priv->queue_mutex);
+}
+
+static void
+spool_set_aside(LastFMThread *self, SpoolEntry *entry)
+{
+	LastFMThreadPrivate *priv = self->priv;
+	if (!priv->spool_path)
+		return;
+
+	gchar *path = g_strconcat(priv->spool_path, ".rejected", NULL);
+	FILE *fp = g_fopen(path, "a");
+	if (fp)
+	{
+		spool_write_entry(fp, entry);
+		fclose(fp);
+	}
+	else
+		g_warning("Unable to write rejected scrobbles to '%s'", path);
+	g_free(path);
+}
+
+/*
+ * Submits up to SPOOL_BATCH_SIZE scrobbles from the head of the spool
+ */
+static void
+spool_submit_batch(LastFMThread *self, LastFMThreadSubmitFunc submit_func, gpointer submit_data)
+{
+	LastFMThreadPrivate *priv = self->priv;
+
+	LastFMThreadMethodCall  *calls[SPOOL_BATCH_SIZE];
+	LastFMThreadSubmitResult results[SPOOL_BATCH_SIZE];
+	GList *links[SPOOL_BATCH_SIZE];
+	guint n_calls = 0;
+	for (GList *l = priv->spool->head; l && (n_calls < SPOOL_BATCH_SIZE); l = l->next)
+	{
+		links[n_calls] = l;
+		calls[n_calls++] = ((SpoolEntry *) l->data)->call;
+	}
+
+	guint n_results = MIN(submit_func(calls, n_calls, results, submit_data), n_calls);
+	gint64 now = g_get_real_time();
+
+	// Refusals are only the entry's fault if the server takes others
+	gboolean any_ok = FALSE;
+	for (guint i = 0; i < n_results; i++)
+		any_ok = any_ok || (results[i] == LASTFM_THREAD_SUBMIT_OK);
+
+	guint n_ok = 0, n_rejected = 0;
+	gboolean retry = (n_results < n_calls);
+	gint64 last_latency = 0, max_latency = 0;
+	for (guint i = 0; i < n_results; i++)
+	{
+		SpoolEntry *entry = (SpoolEntry *) links[i]->data;
+		switch (results[i])
+		{
+		case LASTFM_THREAD_SUBMIT_OK:
+			last_latency = now - entry->spooled;
+			max_latency  = MAX(max_latency, last_latency);
+			n_ok++;
+			break;
+
+		case LASTFM_THREAD_SUBMIT_REFUSED:
+			if (any_ok || (++entry->refusals >= SPOOL_MAX_REFUSALS))
+			{
+				g_warning("Scrobble of '%s' by '%s' was refused, setting it aside",
+					entry->call->title ? entry->call->title : "",
+					entry->call->artist ? entry->call->artist : "");
+				spool_set_aside(self, entry);
+				n_rejected++;
+				break;
+			}
+			retry = TRUE;
+			continue;
+
+		case LASTFM_THREAD_SUBMIT_FAILED:
+		default:
+			retry = TRUE;
+			continue;
+		}
+
+		if (priv->journal)
+			fprintf(priv->journal, "D\t%" G_GUINT64_FORMAT "\n", entry->seq);
+		priv->journal_done++;
+		priv->journal_dirty = TRUE;
+		spool_entry_free(entry);
+		g_queue_delete_link(priv->spool, links[i]);
+	}
+
+	if (g_queue_is_empty(priv->spool) || (priv->journal_done >= SPOOL_COMPACT_AFTER))
+		spool_compact(self);
+	else
+		spool_sync(self);
+
+	// Back off only when something is still worth retrying
+	if (retry)
+	{
+		priv->backoff = priv->backoff ? MIN(priv->backoff * 2, BACKOFF_MAX) : BACKOFF_MIN;
+		priv->next_attempt = g_get_monotonic_time() + (gint64) priv->backoff * G_USEC_PER_SEC;
+		g_debug("Scrobble submission failed, retrying in %us", priv->backoff);
+	}
+	else
+	{
+		priv->backoff = 0;
+		priv->next_attempt = 0;
+	}
+
+	g_mutex_lock(priv->queue_mutex);
+	priv->stats.queue_depth = g_queue_get_length(priv->spool);
+	priv->stats.submitted  += n_ok;
+	priv->stats.rejected   += n_rejected;
+	priv->stats.failed     += retry ? 1 : 0;
+	if (n_ok)
+	{
+		priv->stats.last_latency = last_latency;
+		priv->stats.max_latency  = MAX(priv->stats.max_latency, max_latency);
+	}
+	g_mutex_unlock(priv->queue_mutex);
+}
+
+static guint
+default_submit_func(LastFMThreadMethodCall **calls, guint n_calls, LastFMThreadSubmitResult *results, LastFMThread *self)
+{
+	LastFMThreadPrivate *priv = self->priv;
+
+	// libclastfm has no batch scrobbling, submit them in a row under a
+	// single session lock
+	guint i = 0;
+	g_mutex_lock(priv->sess_mutex);
+	while (i < n_calls)
+	{
+		if (!priv->sess)
+		{
+			results[i++] = LASTFM_THREAD_SUBMIT_FAILED;
+			break;
+		}
+
+		LastFMThreadMethodCall *call = calls[i];
+		gint code = LASTFM_track_scrobble(priv->sess,
+			call->title, call->artist, call->album,
+			call->start_stamp, call->length,
+			0, 0, NULL);
+		g_debug("track_scrobble: code:=%d, status=%s", code, LASTFM_status(priv->sess));
+
+		// ERROR means the server answered and refused this call, anything
+		// else means it couldn't be asked
+		if (code == LASTFM_STATUS_OK)
+			results[i++] = LASTFM_THREAD_SUBMIT_OK;
+		else if (code == LASTFM_STATUS_ERROR)
+			results[i++] = LASTFM_THREAD_SUBMIT_REFUSED;
+		else
+		{
+			results[i++] = LASTFM_THREAD_SUBMIT_FAILED;
+			break;
+		}
+	}
+	g_mutex_unlock(priv->sess_mutex);
+
+	return i;
+}
+
 gpointer
 _lastfm_thread_worker(LastFMThread *self)
 {
 	g_return_val_if_fail (LASTFM_IS_THREAD (self), NULL);
 	LastFMThreadPrivate *priv = self->priv;
 
+	spool_load(self);
+
 	g_mutex_lock(priv->queue_mutex);
-	while (!g_queue_is_empty(priv->queue))
+	while (!priv->quit)
 	{
+		if (g_queue_is_empty(priv->queue))
+		{
+			// All incoming scrobbles are journaled, sync them at once
+			if (priv->journal_dirty)
+			{
+				g_mutex_unlock(priv->queue_mutex);
+				spool_sync(self);
+				g_mutex_lock(priv->queue_mutex);
+				continue;
+			}
+
+			gboolean ready = !g_queue_is_empty(priv->spool) &&
+				((priv->submit_func != (LastFMThreadSubmitFunc) default_submit_func) || priv->logged_in);
+			gint64 now = g_get_monotonic_time();
+
+			if (ready && (now >= priv->next_attempt))
+			{
+				LastFMThreadSubmitFunc submit_func = priv->submit_func;
+				gpointer               submit_data = priv->submit_data;
+				g_mutex_unlock(priv->queue_mutex);
+				spool_submit_batch(self, submit_func, submit_data);
+				g_mutex_lock(priv->queue_mutex);
+			}
+			else if (ready)
+			{
+				GTimeVal tv;
+				g_get_current_time(&tv);
+				g_time_val_add(&tv, priv->next_attempt - now);
+				g_cond_timed_wait(priv->queue_cond, priv->queue_mutex, &tv);
+			}
+			else
+				g_cond_wait(priv->queue_cond, priv->queue_mutex);
+
+			continue;
+		}
+
 		ThreadFuncData *tdata = g_queue_pop_head(priv->queue);
 		g_mutex_unlock(priv->queue_mutex);
 
@@ -157,6 +717,7 @@ _lastfm_thread_worker(LastFMThread *self)
 					LASTFM_dinit(priv->sess);
 				g_debug("Init (%s:%s)", call->api_key, call->api_secret);
 				priv->sess = LASTFM_init(call->api_key, call->api_secret);
+				priv->logged_in = FALSE;
 				g_mutex_unlock(priv->sess_mutex);
 
 			}
@@ -170,6 +731,7 @@ _lastfm_thread_worker(LastFMThread *self)
 				LASTFM_dinit(priv->sess);
 				priv->sess = NULL;
 			}
+			priv->logged_in = FALSE;
 			g_mutex_unlock(priv->sess_mutex);
 		}
 
@@ -183,25 +745,21 @@ _lastfm_thread_worker(LastFMThread *self)
 			}
 			else
 			{
+				gint code = LASTFM_login(priv->sess, call->username, call->password);
 				g_debug("Login (as %s): code=%d, status=%s",
 					call->username,
-					LASTFM_login(priv->sess, call->username, call->password),
+					code,
 					LASTFM_status(priv->sess));
+
+				// New session, retry pending scrobbles right away
+				priv->logged_in = (code == LASTFM_STATUS_OK);
+				priv->next_attempt = 0;
 			}
 			g_mutex_unlock(priv->sess_mutex);
 		}
 
 		else if (g_str_equal("track_scrobble", call->method_name))
-		{
-			g_mutex_lock(priv->sess_mutex);
-			g_debug("track_scrobble: code:=%d, status=%s",
-				LASTFM_track_scrobble(priv->sess,
-					call->title, call->artist, call->album,
-					call->start_stamp, call->length,
-					0, 0, NULL),
-				LASTFM_status(priv->sess));
-			g_mutex_unlock(priv->sess_mutex);
-		}
+			spool_append(self, call);
 
 		else
 		{
@@ -210,32 +768,24 @@ _lastfm_thread_worker(LastFMThread *self)
 		}
 		if ((know_cmd && FALSE) || tdata->callback)
 			g_idle_add((GSourceFunc) callback_wrapper, tdata);
+		else
+			thread_call_destroy(tdata);
 
-		// thread_call_destroy(tdata);
+		g_mutex_lock(priv->queue_mutex);
 	}
 	g_mutex_unlock(priv->queue_mutex);
 
-	g_mutex_lock(priv->subthread_mutex);
-	priv->worker_thread = NULL;
-	g_mutex_unlock(priv->subthread_mutex);
+	spool_sync(self);
 
 	return NULL;
 }
 
-ThreadFuncData*
-thread_data_create(LastFMThread *self, const LastFMThreadMethodCall *call,
-	GCallback callback, gpointer user_data, GDestroyNotify notify)
+static LastFMThreadMethodCall*
+method_call_copy(const LastFMThreadMethodCall *call)
 {
-	ThreadFuncData *ret = g_new0(ThreadFuncData, 1);
-
-	ret->self      = self;
-	ret->callback  = callback;
-	ret->user_data = user_data;
-	ret->notify    = notify;
-
-	ret->call = g_new0(LastFMThreadMethodCall, 1);
+	LastFMThreadMethodCall *ret = g_new0(LastFMThreadMethodCall, 1);
 
-	#define _copy_member(x) do { ret->call->x = (call->x ? g_strdup(call->x) : NULL); } while(0)
+	#define _copy_member(x) do { ret->x = (call->x ? g_strdup(call->x) : NULL); } while(0)
 
 	_copy_member(method_name);
 	_copy_member(api_key);
@@ -246,15 +796,15 @@ thread_data_create(LastFMThread *self, const LastFMThreadMethodCall *call,
 	_copy_member(artist);
 	_copy_member(album);
 
-	ret->call->start_stamp = call->start_stamp;
-	ret->call->length      = call->length;
+	ret->start_stamp = call->start_stamp;
+	ret->length      = call->length;
 	return ret;
 }
 
-void
-thread_call_destroy(ThreadFuncData *tdata)
+static void
+method_call_free(LastFMThreadMethodCall *call)
 {
-	#define _free_str_member(x) do { if (tdata->call->x) g_free(tdata->call->x); } while(0)
+	#define _free_str_member(x) do { if (call->x) g_free(call->x); } while(0)
 
 	_free_str_member (method_name);
 	_free_str_member (api_key);
@@ -264,6 +814,27 @@ thread_call_destroy(ThreadFuncData *tdata)
 	_free_str_member (title);
 	_free_str_member (artist);
 	_free_str_member (album);
-	g_free(tdata->call);
+	g_free(call);
+}
+
+ThreadFuncData*
+thread_data_create(LastFMThread *self, const LastFMThreadMethodCall *call,
+	GCallback callback, gpointer user_data, GDestroyNotify notify)
+{
+	ThreadFuncData *ret = g_new0(ThreadFuncData, 1);
+
+	ret->self      = self;
+	ret->callback  = callback;
+	ret->user_data = user_data;
+	ret->notify    = notify;
+	ret->call      = method_call_copy(call);
+
+	return ret;
+}
+
+void
+thread_call_destroy(ThreadFuncData *tdata)
+{
+	method_call_free(tdata->call);
 	g_free(tdata);
 }
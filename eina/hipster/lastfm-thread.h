@@ -34,9 +34,46 @@ typedef struct {
 	guint64 start_stamp, length;
 } LastFMThreadMethodCall;
 
+/*
+ * Counters for the scrobble spool. Latencies are measured from the moment a
+ * scrobble is spooled until it's accepted, in microseconds.
+ */
+typedef struct {
+	guint   queue_depth;
+	guint64 submitted;
+	guint64 failed;
+	guint64 rejected;
+	gint64  last_latency;
+	gint64  max_latency;
+} LastFMThreadStats;
+
+/*
+ * Outcome of a single scrobble. Failed ones (network, no session) are
+ * retried with back-off, refused ones were answered with an error by the
+ * server and are eventually set aside so they don't block the spool.
+ */
+typedef enum {
+	LASTFM_THREAD_SUBMIT_OK = 0,
+	LASTFM_THREAD_SUBMIT_FAILED,
+	LASTFM_THREAD_SUBMIT_REFUSED
+} LastFMThreadSubmitResult;
+
+/*
+ * Submits up to @n_calls scrobbles in order, storing the outcome of each in
+ * @results. Submission goes on after a refused call and stops after the
+ * first failed one. Returns the number of results stored. Runs in the
+ * worker thread.
+ */
+typedef guint (*LastFMThreadSubmitFunc) (LastFMThreadMethodCall **calls, guint n_calls,
+	LastFMThreadSubmitResult *results, gpointer user_data);
+
 GType lastfm_thread_get_type (void);
 
 LastFMThread* lastfm_thread_new (void);
+LastFMThread* lastfm_thread_new_with_spool(const gchar *spool_path);
+
+void lastfm_thread_set_submit_func(LastFMThread *self, LastFMThreadSubmitFunc func, gpointer user_data);
+void lastfm_thread_get_stats      (LastFMThread *self, LastFMThreadStats *stats);
 
 void lastfm_thread_call     (LastFMThread *self, const LastFMThreadMethodCall *call);
 void lastfm_thread_call_full(LastFMThread *self, const LastFMThreadMethodCall *call,
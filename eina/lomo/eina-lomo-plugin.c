@@ -91,11 +91,16 @@ eina_lomo_plugin_activate (EinaActivatable *activatable, EinaApplication *applic
 	for (gint i = 0; i < G_N_ELEMENTS(props); i++)
 		g_settings_bind(settings, props[i], priv->lomo, props[i], G_SETTINGS_BIND_DEFAULT);
 
+	// Nobody in eina needs per-tag notifications, get a single change-set per
+	// stream instead of one UI/DBus refresh round for each tag
+	lomo_player_set_tag_coalesce(priv->lomo, LOMO_METADATA_PARSER_COALESCE_STREAM);
+
 	g_signal_connect_swapped(priv->lomo, "insert", (GCallback) schedule_save_playlist, plugin);
 	g_signal_connect_swapped(priv->lomo, "clear",  (GCallback) save_playlist, plugin);
 
 	lomo_em_art_provider_set_default_cover(DEFAULT_COVER_URI);
 	lomo_em_art_provider_set_loading_cover(LOADING_COVER_URI);
+	lomo_em_art_provider_set_drop_embedded_tags(TRUE);
 
 	return TRUE;
 }
@@ -158,7 +163,8 @@ schedule_save_playlist(EinaLomoPlugin *plugin)
  * save_playlist:
  * @lomo: A #LomoPlayer
  *
- * Saves playlist in ~/XDG_CONFIG_DIR/PACKAGE/playlist
+ * Saves playlist in ~/XDG_CONFIG_DIR/PACKAGE/playlist and a full snapshot of
+ * it in ~/XDG_CONFIG_DIR/PACKAGE/playlist.snapshot
  *
  * Returns: %FALSE
  */
@@ -199,7 +205,21 @@ save_playlist(EinaLomoPlugin *plugin)
 	GError *err = NULL;
 	if (!output || !g_file_set_contents(output, gs->str, -1, &err))
 		g_warning(N_("Unble to save playlist: %s"), err ? err->message : N_("Missing parent directory"));
+	gel_free_and_invalidate(err, NULL, g_error_free);
+
+	// Plain list above is kept as fallback, snapshot brings back tags, order
+	// and queue. SIDs from adb are not saved, rows can be removed and
+	// inserted again while eina is not running
+	gchar *snapshot = g_build_filename(bname, "playlist.snapshot", NULL);
+	if (!lomo_player_save_snapshot(lomo, snapshot, NULL, &err))
+	{
+		g_warning(N_("Unable to save playlist snapshot: %s"), err->message);
+		g_error_free(err);
+	}
+	g_free(snapshot);
 
+	g_free(bname);
+	g_free(output);
 	g_string_free(gs, TRUE);
 
 	return FALSE;
@@ -25,6 +25,8 @@
 #define MPRIS_SPEC_ROOT_INTERFACE     "org.mpris.MediaPlayer2"
 #define MPRIS_SPEC_PLAYER_INTERFACE   "org.mpris.MediaPlayer2.Player"
 #define MPRIS_SPEC_PLAYLIST_INTERFACE "org.mpris.MediaPlayer2.Playlist"
+#define MPRIS_SPEC_TRACKLIST_INTERFACE "org.mpris.MediaPlayer2.TrackList"
+#define MPRIS_SPEC_NO_TRACK          "/org/mpris/MediaPlayer2/TrackList/NoTrack"
 
 const char *mpris_spec_xml =
 	"<node>"
@@ -90,9 +92,7 @@ const char *mpris_spec_xml =
 	"    <property name='Orderings' type='as' access='read'/>"
 	"    <property name='ActivePlaylist' type='(b(oss))' access='read'/>"
 	"  </interface>"
-
-	/*
-	"  <interface name='org.mpris.MediaPlayer2.TrackList'>"
+	"  <interface name='" MPRIS_SPEC_TRACKLIST_INTERFACE "'>"
 	"    <method name='GetTracksMetadata'>"
 	"      <arg direction='in' name='TrackIds' type='ao'/>"
 	"      <arg direction='out' name='Metadata' type='aa{sv}'/>"
@@ -126,7 +126,6 @@ const char *mpris_spec_xml =
 	"    <property name='Tracks' type='ao' access='read'/>"
 	"    <property name='CanEditTracks' type='b' access='read'/>"
 	"  </interface>"
-	*/
 	"</node>";
 
 #endif
@@ -35,9 +35,67 @@ struct _EinaMprisPlayerPrivate {
 	gchar           *bus_name_suffix;
 	GDBusConnection *conn;
 	GDBusNodeInfo   *nodeinfo;
-	guint bus_id, root_id, player_id, playlist_id;
+	guint bus_id, root_id, player_id, playlist_id, tracklist_id;
 	GHashTable    *prop_changes;
 	guint prop_change_id;
+
+	LomoStream *stream;      // <Current stream, watched for art changes
+	gulong      stream_em_handler;
+
+	GHashTable *tracks;            // <Track id → LomoStream, borrowed
+	GQueue     *track_changes;     // <Pending TrackChange, oldest first
+	gboolean    tracklist_replaced;
+	guint       track_change_id;
+};
+
+/*
+ * TrackList changes are queued and flushed from an idle. Past
+ * TRACKLIST_COALESCE_MAX changes a single TrackListReplaced is emitted
+ * instead.
+ */
+#define TRACKLIST_COALESCE_MAX 32
+
+// Number of tracks resolved per main loop iteration in GetTracksMetadata
+#define TRACKLIST_PAGE_SIZE 256
+
+// Object data key for the stable track id of each stream
+#define TRACK_ID_KEY "eina-mpris-track-id"
+
+typedef enum {
+	TRACK_CHANGE_ADDED,
+	TRACK_CHANGE_REMOVED,
+	TRACK_CHANGE_METADATA
+} TrackChangeType;
+
+typedef struct {
+	TrackChangeType type;
+	LomoStream *stream;
+	gchar      *track_id;
+	gchar      *after_id;  // TRACK_CHANGE_ADDED only, previous track at insert time
+} TrackChange;
+
+/*
+ * Metadata variants are cached on each stream under METADATA_CACHE_KEY. Tag
+ * changes drop the cache, art and length are checked on lookup since they
+ * are not reported through LomoPlayer tag signals.
+ */
+#define METADATA_CACHE_KEY "eina-mpris-metadata"
+
+typedef struct {
+	GVariant *variant;
+	gchar    *art_url;
+	gint64    length;
+} MetadataCache;
+
+// Tags that are exported in the Metadata property
+static const gchar *metadata_tags[] = {
+	LOMO_TAG_URI,
+	LOMO_TAG_TITLE,
+	LOMO_TAG_ARTIST,
+	LOMO_TAG_ALBUM,
+	"album-artist",
+	LOMO_TAG_GENRE,
+	LOMO_TAG_TRACK_NUMBER
 };
 
 enum
@@ -62,11 +120,30 @@ set_bus_name_suffix(EinaMprisPlayer *self, const gchar *bus_name_suffix);
 
 static GVariant*
 build_metadata_variant(LomoStream *stream);
+static GVariant*
+stream_get_metadata_variant(LomoStream *stream);
 
 static void
 lomo_notify_state_cb(LomoPlayer *lomo, GParamSpec *pspec, EinaMprisPlayer *self);
 static void
 lomo_change_cb(LomoPlayer *lomo, gint from, gint to, EinaMprisPlayer *self);
+static void
+lomo_tag_cb(LomoPlayer *lomo, LomoStream *stream, const gchar *tag, EinaMprisPlayer *self);
+static void
+lomo_tags_changed_cb(LomoPlayer *lomo, LomoStream *stream, GArray *tags, EinaMprisPlayer *self);
+static void
+lomo_all_tags_cb(LomoPlayer *lomo, LomoStream *stream, EinaMprisPlayer *self);
+static void
+lomo_insert_cb(LomoPlayer *lomo, LomoStream *stream, gint pos, EinaMprisPlayer *self);
+static void
+lomo_remove_cb(LomoPlayer *lomo, LomoStream *stream, gint pos, EinaMprisPlayer *self);
+static void
+lomo_clear_cb(LomoPlayer *lomo, EinaMprisPlayer *self);
+
+static const gchar*
+stream_get_track_id(LomoStream *stream);
+static void
+track_change_free(TrackChange *change);
 
 static void
 server_name_lost_cb (GDBusConnection *connection, const gchar *name, gpointer user_data);
@@ -184,6 +261,34 @@ GDBusInterfaceVTable playlist_vtable =
 	(GDBusInterfaceSetPropertyFunc) playlist_set_property_cb
 };
 
+/*
+ * TrackList node call/get/set
+ */
+static void
+tracklist_method_call_cb (GDBusConnection *connection,
+	const char *sender,
+	const char *object_path,
+	const char *interface_name,
+	const char *method_name,
+	GVariant *parameters,
+	GDBusMethodInvocation *invocation,
+	EinaMprisPlayer *self);
+static GVariant*
+tracklist_get_property_cb (GDBusConnection *connection,
+	const char *sender,
+	const char *object_path,
+	const char *interface_name,
+	const char *property_name,
+	GError **error,
+	EinaMprisPlayer *self);
+
+GDBusInterfaceVTable tracklist_vtable =
+{
+	(GDBusInterfaceMethodCallFunc)  tracklist_method_call_cb,
+	(GDBusInterfaceGetPropertyFunc) tracklist_get_property_cb,
+	(GDBusInterfaceSetPropertyFunc) NULL
+};
+
 static void
 eina_mpris_player_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
 {
@@ -223,9 +328,39 @@ eina_mpris_player_dispose (GObject *object)
 {
 	EinaMprisPlayer *self = EINA_MPRIS_PLAYER(object);
 
-	// FIXME: Disconnect signals
 	// FIXME: Merge this code with complete_setup_error goto
 
+	if (self->priv->stream_em_handler)
+	{
+		g_signal_handler_disconnect(self->priv->stream, self->priv->stream_em_handler);
+		self->priv->stream_em_handler = 0;
+	}
+	self->priv->stream = NULL;
+
+	gel_free_and_invalidate(self->priv->prop_change_id, 0, g_source_remove);
+
+	LomoPlayer *lomo = self->priv->app ? eina_application_get_lomo(self->priv->app) : NULL;
+	if (lomo)
+	{
+		g_signal_handlers_disconnect_by_func(lomo, lomo_notify_state_cb, self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_change_cb,       self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_tag_cb,          self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_tags_changed_cb, self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_all_tags_cb,     self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_insert_cb,       self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_remove_cb,       self);
+		g_signal_handlers_disconnect_by_func(lomo, lomo_clear_cb,        self);
+	}
+
+	gel_free_and_invalidate(self->priv->track_change_id, 0, g_source_remove);
+	if (self->priv->track_changes)
+	{
+		g_queue_foreach(self->priv->track_changes, (GFunc) track_change_free, NULL);
+		g_queue_free(self->priv->track_changes);
+		self->priv->track_changes = NULL;
+	}
+	gel_free_and_invalidate(self->priv->tracks, NULL, g_hash_table_destroy);
+
 	gel_free_and_invalidate(self->priv->bus_id, 0, g_bus_unown_name);
 
 	if (self->priv->player_id)
@@ -240,6 +375,12 @@ eina_mpris_player_dispose (GObject *object)
 		self->priv->playlist_id = 0;
 	}
 
+	if (self->priv->tracklist_id)
+	{
+		g_dbus_connection_unregister_object(self->priv->conn, self->priv->tracklist_id);
+		self->priv->tracklist_id = 0;
+	}
+
 	if (self->priv->root_id)
 	{
 		g_dbus_connection_unregister_object(self->priv->conn, self->priv->root_id);
@@ -280,6 +421,8 @@ eina_mpris_player_init (EinaMprisPlayer *self)
 {
 	self->priv = G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_MPRIS_PLAYER, EinaMprisPlayerPrivate);
 	self->priv->prop_changes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_variant_unref);
+	self->priv->tracks        = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	self->priv->track_changes = g_queue_new();
 }
 
 EinaMprisPlayer*
@@ -351,6 +494,19 @@ complete_setup(EinaMprisPlayer *self)
 		goto complete_setup_error;
 	}
 
+	self->priv->tracklist_id = g_dbus_connection_register_object(self->priv->conn,
+		MPRIS_SPEC_OBJECT_PATH,
+		g_dbus_node_info_lookup_interface(self->priv->nodeinfo, MPRIS_SPEC_TRACKLIST_INTERFACE),
+		&tracklist_vtable,
+		self,
+		NULL,
+		&error);
+	if (!self->priv->tracklist_id)
+	{
+		g_warning(_("Unable to register interface %s: '%s'"), MPRIS_SPEC_TRACKLIST_INTERFACE, error->message);
+		goto complete_setup_error;
+	}
+
 	gchar *bus_name = g_strconcat(MPRIS_SPEC_BUS_NAME_PREFIX, ".", self->priv->bus_name_suffix, NULL);
 	self->priv->bus_id = g_bus_own_name(G_BUS_TYPE_SESSION,
 		bus_name,
@@ -371,6 +527,16 @@ complete_setup(EinaMprisPlayer *self)
 	LomoPlayer *lomo = eina_application_get_lomo(self->priv->app);
 	g_signal_connect(lomo, "notify::state", (GCallback) lomo_notify_state_cb, self);
 	g_signal_connect(lomo, "change",        (GCallback) lomo_change_cb, self);
+	g_signal_connect(lomo, "tag",           (GCallback) lomo_tag_cb, self);
+	g_signal_connect(lomo, "tags-changed",  (GCallback) lomo_tags_changed_cb, self);
+	g_signal_connect(lomo, "all-tags",      (GCallback) lomo_all_tags_cb, self);
+	g_signal_connect(lomo, "insert",        (GCallback) lomo_insert_cb, self);
+	g_signal_connect(lomo, "remove",        (GCallback) lomo_remove_cb, self);
+	g_signal_connect(lomo, "clear",         (GCallback) lomo_clear_cb, self);
+
+	// Streams inserted before we were loaded
+	for (GList *l = (GList *) lomo_player_get_playlist(lomo); l; l = l->next)
+		g_hash_table_insert(self->priv->tracks, g_strdup(stream_get_track_id(l->data)), l->data);
 
 	return;
 
@@ -389,6 +555,11 @@ complete_setup_error:
 		g_dbus_connection_unregister_object(self->priv->conn, self->priv->playlist_id);
 		self->priv->playlist_id = 0;
 	}
+	if (self->priv->tracklist_id)
+	{
+		g_dbus_connection_unregister_object(self->priv->conn, self->priv->tracklist_id);
+		self->priv->tracklist_id = 0;
+	}
 	if (self->priv->root_id)
 	{
 		g_dbus_connection_unregister_object(self->priv->conn, self->priv->root_id);
@@ -510,6 +681,205 @@ emit_properties_change(EinaMprisPlayer *self)
 		self->priv->prop_change_id = g_idle_add((GSourceFunc) emit_properties_change_idle_cb, self);
 }
 
+/*
+ * Track ids are assigned lazily and stay attached to the stream for its
+ * whole life, so they survive reorders and are never reused.
+ */
+static const gchar*
+stream_get_track_id(LomoStream *stream)
+{
+	static guint next_id = 0;
+
+	const gchar *ret = g_object_get_data((GObject *) stream, TRACK_ID_KEY);
+	if (ret)
+		return ret;
+
+	gchar *id = g_strdup_printf("%s/Track/%u", EINA_APP_PATH_DOMAIN, next_id++);
+	g_object_set_data_full((GObject *) stream, TRACK_ID_KEY, id, g_free);
+	return id;
+}
+
+static const gchar*
+current_track_id(EinaMprisPlayer *self)
+{
+	LomoStream *stream = lomo_player_get_current_stream(eina_application_get_lomo(self->priv->app));
+	return stream ? stream_get_track_id(stream) : MPRIS_SPEC_NO_TRACK;
+}
+
+static GVariant*
+build_tracks_variant(EinaMprisPlayer *self)
+{
+	GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE("ao"));
+	const GList *l = lomo_player_get_playlist(eina_application_get_lomo(self->priv->app));
+	for (; l; l = l->next)
+		g_variant_builder_add(builder, "o", stream_get_track_id((LomoStream *) l->data));
+
+	GVariant *ret = g_variant_builder_end(builder);
+	g_variant_builder_unref(builder);
+	return ret;
+}
+
+static void
+track_change_free(TrackChange *change)
+{
+	if (change->stream)
+		g_object_unref(change->stream);
+	g_free(change->track_id);
+	g_free(change->after_id);
+	g_free(change);
+}
+
+static void
+tracklist_emit(EinaMprisPlayer *self, const gchar *signal_name, GVariant *parameters)
+{
+	GError *error = NULL;
+	if (!g_dbus_connection_emit_signal(self->priv->conn,
+		NULL,
+		MPRIS_SPEC_OBJECT_PATH,
+		MPRIS_SPEC_TRACKLIST_INTERFACE,
+		signal_name,
+		parameters,
+		&error))
+	{
+		g_warning(_("Unable to emit %s.%s: %s"), MPRIS_SPEC_TRACKLIST_INTERFACE, signal_name, error->message);
+		g_error_free(error);
+	}
+}
+
+/*
+ * Tracks is announced with invalidation only, as the spec mandates
+ */
+static void
+tracklist_emit_tracks_invalidated(EinaMprisPlayer *self)
+{
+	const gchar *invalidated[] = { "Tracks", NULL };
+	GError *error = NULL;
+	if (!g_dbus_connection_emit_signal(self->priv->conn,
+		NULL,
+		MPRIS_SPEC_OBJECT_PATH,
+		"org.freedesktop.DBus.Properties",
+		"PropertiesChanged",
+		g_variant_new("(s@a{sv}^as)", MPRIS_SPEC_TRACKLIST_INTERFACE,
+			g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0), invalidated),
+		&error))
+	{
+		g_warning(_("Unable to emit %s.%s: %s"), "org.freedesktop.DBus.Properties", "PropertiesChanged", error->message);
+		g_error_free(error);
+	}
+}
+
+static gboolean
+emit_track_changes_idle_cb(EinaMprisPlayer *self)
+{
+	g_return_val_if_fail(EINA_IS_MPRIS_PLAYER(self), FALSE);
+	EinaMprisPlayerPrivate *priv = self->priv;
+
+	priv->track_change_id = 0;
+	LomoPlayer *lomo = eina_application_get_lomo(priv->app);
+	gboolean tracks_changed = priv->tracklist_replaced;
+
+	if (priv->tracklist_replaced || (g_queue_get_length(priv->track_changes) > TRACKLIST_COALESCE_MAX))
+	{
+		tracklist_emit(self, "TrackListReplaced",
+			g_variant_new("(@aoo)", build_tracks_variant(self), current_track_id(self)));
+		tracks_changed = TRUE;
+		goto emit_track_changes_idle_cb_out;
+	}
+
+	for (GList *l = priv->track_changes->head; l; l = l->next)
+	{
+		TrackChange *change = (TrackChange *) l->data;
+
+		switch (change->type)
+		{
+		case TRACK_CHANGE_ADDED:
+			// Changes are replayed in order, so the previous track is the one
+			// it had when inserted even if it moved or went away since. A
+			// stream removed again is announced and then removed.
+			tracklist_emit(self, "TrackAdded", g_variant_new("(@a{sv}o)",
+				stream_get_metadata_variant(change->stream),
+				change->after_id));
+			tracks_changed = TRUE;
+			break;
+
+		case TRACK_CHANGE_REMOVED:
+			tracklist_emit(self, "TrackRemoved", g_variant_new("(o)", change->track_id));
+			tracks_changed = TRUE;
+			break;
+
+		case TRACK_CHANGE_METADATA:
+			if (lomo_player_get_stream_index(lomo, change->stream) < 0)
+				break;
+
+			tracklist_emit(self, "TrackMetadataChanged", g_variant_new("(o@a{sv})",
+				change->track_id,
+				stream_get_metadata_variant(change->stream)));
+			break;
+		}
+	}
+
+emit_track_changes_idle_cb_out:
+	if (tracks_changed)
+		tracklist_emit_tracks_invalidated(self);
+
+	g_queue_foreach(priv->track_changes, (GFunc) track_change_free, NULL);
+	g_queue_clear(priv->track_changes);
+	priv->tracklist_replaced = FALSE;
+
+	return FALSE;
+}
+
+static void
+track_changed(EinaMprisPlayer *self, TrackChangeType type, LomoStream *stream, LomoStream *after)
+{
+	EinaMprisPlayerPrivate *priv = self->priv;
+
+	// Past the threshold everything collapses into TrackListReplaced, don't
+	// bother tracking details
+	if (!priv->tracklist_replaced && (g_queue_get_length(priv->track_changes) <= TRACKLIST_COALESCE_MAX))
+	{
+		TrackChange *change = g_new0(TrackChange, 1);
+		change->type     = type;
+		change->stream   = (type != TRACK_CHANGE_REMOVED) ? g_object_ref(stream) : NULL;
+		change->track_id = g_strdup(stream_get_track_id(stream));
+		if (type == TRACK_CHANGE_ADDED)
+			change->after_id = g_strdup(after ? stream_get_track_id(after) : MPRIS_SPEC_NO_TRACK);
+		g_queue_push_tail(priv->track_changes, change);
+	}
+
+	if (!priv->track_change_id)
+		priv->track_change_id = g_idle_add((GSourceFunc) emit_track_changes_idle_cb, self);
+}
+
+static void
+lomo_insert_cb(LomoPlayer *lomo, LomoStream *stream, gint pos, EinaMprisPlayer *self)
+{
+	g_hash_table_insert(self->priv->tracks, g_strdup(stream_get_track_id(stream)), stream);
+	track_changed(self, TRACK_CHANGE_ADDED, stream, (pos > 0) ? lomo_player_get_nth_stream(lomo, pos - 1) : NULL);
+}
+
+static void
+lomo_remove_cb(LomoPlayer *lomo, LomoStream *stream, gint pos, EinaMprisPlayer *self)
+{
+	g_hash_table_remove(self->priv->tracks, stream_get_track_id(stream));
+	track_changed(self, TRACK_CHANGE_REMOVED, stream, NULL);
+}
+
+static void
+lomo_clear_cb(LomoPlayer *lomo, EinaMprisPlayer *self)
+{
+	EinaMprisPlayerPrivate *priv = self->priv;
+
+	// Streams are already gone, don't touch them
+	g_hash_table_remove_all(priv->tracks);
+	g_queue_foreach(priv->track_changes, (GFunc) track_change_free, NULL);
+	g_queue_clear(priv->track_changes);
+
+	priv->tracklist_replaced = TRUE;
+	if (!priv->track_change_id)
+		priv->track_change_id = g_idle_add((GSourceFunc) emit_track_changes_idle_cb, self);
+}
+
 static void
 lomo_notify_state_cb(LomoPlayer *lomo, GParamSpec *pspec, EinaMprisPlayer *self)
 {
@@ -535,22 +905,84 @@ lomo_notify_state_cb(LomoPlayer *lomo, GParamSpec *pspec, EinaMprisPlayer *self)
 	emit_properties_change(self);
 }
 
+static void
+metadata_changed(EinaMprisPlayer *self, LomoStream *stream)
+{
+	if ((stream != self->priv->stream) || !lomo_stream_get_all_tags_flag(stream))
+		return;
+
+	g_hash_table_insert(self->priv->prop_changes, g_strdup("Metadata"),
+		g_variant_ref(stream_get_metadata_variant(stream)));
+	emit_properties_change(self);
+}
+
+static void
+stream_em_updated_cb(LomoStream *stream, const gchar *key, EinaMprisPlayer *self)
+{
+	if (g_str_equal(key, LOMO_STREAM_EM_ART_DATA))
+		metadata_changed(self, stream);
+}
+
 static void
 lomo_change_cb(LomoPlayer *lomo, gint from, gint to, EinaMprisPlayer *self)
 {
+	EinaMprisPlayerPrivate *priv = self->priv;
+
+	if (priv->stream_em_handler)
+	{
+		g_signal_handler_disconnect(priv->stream, priv->stream_em_handler);
+		priv->stream_em_handler = 0;
+	}
+	priv->stream = NULL;
+
 	if (to == -1)
 		return;
 
 	LomoStream *stream = lomo_player_get_nth_stream(lomo, to);
 	g_return_if_fail(LOMO_IS_STREAM(stream));
 
-	if (lomo_stream_get_all_tags_flag(stream))
+	priv->stream = stream;
+	priv->stream_em_handler = g_signal_connect(stream, "extended-metadata-updated", (GCallback) stream_em_updated_cb, self);
+
+	metadata_changed(self, stream);
+}
+
+static gboolean
+tag_is_metadata(const gchar *tag)
+{
+	for (guint i = 0; i < G_N_ELEMENTS(metadata_tags); i++)
+		if (g_str_equal(metadata_tags[i], tag))
+			return TRUE;
+	return FALSE;
+}
+
+static void
+lomo_tag_cb(LomoPlayer *lomo, LomoStream *stream, const gchar *tag, EinaMprisPlayer *self)
+{
+	if (tag_is_metadata(tag))
+		g_object_set_data((GObject *) stream, METADATA_CACHE_KEY, NULL);
+}
+
+static void
+lomo_tags_changed_cb(LomoPlayer *lomo, LomoStream *stream, GArray *tags, EinaMprisPlayer *self)
+{
+	for (guint i = 0; i < tags->len; i++)
 	{
-		g_hash_table_insert(self->priv->prop_changes, g_strdup("Metadata"), build_metadata_variant(stream));
-		emit_properties_change(self);
+		if (tag_is_metadata(g_quark_to_string(g_array_index(tags, GQuark, i))))
+		{
+			g_object_set_data((GObject *) stream, METADATA_CACHE_KEY, NULL);
+			return;
+		}
 	}
 }
 
+static void
+lomo_all_tags_cb(LomoPlayer *lomo, LomoStream *stream, EinaMprisPlayer *self)
+{
+	metadata_changed(self, stream);
+	track_changed(self, TRACK_CHANGE_METADATA, stream, NULL);
+}
+
 static void
 server_name_acquired_cb(GDBusConnection *connection, const gchar *name, gpointer user_data)
 {
@@ -624,7 +1056,7 @@ root_get_property_cb (GDBusConnection *connection,
 
 	else if (g_str_equal("HasTrackList", property_name))
 	{
-		return g_variant_new_boolean(FALSE);
+		return g_variant_new_boolean(TRUE);
 	}
 
 	else if (g_str_equal("Identity", property_name))
@@ -736,59 +1168,48 @@ player_method_call_cb(GDBusConnection *connection,
 		method_name);
 }
 
+static void
+metadata_add_string(GVariantBuilder *builder, const gchar *key, LomoStream *stream, const gchar *tag, gboolean as_strv)
+{
+	const GValue *v = lomo_stream_get_tag(stream, tag);
+	if (!v || !G_VALUE_HOLDS_STRING(v) || !g_value_get_string(v))
+		return;
+
+	if (as_strv)
+	{
+		const gchar *strv[] = { g_value_get_string(v), NULL };
+		g_variant_builder_add(builder, "{sv}", key, g_variant_new_strv(strv, -1));
+	}
+	else
+		g_variant_builder_add(builder, "{sv}", key, g_variant_new_string(g_value_get_string(v)));
+}
+
 static GVariant*
 build_metadata_variant(LomoStream *stream)
 {
 	GVariantBuilder *builder = g_variant_builder_new(G_VARIANT_TYPE ("a{sv}"));
 	g_return_val_if_fail(LOMO_IS_STREAM(stream), g_variant_builder_end(builder));
 
-	GList *taglist = lomo_stream_get_tags(stream);
-	GList *l = taglist;
-	while (l)
-	{
-		const gchar *tag = (const gchar *) l->data;
-		if (lomo_tag_get_gtype(tag) != G_TYPE_STRING)
-			goto build_metadata_variant_loop_next;
-
-		// Translate LomoTag to xesam tag
-		const gchar *xesam_tag = NULL;
-		GVariant    *tag_variant = NULL;
-		if (g_str_equal(LOMO_TAG_ALBUM, tag))
-			xesam_tag = "album";
-
-		else if (g_str_equal(LOMO_TAG_TITLE, tag))
-			xesam_tag = "title";
-
-		else if (g_str_equal(LOMO_TAG_ARTIST, tag))
-		{
-			xesam_tag = "artist";
-			gchar *artists[] = { lomo_stream_strdup_tag_value(stream, tag), NULL };
-			tag_variant = g_variant_new_strv((const gchar * const *) artists, -1);
-			g_free(artists[0]);
-		}
-
-		else
-			goto build_metadata_variant_loop_next;
-
-		if (tag_variant == NULL)
-		{
-			gchar *tag_str = lomo_stream_strdup_tag_value(stream, tag);
-			if (tag_str)
-				tag_variant = g_variant_new_string(tag_str);
-			g_free(tag_str);
-		}
-
-		if (!xesam_tag || !tag_variant)
-			goto build_metadata_variant_loop_next;
+	g_variant_builder_add(builder, "{sv}", "mpris:trackid", g_variant_new_object_path(stream_get_track_id(stream)));
+	metadata_add_string(builder, "xesam:url",         stream, LOMO_TAG_URI,    FALSE);
+	metadata_add_string(builder, "xesam:title",       stream, LOMO_TAG_TITLE,  FALSE);
+	metadata_add_string(builder, "xesam:album",       stream, LOMO_TAG_ALBUM,  FALSE);
+	metadata_add_string(builder, "xesam:artist",      stream, LOMO_TAG_ARTIST, TRUE);
+	metadata_add_string(builder, "xesam:albumArtist", stream, "album-artist",  TRUE);
+	metadata_add_string(builder, "xesam:genre",       stream, LOMO_TAG_GENRE,  TRUE);
 
-		gchar *tmp = g_strconcat("xesam:", xesam_tag, NULL);
-		g_variant_builder_add(builder, "{sv}", tmp, tag_variant);
-		g_free(tmp);
+	const GValue *track_number = lomo_stream_get_tag(stream, LOMO_TAG_TRACK_NUMBER);
+	if (track_number && G_VALUE_HOLDS_UINT(track_number))
+		g_variant_builder_add(builder, "{sv}",
+			"xesam:trackNumber",
+			g_variant_new_int32(g_value_get_uint(track_number)));
 
-build_metadata_variant_loop_next:
-		l = l->next;
-	}
-	gel_list_deep_free(taglist, g_free);
+	// Lomo measures in nanoseconds, MPRIS in microseconds
+	gint64 length = lomo_stream_get_length(stream);
+	if (length >= 0)
+		g_variant_builder_add(builder, "{sv}",
+			"mpris:length",
+			g_variant_new_int64(length / 1000));
 
 	const GValue *art_value = lomo_stream_get_extended_metadata(stream, LOMO_STREAM_EM_ART_DATA);
 	if (art_value && G_VALUE_HOLDS_STRING(art_value))
@@ -802,6 +1223,38 @@ build_metadata_variant_loop_next:
 	return ret;
 }
 
+static void
+metadata_cache_free(MetadataCache *cache)
+{
+	g_variant_unref(cache->variant);
+	g_free(cache->art_url);
+	g_free(cache);
+}
+
+/*
+ * Returns: (transfer none): The cached metadata variant for @stream, rebuilt
+ * if missing or stale
+ */
+static GVariant*
+stream_get_metadata_variant(LomoStream *stream)
+{
+	const GValue *art_value = lomo_stream_get_extended_metadata(stream, LOMO_STREAM_EM_ART_DATA);
+	const gchar  *art_url   = (art_value && G_VALUE_HOLDS_STRING(art_value)) ? g_value_get_string(art_value) : NULL;
+	gint64 length = lomo_stream_get_length(stream);
+
+	MetadataCache *cache = g_object_get_data((GObject *) stream, METADATA_CACHE_KEY);
+	if (cache && (cache->length == length) && !g_strcmp0(cache->art_url, art_url))
+		return cache->variant;
+
+	cache = g_new0(MetadataCache, 1);
+	cache->variant = g_variant_ref_sink(build_metadata_variant(stream));
+	cache->art_url = g_strdup(art_url);
+	cache->length  = length;
+	g_object_set_data_full((GObject *) stream, METADATA_CACHE_KEY, cache, (GDestroyNotify) metadata_cache_free);
+
+	return cache->variant;
+}
+
 static GVariant *
 player_get_property_cb (GDBusConnection *connection,
 	const char *sender,
@@ -862,7 +1315,7 @@ player_get_property_cb (GDBusConnection *connection,
 			goto player_get_property_cb_error;
 		}
 
-		return build_metadata_variant(stream);
+		return g_variant_ref(stream_get_metadata_variant(stream));
 	}
 
 	// MinimumRate, MaximumRate
@@ -1118,3 +1571,175 @@ playlist_set_property_cb (GDBusConnection *connection,
 	return FALSE;
 }
 
+
+typedef struct {
+	EinaMprisPlayer       *self;
+	GDBusMethodInvocation *invocation;
+	GVariant              *ids;
+	gsize                  index;
+	GVariantBuilder       *builder;
+} TracksMetadataRequest;
+
+/*
+ * Resolves up to TRACKLIST_PAGE_SIZE ids per call so big requests don't
+ * stall the main loop. Unknown ids are skipped as mandated by the spec.
+ */
+static gboolean
+tracks_metadata_page_cb(TracksMetadataRequest *req)
+{
+	gsize n_ids = g_variant_n_children(req->ids);
+	for (guint i = 0; (i < TRACKLIST_PAGE_SIZE) && (req->index < n_ids); i++, req->index++)
+	{
+		const gchar *id = NULL;
+		g_variant_get_child(req->ids, req->index, "&o", &id);
+
+		LomoStream *stream = req->self->priv->tracks ? g_hash_table_lookup(req->self->priv->tracks, id) : NULL;
+		if (stream)
+			g_variant_builder_add_value(req->builder, stream_get_metadata_variant(stream));
+	}
+
+	if (req->index < n_ids)
+		return TRUE;
+
+	g_dbus_method_invocation_return_value(req->invocation, g_variant_new("(aa{sv})", req->builder));
+
+	g_variant_builder_unref(req->builder);
+	g_variant_unref(req->ids);
+	g_object_unref(req->self);
+	g_free(req);
+
+	return FALSE;
+}
+
+static void
+tracklist_method_call_cb (GDBusConnection *connection,
+	const char *sender,
+	const char *object_path,
+	const char *interface_name,
+	const char *method_name,
+	GVariant *parameters,
+	GDBusMethodInvocation *invocation,
+	EinaMprisPlayer *self)
+{
+	LomoPlayer *lomo = eina_application_get_lomo(self->priv->app);
+
+	if (g_str_equal("GetTracksMetadata", method_name))
+	{
+		TracksMetadataRequest *req = g_new0(TracksMetadataRequest, 1);
+		req->self       = g_object_ref(self);
+		req->invocation = invocation;
+		req->ids        = g_variant_get_child_value(parameters, 0);
+		req->builder    = g_variant_builder_new(G_VARIANT_TYPE("aa{sv}"));
+
+		if (tracks_metadata_page_cb(req))
+			g_idle_add((GSourceFunc) tracks_metadata_page_cb, req);
+		return;
+	}
+
+	else if (g_str_equal("AddTrack", method_name))
+	{
+		const gchar *uri = NULL, *after = NULL;
+		gboolean set_as_current = FALSE;
+		g_variant_get(parameters, "(&s&ob)", &uri, &after, &set_as_current);
+
+		gint index = 0;
+		if (!g_str_equal(after, MPRIS_SPEC_NO_TRACK))
+		{
+			LomoStream *after_stream = g_hash_table_lookup(self->priv->tracks, after);
+			index = after_stream ? lomo_player_get_stream_index(lomo, after_stream) : -1;
+			if (index < 0)
+			{
+				g_dbus_method_invocation_return_error (invocation,
+					G_DBUS_ERROR,
+					G_DBUS_ERROR_INVALID_ARGS,
+					"Unknow track %s",
+					after);
+				return;
+			}
+			index++;
+		}
+
+		// Same check lomo_player_insert_strv() does, it only warns
+		gchar *scheme = g_uri_parse_scheme(uri);
+		if (scheme == NULL)
+		{
+			g_dbus_method_invocation_return_error (invocation,
+				G_DBUS_ERROR,
+				G_DBUS_ERROR_INVALID_ARGS,
+				"Invalid URI %s",
+				uri);
+			return;
+		}
+		g_free(scheme);
+
+		// Insert hooks may refuse the stream, only make it current if it
+		// made it into the playlist
+		LomoStream *stream = lomo_stream_new(uri);
+		lomo_player_insert(lomo, stream, index);
+		gint inserted = lomo_player_get_stream_index(lomo, stream);
+		g_object_unref(stream);
+
+		if (set_as_current && (inserted >= 0))
+			lomo_player_set_current(lomo, inserted, NULL);
+
+		g_dbus_method_invocation_return_value(invocation, NULL);
+		return;
+	}
+
+	else if (g_str_equal("RemoveTrack", method_name) || g_str_equal("GoTo", method_name))
+	{
+		const gchar *id = NULL;
+		g_variant_get(parameters, "(&o)", &id);
+
+		LomoStream *stream = g_hash_table_lookup(self->priv->tracks, id);
+		gint index = stream ? lomo_player_get_stream_index(lomo, stream) : -1;
+		if (index < 0)
+		{
+			g_dbus_method_invocation_return_error (invocation,
+				G_DBUS_ERROR,
+				G_DBUS_ERROR_INVALID_ARGS,
+				"Unknow track %s",
+				id);
+			return;
+		}
+
+		if (g_str_equal("GoTo", method_name))
+			lomo_player_set_current(lomo, index, NULL);
+		else
+			lomo_player_remove(lomo, index);
+
+		g_dbus_method_invocation_return_value(invocation, NULL);
+		return;
+	}
+
+	g_dbus_method_invocation_return_error (invocation,
+		G_DBUS_ERROR,
+		G_DBUS_ERROR_NOT_SUPPORTED,
+		"Method %s.%s not supported",
+		interface_name,
+		method_name);
+}
+
+static GVariant*
+tracklist_get_property_cb (GDBusConnection *connection,
+	const char *sender,
+	const char *object_path,
+	const char *interface_name,
+	const char *property_name,
+	GError **error,
+	EinaMprisPlayer *self)
+{
+	if (g_str_equal("Tracks", property_name))
+		return build_tracks_variant(self);
+
+	else if (g_str_equal("CanEditTracks", property_name))
+		return g_variant_new_boolean(TRUE);
+
+	g_set_error (error,
+		G_DBUS_ERROR,
+		G_DBUS_ERROR_NOT_SUPPORTED,
+		"get_property %s.%s not supported",
+		interface_name,
+		property_name);
+	return NULL;
+}
@@ -0,0 +1,795 @@
+/*
+ * eina/muine/eina-muine-browser-model.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: eina-muine-browser-model
+ * @title: EinaMuineBrowserModel
+ * @short_description: Lazy artist, album and track tree over EinaAdb
+ *
+ * #EinaMuineBrowserModel exposes the library as an artist → album → track
+ * #GtkTreeModel. Nothing is read upfront but the number of artists:
+ *
+ * <itemizedlist>
+ *   <listitem><para>Artists are fetched in pages when a view reads them,
+ *   using keyset pagination on the metadata index. Only a few pages are
+ *   kept in memory.</para></listitem>
+ *   <listitem><para>Albums and tracks are fetched with one query when their
+ *   parent is expanded, and dropped by
+ *   eina_muine_browser_model_collapse().</para></listitem>
+ * </itemizedlist>
+ *
+ * The model is a snapshot, it doesn't track changes in the database. Iters
+ * are only valid until the next call to
+ * eina_muine_browser_model_collapse().
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "eina-muine-browser-model.h"
+#include <glib/gi18n.h>
+#include <gel/gel.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaMuineBrowserModel"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// Artists per page and pages kept in memory, several screens of rows
+#define PAGE_SIZE 256
+#define MAX_PAGES 16
+
+static void eina_muine_browser_model_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (EinaMuineBrowserModel, eina_muine_browser_model, G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, eina_muine_browser_model_tree_model_init))
+
+typedef struct _Level Level;
+
+typedef struct {
+	gchar  *key;      // Artist, album or title
+	guint   count;    // Streams below, artists and albums only
+	gint64  sid;      // Tracks only
+	Level  *children; // Loaded on demand
+} Node;
+
+typedef struct {
+	Level *level;
+	guint  index;
+	Node  *nodes;
+	guint  n;
+	guint  n_expanded; // Nodes with children loaded, page can't be dropped
+	GList *lru_link;   // Artist pages only
+} Page;
+
+struct _Level {
+	Level *parent;
+	guint  parent_index;
+	guint  depth;     // EinaMuineBrowserModelLevel
+	guint  n;
+	guint  page_size;
+	Page **pages;
+	guint  n_pages;
+	gchar **bounds;   // Artists only, last key of each page if known
+};
+
+struct _EinaMuineBrowserModelPrivate {
+	EinaAdb *adb;
+	gint     stamp;
+	Level   *root;
+	GQueue  *lru; // <Page>, artist pages, most recently used first
+};
+
+enum {
+	PROP_ADB = 1
+};
+
+static Level* level_new_root    (EinaMuineBrowserModel *self);
+static Level* level_new_children(EinaMuineBrowserModel *self, Level *parent, guint index);
+static void   level_free        (EinaMuineBrowserModel *self, Level *level);
+static Node*  level_get_node    (EinaMuineBrowserModel *self, Level *level, guint index);
+static Level* node_get_children (EinaMuineBrowserModel *self, Level *level, guint index);
+
+static void
+eina_muine_browser_model_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	switch (property_id) {
+	case PROP_ADB:
+		g_value_set_object(value, eina_muine_browser_model_get_adb((EinaMuineBrowserModel *) object));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
+static void
+eina_muine_browser_model_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(object);
+
+	switch (property_id) {
+	case PROP_ADB:
+		g_return_if_fail(self->priv->adb == NULL);
+		self->priv->adb = g_value_dup_object(value);
+		self->priv->root = level_new_root(self);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
+static void
+eina_muine_browser_model_dispose (GObject *object)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(object);
+	EinaMuineBrowserModelPrivate *priv = self->priv;
+
+	if (priv->root)
+	{
+		level_free(self, priv->root);
+		priv->root = NULL;
+	}
+	gel_free_and_invalidate(priv->lru, NULL, g_queue_free);
+	gel_free_and_invalidate(priv->adb, NULL, g_object_unref);
+
+	G_OBJECT_CLASS (eina_muine_browser_model_parent_class)->dispose (object);
+}
+
+static void
+eina_muine_browser_model_class_init (EinaMuineBrowserModelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (EinaMuineBrowserModelPrivate));
+
+	object_class->get_property = eina_muine_browser_model_get_property;
+	object_class->set_property = eina_muine_browser_model_set_property;
+	object_class->dispose = eina_muine_browser_model_dispose;
+
+	/**
+	 * EinaMuineBrowserModel:adb:
+	 *
+	 * The #EinaAdb to browse
+	 */
+	g_object_class_install_property(object_class, PROP_ADB,
+		g_param_spec_object("adb", "adb", "adb",
+			EINA_TYPE_ADB, G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS));
+}
+
+static void
+eina_muine_browser_model_init (EinaMuineBrowserModel *self)
+{
+	EinaMuineBrowserModelPrivate *priv = self->priv = G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_MUINE_BROWSER_MODEL, EinaMuineBrowserModelPrivate);
+
+	priv->stamp = g_random_int();
+	priv->lru   = g_queue_new();
+}
+
+/**
+ * eina_muine_browser_model_new:
+ * @adb: (transfer none): An #EinaAdb
+ *
+ * Creates a new #EinaMuineBrowserModel over the library in @adb
+ *
+ * Returns: The #EinaMuineBrowserModel
+ */
+EinaMuineBrowserModel*
+eina_muine_browser_model_new (EinaAdb *adb)
+{
+	g_return_val_if_fail(EINA_IS_ADB(adb), NULL);
+	return g_object_new (EINA_TYPE_MUINE_BROWSER_MODEL, "adb", adb, NULL);
+}
+
+/**
+ * eina_muine_browser_model_get_adb:
+ * @self: An #EinaMuineBrowserModel
+ *
+ * Gets the value of #EinaMuineBrowserModel:adb property
+ *
+ * Returns: (transfer none): The property value
+ */
+EinaAdb*
+eina_muine_browser_model_get_adb(EinaMuineBrowserModel *self)
+{
+	g_return_val_if_fail(EINA_IS_MUINE_BROWSER_MODEL(self), NULL);
+	return self->priv->adb;
+}
+
+/**
+ * eina_muine_browser_model_collapse:
+ * @self: An #EinaMuineBrowserModel
+ * @iter: A row of @self
+ *
+ * Drops the rows below @iter, they will be fetched again if needed. Call it
+ * when the row is collapsed in the view. All iters are invalidated.
+ */
+void
+eina_muine_browser_model_collapse(EinaMuineBrowserModel *self, GtkTreeIter *iter)
+{
+	g_return_if_fail(EINA_IS_MUINE_BROWSER_MODEL(self));
+	EinaMuineBrowserModelPrivate *priv = self->priv;
+	g_return_if_fail(iter->stamp == priv->stamp);
+
+	Level *level = (Level *) iter->user_data;
+	guint  index = GPOINTER_TO_UINT(iter->user_data2);
+
+	Page *page = level->pages[index / level->page_size];
+	Node *node = page ? &page->nodes[index % level->page_size] : NULL;
+	if (!node || !node->children)
+		return;
+
+	level_free(self, node->children);
+	node->children = NULL;
+	page->n_expanded--;
+	priv->stamp++;
+}
+
+/**
+ * eina_muine_browser_model_get_uris:
+ * @self: An #EinaMuineBrowserModel
+ * @iter: A row of @self
+ *
+ * Gets the URIs of all tracks below @iter, or of @iter itself if it's a
+ * track, ordered by album and title
+ *
+ * Returns: (transfer full) (element-type utf8): The URIs
+ */
+GList*
+eina_muine_browser_model_get_uris(EinaMuineBrowserModel *self, GtkTreeIter *iter)
+{
+	g_return_val_if_fail(EINA_IS_MUINE_BROWSER_MODEL(self), NULL);
+	EinaMuineBrowserModelPrivate *priv = self->priv;
+	g_return_val_if_fail(iter->stamp == priv->stamp, NULL);
+
+	Level *level = (Level *) iter->user_data;
+	Node  *node  = level_get_node(self, level, GPOINTER_TO_UINT(iter->user_data2));
+	g_return_val_if_fail(node != NULL, NULL);
+
+	// Albums and tracks without tag have a NULL key, matched with IS
+	EinaAdbResult *r = NULL;
+	switch (level->depth)
+	{
+	case EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST:
+		r = eina_adb_query(priv->adb,
+			"SELECT s.uri FROM metadata AS a JOIN streams AS s ON s.sid = a.sid "
+			"LEFT JOIN metadata AS b ON b.sid = a.sid AND b.key = 'album' "
+			"LEFT JOIN metadata AS t ON t.sid = a.sid AND t.key = 'title' "
+			"WHERE a.key = 'artist' AND a.value = '%q' ORDER BY b.value IS NULL, b.value, t.value",
+			node->key ? node->key : "");
+		break;
+
+	case EINA_MUINE_BROWSER_MODEL_LEVEL_ALBUM:
+		r = eina_adb_query(priv->adb,
+			"SELECT s.uri FROM metadata AS a JOIN streams AS s ON s.sid = a.sid "
+			"LEFT JOIN metadata AS b ON b.sid = a.sid AND b.key = 'album' "
+			"LEFT JOIN metadata AS t ON t.sid = a.sid AND t.key = 'title' "
+			"WHERE a.key = 'artist' AND a.value = '%q' AND b.value IS %Q ORDER BY t.value",
+			level_get_node(self, level->parent, level->parent_index)->key, node->key);
+		break;
+
+	case EINA_MUINE_BROWSER_MODEL_LEVEL_TRACK:
+		r = eina_adb_query(priv->adb, "SELECT uri FROM streams WHERE sid = %lld", (long long) node->sid);
+		break;
+	}
+	g_return_val_if_fail(r != NULL, NULL);
+
+	GList *ret = NULL;
+	while (eina_adb_result_step(r))
+	{
+		gchar *uri = NULL;
+		eina_adb_result_get(r, 0, G_TYPE_STRING, &uri, -1);
+		if (uri)
+			ret = g_list_prepend(ret, uri);
+	}
+	g_object_unref(r);
+
+	return g_list_reverse(ret);
+}
+
+/*
+ * Levels and pages
+ */
+static void
+page_free(Page *page)
+{
+	for (guint i = 0; i < page->n; i++)
+	{
+		g_free(page->nodes[i].key);
+		g_warn_if_fail(page->nodes[i].children == NULL);
+	}
+	g_free(page->nodes);
+	g_free(page);
+}
+
+static void
+level_free(EinaMuineBrowserModel *self, Level *level)
+{
+	for (guint i = 0; i < level->n_pages; i++)
+	{
+		Page *page = level->pages[i];
+		if (!page)
+			continue;
+
+		for (guint j = 0; j < page->n; j++)
+		{
+			if (page->nodes[j].children)
+				level_free(self, page->nodes[j].children);
+			page->nodes[j].children = NULL;
+		}
+		if (page->lru_link)
+			g_queue_delete_link(self->priv->lru, page->lru_link);
+		page_free(page);
+	}
+
+	if (level->bounds)
+	{
+		for (guint i = 0; i < level->n_pages; i++)
+			g_free(level->bounds[i]);
+		g_free(level->bounds);
+	}
+	g_free(level->pages);
+	g_free(level);
+}
+
+static Level*
+level_new(Level *parent, guint parent_index, guint depth, guint n, guint page_size)
+{
+	Level *level = g_new0(Level, 1);
+	level->parent       = parent;
+	level->parent_index = parent_index;
+	level->depth        = depth;
+	level->n            = n;
+	level->page_size    = page_size;
+	level->n_pages      = (n + page_size - 1) / page_size;
+	level->pages        = g_new0(Page*, MAX(level->n_pages, 1));
+	return level;
+}
+
+static Level*
+level_new_root(EinaMuineBrowserModel *self)
+{
+	guint n = 0;
+	EinaAdbResult *r = eina_adb_query(self->priv->adb,
+		"SELECT count(DISTINCT value) FROM metadata WHERE key = 'artist'", NULL);
+	if (r && eina_adb_result_step(r))
+		eina_adb_result_get(r, 0, G_TYPE_UINT, &n, -1);
+	gel_free_and_invalidate(r, NULL, g_object_unref);
+
+	Level *root = level_new(NULL, 0, EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST, n, PAGE_SIZE);
+	root->bounds = g_new0(gchar*, MAX(root->n_pages, 1));
+
+	debug("%u artists in %u pages", n, root->n_pages);
+	return root;
+}
+
+/*
+ * Drops least recently used artist pages, but not those with expanded rows
+ */
+static void
+lru_trim(EinaMuineBrowserModel *self)
+{
+	GQueue *lru = self->priv->lru;
+
+	GList *link = lru->tail;
+	while (link && (g_queue_get_length(lru) > MAX_PAGES))
+	{
+		GList *prev = link->prev;
+		Page  *page = (Page *) link->data;
+
+		if (page->n_expanded == 0)
+		{
+			debug("Dropping artist page %u", page->index);
+			page->level->pages[page->index] = NULL;
+			g_queue_delete_link(lru, link);
+			page_free(page);
+		}
+		link = prev;
+	}
+}
+
+/*
+ * Fetches a page of artists. Pages are read with keyset pagination from the
+ * last artist of the closest previous page already seen, so scrolling costs
+ * one index range scan per page. Jumping far ahead falls back to OFFSET from
+ * there, which still only walks the index.
+ */
+static Page*
+root_load_page(EinaMuineBrowserModel *self, Level *root, guint index)
+{
+	gint from = (gint) index - 1;
+	while ((from >= 0) && (root->bounds[from] == NULL))
+		from--;
+	guint offset = (guint) ((gint) index - 1 - from) * PAGE_SIZE;
+
+	EinaAdbResult *r = NULL;
+	if (from >= 0)
+		r = eina_adb_query(self->priv->adb,
+			"SELECT value, count(*) FROM metadata WHERE key = 'artist' AND value > '%q' "
+			"GROUP BY value ORDER BY value LIMIT %u OFFSET %u",
+			root->bounds[from], PAGE_SIZE, offset);
+	else
+		r = eina_adb_query(self->priv->adb,
+			"SELECT value, count(*) FROM metadata WHERE key = 'artist' AND value IS NOT NULL "
+			"GROUP BY value ORDER BY value LIMIT %u OFFSET %u",
+			PAGE_SIZE, offset);
+	debug("Loading artist page %u (from page %d, offset %u)", index, from, offset);
+
+	Page *page = g_new0(Page, 1);
+	page->level = root;
+	page->index = index;
+	page->n     = MIN(PAGE_SIZE, root->n - index * PAGE_SIZE);
+	page->nodes = g_new0(Node, page->n);
+
+	// Rows missing if the library changed since counting are left empty
+	for (guint i = 0; r && (i < page->n) && eina_adb_result_step(r); i++)
+	{
+		eina_adb_result_get(r,
+			0, G_TYPE_STRING, &(page->nodes[i].key),
+			1, G_TYPE_UINT,   &(page->nodes[i].count),
+			-1);
+	}
+	gel_free_and_invalidate(r, NULL, g_object_unref);
+
+	if (page->n && page->nodes[page->n - 1].key)
+		root->bounds[index] = g_strdup(page->nodes[page->n - 1].key);
+
+	root->pages[index] = page;
+	g_queue_push_head(self->priv->lru, page);
+	page->lru_link = self->priv->lru->head;
+	lru_trim(self);
+
+	return page;
+}
+
+static Node*
+level_get_node(EinaMuineBrowserModel *self, Level *level, guint index)
+{
+	g_return_val_if_fail(index < level->n, NULL);
+
+	guint p = index / level->page_size;
+	Page *page = level->pages[p];
+	if (page == NULL)
+	{
+		// Only artists are paged, other levels are loaded as a whole
+		g_return_val_if_fail(level->depth == EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST, NULL);
+		page = root_load_page(self, level, p);
+	}
+	else if (page->lru_link && (page->lru_link != self->priv->lru->head))
+	{
+		g_queue_unlink(self->priv->lru, page->lru_link);
+		g_queue_push_head_link(self->priv->lru, page->lru_link);
+	}
+
+	return &page->nodes[index % level->page_size];
+}
+
+/*
+ * Fetches albums of an artist or tracks of an album with a single query
+ */
+static Level*
+level_new_children(EinaMuineBrowserModel *self, Level *parent, guint index)
+{
+	EinaMuineBrowserModelPrivate *priv = self->priv;
+	Node *node = level_get_node(self, parent, index);
+
+	EinaAdbResult *r = NULL;
+	// Streams without album are grouped in a last, unknown album (NULL key),
+	// so the tree lists the same streams get_uris() returns for the artist
+	switch (parent->depth)
+	{
+	case EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST:
+		r = eina_adb_query(priv->adb,
+			"SELECT b.value, count(*) FROM metadata AS a "
+			"LEFT JOIN metadata AS b ON b.sid = a.sid AND b.key = 'album' "
+			"WHERE a.key = 'artist' AND a.value = '%q' GROUP BY b.value ORDER BY b.value IS NULL, b.value",
+			node->key ? node->key : "");
+		break;
+
+	case EINA_MUINE_BROWSER_MODEL_LEVEL_ALBUM:
+		r = eina_adb_query(priv->adb,
+			"SELECT a.sid, t.value FROM metadata AS a "
+			"LEFT JOIN metadata AS b ON b.sid = a.sid AND b.key = 'album' "
+			"LEFT JOIN metadata AS t ON t.sid = a.sid AND t.key = 'title' "
+			"WHERE a.key = 'artist' AND a.value = '%q' AND b.value IS %Q ORDER BY t.value",
+			level_get_node(self, parent->parent, parent->parent_index)->key,
+			node->key);
+		break;
+
+	default:
+		g_return_val_if_reached(NULL);
+	}
+
+	GArray *nodes = g_array_new(FALSE, TRUE, sizeof(Node));
+	while (r && eina_adb_result_step(r))
+	{
+		Node child = { NULL, 0, 0, NULL };
+		if (parent->depth == EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST)
+			eina_adb_result_get(r,
+				0, G_TYPE_STRING, &child.key,
+				1, G_TYPE_UINT,   &child.count,
+				-1);
+		else
+			eina_adb_result_get(r,
+				0, G_TYPE_INT64,  &child.sid,
+				1, G_TYPE_STRING, &child.key,
+				-1);
+		g_array_append_val(nodes, child);
+	}
+	gel_free_and_invalidate(r, NULL, g_object_unref);
+
+	Level *level = level_new(parent, index, parent->depth + 1, nodes->len, G_MAXUINT);
+
+	Page *page = g_new0(Page, 1);
+	page->level = level;
+	page->n     = nodes->len;
+	page->nodes = (Node *) g_array_free(nodes, FALSE);
+	level->pages[0] = page;
+
+	debug("Loaded %u rows at depth %u", level->n, level->depth);
+	return level;
+}
+
+static Level*
+node_get_children(EinaMuineBrowserModel *self, Level *level, guint index)
+{
+	if (level->depth >= EINA_MUINE_BROWSER_MODEL_LEVEL_TRACK)
+		return NULL;
+
+	Node *node = level_get_node(self, level, index);
+	g_return_val_if_fail(node != NULL, NULL);
+
+	if (node->children == NULL)
+	{
+		node->children = level_new_children(self, level, index);
+		if (node->children)
+			level->pages[index / level->page_size]->n_expanded++;
+	}
+	return node->children;
+}
+
+/*
+ * GtkTreeModel implementation
+ */
+static gboolean
+model_set_iter(EinaMuineBrowserModel *self, GtkTreeIter *iter, Level *level, guint index)
+{
+	if (!level || (index >= level->n))
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+
+	iter->stamp      = self->priv->stamp;
+	iter->user_data  = level;
+	iter->user_data2 = GUINT_TO_POINTER(index);
+	return TRUE;
+}
+
+static GtkTreeModelFlags
+model_get_flags(GtkTreeModel *model)
+{
+	return 0;
+}
+
+static gint
+model_get_n_columns(GtkTreeModel *model)
+{
+	return EINA_MUINE_BROWSER_MODEL_N_COLUMNS;
+}
+
+static GType
+model_get_column_type(GtkTreeModel *model, gint column)
+{
+	switch (column)
+	{
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_ICON:
+		return GDK_TYPE_PIXBUF;
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_MARKUP:
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_KEY:
+		return G_TYPE_STRING;
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_LEVEL:
+		return G_TYPE_UINT;
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_SID:
+		return G_TYPE_INT64;
+	default:
+		g_return_val_if_reached(G_TYPE_INVALID);
+	}
+}
+
+static gboolean
+model_get_iter(GtkTreeModel *model, GtkTreeIter *iter, GtkTreePath *path)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+
+	gint  depth   = gtk_tree_path_get_depth(path);
+	gint *indices = gtk_tree_path_get_indices(path);
+
+	Level *level = self->priv->root;
+	for (gint i = 0; level && (i < depth - 1); i++)
+	{
+		if ((guint) indices[i] >= level->n)
+			level = NULL;
+		else
+			level = node_get_children(self, level, indices[i]);
+	}
+
+	return model_set_iter(self, iter, level, indices[depth - 1]);
+}
+
+static GtkTreePath*
+model_get_path(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	g_return_val_if_fail(iter->stamp == EINA_MUINE_BROWSER_MODEL(model)->priv->stamp, NULL);
+
+	GtkTreePath *path = gtk_tree_path_new();
+	gtk_tree_path_prepend_index(path, GPOINTER_TO_UINT(iter->user_data2));
+	for (Level *level = (Level *) iter->user_data; level->parent; level = level->parent)
+		gtk_tree_path_prepend_index(path, level->parent_index);
+
+	return path;
+}
+
+static void
+model_get_value(GtkTreeModel *model, GtkTreeIter *iter, gint column, GValue *value)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+	g_return_if_fail(iter->stamp == self->priv->stamp);
+
+	Level *level = (Level *) iter->user_data;
+	Node  *node  = level_get_node(self, level, GPOINTER_TO_UINT(iter->user_data2));
+
+	g_value_init(value, model_get_column_type(model, column));
+	if (node == NULL)
+		return;
+
+	switch (column)
+	{
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_MARKUP:
+	{
+		const gchar *unknown = (level->depth == EINA_MUINE_BROWSER_MODEL_LEVEL_ALBUM) ? _("Unknown album") : _("Unknown");
+		gchar *escaped = g_markup_escape_text(node->key ? node->key : unknown, -1);
+		switch (level->depth)
+		{
+		case EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST:
+			g_value_take_string(value, g_strdup_printf("<b>%s</b> <span size=\"small\" weight=\"light\">(%u streams)</span>", escaped, node->count));
+			break;
+		case EINA_MUINE_BROWSER_MODEL_LEVEL_ALBUM:
+			g_value_take_string(value, g_strdup_printf("%s <span size=\"small\" weight=\"light\">(%u streams)</span>", escaped, node->count));
+			break;
+		default:
+			g_value_set_string(value, escaped);
+			break;
+		}
+		g_free(escaped);
+		break;
+	}
+
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_KEY:
+		g_value_set_string(value, node->key);
+		break;
+
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_LEVEL:
+		g_value_set_uint(value, level->depth);
+		break;
+
+	case EINA_MUINE_BROWSER_MODEL_COLUMN_SID:
+		g_value_set_int64(value, node->sid);
+		break;
+
+	default:
+		break;
+	}
+}
+
+static gboolean
+model_iter_next(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+	g_return_val_if_fail(iter->stamp == self->priv->stamp, FALSE);
+
+	return model_set_iter(self, iter, (Level *) iter->user_data, GPOINTER_TO_UINT(iter->user_data2) + 1);
+}
+
+static gboolean
+model_iter_previous(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+	g_return_val_if_fail(iter->stamp == self->priv->stamp, FALSE);
+
+	guint index = GPOINTER_TO_UINT(iter->user_data2);
+	if (index == 0)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+	return model_set_iter(self, iter, (Level *) iter->user_data, index - 1);
+}
+
+static gboolean
+model_iter_nth_child(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent, gint n)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+
+	Level *level = self->priv->root;
+	if (parent)
+	{
+		g_return_val_if_fail(parent->stamp == self->priv->stamp, FALSE);
+		level = node_get_children(self, (Level *) parent->user_data, GPOINTER_TO_UINT(parent->user_data2));
+	}
+
+	return model_set_iter(self, iter, level, (guint) n);
+}
+
+static gboolean
+model_iter_children(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent)
+{
+	return model_iter_nth_child(model, iter, parent, 0);
+}
+
+static gboolean
+model_iter_has_child(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	// Artists and albums are shown as expandable without querying
+	return (((Level *) iter->user_data)->depth < EINA_MUINE_BROWSER_MODEL_LEVEL_TRACK);
+}
+
+static gint
+model_iter_n_children(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+
+	if (iter == NULL)
+		return self->priv->root ? self->priv->root->n : 0;
+
+	g_return_val_if_fail(iter->stamp == self->priv->stamp, 0);
+	Level *level = node_get_children(self, (Level *) iter->user_data, GPOINTER_TO_UINT(iter->user_data2));
+	return level ? level->n : 0;
+}
+
+static gboolean
+model_iter_parent(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *child)
+{
+	EinaMuineBrowserModel *self = EINA_MUINE_BROWSER_MODEL(model);
+	g_return_val_if_fail(child->stamp == self->priv->stamp, FALSE);
+
+	Level *level = (Level *) child->user_data;
+	return model_set_iter(self, iter, level->parent, level->parent_index);
+}
+
+static void
+eina_muine_browser_model_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags       = model_get_flags;
+	iface->get_n_columns   = model_get_n_columns;
+	iface->get_column_type = model_get_column_type;
+	iface->get_iter        = model_get_iter;
+	iface->get_path        = model_get_path;
+	iface->get_value       = model_get_value;
+	iface->iter_next       = model_iter_next;
+	iface->iter_previous   = model_iter_previous;
+	iface->iter_children   = model_iter_children;
+	iface->iter_has_child  = model_iter_has_child;
+	iface->iter_n_children = model_iter_n_children;
+	iface->iter_nth_child  = model_iter_nth_child;
+	iface->iter_parent     = model_iter_parent;
+}
@@ -0,0 +1,88 @@
+/*
+ * eina/muine/eina-muine-browser-model.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EINA_MUINE_BROWSER_MODEL_H__
+#define __EINA_MUINE_BROWSER_MODEL_H__
+
+#include <gtk/gtk.h>
+#include <eina/adb/eina-adb.h>
+
+G_BEGIN_DECLS
+
+#define EINA_TYPE_MUINE_BROWSER_MODEL eina_muine_browser_model_get_type()
+
+#define EINA_MUINE_BROWSER_MODEL(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EINA_TYPE_MUINE_BROWSER_MODEL, EinaMuineBrowserModel))
+#define EINA_MUINE_BROWSER_MODEL_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  EINA_TYPE_MUINE_BROWSER_MODEL, EinaMuineBrowserModelClass))
+#define EINA_IS_MUINE_BROWSER_MODEL(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EINA_TYPE_MUINE_BROWSER_MODEL))
+#define EINA_IS_MUINE_BROWSER_MODEL_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  EINA_TYPE_MUINE_BROWSER_MODEL))
+#define EINA_MUINE_BROWSER_MODEL_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  EINA_TYPE_MUINE_BROWSER_MODEL, EinaMuineBrowserModelClass))
+
+typedef struct _EinaMuineBrowserModelPrivate EinaMuineBrowserModelPrivate;
+typedef struct {
+	GObject parent;
+	EinaMuineBrowserModelPrivate *priv;
+} EinaMuineBrowserModel;
+
+typedef struct {
+	GObjectClass parent_class;
+} EinaMuineBrowserModelClass;
+
+/**
+ * EinaMuineBrowserModelColumn:
+ * @EINA_MUINE_BROWSER_MODEL_COLUMN_ICON: Always %NULL, keeps the column layout
+ *                                        of muine's list model
+ * @EINA_MUINE_BROWSER_MODEL_COLUMN_MARKUP: Markup for the row
+ * @EINA_MUINE_BROWSER_MODEL_COLUMN_KEY: Artist, album or title as plain text
+ * @EINA_MUINE_BROWSER_MODEL_COLUMN_LEVEL: An #EinaMuineBrowserModelLevel
+ * @EINA_MUINE_BROWSER_MODEL_COLUMN_SID: Stream ID for tracks, 0 otherwise
+ */
+typedef enum {
+	EINA_MUINE_BROWSER_MODEL_COLUMN_ICON = 0,
+	EINA_MUINE_BROWSER_MODEL_COLUMN_MARKUP,
+	EINA_MUINE_BROWSER_MODEL_COLUMN_KEY,
+	EINA_MUINE_BROWSER_MODEL_COLUMN_LEVEL,
+	EINA_MUINE_BROWSER_MODEL_COLUMN_SID,
+
+	EINA_MUINE_BROWSER_MODEL_N_COLUMNS
+} EinaMuineBrowserModelColumn;
+
+/**
+ * EinaMuineBrowserModelLevel:
+ * @EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST: Top level rows
+ * @EINA_MUINE_BROWSER_MODEL_LEVEL_ALBUM: Albums of an artist
+ * @EINA_MUINE_BROWSER_MODEL_LEVEL_TRACK: Tracks of an album
+ */
+typedef enum {
+	EINA_MUINE_BROWSER_MODEL_LEVEL_ARTIST = 0,
+	EINA_MUINE_BROWSER_MODEL_LEVEL_ALBUM,
+	EINA_MUINE_BROWSER_MODEL_LEVEL_TRACK
+} EinaMuineBrowserModelLevel;
+
+GType eina_muine_browser_model_get_type (void);
+
+EinaMuineBrowserModel* eina_muine_browser_model_new (EinaAdb *adb);
+
+EinaAdb* eina_muine_browser_model_get_adb(EinaMuineBrowserModel *self);
+
+void   eina_muine_browser_model_collapse(EinaMuineBrowserModel *self, GtkTreeIter *iter);
+GList* eina_muine_browser_model_get_uris(EinaMuineBrowserModel *self, GtkTreeIter *iter);
+
+G_END_DECLS
+
+#endif /* __EINA_MUINE_BROWSER_MODEL_H__ */
@@ -19,6 +19,7 @@
 
 #define LIBLOMO_USE_PRIVATE_API
 #include "eina-muine.h"
+#include "eina-muine-browser-model.h"
 
 #if HAVE_CONFIG_H
 #include <config.h>
@@ -27,6 +28,7 @@
 #include <glib/gi18n.h>
 #include <gel/gel-io.h>
 #include <lomo/lomo-em-art-provider.h>
+#include <eina/core/eina-art-cache.h>
 
 G_DEFINE_TYPE (EinaMuine, eina_muine, GEL_UI_TYPE_GENERIC)
 
@@ -42,10 +44,15 @@ struct _EinaMuinePrivate {
 	// Internal
 	GHashTable         *stream_iter_map;
 	GtkTreeView        *listview;
-	GtkTreeModelFilter *filter;
+	GtkTreeModelFilter *filter; // NULL while filling
+	GtkTreeModelSort   *sort;   // Over filter, best matches first while searching
 	GtkListStore       *model;
-	GtkEntry           *search;
-	gchar              *search_str;
+	GelUIModelFiller   *filler; // Only while filling
+	GCancellable       *update_cancellable; // Running group query
+	GCancellable       *icon_cancellable;   // Art lookups, cancelled on dispose
+	GelUISearch        *search;
+	GtkEntry           *search_entry;
+	EinaMuineBrowserModel *browser; // Only in EINA_MUINE_MODE_BROWSE
 };
 
 enum {
@@ -62,24 +69,43 @@ enum {
 	COMBO_N_COLUMNS
 };
 
+// Sort column id of priv->sort, not a model column
+#define SORT_COLUMN_SCORE 0
+
 static GtkListStore*
 muine_get_model(EinaMuine *self);
-static GtkTreeModelFilter*
-muine_get_filter(EinaMuine *self);
 static void
 muine_update(EinaMuine *self);
 static void
+muine_set_browsing(EinaMuine *self, gboolean browse);
+static void
+muine_attach_filter(EinaMuine *self);
+static void
 muine_update_icon(EinaMuine *self, LomoStream *stream);
+
+typedef struct {
+	EinaMuine  *self;
+	LomoStream *stream;
+} MuineIconLookup;
+
+static void
+muine_icon_lookup_free(MuineIconLookup *lookup);
+static void
+muine_icon_lookup_cb(GdkPixbuf *pixbuf, const GError *error, MuineIconLookup *lookup);
 static GList *
 muine_get_uris_from_tree_iter(EinaMuine *self, GtkTreeIter *iter);
-static gboolean
-muine_filter_func(GtkTreeModel *model, GtkTreeIter *iter, EinaMuine *self);
 
 static void
 row_activated_cb(GtkWidget *w, GtkTreePath *path, GtkTreeViewColumn *column, EinaMuine *self);
 static void
+row_collapsed_cb(GtkWidget *w, GtkTreeIter *iter, GtkTreePath *path, EinaMuine *self);
+static void
 search_changed_cb(GtkWidget *w, EinaMuine *self);
 static void
+search_updated_cb(GelUISearch *search, EinaMuine *self);
+static gchar*
+search_key_func(GtkTreeModel *model, GtkTreeIter *iter, EinaMuine *self);
+static void
 search_icon_press_cb(GtkWidget *w, GtkEntryIconPosition pos, GdkEvent *ev, EinaMuine *self);
 static void
 action_activate_cb(GtkAction *action, EinaMuine *self);
@@ -129,6 +155,29 @@ eina_muine_set_property (GObject *object, guint property_id, const GValue *value
 static void
 eina_muine_dispose (GObject *object)
 {
+	EinaMuinePrivate *priv = EINA_MUINE(object)->priv;
+
+	if (priv->filler)
+	{
+		gel_ui_model_filler_cancel(priv->filler);
+		gel_free_and_invalidate(priv->filler, NULL, g_object_unref);
+	}
+	if (priv->update_cancellable)
+	{
+		g_cancellable_cancel(priv->update_cancellable);
+		gel_free_and_invalidate(priv->update_cancellable, NULL, g_object_unref);
+	}
+	if (priv->icon_cancellable)
+	{
+		g_cancellable_cancel(priv->icon_cancellable);
+		gel_free_and_invalidate(priv->icon_cancellable, NULL, g_object_unref);
+	}
+	gel_free_and_invalidate(priv->search, NULL, g_object_unref);
+	gel_free_and_invalidate(priv->browser, NULL, g_object_unref);
+	gel_free_and_invalidate(priv->sort,   NULL, g_object_unref);
+	gel_free_and_invalidate(priv->filter, NULL, g_object_unref);
+	gel_free_and_invalidate(priv->model,  NULL, g_object_unref);
+
 	G_OBJECT_CLASS (eina_muine_parent_class)->dispose (object);
 }
 
@@ -152,7 +201,7 @@ eina_muine_class_init (EinaMuineClass *klass)
 		);
 
 	g_object_class_install_property(object_class, PROP_MODE,
-		g_param_spec_int("mode", "mode", "mode", 0, 1, EINA_MUINE_MODE_ALBUM, G_PARAM_WRITABLE | G_PARAM_READABLE)
+		g_param_spec_int("mode", "mode", "mode", 0, 2, EINA_MUINE_MODE_ALBUM, G_PARAM_WRITABLE | G_PARAM_READABLE)
 		);
 }
 
@@ -161,6 +210,7 @@ eina_muine_init (EinaMuine *self)
 {
 	EinaMuinePrivate *priv = self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_MUINE, EinaMuinePrivate));
 	priv->stream_iter_map = g_hash_table_new_full(g_direct_hash, g_direct_equal, (GDestroyNotify) g_object_unref, (GDestroyNotify) gtk_tree_iter_free);
+	priv->icon_cancellable = g_cancellable_new();
 }
 
 EinaMuine*
@@ -175,15 +225,19 @@ eina_muine_new (void)
 
 	GelUIGeneric *ui_generic = GEL_UI_GENERIC(self);
 
-	priv->listview = gel_ui_generic_get_typed(ui_generic, GTK_TREE_VIEW,         "list-view");
-	priv->filter   = gel_ui_generic_get_typed(ui_generic, GTK_TREE_MODEL_FILTER, "model-filter");
-	priv->model    = gel_ui_generic_get_typed(ui_generic, GTK_LIST_STORE,        "model");
-	priv->search   = gel_ui_generic_get_typed(ui_generic, GTK_ENTRY,             "search-entry");
+	priv->listview     = gel_ui_generic_get_typed(ui_generic, GTK_TREE_VIEW,  "list-view");
+	priv->model        = gel_ui_generic_get_typed(ui_generic, GTK_LIST_STORE, "model");
+	priv->search_entry = gel_ui_generic_get_typed(ui_generic, GTK_ENTRY,      "search-entry");
+
+	// Stores are replaced on each fill, filters are created for them
+	g_object_ref(priv->model);
+	priv->search = gel_ui_search_new(NULL, -1);
+	muine_attach_filter(self);
+	gel_ui_search_set_key_func(priv->search, (GelUISearchKeyFunc) search_key_func, self, NULL);
 
 	g_object_set(gel_ui_generic_get_object(ui_generic, "markup-renderer"),
 		"yalign", 0.0f,
 		NULL);
-	gtk_tree_model_filter_set_visible_func(priv->filter, (GtkTreeModelFilterVisibleFunc) muine_filter_func, self, NULL);
 	g_object_bind_property(self, "mode", gel_ui_generic_get_object(ui_generic, "mode-view"), "active", G_BINDING_BIDIRECTIONAL | G_BINDING_SYNC_CREATE);
 
 	gchar *actions[] = { "play-action", "queue-action" };
@@ -193,8 +247,10 @@ eina_muine_new (void)
 		g_signal_connect(a, "activate", (GCallback) action_activate_cb, self);
 	}
 	g_signal_connect(priv->listview, "row-activated", (GCallback) row_activated_cb, self);
-	g_signal_connect(priv->search,   "changed",       (GCallback) search_changed_cb, self);
-	g_signal_connect(priv->search,   "icon-press",    (GCallback) search_icon_press_cb, self);
+	g_signal_connect(priv->listview, "row-collapsed", (GCallback) row_collapsed_cb, self);
+	g_signal_connect(priv->search_entry, "changed",    (GCallback) search_changed_cb, self);
+	g_signal_connect(priv->search_entry, "icon-press", (GCallback) search_icon_press_cb, self);
+	g_signal_connect(priv->search, "updated", (GCallback) search_updated_cb, self);
 
 	return self;
 }
@@ -279,11 +335,91 @@ muine_get_model(EinaMuine *self)
 	return self->priv->model;
 }
 
-static GtkTreeModelFilter*
-muine_get_filter(EinaMuine *self)
+/*
+ * Best matches first, rows with the same score keep the order of the store
+ */
+static gint
+muine_score_compare(GtkTreeModel *model, GtkTreeIter *a, GtkTreeIter *b, EinaMuine *self)
 {
-	g_return_val_if_fail(EINA_IS_MUINE(self), NULL);
-	return self->priv->filter;
+	GtkTreeIter child_a, child_b;
+	gtk_tree_model_filter_convert_iter_to_child_iter((GtkTreeModelFilter *) model, &child_a, a);
+	gtk_tree_model_filter_convert_iter_to_child_iter((GtkTreeModelFilter *) model, &child_b, b);
+
+	gint score_a = gel_ui_search_get_score(self->priv->search, &child_a);
+	gint score_b = gel_ui_search_get_score(self->priv->search, &child_b);
+	if (score_a != score_b)
+		return score_b - score_a;
+
+	GtkTreePath *path_a = gtk_tree_model_get_path(model, a);
+	GtkTreePath *path_b = gtk_tree_model_get_path(model, b);
+	gint ret = gtk_tree_path_compare(path_a, path_b);
+	gtk_tree_path_free(path_a);
+	gtk_tree_path_free(path_b);
+
+	return ret;
+}
+
+/*
+ * Sorts by score while there is a query, in the order of the store otherwise
+ */
+static void
+muine_update_sort(EinaMuine *self)
+{
+	EinaMuinePrivate *priv = self->priv;
+	if (!priv->sort)
+		return;
+
+	GtkTreeSortable *sortable = (GtkTreeSortable *) priv->sort;
+	if (gel_ui_search_get_query(priv->search))
+	{
+		// Scores changed, setting the function again sorts again
+		gtk_tree_sortable_set_sort_func(sortable, SORT_COLUMN_SCORE,
+			(GtkTreeIterCompareFunc) muine_score_compare, self, NULL);
+		gtk_tree_sortable_set_sort_column_id(sortable, SORT_COLUMN_SCORE, GTK_SORT_ASCENDING);
+	}
+	else
+		gtk_tree_sortable_set_sort_column_id(sortable, GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID, GTK_SORT_ASCENDING);
+}
+
+/*
+ * Filters can't be detached from their store and would handle every insert
+ * while filling, so the store is filled alone and gets a new filter once
+ * complete
+ */
+static void
+muine_attach_filter(EinaMuine *self)
+{
+	EinaMuinePrivate *priv = self->priv;
+
+	if (!priv->filter)
+	{
+		priv->filter = (GtkTreeModelFilter *) gtk_tree_model_filter_new((GtkTreeModel *) priv->model, NULL);
+		priv->sort   = (GtkTreeModelSort *)   gtk_tree_model_sort_new_with_model((GtkTreeModel *) priv->filter);
+		gel_ui_search_set_filter(priv->search, priv->filter);
+		muine_update_sort(self);
+	}
+	if (!priv->browser)
+		gtk_tree_view_set_model(priv->listview, (GtkTreeModel *) priv->sort);
+}
+
+static void
+muine_detach_filter(EinaMuine *self)
+{
+	EinaMuinePrivate *priv = self->priv;
+
+	if (!priv->browser)
+		gtk_tree_view_set_model(priv->listview, NULL);
+	gel_ui_search_set_filter(priv->search, NULL);
+	gel_free_and_invalidate(priv->sort,   NULL, g_object_unref);
+	gel_free_and_invalidate(priv->filter, NULL, g_object_unref);
+}
+
+static void
+muine_fill_finished_cb(GelUIModelFiller *filler, gboolean completed, EinaMuine *self)
+{
+	// Cancelled fills are followed by a new one
+	if (completed)
+		muine_attach_filter(self);
 }
 
 static void
@@ -299,173 +435,270 @@ stream_em_updated_cb(LomoStream *stream, const gchar *key, EinaMuine *self)
 	}
 }
 
+typedef struct {
+	guint count;           // How many items have been folded
+	gchar *artist, *album; // Metadata from DB
+} MuineDataSet;
+
+typedef struct {
+	EinaMuine     *self;
+	EinaMuineMode  mode;
+	const gchar   *markup_fmt;
+	GList         *data; // <MuineDataSet>, pending rows
+	guint          n_rows;
+} MuineFill;
+
 static void
-muine_update(EinaMuine *self)
+muine_data_set_free(MuineDataSet *ds)
 {
-	g_return_if_fail(EINA_IS_MUINE(self));
+	g_free(ds->artist);
+	g_free(ds->album);
+	g_free(ds);
+}
+
+static void
+muine_fill_free(MuineFill *fill)
+{
+	gel_list_deep_free(fill->data, muine_data_set_free);
+	g_free(fill);
+}
+
+static GdkPixbuf*
+muine_get_default_icon(void)
+{
+	static GdkPixbuf *default_pb = NULL;
+	if (!default_pb) {
+		GError *e = NULL;
+		GInputStream *stream = gel_io_open(lomo_em_art_provider_get_default_cover(), &e);
+		if (stream == NULL)
+			g_error(_("Can't open `%s': %s"), lomo_em_art_provider_get_default_cover(), e->message);
+
+		default_pb = gdk_pixbuf_new_from_stream_at_scale(stream, DEFAULT_SIZE, DEFAULT_SIZE, TRUE, NULL, NULL);
+		g_input_stream_close(stream, NULL, NULL);
+	}
+	return default_pb;
+}
+
+/*
+ * Inserts one row into the model, called by the GelUIModelFiller
+ */
+static gboolean
+muine_fill_cb(GtkListStore *model, MuineFill *fill)
+{
+	if (fill->data == NULL)
+		return FALSE;
+
+	EinaMuine *self = fill->self;
 	EinaMuinePrivate *priv = self->priv;
+	EinaMuineMode mode = fill->mode;
 
-	typedef struct {
-		guint count;           // How many items have been folded
-		gchar *artist, *album; // Metadata from DB
-		LomoStream *stream;    // Fake stream
-	} data_set_t;
+	MuineDataSet *ds = (MuineDataSet *) fill->data->data;
+	fill->data = g_list_delete_link(fill->data, fill->data);
 
-	EinaMuineMode mode = eina_muine_get_mode(self);
-	gchar *markup_fmt = NULL;
+	// Try to get a sample for the item
+	// q = "select uri from streams where sid = (select sid from fast_meta where lower(%s)=lower('%q') limit 1 offset %d)";
+	gchar *q = "select uri from streams where sid = (select sid from fast_meta where %s='%q' limit 1 offset %d)";
+	gchar *field = (mode == EINA_MUINE_MODE_ALBUM) ? "album" : "artist";
+	gchar *key   = (mode == EINA_MUINE_MODE_ALBUM) ? ds->album : ds->artist;
+	gchar *sample_uri = NULL;
+
+	char *q2 = sqlite3_mprintf(q, field, key, g_random_int_range(0, ds->count));
+
+	EinaAdbResult *sr = eina_adb_query_raw(eina_muine_get_adb(self), q2);
+	if (!sr || !eina_adb_result_step(sr))
+	{
+		g_warning(N_("Unable to fetch sample URI for %s '%s', query was %s"), field, key, q2);
+		sample_uri = g_strdup("file:///nonexistent");
+	}
+	else
+		eina_adb_result_get(sr, 0, G_TYPE_STRING, &sample_uri, -1);
+
+	gel_free_and_invalidate(sr, NULL, g_object_unref);
+	gel_free_and_invalidate(q2, NULL, sqlite3_free);
+
+	LomoStream *stream = lomo_stream_new(sample_uri);
+	g_free(sample_uri);
+
+	// Build the row
+	gchar *artist = NULL, *album = NULL; gchar *markup = NULL;
+
+	GValue v = { 0 };
+	g_value_init(&v, G_TYPE_STRING);
+
+	// Tags hold plain text, they are used for searching and art lookups
+	if (ds->artist)
+	{
+		artist = g_markup_escape_text(ds->artist, -1);
+
+		g_value_set_static_string(&v, ds->artist);
+		lomo_stream_set_tag(stream, LOMO_TAG_ARTIST, &v);
+	}
+
+	if (ds->album)
+	{
+		album  = g_markup_escape_text(ds->album,  -1);
+
+		g_value_set_static_string(&v, ds->album);
+		lomo_stream_set_tag(stream, LOMO_TAG_ALBUM, &v);
+	}
+	g_value_unset(&v);
 
-	// Build master query
-	gchar *q = NULL;
 	switch (mode)
 	{
+	case EINA_MUINE_MODE_INVALID:
 	case EINA_MUINE_MODE_ALBUM:
-		// q = "select count(*) as count,artist,album from fast_meta group by(lower(album)) order by artist ASC";
-		q = "select count(*) as count,artist,album from fast_meta group by(album) order by lower(artist) ASC";
-		markup_fmt = "<big><b>%s</b></big>\n%s <span size=\"small\" weight=\"light\">(%d streams)</span>";
+	case EINA_MUINE_MODE_BROWSE:
+		markup = g_strdup_printf(fill->markup_fmt, album, artist, ds->count);
 		break;
 	case EINA_MUINE_MODE_ARTIST:
-		// q = "select count(*) as count,artist,NULL from fast_meta group by(lower(artist)) order by artist ASC";
-		q = "select count(*) as count,artist,NULL from fast_meta group by(artist) order by lower(artist) ASC";
-		markup_fmt = "<big><b>%s</b></big>\n<span size=\"small\" weight=\"light\">(%d streams)</span>";
+		markup = g_strdup_printf(fill->markup_fmt, artist, ds->count);
 		break;
-	default:
-		g_warning(N_("Unknow mode: %d"), mode);
-		return;
 	}
 
-	// Now fill the data_store;
-	EinaAdbResult *r = eina_adb_query(eina_muine_get_adb(self), q, NULL);
-
-	GList *db_data = NULL;
-	data_set_t *ds = NULL;
-	while (eina_adb_result_step(r))
-	{
-		if (ds == NULL)
-			ds = g_new0(data_set_t, 1);
+	GtkTreeIter iter;
+	gtk_list_store_insert_with_values(model, &iter, -1,
+		COMBO_COLUMN_MARKUP, markup,
+		COMBO_COLUMN_ID,     key,
+		COMBO_COLUMN_STREAM, stream,
+		COMBO_COLUMN_ICON,   muine_get_default_icon(),
+		-1);
 
-		eina_adb_result_get(r,
-			  0, G_TYPE_UINT,   &(ds->count),
-			  1, G_TYPE_STRING, &(ds->artist),
-			  2, G_TYPE_STRING, &(ds->album),
-		     -1);
+	g_hash_table_insert(priv->stream_iter_map, stream, gtk_tree_iter_copy(&iter));
+	lomo_stream_set_all_tags_flag(stream, TRUE);
+	g_signal_connect(stream, "extended-metadata-updated", (GCallback) stream_em_updated_cb, self);
+	lomo_em_art_provider_init_stream(priv->art, stream);
 
-		db_data = g_list_prepend(db_data, ds);
-		ds = NULL;
-	}
-	g_object_unref(r);
+	muine_data_set_free(ds);
+	g_free(markup);
+	gel_free_and_invalidate(artist, NULL, g_free);
+	gel_free_and_invalidate(album,  NULL, g_free);
 
-	// Try to get a sample for each item
-	// q = "select uri from streams where sid = (select sid from fast_meta where lower(%s)=lower('%q') limit 1 offset %d)";
-	q = "select uri from streams where sid = (select sid from fast_meta where %s='%q' limit 1 offset %d)";
-	EinaAdb *adb      = eina_muine_get_adb(self);
-	gchar *sample_uri = NULL;
-	gchar *field = (mode == EINA_MUINE_MODE_ALBUM) ? "album" : "artist";
-	gchar *key   = NULL;
+	return TRUE;
+}
 
-	GList *ds_p = db_data;
-	while (ds_p)
+/*
+ * Collects the groups as they arrive from the reader thread, the list is
+ * replaced once all of them are there
+ */
+static gboolean
+muine_update_rows_cb(EinaAdb *adb, EinaAdbResult *r, const GError *error, MuineFill *fill)
+{
+	if (r)
 	{
-		data_set_t *ds = (data_set_t *) ds_p->data;
+		guint n = MAX(eina_adb_result_fetch(r, G_MAXUINT), 0);
+		const gint64       *counts  = eina_adb_result_get_int64_column (r, 0, NULL);
+		const gchar* const *artists = eina_adb_result_get_string_column(r, 1, NULL);
+		const gchar* const *albums  = eina_adb_result_get_string_column(r, 2, NULL);
 
-		char *q2 = sqlite3_mprintf(q,
-			field,
-			key = ((mode == EINA_MUINE_MODE_ALBUM) ? ds->album : ds->artist),
-			g_random_int_range(0, ds->count));
-
-		EinaAdbResult *sr = eina_adb_query_raw(adb, q2);
-		if (!sr || !eina_adb_result_step(sr))
+		for (guint i = 0; i < n; i++)
 		{
-			g_warning(N_("Unable to fetch sample URI for %s '%s', query was %s"), field, key, q2);
-			sample_uri = g_strdup("file:///nonexistent");
+			MuineDataSet *ds = g_new0(MuineDataSet, 1);
+			ds->count  = (guint) counts[i];
+			ds->artist = g_strdup(artists[i]);
+			ds->album  = g_strdup(albums[i]);
+
+			fill->data = g_list_prepend(fill->data, ds);
 		}
-		else
-			eina_adb_result_get(sr, 0, G_TYPE_STRING, &sample_uri, -1);
+		fill->n_rows += n;
+		return TRUE;
+	}
+
+	// Cancelled queries may outlive the muine, don't touch it
+	if (error)
+	{
+		if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			g_warning(N_("Unable to fetch groups: %s"), error->message);
+		muine_fill_free(fill);
+		return FALSE;
+	}
 
-		gel_free_and_invalidate(sr, NULL, g_object_unref);
-		gel_free_and_invalidate(q2, NULL, sqlite3_free);
+	EinaMuine *self = fill->self;
+	EinaMuinePrivate *priv = self->priv;
 
-		ds->stream = lomo_stream_new(sample_uri);
-		g_free(sample_uri);
+	gel_free_and_invalidate(priv->update_cancellable, NULL, g_object_unref);
 
-		ds_p = ds_p->next;
-	}
+	// Fill a new store with the same columns
+	GtkTreeModel *old = (GtkTreeModel *) priv->model;
+	gint n_columns = gtk_tree_model_get_n_columns(old);
+	GType types[n_columns];
+	for (gint i = 0; i < n_columns; i++)
+		types[i] = gtk_tree_model_get_column_type(old, i);
 
-	// All data (and all I/O) from DB has been fetched, insert into interface
-	gtk_list_store_clear(muine_get_model(self));
+	muine_detach_filter(self);
 	g_hash_table_remove_all(priv->stream_iter_map);
-	ds_p = db_data;
-	GtkListStore *model = muine_get_model(self);
-	gchar *artist = NULL, *album = NULL; gchar *markup = NULL;
+	g_object_unref(priv->model);
+	priv->model = gtk_list_store_newv(n_columns, types);
 
-	GValue v = { 0 };
-	g_value_init(&v, G_TYPE_STRING);
+	gel_free_and_invalidate(priv->filler, NULL, g_object_unref);
+	priv->filler = gel_ui_model_filler_new(NULL, (GtkTreeModel *) priv->model);
+	g_signal_connect(priv->filler, "finished", (GCallback) muine_fill_finished_cb, self);
 
-	while (ds_p)
-	{
-		data_set_t *ds = (data_set_t *) ds_p->data;
+	fill->data = g_list_reverse(fill->data);
+	gel_ui_model_filler_start(priv->filler,
+		(GelUIModelFillerFunc) muine_fill_cb, fill, (GDestroyNotify) muine_fill_free,
+		fill->n_rows);
 
-		if (ds->artist)
-		{
-			artist = g_markup_escape_text(ds->artist, -1);
+	return FALSE;
+}
 
-			g_value_set_static_string(&v, artist);
-			lomo_stream_set_tag(ds->stream, LOMO_TAG_ARTIST, &v);
-		}
+static void
+muine_update(EinaMuine *self)
+{
+	g_return_if_fail(EINA_IS_MUINE(self));
+	EinaMuinePrivate *priv = self->priv;
 
-		if (ds->album)
-		{
-			album  = g_markup_escape_text(ds->album,  -1);
+	EinaMuineMode mode = eina_muine_get_mode(self);
+	gchar *markup_fmt = NULL;
 
-			g_value_set_static_string(&v, album);
-			lomo_stream_set_tag(ds->stream, LOMO_TAG_ALBUM, &v);
-		}
+	// Build master query
+	gchar *q = NULL;
+	switch (mode)
+	{
+	case EINA_MUINE_MODE_ALBUM:
+		// q = "select count(*) as count,artist,album from fast_meta group by(lower(album)) order by artist ASC";
+		q = "select count(*) as count,artist,album from fast_meta group by(album) order by lower(artist) ASC";
+		markup_fmt = "<big><b>%s</b></big>\n%s <span size=\"small\" weight=\"light\">(%d streams)</span>";
+		break;
+	case EINA_MUINE_MODE_ARTIST:
+		// q = "select count(*) as count,artist,NULL from fast_meta group by(lower(artist)) order by artist ASC";
+		q = "select count(*) as count,artist,NULL from fast_meta group by(artist) order by lower(artist) ASC";
+		markup_fmt = "<big><b>%s</b></big>\n<span size=\"small\" weight=\"light\">(%d streams)</span>";
+		break;
+	case EINA_MUINE_MODE_BROWSE:
+		break;
+	default:
+		g_warning(N_("Unknow mode: %d"), mode);
+		return;
+	}
 
-		switch (mode)
-		{
-		case EINA_MUINE_MODE_INVALID:
-		case EINA_MUINE_MODE_ALBUM:
-			markup = g_strdup_printf(markup_fmt, album, artist, ds->count);
-			break;
-		case EINA_MUINE_MODE_ARTIST:
-			markup = g_strdup_printf(markup_fmt, artist, ds->count);
-			break;
-		}
+	// Drop any running query or fill before touching the model
+	if (priv->update_cancellable)
+	{
+		g_cancellable_cancel(priv->update_cancellable);
+		gel_free_and_invalidate(priv->update_cancellable, NULL, g_object_unref);
+	}
+	if (priv->filler)
+		gel_ui_model_filler_cancel(priv->filler);
 
-		static GdkPixbuf *default_pb = NULL;
-		if (!default_pb) {
-			GError *e = NULL;
-			GInputStream *stream = gel_io_open(lomo_em_art_provider_get_default_cover(), &e);
-			if (stream == NULL)
-				g_error(_("Can't open `%s': %s"), lomo_em_art_provider_get_default_cover(), e->message);
+	// The browser fetches its rows by itself, the list isn't needed
+	muine_set_browsing(self, mode == EINA_MUINE_MODE_BROWSE);
+	if (mode == EINA_MUINE_MODE_BROWSE)
+	{
+		gtk_list_store_clear(muine_get_model(self));
+		g_hash_table_remove_all(priv->stream_iter_map);
+		return;
+	}
 
-			default_pb = gdk_pixbuf_new_from_stream_at_scale(stream, DEFAULT_SIZE, DEFAULT_SIZE, TRUE, NULL, NULL);
-			g_input_stream_close(stream, NULL, NULL);
-		}
+	// Fetch the groups off the main thread, samples are fetched row by row
+	// while filling
+	MuineFill *fill = g_new0(MuineFill, 1);
+	fill->self       = self;
+	fill->mode       = mode;
+	fill->markup_fmt = markup_fmt;
 
-		GtkTreeIter iter;
-		gtk_list_store_insert_with_values(model, &iter, 0,
-			COMBO_COLUMN_MARKUP, markup,
-			COMBO_COLUMN_ID,     (mode == EINA_MUINE_MODE_ALBUM) ? ds->album : ds->artist,
-			COMBO_COLUMN_STREAM, ds->stream,
-			COMBO_COLUMN_ICON,   default_pb,
-			-1);
-
-		g_hash_table_insert(priv->stream_iter_map, ds->stream, gtk_tree_iter_copy(&iter));
-		lomo_stream_set_all_tags_flag(ds->stream, TRUE);
-		g_signal_connect(ds->stream, "extended-metadata-updated", (GCallback) stream_em_updated_cb, self);
-		lomo_em_art_provider_init_stream(priv->art, ds->stream);
-
-		g_free(ds->artist);
-		g_free(ds->album);
-		g_free(ds);
-		g_free(markup);
-		gel_free_and_invalidate(artist, NULL, g_free);
-		gel_free_and_invalidate(album,  NULL, g_free);
-
-		ds_p = ds_p->next;
-	}
-	g_value_reset(&v);
-	g_list_free(db_data);
+	priv->update_cancellable = g_cancellable_new();
+	eina_adb_query_async_raw(eina_muine_get_adb(self), q, priv->update_cancellable,
+		(EinaAdbQueryFunc) muine_update_rows_cb, fill, NULL);
 }
 
 static void
@@ -484,21 +717,86 @@ muine_update_icon(EinaMuine *self, LomoStream *stream)
 		return;
 
 	// Check for matching iter
-	GtkTreeIter *iter = g_hash_table_lookup(priv->stream_iter_map, stream);
-	g_return_if_fail(iter);
+	g_return_if_fail(g_hash_table_lookup(priv->stream_iter_map, stream));
 
-	// Load pixbuf
-	GdkPixbuf *pb = gel_ui_pixbuf_from_value(art_value);
-	g_return_if_fail(GDK_IS_PIXBUF(pb));
+	MuineIconLookup *lookup = g_new0(MuineIconLookup, 1);
+	lookup->self   = self;
+	lookup->stream = g_object_ref(stream);
+	eina_art_cache_lookup_async(art_value, DEFAULT_SIZE, priv->icon_cancellable,
+		(EinaArtCacheFunc) muine_icon_lookup_cb, lookup, (GDestroyNotify) muine_icon_lookup_free);
+}
 
-	GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pb, DEFAULT_SIZE, DEFAULT_SIZE, GDK_INTERP_NEAREST);
-	g_object_unref(pb);
+static void
+muine_icon_lookup_free(MuineIconLookup *lookup)
+{
+	g_object_unref(lookup->stream);
+	g_free(lookup);
+}
+
+static void
+muine_icon_lookup_cb(GdkPixbuf *pixbuf, const GError *error, MuineIconLookup *lookup)
+{
+	// Muine is gone
+	if (error || !pixbuf)
+		return;
+
+	// Row may have been dropped by a new fill meanwhile
+	EinaMuine *self = lookup->self;
+	GtkTreeIter *iter = g_hash_table_lookup(self->priv->stream_iter_map, lookup->stream);
+	if (!iter)
+		return;
+
+	// Cache keeps aspect ratio but rows must have the same height
+	GdkPixbuf *pb = g_object_ref(pixbuf);
+	if ((gdk_pixbuf_get_width(pb) != DEFAULT_SIZE) || (gdk_pixbuf_get_height(pb) != DEFAULT_SIZE))
+	{
+		GdkPixbuf *scaled = gdk_pixbuf_scale_simple(pb, DEFAULT_SIZE, DEFAULT_SIZE, GDK_INTERP_NEAREST);
+		g_object_unref(pb);
+		pb = scaled;
+	}
 
 	// Store
 	gtk_list_store_set(muine_get_model(self), iter,
-		COMBO_COLUMN_ICON, scaled,
+		COMBO_COLUMN_ICON, pb,
 		-1);
-	g_object_unref(scaled);
+	g_object_unref(pb);
+}
+
+static void
+muine_set_browsing(EinaMuine *self, gboolean browse)
+{
+	EinaMuinePrivate *priv = self->priv;
+	GelUIGeneric *ui_generic = GEL_UI_GENERIC(self);
+
+	GtkTreeViewColumn *icon_column = gel_ui_generic_get_typed(ui_generic, GTK_TREE_VIEW_COLUMN, "treeviewcolumn1");
+	GtkTreeViewColumn *text_column = gel_ui_generic_get_typed(ui_generic, GTK_TREE_VIEW_COLUMN, "treeviewcolumn4");
+
+	gtk_tree_view_set_fixed_height_mode(priv->listview, FALSE);
+	gtk_tree_view_set_model(priv->listview, NULL);
+	gel_free_and_invalidate(priv->browser, NULL, g_object_unref);
+
+	// Fixed height mode keeps the view from reading rows it doesn't show, so
+	// artists are only fetched when scrolled into view. It requires fixed
+	// sizing on every column.
+	GtkTreeViewColumnSizing sizing = browse ? GTK_TREE_VIEW_COLUMN_FIXED : GTK_TREE_VIEW_COLUMN_GROW_ONLY;
+	gtk_tree_view_column_set_sizing(icon_column, sizing);
+	gtk_tree_view_column_set_sizing(text_column, sizing);
+	gtk_tree_view_column_set_visible(icon_column, !browse);
+	gtk_widget_set_sensitive((GtkWidget *) priv->search_entry, !browse);
+
+	if (!browse)
+	{
+		muine_attach_filter(self);
+		return;
+	}
+
+	EinaAdb *adb = eina_muine_get_adb(self);
+	if (adb == NULL)
+		return;
+
+	priv->browser = eina_muine_browser_model_new(adb);
+	gtk_tree_view_set_model(priv->listview, (GtkTreeModel *) priv->browser);
+	gtk_tree_view_set_fixed_height_mode(priv->listview, TRUE);
 }
 
 static GList *
@@ -506,7 +804,10 @@ muine_get_uris_from_tree_iter(EinaMuine *self, GtkTreeIter *iter)
 {
 	gchar *id = NULL;
 
-	gtk_tree_model_get((GtkTreeModel *) muine_get_filter(self), iter,
+	if (self->priv->browser)
+		return eina_muine_browser_model_get_uris(self->priv->browser, iter);
+
+	gtk_tree_model_get(gtk_tree_view_get_model(self->priv->listview), iter,
 		COMBO_COLUMN_ID, &id,
 		-1);
 
@@ -520,6 +821,7 @@ muine_get_uris_from_tree_iter(EinaMuine *self, GtkTreeIter *iter)
 	case EINA_MUINE_MODE_ARTIST:
 		q = "select uri from streams where sid in (select sid from fast_meta where lower(artist)=lower('%q'))";
 		break;
+	case EINA_MUINE_MODE_BROWSE:
 	default:
 		g_warning(N_("Unknow mode"));
 		return NULL;
@@ -545,33 +847,11 @@ muine_get_uris_from_tree_iter(EinaMuine *self, GtkTreeIter *iter)
 	return g_list_reverse(uris);
 }
 
-static gboolean
-muine_filter_func(GtkTreeModel *model, GtkTreeIter *iter, EinaMuine *self)
-{
-	EinaMuinePrivate *priv = self->priv;
-	if (priv->search_str == NULL)
-		return TRUE;
-
-	gchar *markup = NULL;
-	gtk_tree_model_get(model, iter,
-		COMBO_COLUMN_MARKUP, &markup,
-		-1
-		);
-	g_return_val_if_fail(markup != NULL, FALSE);
-
-	gchar *haystack = g_utf8_casefold(markup, -1);
-	g_free(markup);
-
-	gboolean ret = (strstr(haystack, priv->search_str) != NULL);
-	g_free(haystack);
-	return ret;
-}
-
 static void
 row_activated_cb(GtkWidget *w, GtkTreePath *path, GtkTreeViewColumn *column, EinaMuine *self)
 {
 	GtkTreeIter iter;
-	if (!gtk_tree_model_get_iter(GTK_TREE_MODEL(muine_get_filter(self)), &iter, path))
+	if (!gtk_tree_model_get_iter(gtk_tree_view_get_model(GTK_TREE_VIEW(w)), &iter, path))
 	{
 		g_warning(N_("Cannot get iter  for model"));
 		return;
@@ -594,39 +874,44 @@ row_activated_cb(GtkWidget *w, GtkTreePath *path, GtkTreeViewColumn *column, Ein
 	gel_list_deep_free(uri_list, g_free);
 }
 
+static void
+row_collapsed_cb(GtkWidget *w, GtkTreeIter *iter, GtkTreePath *path, EinaMuine *self)
+{
+	// Albums and tracks are fetched again on next expand
+	if (self->priv->browser)
+		eina_muine_browser_model_collapse(self->priv->browser, iter);
+}
+
 static void
 search_changed_cb(GtkWidget *w, EinaMuine *self)
 {
-	EinaMuinePrivate *priv = self->priv;
+	gel_ui_search_set_query(self->priv->search, gtk_entry_get_text(GTK_ENTRY(w)));
+}
 
-	const gchar *search_str = gtk_entry_get_text(GTK_ENTRY(w));
-	if (search_str && (search_str[0] == '\0'))
-		search_str = NULL;
+static void
+search_updated_cb(GelUISearch *search, EinaMuine *self)
+{
+	muine_update_sort(self);
+}
 
-	// From no-search to search
-	if ((priv->search_str == NULL) && (search_str != NULL))
-	{
-		priv->search_str = g_utf8_casefold(search_str, -1);
-		gtk_tree_model_filter_refilter(muine_get_filter(self));
-	}
+static gchar*
+search_key_func(GtkTreeModel *model, GtkTreeIter *iter, EinaMuine *self)
+{
+	// Match plain artist and album, not the markup nor the stream count
+	LomoStream *stream = NULL;
+	gtk_tree_model_get(model, iter, COMBO_COLUMN_STREAM, &stream, -1);
+	if (stream == NULL)
+		return NULL;
 
-	// From search to more complex search
-	else if ((priv->search_str != NULL) && (search_str != NULL))
-	{
-		g_free(priv->search_str);
-		priv->search_str = g_utf8_casefold(search_str, -1);
-		gtk_tree_model_filter_refilter(muine_get_filter(self));
-	}
+	gchar *artist = lomo_stream_strdup_tag_value(stream, LOMO_TAG_ARTIST);
+	gchar *album  = lomo_stream_strdup_tag_value(stream, LOMO_TAG_ALBUM);
+	gchar *ret = g_strjoin(" ", artist ? artist : "", album ? album : "", NULL);
 
-	// From search to no search
-	else if ((priv->search_str != NULL) && (search_str == NULL))
-	{
-		gel_free_and_invalidate(priv->search_str, NULL, g_free);
-		gtk_tree_model_filter_refilter(muine_get_filter(self));
-	}
+	g_free(artist);
+	g_free(album);
+	g_object_unref(stream);
 
-	else
-		g_warning(N_("Unhandled situation"));
+	return ret;
 }
 
 static void
@@ -47,7 +47,8 @@ typedef struct {
 typedef enum {
 	EINA_MUINE_MODE_INVALID = -1,
 	EINA_MUINE_MODE_ALBUM   = 0,
-	EINA_MUINE_MODE_ARTIST
+	EINA_MUINE_MODE_ARTIST,
+	EINA_MUINE_MODE_BROWSE
 } EinaMuineMode;
 
 GType eina_muine_get_type (void);
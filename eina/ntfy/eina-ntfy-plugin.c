@@ -21,6 +21,7 @@
 #include <libnotify/notify.h>
 #include <gel/gel-ui.h>
 #include <eina/lomo/eina-lomo-plugin.h>
+#include <eina/core/eina-art-cache.h>
 
 /*
  * EinaExtension boilerplate code
@@ -38,12 +39,15 @@ typedef struct {
 
 	NotifyNotification *ntfy;
 	LomoStream         *stream;
+	GCancellable       *lookup_cancellable; // Art lookup, notification is shown when done
 } EinaNtfyPluginPrivate;
 EINA_PLUGIN_REGISTER(EINA_TYPE_NTFY_PLUGIN, EinaNtfyPlugin, eina_ntfy_plugin)
 
 static gboolean ntfy_enable (EinaNtfyPlugin *plugin, GError **error);
 static void     ntfy_disable(EinaNtfyPlugin *plugin);
 static void     ntfy_sync   (EinaNtfyPlugin *plugin);
+static void     ntfy_cancel_lookup(EinaNtfyPlugin *plugin);
+static void     ntfy_lookup_cb    (GdkPixbuf *pixbuf, const GError *error, EinaNtfyPlugin *plugin);
 
 static void stream_weak_ref_cb  (EinaNtfyPlugin *plugin, GObject *_stream);
 static void stream_em_updated_cb(LomoStream *stream, const gchar *key, EinaNtfyPlugin *plugin);
@@ -137,6 +141,7 @@ ntfy_disable(EinaNtfyPlugin *plugin)
 		priv->stream  = NULL;
 	}
 
+	ntfy_cancel_lookup(plugin);
 	gel_free_and_invalidate(priv->ntfy,  NULL, g_object_unref);
 
 	if (notify_is_initted())
@@ -168,8 +173,6 @@ ntfy_sync(EinaNtfyPlugin *plugin)
 		g_signal_connect(priv->stream, "extended-metadata-updated", G_CALLBACK (stream_em_updated_cb), plugin);
 	}
 
-	GdkPixbuf *scaled = NULL;
-
 	// Build body
 	gchar *tmp = g_path_get_basename(lomo_stream_get_uri(stream));
 	gchar *bname = g_uri_unescape_string(tmp, NULL);
@@ -183,29 +186,45 @@ ntfy_sync(EinaNtfyPlugin *plugin)
 	gel_str_free_and_invalidate(bname);
 
 	notify_notification_update(priv->ntfy, N_("Playing now"), body, NULL);
+	gel_free_and_invalidate(body, NULL, g_free);
 
-	GdkPixbuf *pb = gel_ui_pixbuf_from_value(lomo_stream_get_extended_metadata(stream, LOMO_STREAM_EM_ART_DATA));
-	if (!pb || !GDK_IS_PIXBUF(pb))
+	// Shown once the art is loaded
+	ntfy_cancel_lookup(plugin);
+	const GValue *art = lomo_stream_get_extended_metadata(stream, LOMO_STREAM_EM_ART_DATA);
+	if (art)
 	{
-		g_warn_if_fail(pb && GDK_IS_PIXBUF(pb));
-		goto ntfy_sync_show;
+		priv->lookup_cancellable = g_cancellable_new();
+		eina_art_cache_lookup_async(art, 64, priv->lookup_cancellable,
+			(EinaArtCacheFunc) ntfy_lookup_cb, plugin, NULL);
 	}
+	else
+		notify_notification_show(priv->ntfy, NULL);
+}
 
-	gdouble sx = (gdouble) 64 / gdk_pixbuf_get_width(pb);
-	gdouble sy = (gdouble) 64 / gdk_pixbuf_get_height(pb);
+static void
+ntfy_cancel_lookup(EinaNtfyPlugin *plugin)
+{
+	EinaNtfyPluginPrivate *priv = plugin->priv;
+	if (!priv->lookup_cancellable)
+		return;
 
-	gint dx = MIN(sx,sy) * gdk_pixbuf_get_width(pb);
-	gint dy = MIN(sx,sy) * gdk_pixbuf_get_height(pb);
+	g_cancellable_cancel(priv->lookup_cancellable);
+	gel_free_and_invalidate(priv->lookup_cancellable, NULL, g_object_unref);
+}
 
-	scaled = gdk_pixbuf_scale_simple(pb, dx, dy, GDK_INTERP_NEAREST);
-	g_object_unref(pb);
+static void
+ntfy_lookup_cb(GdkPixbuf *pixbuf, const GError *error, EinaNtfyPlugin *plugin)
+{
+	// Replaced by a newer notification or disabled
+	if (error)
+		return;
 
-	notify_notification_set_icon_from_pixbuf(priv->ntfy, scaled);
+	EinaNtfyPluginPrivate *priv = plugin->priv;
+	gel_free_and_invalidate(priv->lookup_cancellable, NULL, g_object_unref);
 
-ntfy_sync_show:
+	if (pixbuf)
+		notify_notification_set_icon_from_pixbuf(priv->ntfy, pixbuf);
 	notify_notification_show(priv->ntfy, NULL);
-	gel_free_and_invalidate(body,   NULL, g_free);
-	gel_free_and_invalidate(scaled, NULL, g_object_unref);
 }
 
 static void
@@ -37,13 +37,16 @@ struct _EinaCoverImagePrivate {
 	GtkAllocation allocation;
 	gint pb_w, pb_h, m_w, m_h;
 	gfloat scale;
-	cairo_t *cr;
+	cairo_surface_t *surface; // <Cover scaled to allocation, mask applied
 };
 
 enum {
 	PROPERTY_COVER = 1,
 };
 
+static void
+cover_image_update_surface(EinaCoverImage *self);
+
 static void
 eina_cover_image_get_property (GObject *object, guint property_id,
 		                          GValue *value, GParamSpec *pspec)
@@ -73,55 +76,83 @@ eina_cover_image_dispose (GObject *object)
 	EinaCoverImage *self = EINA_COVER_IMAGE(object);
 	EinaCoverImagePrivate *priv = GET_PRIVATE(self);
 
-	gel_free_and_invalidate(priv->pixbuf, NULL, g_object_unref);
+	gel_free_and_invalidate(priv->pixbuf,  NULL, g_object_unref);
+	gel_free_and_invalidate(priv->mask,    NULL, g_object_unref);
+	gel_free_and_invalidate(priv->surface, NULL, cairo_surface_destroy);
 
 	G_OBJECT_CLASS (eina_cover_image_parent_class)->dispose (object);
 }
 
-static gboolean
-eina_cover_image_draw(GtkWidget *widget, cairo_t *_cr)
+/*
+ * Renders the cover scaled to the current allocation and composited with the
+ * mask into priv->surface, so draw is reduced to a single blit.
+ */
+static void
+cover_image_update_surface(EinaCoverImage *self)
 {
-	EinaCoverImage        *self = EINA_COVER_IMAGE(widget);
+	GtkWidget *widget = (GtkWidget *) self;
 	EinaCoverImagePrivate *priv = GET_PRIVATE(self);
-	if (!priv->pixbuf)
-		return TRUE;
 
-	cairo_scale(_cr, priv->allocation.width / (gfloat) priv->pb_w, priv->allocation.height / (gfloat) priv->pb_h);
-	gdk_cairo_set_source_pixbuf(_cr, priv->pixbuf, 0, 0);
-	cairo_paint(_cr);
+	gel_free_and_invalidate(priv->surface, NULL, cairo_surface_destroy);
+
+	gint w = priv->allocation.width;
+	gint h = priv->allocation.height;
+	if (!priv->pixbuf || (w <= 0) || (h <= 0))
+		return;
+
+	GdkWindow *window = gtk_widget_get_window(widget);
+	priv->surface = window ?
+		gdk_window_create_similar_surface(window, CAIRO_CONTENT_COLOR_ALPHA, w, h) :
+		cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+
+	cairo_t *cr = cairo_create(priv->surface);
+
+	cairo_save(cr);
+	cairo_scale(cr, w / (gfloat) priv->pb_w, h / (gfloat) priv->pb_h);
+	gdk_cairo_set_source_pixbuf(cr, priv->pixbuf, 0, 0);
+	cairo_paint(cr);
+	cairo_restore(cr);
 
 	if (priv->mask)
 	{
 		// Create mask
-		cairo_push_group(_cr);
-		cairo_identity_matrix(_cr);
-		cairo_scale(_cr,
-			priv->allocation.width  / (gfloat) priv->m_w,
-			priv->allocation.height / (gfloat) priv->m_h);
-		gdk_cairo_set_source_pixbuf(_cr, priv->mask, 0, 0);
-		cairo_paint(_cr);
-		cairo_pattern_t *mask = cairo_pop_group(_cr);
-
-		// Create new combined pattern
-		cairo_push_group(_cr);
+		cairo_push_group(cr);
+		cairo_scale(cr, w / (gfloat) priv->m_w, h / (gfloat) priv->m_h);
+		gdk_cairo_set_source_pixbuf(cr, priv->mask, 0, 0);
+		cairo_paint(cr);
+		cairo_pattern_t *mask = cairo_pop_group(cr);
 
+		// Paint background through the mask
 		GdkRGBA color;
 		gtk_style_context_get_background_color(
 			gtk_widget_get_style_context(GTK_WIDGET(gtk_widget_get_toplevel(widget))),
 			GTK_STATE_FLAG_NORMAL,
 			&color);
 
-		cairo_set_source_rgba(_cr, color.red, color.green, color.blue, color.alpha);
-		cairo_mask(_cr, mask);
-		cairo_pattern_t *f = cairo_pop_group(_cr);
+		cairo_set_source_rgba(cr, color.red, color.green, color.blue, color.alpha);
+		cairo_mask(cr, mask);
 		cairo_pattern_destroy(mask);
+	}
 
-		// Apply all
-		cairo_set_source(_cr, f);
-		cairo_pattern_destroy(f);
+	cairo_destroy(cr);
+}
 
-		cairo_paint(_cr);
-	}
+static gboolean
+eina_cover_image_draw(GtkWidget *widget, cairo_t *_cr)
+{
+	EinaCoverImage        *self = EINA_COVER_IMAGE(widget);
+	EinaCoverImagePrivate *priv = GET_PRIVATE(self);
+	if (!priv->pixbuf)
+		return TRUE;
+
+	// No configure-event received yet
+	if (!priv->surface)
+		cover_image_update_surface(self);
+	if (!priv->surface)
+		return TRUE;
+
+	cairo_set_source_surface(_cr, priv->surface, 0, 0);
+	cairo_paint(_cr);
 
 	return TRUE;
 }
@@ -132,6 +163,7 @@ eina_cover_image_configure_event(GtkWidget *widget, GdkEventConfigure *ev)
 	EinaCoverImagePrivate *priv = GET_PRIVATE(EINA_COVER_IMAGE(widget));
 	gtk_widget_get_allocation(widget, &priv->allocation);
 	priv->scale = MAX(priv->allocation.width / (gfloat) priv->pb_w, priv->allocation.height / (gfloat) priv->pb_h);
+	cover_image_update_surface(EINA_COVER_IMAGE(widget));
 	gtk_widget_queue_draw(widget);
 	return TRUE;
 }
@@ -195,12 +227,14 @@ eina_cover_image_set_from_pixbuf(EinaCoverImage *self, GdkPixbuf *pixbuf)
 	{
 		priv->pb_w = priv->pb_h = -1;
 		priv->scale = 0;
+		gel_free_and_invalidate(priv->surface, NULL, cairo_surface_destroy);
 		return;
 	}
 
 	priv->pb_w = gdk_pixbuf_get_width(priv->pixbuf);
-	priv->pb_h = gdk_pixbuf_get_width(priv->pixbuf);
+	priv->pb_h = gdk_pixbuf_get_height(priv->pixbuf);
 	priv->scale = MAX(priv->allocation.width / (gfloat) priv->pb_w, priv->allocation.height / (gfloat) priv->pb_h);
+	cover_image_update_surface(self);
 	gtk_widget_queue_draw(GTK_WIDGET(self));
 
 	g_object_notify((GObject *) self, "cover");
@@ -22,10 +22,15 @@
 #include <glib/gprintf.h>
 #include <gel/gel.h>
 #include <gel/gel-ui.h>
+#include <eina/core/eina-art-cache.h>
 
 G_DEFINE_TYPE (EinaCover, eina_cover, GTK_TYPE_GRID)
 
 #define SIZE_HACKS 1
+
+// Largest size covers are rendered at, requests are served from the art cache
+#define COVER_SIZE EINA_ART_CACHE_SIZE_XLARGE
+
 #define DEBUG 0
 #define DEBUG_PREFIX EinaCover
 
@@ -44,6 +49,8 @@ struct _EinaCoverPrivate {
 
 	LomoStream *stream;
 	gulong      stream_em_handler;
+
+	GCancellable *lookup_cancellable; // Running art lookup
 };
 
 enum {
@@ -55,6 +62,8 @@ enum {
 static void
 cover_set(EinaCover *self, const GValue *value);
 static void
+cover_lookup_cb(GdkPixbuf *pixbuf, const GError *error, EinaCover *self);
+static void
 lomo_change_cb(LomoPlayer *lomo, gint from, gint to, EinaCover *self);
 static void
 lomo_clear_cb(LomoPlayer *lomo,  EinaCover *self);
@@ -104,6 +113,11 @@ eina_cover_dispose (GObject *object)
 		g_signal_handler_disconnect(priv->stream, priv->stream_em_handler);
 		priv->stream_em_handler = 0;
 	}
+	if (priv->lookup_cancellable)
+	{
+		g_cancellable_cancel(priv->lookup_cancellable);
+		gel_free_and_invalidate(priv->lookup_cancellable, NULL, g_object_unref);
+	}
 
 	gel_object_free_and_invalidate(priv->default_pb);
 
@@ -335,16 +349,34 @@ cover_set(EinaCover *self, const GValue *value)
 	EinaCoverPrivate *priv = self->priv;
 
 	priv->has_cover = FALSE;
+	if (priv->lookup_cancellable)
+	{
+		g_cancellable_cancel(priv->lookup_cancellable);
+		gel_free_and_invalidate(priv->lookup_cancellable, NULL, g_object_unref);
+	}
+
 	if (value == NULL)
 	{
 		g_object_set((GObject *) priv->renderer, "cover", priv->default_pb, NULL);
 		return;
 	}
 
-	GdkPixbuf *pb = gel_ui_pixbuf_from_value(value);
-	g_object_set((GObject *) priv->renderer, "cover", pb ? pb : priv->default_pb, NULL);
-	if (pb)
-		g_object_unref(pb);
+	// Current cover is shown until the new one is loaded
+	priv->lookup_cancellable = g_cancellable_new();
+	eina_art_cache_lookup_async(value, COVER_SIZE, priv->lookup_cancellable,
+		(EinaArtCacheFunc) cover_lookup_cb, self, NULL);
+}
+
+static void
+cover_lookup_cb(GdkPixbuf *pixbuf, const GError *error, EinaCover *self)
+{
+	// Replaced by another cover or disposed
+	if (error)
+		return;
+
+	EinaCoverPrivate *priv = self->priv;
+	gel_free_and_invalidate(priv->lookup_cancellable, NULL, g_object_unref);
+	g_object_set((GObject *) priv->renderer, "cover", pixbuf ? pixbuf : priv->default_pb, NULL);
 }
 
 static void
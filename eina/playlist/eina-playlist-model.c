@@ -0,0 +1,880 @@
+/*
+ * eina/playlist/eina-playlist-model.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION: eina-playlist-model
+ * @title: EinaPlaylistModel
+ * @short_description: Virtual GtkTreeModel over a LomoPlayer
+ *
+ * #EinaPlaylistModel exposes the playlist of a #LomoPlayer as a list-only
+ * #GtkTreeModel without copying it. Rows are read from the player on demand
+ * and the text of each stream is only formatted when a view asks for it,
+ * keeping the most recently used strings in a bounded cache.
+ *
+ * Iters are only valid until the next insertion or removal.
+ */
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "eina-playlist-model.h"
+#include <glib/gi18n.h>
+#include <gel/gel.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "EinaPlaylistModel"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+// Number of formatted strings kept in the cache, several screens of rows
+#define CACHE_SIZE 1024
+
+#define DEFAULT_STREAM_MARKUP "{%a - }%t"
+
+static void eina_playlist_model_tree_model_init(GtkTreeModelIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (EinaPlaylistModel, eina_playlist_model, G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE(GTK_TYPE_TREE_MODEL, eina_playlist_model_tree_model_init))
+
+/*
+ * A finger remembers a link of the player's list and its index, so nearby
+ * lookups walk from there instead of from the head of the list
+ */
+typedef struct {
+	GList *link;
+	gint   index;
+} Finger;
+
+enum {
+	FINGER_VIEW = 0, // Moved by views reading rows
+	FINGER_TAGS,     // Moved by tag updates, which arrive in playlist order
+	N_FINGERS
+};
+
+typedef struct {
+	LomoStream *stream;
+	gchar      *text;
+} CacheEntry;
+
+struct _EinaPlaylistModelPrivate {
+	LomoPlayer *lomo;
+	gchar      *stream_markup;
+
+	gint   n_rows;
+	gint   stamp;
+	Finger fingers[N_FINGERS];
+
+	GQueue     *lru;   // <CacheEntry>, most recently used first
+	GHashTable *cache; // <LomoStream, GList<CacheEntry> link in lru>
+
+	GArray *queue_rows; // <gint> Row of each queued stream, in queue order
+};
+
+enum {
+	PROP_LOMO_PLAYER = 1,
+	PROP_STREAM_MARKUP
+};
+
+static void model_set_lomo_player(EinaPlaylistModel *self, LomoPlayer *lomo);
+
+static GList*       model_nth_link    (EinaPlaylistModel *self, gint index);
+static gint         model_stream_index(EinaPlaylistModel *self, LomoStream *stream);
+static void         model_row_changed (EinaPlaylistModel *self, gint index);
+static const gchar* model_get_text    (EinaPlaylistModel *self, LomoStream *stream);
+
+static void cache_invalidate(EinaPlaylistModel *self, LomoStream *stream);
+static void cache_clear     (EinaPlaylistModel *self);
+
+static gchar* format_stream   (LomoStream *stream, const gchar *fmt);
+static gchar* format_stream_cb(gchar key, LomoStream *stream);
+
+static void lomo_insert_cb  (LomoPlayer *lomo, LomoStream *stream, gint index, EinaPlaylistModel *self);
+static void lomo_remove_cb  (LomoPlayer *lomo, LomoStream *stream, gint index, EinaPlaylistModel *self);
+static void lomo_clear_cb   (LomoPlayer *lomo, EinaPlaylistModel *self);
+static void lomo_change_cb  (LomoPlayer *lomo, gint from, gint to, EinaPlaylistModel *self);
+static void lomo_state_cb   (LomoPlayer *lomo, GParamSpec *pspec, EinaPlaylistModel *self);
+static void lomo_all_tags_cb(LomoPlayer *lomo, LomoStream *stream, EinaPlaylistModel *self);
+static void lomo_tag_cb     (LomoPlayer *lomo, LomoStream *stream, const gchar *tag, EinaPlaylistModel *self);
+static void lomo_tags_changed_cb(LomoPlayer *lomo, LomoStream *stream, GArray *tags, EinaPlaylistModel *self);
+static void lomo_queue_cb   (LomoPlayer *lomo, LomoStream *stream, gint index, gint queue_index, EinaPlaylistModel *self);
+static void lomo_dequeue_cb (LomoPlayer *lomo, LomoStream *stream, gint index, gint queue_index, EinaPlaylistModel *self);
+static void lomo_queue_clear_cb(LomoPlayer *lomo, EinaPlaylistModel *self);
+
+static void
+eina_playlist_model_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(object);
+
+	switch (property_id) {
+	case PROP_LOMO_PLAYER:
+		g_value_set_object(value, eina_playlist_model_get_lomo_player(self));
+		break;
+	case PROP_STREAM_MARKUP:
+		g_value_set_string(value, eina_playlist_model_get_stream_markup(self));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
+static void
+eina_playlist_model_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(object);
+
+	switch (property_id) {
+	case PROP_LOMO_PLAYER:
+		model_set_lomo_player(self, g_value_get_object(value));
+		break;
+	case PROP_STREAM_MARKUP:
+		eina_playlist_model_set_stream_markup(self, g_value_get_string(value));
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
+static void
+eina_playlist_model_dispose (GObject *object)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(object);
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	if (priv->lomo)
+	{
+		g_signal_handlers_disconnect_matched(priv->lomo, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+		gel_free_and_invalidate(priv->lomo, NULL, g_object_unref);
+	}
+
+	if (priv->cache)
+	{
+		cache_clear(self);
+		gel_free_and_invalidate(priv->cache, NULL, g_hash_table_destroy);
+		gel_free_and_invalidate(priv->lru,   NULL, g_queue_free);
+	}
+	gel_free_and_invalidate(priv->queue_rows,    NULL, g_array_unref);
+	gel_free_and_invalidate(priv->stream_markup, NULL, g_free);
+
+	G_OBJECT_CLASS (eina_playlist_model_parent_class)->dispose (object);
+}
+
+static void
+eina_playlist_model_class_init (EinaPlaylistModelClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (EinaPlaylistModelPrivate));
+
+	object_class->get_property = eina_playlist_model_get_property;
+	object_class->set_property = eina_playlist_model_set_property;
+	object_class->dispose = eina_playlist_model_dispose;
+
+	/**
+	 * EinaPlaylistModel:lomo-player:
+	 *
+	 * The #LomoPlayer whose playlist is exposed
+	 */
+	g_object_class_install_property(object_class, PROP_LOMO_PLAYER,
+		g_param_spec_object("lomo-player", "lomo-player", "lomo-player",
+			LOMO_TYPE_PLAYER, G_PARAM_READWRITE|G_PARAM_CONSTRUCT_ONLY|G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * EinaPlaylistModel:stream-markup:
+	 *
+	 * Format used to build the text column, see gel_str_parser()
+	 */
+	g_object_class_install_property(object_class, PROP_STREAM_MARKUP,
+		g_param_spec_string("stream-markup", "stream-markup", "stream-markup",
+			DEFAULT_STREAM_MARKUP, G_PARAM_READWRITE|G_PARAM_STATIC_STRINGS));
+}
+
+static void
+eina_playlist_model_init (EinaPlaylistModel *self)
+{
+	EinaPlaylistModelPrivate *priv = self->priv = G_TYPE_INSTANCE_GET_PRIVATE ((self), EINA_TYPE_PLAYLIST_MODEL, EinaPlaylistModelPrivate);
+
+	priv->stream_markup = g_strdup(DEFAULT_STREAM_MARKUP);
+	priv->stamp = g_random_int();
+	for (guint i = 0; i < N_FINGERS; i++)
+		priv->fingers[i].index = -1;
+
+	priv->lru   = g_queue_new();
+	priv->cache = g_hash_table_new(g_direct_hash, g_direct_equal);
+	priv->queue_rows = g_array_new(FALSE, FALSE, sizeof(gint));
+}
+
+/**
+ * eina_playlist_model_new:
+ * @lomo: (transfer none): A #LomoPlayer
+ *
+ * Creates a new #EinaPlaylistModel tracking the playlist of @lomo
+ *
+ * Returns: The #EinaPlaylistModel
+ */
+EinaPlaylistModel*
+eina_playlist_model_new (LomoPlayer *lomo)
+{
+	g_return_val_if_fail(LOMO_IS_PLAYER(lomo), NULL);
+	return g_object_new (EINA_TYPE_PLAYLIST_MODEL, "lomo-player", lomo, NULL);
+}
+
+/**
+ * eina_playlist_model_get_lomo_player:
+ * @self: An #EinaPlaylistModel
+ *
+ * Gets the value of #EinaPlaylistModel:lomo-player property
+ *
+ * Returns: (transfer none): The property value
+ */
+LomoPlayer*
+eina_playlist_model_get_lomo_player(EinaPlaylistModel *self)
+{
+	g_return_val_if_fail(EINA_IS_PLAYLIST_MODEL(self), NULL);
+	return self->priv->lomo;
+}
+
+static void
+model_set_lomo_player(EinaPlaylistModel *self, LomoPlayer *lomo)
+{
+	g_return_if_fail(EINA_IS_PLAYLIST_MODEL(self));
+	g_return_if_fail(LOMO_IS_PLAYER(lomo));
+
+	EinaPlaylistModelPrivate *priv = self->priv;
+	g_return_if_fail(priv->lomo == NULL);
+
+	priv->lomo   = g_object_ref(lomo);
+	priv->n_rows = lomo_player_get_n_streams(lomo);
+
+	for (gint i = 0; i < lomo_player_queue_get_n_streams(lomo); i++)
+	{
+		gint row = lomo_player_get_stream_index(lomo, lomo_player_queue_get_nth_stream(lomo, i));
+		g_array_append_val(priv->queue_rows, row);
+	}
+
+	g_signal_connect(lomo, "insert",        (GCallback) lomo_insert_cb,   self);
+	g_signal_connect(lomo, "remove",        (GCallback) lomo_remove_cb,   self);
+	g_signal_connect(lomo, "clear",         (GCallback) lomo_clear_cb,    self);
+	g_signal_connect(lomo, "change",        (GCallback) lomo_change_cb,   self);
+	g_signal_connect(lomo, "notify::state", (GCallback) lomo_state_cb,    self);
+	g_signal_connect(lomo, "all-tags",      (GCallback) lomo_all_tags_cb, self);
+	g_signal_connect(lomo, "tag",           (GCallback) lomo_tag_cb,      self);
+	g_signal_connect(lomo, "tags-changed",  (GCallback) lomo_tags_changed_cb, self);
+	g_signal_connect(lomo, "queue",         (GCallback) lomo_queue_cb,    self);
+	g_signal_connect(lomo, "dequeue",       (GCallback) lomo_dequeue_cb,  self);
+	g_signal_connect(lomo, "queue-clear",   (GCallback) lomo_queue_clear_cb, self);
+}
+
+/**
+ * eina_playlist_model_set_stream_markup:
+ * @self: An #EinaPlaylistModel
+ * @markup: Value for the property
+ *
+ * Sets the value of #EinaPlaylistModel:stream-markup property. Cached strings
+ * are dropped, rows will be formatted again the next time they are read.
+ */
+void
+eina_playlist_model_set_stream_markup(EinaPlaylistModel *self, const gchar *markup)
+{
+	g_return_if_fail(EINA_IS_PLAYLIST_MODEL(self));
+
+	EinaPlaylistModelPrivate *priv = self->priv;
+	if (!markup)
+		markup = DEFAULT_STREAM_MARKUP;
+	if (g_str_equal(markup, priv->stream_markup))
+		return;
+
+	g_free(priv->stream_markup);
+	priv->stream_markup = g_strdup(markup);
+	cache_clear(self);
+
+	g_object_notify((GObject *) self, "stream-markup");
+}
+
+/**
+ * eina_playlist_model_get_stream_markup:
+ * @self: An #EinaPlaylistModel
+ *
+ * Gets the value of #EinaPlaylistModel:stream-markup property
+ *
+ * Returns: (transfer none): The property value
+ */
+const gchar*
+eina_playlist_model_get_stream_markup(EinaPlaylistModel *self)
+{
+	g_return_val_if_fail(EINA_IS_PLAYLIST_MODEL(self), NULL);
+	return self->priv->stream_markup;
+}
+
+/*
+ * Row lookup
+ */
+static void
+fingers_update(EinaPlaylistModel *self, guint finger, GList *link, gint index)
+{
+	self->priv->fingers[finger].link  = link;
+	self->priv->fingers[finger].index = index;
+}
+
+static GList*
+model_nth_link(EinaPlaylistModel *self, gint index)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	if ((index < 0) || (index >= priv->n_rows))
+		return NULL;
+
+	// Start from the head or from the closest finger
+	GList *link = (GList *) lomo_player_get_playlist(priv->lomo);
+	gint   pos  = 0;
+	for (guint i = 0; i < N_FINGERS; i++)
+	{
+		Finger *f = &priv->fingers[i];
+		if ((f->index >= 0) && (ABS(index - f->index) < ABS(index - pos)))
+		{
+			link = f->link;
+			pos  = f->index;
+		}
+	}
+
+	for (; link && (pos < index); pos++)
+		link = link->next;
+	for (; link && (pos > index); pos--)
+		link = link->prev;
+
+	g_return_val_if_fail(link != NULL, NULL);
+	fingers_update(self, FINGER_VIEW, link, index);
+
+	return link;
+}
+
+static gint
+model_stream_index(EinaPlaylistModel *self, LomoStream *stream)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	// Tags are mostly discovered in playlist order, try next to the last hit
+	Finger *f = &priv->fingers[FINGER_TAGS];
+	if (f->index >= 0)
+	{
+		if (f->link->data == stream)
+			return f->index;
+		if (f->link->next && (f->link->next->data == stream))
+		{
+			fingers_update(self, FINGER_TAGS, f->link->next, f->index + 1);
+			return f->index;
+		}
+	}
+
+	gint index = 0;
+	for (GList *l = (GList *) lomo_player_get_playlist(priv->lomo); l; l = l->next, index++)
+	{
+		if (l->data == stream)
+		{
+			fingers_update(self, FINGER_TAGS, l, index);
+			return index;
+		}
+	}
+	return -1;
+}
+
+static void
+model_row_changed(EinaPlaylistModel *self, gint index)
+{
+	GList *link = model_nth_link(self, index);
+	if (!link)
+		return;
+
+	GtkTreeIter iter = { self->priv->stamp, link, GINT_TO_POINTER(index), NULL };
+	GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
+	gtk_tree_model_row_changed((GtkTreeModel *) self, path, &iter);
+	gtk_tree_path_free(path);
+}
+
+/*
+ * LRU cache of formatted text
+ */
+static void
+cache_entry_free(CacheEntry *entry)
+{
+	g_object_unref(entry->stream);
+	g_free(entry->text);
+	g_slice_free(CacheEntry, entry);
+}
+
+static const gchar*
+model_get_text(EinaPlaylistModel *self, LomoStream *stream)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	GList *link = g_hash_table_lookup(priv->cache, stream);
+	if (link)
+	{
+		if (link != priv->lru->head)
+		{
+			g_queue_unlink(priv->lru, link);
+			g_queue_push_head_link(priv->lru, link);
+		}
+		return ((CacheEntry *) link->data)->text;
+	}
+
+	gchar *tmp = format_stream(stream, priv->stream_markup);
+
+	CacheEntry *entry = g_slice_new(CacheEntry);
+	entry->stream = g_object_ref(stream);
+	entry->text   = g_markup_escape_text(tmp ? tmp : "", -1);
+	g_free(tmp);
+
+	g_queue_push_head(priv->lru, entry);
+	g_hash_table_insert(priv->cache, stream, priv->lru->head);
+
+	while (g_queue_get_length(priv->lru) > CACHE_SIZE)
+	{
+		CacheEntry *old = g_queue_pop_tail(priv->lru);
+		g_hash_table_remove(priv->cache, old->stream);
+		cache_entry_free(old);
+	}
+
+	return entry->text;
+}
+
+static void
+cache_invalidate(EinaPlaylistModel *self, LomoStream *stream)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	GList *link = g_hash_table_lookup(priv->cache, stream);
+	if (!link)
+		return;
+
+	g_hash_table_remove(priv->cache, stream);
+	cache_entry_free((CacheEntry *) link->data);
+	g_queue_delete_link(priv->lru, link);
+}
+
+static void
+cache_clear(EinaPlaylistModel *self)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	g_hash_table_remove_all(priv->cache);
+	CacheEntry *entry;
+	while ((entry = g_queue_pop_head(priv->lru)) != NULL)
+		cache_entry_free(entry);
+}
+
+/*
+ * GtkTreeModel implementation
+ */
+static GtkTreeModelFlags
+model_get_flags(GtkTreeModel *model)
+{
+	return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+model_get_n_columns(GtkTreeModel *model)
+{
+	return EINA_PLAYLIST_MODEL_N_COLUMNS;
+}
+
+static GType
+model_get_column_type(GtkTreeModel *model, gint column)
+{
+	switch (column)
+	{
+	case EINA_PLAYLIST_MODEL_COLUMN_STREAM:
+		return LOMO_TYPE_STREAM;
+	case EINA_PLAYLIST_MODEL_COLUMN_INDEX:
+		return G_TYPE_UINT;
+	case EINA_PLAYLIST_MODEL_COLUMN_STATE:
+	case EINA_PLAYLIST_MODEL_COLUMN_TEXT:
+	case EINA_PLAYLIST_MODEL_COLUMN_MARKUP:
+	case EINA_PLAYLIST_MODEL_COLUMN_QUEUE_STR:
+		return G_TYPE_STRING;
+	default:
+		g_return_val_if_reached(G_TYPE_INVALID);
+	}
+}
+
+static gboolean
+model_iter_nth_child(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent, gint n)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(model);
+
+	GList *link = parent ? NULL : model_nth_link(self, n);
+	if (!link)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+
+	iter->stamp      = self->priv->stamp;
+	iter->user_data  = link;
+	iter->user_data2 = GINT_TO_POINTER(n);
+	return TRUE;
+}
+
+static gboolean
+model_get_iter(GtkTreeModel *model, GtkTreeIter *iter, GtkTreePath *path)
+{
+	g_return_val_if_fail(gtk_tree_path_get_depth(path) == 1, FALSE);
+	return model_iter_nth_child(model, iter, NULL, gtk_tree_path_get_indices(path)[0]);
+}
+
+static GtkTreePath*
+model_get_path(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	g_return_val_if_fail(iter->stamp == EINA_PLAYLIST_MODEL(model)->priv->stamp, NULL);
+	return gtk_tree_path_new_from_indices(GPOINTER_TO_INT(iter->user_data2), -1);
+}
+
+static void
+model_get_value(GtkTreeModel *model, GtkTreeIter *iter, gint column, GValue *value)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(model);
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	g_return_if_fail(iter->stamp == priv->stamp);
+
+	LomoStream *stream = LOMO_STREAM(((GList *) iter->user_data)->data);
+	gint        index  = GPOINTER_TO_INT(iter->user_data2);
+	gboolean    is_current = (index == lomo_player_get_current(priv->lomo));
+
+	g_value_init(value, model_get_column_type(model, column));
+
+	switch (column)
+	{
+	case EINA_PLAYLIST_MODEL_COLUMN_STREAM:
+		g_value_set_object(value, stream);
+		break;
+
+	case EINA_PLAYLIST_MODEL_COLUMN_STATE:
+		if (!is_current)
+			break;
+		switch (lomo_player_get_state(priv->lomo))
+		{
+		case LOMO_STATE_STOP:
+			g_value_set_static_string(value, "media-playback-stop-symbolic");
+			break;
+		case LOMO_STATE_PAUSE:
+			g_value_set_static_string(value, "media-playback-pause-symbolic");
+			break;
+		case LOMO_STATE_PLAY:
+			g_value_set_static_string(value, "media-playback-start-symbolic");
+			break;
+		default:
+			break;
+		}
+		break;
+
+	case EINA_PLAYLIST_MODEL_COLUMN_TEXT:
+		g_value_set_string(value, model_get_text(self, stream));
+		break;
+
+	case EINA_PLAYLIST_MODEL_COLUMN_MARKUP:
+		if (is_current)
+			g_value_take_string(value, g_strdup_printf("<b>%s</b>", model_get_text(self, stream)));
+		else
+			g_value_set_string(value, model_get_text(self, stream));
+		break;
+
+	case EINA_PLAYLIST_MODEL_COLUMN_INDEX:
+		g_value_set_uint(value, index);
+		break;
+
+	case EINA_PLAYLIST_MODEL_COLUMN_QUEUE_STR:
+	{
+		gint queue_index = lomo_player_queue_get_stream_index(priv->lomo, stream);
+		if (queue_index >= 0)
+			g_value_take_string(value, g_strdup_printf("<b>%d</b>", queue_index + 1));
+		break;
+	}
+
+	default:
+		g_warn_if_reached();
+	}
+}
+
+static gboolean
+model_iter_next(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(model);
+	g_return_val_if_fail(iter->stamp == self->priv->stamp, FALSE);
+
+	GList *link = ((GList *) iter->user_data)->next;
+	if (!link)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+
+	gint index = GPOINTER_TO_INT(iter->user_data2) + 1;
+	iter->user_data  = link;
+	iter->user_data2 = GINT_TO_POINTER(index);
+	fingers_update(self, FINGER_VIEW, link, index);
+	return TRUE;
+}
+
+static gboolean
+model_iter_previous(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	EinaPlaylistModel *self = EINA_PLAYLIST_MODEL(model);
+	g_return_val_if_fail(iter->stamp == self->priv->stamp, FALSE);
+
+	GList *link = ((GList *) iter->user_data)->prev;
+	if (!link)
+	{
+		iter->stamp = 0;
+		return FALSE;
+	}
+
+	gint index = GPOINTER_TO_INT(iter->user_data2) - 1;
+	iter->user_data  = link;
+	iter->user_data2 = GINT_TO_POINTER(index);
+	fingers_update(self, FINGER_VIEW, link, index);
+	return TRUE;
+}
+
+static gboolean
+model_iter_children(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *parent)
+{
+	return model_iter_nth_child(model, iter, parent, 0);
+}
+
+static gboolean
+model_iter_has_child(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	return FALSE;
+}
+
+static gint
+model_iter_n_children(GtkTreeModel *model, GtkTreeIter *iter)
+{
+	return iter ? 0 : EINA_PLAYLIST_MODEL(model)->priv->n_rows;
+}
+
+static gboolean
+model_iter_parent(GtkTreeModel *model, GtkTreeIter *iter, GtkTreeIter *child)
+{
+	iter->stamp = 0;
+	return FALSE;
+}
+
+static void
+eina_playlist_model_tree_model_init(GtkTreeModelIface *iface)
+{
+	iface->get_flags       = model_get_flags;
+	iface->get_n_columns   = model_get_n_columns;
+	iface->get_column_type = model_get_column_type;
+	iface->get_iter        = model_get_iter;
+	iface->get_path        = model_get_path;
+	iface->get_value       = model_get_value;
+	iface->iter_next       = model_iter_next;
+	iface->iter_previous   = model_iter_previous;
+	iface->iter_children   = model_iter_children;
+	iface->iter_has_child  = model_iter_has_child;
+	iface->iter_n_children = model_iter_n_children;
+	iface->iter_nth_child  = model_iter_nth_child;
+	iface->iter_parent     = model_iter_parent;
+}
+
+/*
+ * LomoPlayer callbacks
+ */
+static void
+lomo_insert_cb(LomoPlayer *lomo, LomoStream *stream, gint index, EinaPlaylistModel *self)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	// Links don't move on insertion, only indexes after it shift
+	for (guint i = 0; i < N_FINGERS; i++)
+		if (priv->fingers[i].index >= index)
+			priv->fingers[i].index++;
+	for (guint i = 0; i < priv->queue_rows->len; i++)
+		if (g_array_index(priv->queue_rows, gint, i) >= index)
+			g_array_index(priv->queue_rows, gint, i)++;
+
+	priv->n_rows++;
+	priv->stamp++;
+
+	GtkTreeIter iter;
+	g_return_if_fail(model_iter_nth_child((GtkTreeModel *) self, &iter, NULL, index));
+
+	GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
+	gtk_tree_model_row_inserted((GtkTreeModel *) self, path, &iter);
+	gtk_tree_path_free(path);
+}
+
+static void
+lomo_remove_cb(LomoPlayer *lomo, LomoStream *stream, gint index, EinaPlaylistModel *self)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	// The link at index is already freed
+	for (guint i = 0; i < N_FINGERS; i++)
+	{
+		if (priv->fingers[i].index == index)
+			fingers_update(self, i, NULL, -1);
+		else if (priv->fingers[i].index > index)
+			priv->fingers[i].index--;
+	}
+	// LomoPlayer keeps removed streams queued, they have no row
+	for (guint i = 0; i < priv->queue_rows->len; i++)
+	{
+		gint *row = &g_array_index(priv->queue_rows, gint, i);
+		if (*row == index)
+			*row = -1;
+		else if (*row > index)
+			(*row)--;
+	}
+
+	priv->n_rows--;
+	priv->stamp++;
+	cache_invalidate(self, stream);
+
+	GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
+	gtk_tree_model_row_deleted((GtkTreeModel *) self, path);
+	gtk_tree_path_free(path);
+}
+
+static void
+lomo_clear_cb(LomoPlayer *lomo, EinaPlaylistModel *self)
+{
+	EinaPlaylistModelPrivate *priv = self->priv;
+
+	for (guint i = 0; i < N_FINGERS; i++)
+		fingers_update(self, i, NULL, -1);
+	priv->stamp++;
+	cache_clear(self);
+	g_array_set_size(priv->queue_rows, 0);
+
+	// Delete from the tail so views don't have to shift the remaining rows
+	while (priv->n_rows > 0)
+	{
+		priv->n_rows--;
+		GtkTreePath *path = gtk_tree_path_new_from_indices(priv->n_rows, -1);
+		gtk_tree_model_row_deleted((GtkTreeModel *) self, path);
+		gtk_tree_path_free(path);
+	}
+}
+
+static void
+lomo_change_cb(LomoPlayer *lomo, gint from, gint to, EinaPlaylistModel *self)
+{
+	if (from == to)
+		return;
+	model_row_changed(self, from);
+	model_row_changed(self, to);
+}
+
+static void
+lomo_state_cb(LomoPlayer *lomo, GParamSpec *pspec, EinaPlaylistModel *self)
+{
+	model_row_changed(self, lomo_player_get_current(lomo));
+}
+
+static void
+lomo_all_tags_cb(LomoPlayer *lomo, LomoStream *stream, EinaPlaylistModel *self)
+{
+	cache_invalidate(self, stream);
+	model_row_changed(self, model_stream_index(self, stream));
+}
+
+static void
+lomo_tag_cb(LomoPlayer *lomo, LomoStream *stream, const gchar *tag, EinaPlaylistModel *self)
+{
+	// Until all tags are known the text is built from the URI, see
+	// format_stream()
+	if (!lomo_stream_get_all_tags_flag(stream))
+		return;
+	lomo_all_tags_cb(lomo, stream, self);
+}
+
+static void
+lomo_tags_changed_cb(LomoPlayer *lomo, LomoStream *stream, GArray *tags, EinaPlaylistModel *self)
+{
+	// Coalesced parsers emit this instead of "tag"
+	if (!lomo_stream_get_all_tags_flag(stream))
+		return;
+	lomo_all_tags_cb(lomo, stream, self);
+}
+
+static void
+lomo_queue_cb(LomoPlayer *lomo, LomoStream *stream, gint index, gint queue_index, EinaPlaylistModel *self)
+{
+	g_array_append_val(self->priv->queue_rows, index);
+	model_row_changed(self, index);
+}
+
+static void
+lomo_dequeue_cb(LomoPlayer *lomo, LomoStream *stream, gint index, gint queue_index, EinaPlaylistModel *self)
+{
+	GArray *queue_rows = self->priv->queue_rows;
+	g_return_if_fail((queue_index >= 0) && ((guint) queue_index < queue_rows->len));
+	g_array_remove_index(queue_rows, queue_index);
+
+	// Every stream queued after this one moves up
+	model_row_changed(self, index);
+	for (guint i = queue_index; i < queue_rows->len; i++)
+		model_row_changed(self, g_array_index(queue_rows, gint, i));
+}
+
+static void
+lomo_queue_clear_cb(LomoPlayer *lomo, EinaPlaylistModel *self)
+{
+	GArray *queue_rows = self->priv->queue_rows;
+	for (guint i = 0; i < queue_rows->len; i++)
+		model_row_changed(self, g_array_index(queue_rows, gint, i));
+	g_array_set_size(queue_rows, 0);
+}
+
+/*
+ * Formating
+ */
+static gchar *
+format_stream(LomoStream *stream, const gchar *fmt)
+{
+	if (lomo_stream_get_all_tags_flag(stream))
+		return gel_str_parser((gchar *) fmt, (GelStrParserFunc) format_stream_cb, stream);
+	else
+	{
+		gchar *unescape_uri = g_uri_unescape_string(lomo_stream_get_uri(stream), NULL);
+		gchar *ret = g_path_get_basename(unescape_uri);
+		g_free(unescape_uri);
+		return ret;
+	}
+}
+
+static gchar*
+format_stream_cb(gchar key, LomoStream *stream)
+{
+	gchar *tag = lomo_stream_get_tag_by_id(stream, key);
+	if ((tag == NULL) && (key == 't'))
+	{
+		gchar *tmp = g_path_get_basename(lomo_stream_get_uri(stream));
+		tag = g_uri_unescape_string(tmp, NULL);
+		g_free(tmp);
+	}
+
+	return tag;
+}
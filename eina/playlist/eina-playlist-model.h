@@ -0,0 +1,77 @@
+/*
+ * eina/playlist/eina-playlist-model.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EINA_PLAYLIST_MODEL_H__
+#define __EINA_PLAYLIST_MODEL_H__
+
+#include <gtk/gtk.h>
+#include <lomo/lomo-player.h>
+
+G_BEGIN_DECLS
+
+#define EINA_TYPE_PLAYLIST_MODEL eina_playlist_model_get_type()
+
+#define EINA_PLAYLIST_MODEL(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), EINA_TYPE_PLAYLIST_MODEL, EinaPlaylistModel))
+#define EINA_PLAYLIST_MODEL_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  EINA_TYPE_PLAYLIST_MODEL, EinaPlaylistModelClass))
+#define EINA_IS_PLAYLIST_MODEL(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), EINA_TYPE_PLAYLIST_MODEL))
+#define EINA_IS_PLAYLIST_MODEL_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  EINA_TYPE_PLAYLIST_MODEL))
+#define EINA_PLAYLIST_MODEL_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  EINA_TYPE_PLAYLIST_MODEL, EinaPlaylistModelClass))
+
+typedef struct _EinaPlaylistModelPrivate EinaPlaylistModelPrivate;
+typedef struct {
+	GObject parent;
+	EinaPlaylistModelPrivate *priv;
+} EinaPlaylistModel;
+
+typedef struct {
+	GObjectClass parent_class;
+} EinaPlaylistModelClass;
+
+/**
+ * EinaPlaylistModelColumn:
+ * @EINA_PLAYLIST_MODEL_COLUMN_STREAM: The #LomoStream
+ * @EINA_PLAYLIST_MODEL_COLUMN_STATE: Icon name for the current stream
+ * @EINA_PLAYLIST_MODEL_COLUMN_TEXT: Escaped text of the stream
+ * @EINA_PLAYLIST_MODEL_COLUMN_MARKUP: Same as text, bold if stream is current
+ * @EINA_PLAYLIST_MODEL_COLUMN_INDEX: Index of the stream
+ * @EINA_PLAYLIST_MODEL_COLUMN_QUEUE_STR: Position in queue as markup
+ */
+typedef enum {
+	EINA_PLAYLIST_MODEL_COLUMN_STREAM = 0,
+	EINA_PLAYLIST_MODEL_COLUMN_STATE,
+	EINA_PLAYLIST_MODEL_COLUMN_TEXT,
+	EINA_PLAYLIST_MODEL_COLUMN_MARKUP,
+	EINA_PLAYLIST_MODEL_COLUMN_INDEX,
+	EINA_PLAYLIST_MODEL_COLUMN_QUEUE_STR,
+
+	EINA_PLAYLIST_MODEL_N_COLUMNS
+} EinaPlaylistModelColumn;
+
+GType eina_playlist_model_get_type (void);
+
+EinaPlaylistModel* eina_playlist_model_new (LomoPlayer *lomo);
+
+LomoPlayer*  eina_playlist_model_get_lomo_player  (EinaPlaylistModel *self);
+
+void         eina_playlist_model_set_stream_markup(EinaPlaylistModel *self, const gchar *markup);
+const gchar* eina_playlist_model_get_stream_markup(EinaPlaylistModel *self);
+
+G_END_DECLS
+
+#endif /* __EINA_PLAYLIST_MODEL_H__ */
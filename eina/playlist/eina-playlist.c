@@ -31,6 +31,7 @@
 #endif
 
 #include "eina-playlist.h"
+#include "eina-playlist-model.h"
 #include <glib/gi18n.h>
 #include <gel/gel-io.h>
 
@@ -55,7 +56,7 @@ struct _EinaPlaylistPrivate {
 
 	// Filtering
 	GtkTreeModelFilter *filter;
-	gchar *filter_str;
+	GelUISearch        *search;
 };
 
 /*
@@ -78,43 +79,24 @@ enum {
 	TAB_PLAYLIST_NON_EMPTY = 1
 };
 
-enum
-{
-	PLAYLIST_COLUMN_STREAM = 0,
-	PLAYLIST_COLUMN_STATE,
-	PLAYLIST_COLUMN_TEXT,
-	PLAYLIST_COLUMN_MARKUP,
-	PLAYLIST_COLUMN_INDEX,
-	PLAYLIST_COLUMN_QUEUE_STR,
-};
-
 void        playlist_set_lomo_player(EinaPlaylist *self, LomoPlayer *lomo);
-static void playlist_refresh_model  (EinaPlaylist *self);
-static void playlist_insert_stream  (EinaPlaylist *self, LomoStream *stream, gint index);
-static void playlist_remove_stream  (EinaPlaylist *self, LomoStream *stream, gint index);
-static void playlist_update_state   (EinaPlaylist *self);
+static void playlist_update_notebook(EinaPlaylist *self);
 static void playlist_change_current (EinaPlaylist *self, gint from, gint to);
-static void playlist_update_stream  (EinaPlaylist *self, LomoStream *stream);
 static void playlist_remove_selected(EinaPlaylist *self);
 static void playlist_queue_selected (EinaPlaylist *self);
-static void playlist_queue_stream   (EinaPlaylist *self, LomoStream *stream, gint index, gint queue_index);
-static void playlist_dequeue_stream (EinaPlaylist *self, LomoStream *stream, gint index, gint queue_index);
 
 static void     playlist_change_to_activated(EinaPlaylist *self, GtkTreePath *path, GtkTreeViewColumn *column);
 static gboolean playlist_react_to_event     (EinaPlaylist *self, GdkEvent *ev);
 static void     playlist_handle_action      (EinaPlaylist *self, GtkAction *action);
 
-static gboolean playlist_get_iter_from_index(EinaPlaylist *self, GtkTreeIter *iter, gint index);
 static gint*    playlist_get_selected_indices(EinaPlaylist *self);
 
 static void     playlist_search_show (EinaPlaylist *self, gboolean focus);
 static void     playlist_search_hide (EinaPlaylist *self);
 static void     playlist_search_clear(EinaPlaylist *self);
 static void     playlist_filter_model(EinaPlaylist *self);
-static gboolean playlist_filter_cb(GtkTreeModel *model, GtkTreeIter *iter, EinaPlaylist *self);
-
-static gchar* format_stream(LomoStream *stream, gchar *fmt);
-static gchar* format_stream_cb(gchar key, LomoStream *stream);
+static void     playlist_filter_updated(EinaPlaylist *self);
+static gchar*   playlist_search_key_func(GtkTreeModel *model, GtkTreeIter *iter, EinaPlaylist *self);
 
 static void
 eina_playlist_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
@@ -159,8 +141,14 @@ eina_playlist_dispose (GObject *object)
 	if (priv->lomo)
 		playlist_set_lomo_player(self, NULL);
 
+	// Search is referenced by the filter's visible function
+	if (priv->tv)
+		gtk_tree_view_set_model(priv->tv, NULL);
+	gel_free_and_invalidate(priv->search, NULL, g_object_unref);
+	gel_free_and_invalidate(priv->filter, NULL, g_object_unref);
+	gel_free_and_invalidate(priv->model,  NULL, g_object_unref);
+
 	gel_free_and_invalidate(priv->stream_mrkp, NULL, g_free);
-	gel_free_and_invalidate(priv->filter_str, NULL, g_free);
 
 	G_OBJECT_CLASS (eina_playlist_parent_class)->dispose (object);
 }
@@ -248,10 +236,7 @@ eina_playlist_new (LomoPlayer *lomo)
 	g_free(xml_string);
 
  	EinaPlaylistPrivate *priv = self->priv;
-	priv->tv     = gel_ui_generic_get_typed(GEL_UI_GENERIC(self), GTK_TREE_VIEW,         "playlist-treeview");
-	priv->model  = gel_ui_generic_get_typed(GEL_UI_GENERIC(self), GTK_TREE_MODEL,        "playlist-model");
-	priv->filter = gel_ui_generic_get_typed(GEL_UI_GENERIC(self), GTK_TREE_MODEL_FILTER, "playlist-model-filter");
-	gtk_tree_model_filter_set_visible_func(priv->filter, (GtkTreeModelFilterVisibleFunc) playlist_filter_cb,self, NULL);
+	priv->tv = gel_ui_generic_get_typed(GEL_UI_GENERIC(self), GTK_TREE_VIEW, "playlist-treeview");
 
 	playlist_set_lomo_player(self, lomo);
 	g_object_set(
@@ -294,20 +279,28 @@ playlist_set_lomo_player(EinaPlaylist *self, LomoPlayer *lomo)
 	g_return_if_fail(EINA_IS_PLAYLIST(self));
 	g_return_if_fail(LOMO_IS_PLAYER(lomo));
 
-	self->priv->lomo = g_object_ref(lomo);
+	EinaPlaylistPrivate *priv = self->priv;
+	priv->lomo = g_object_ref(lomo);
 
-	playlist_refresh_model(self);
+	// Rows are read from lomo on demand, the model follows its signals by
+	// itself
+	priv->model = (GtkTreeModel *) eina_playlist_model_new(lomo);
+	if (priv->stream_mrkp)
+		eina_playlist_model_set_stream_markup((EinaPlaylistModel *) priv->model, priv->stream_mrkp);
 
-	g_signal_connect_swapped(lomo, "notify::state", (GCallback) playlist_update_state, self);
-	g_signal_connect_swapped(lomo, "insert",   (GCallback) playlist_insert_stream,  self);
-	g_signal_connect_swapped(lomo, "remove",   (GCallback) playlist_remove_stream,  self);
-	g_signal_connect_swapped(lomo, "clear",    (GCallback) playlist_refresh_model,  self);
-	g_signal_connect_swapped(lomo, "change",   (GCallback) playlist_change_current, self);
-	g_signal_connect_swapped(lomo, "all-tags", (GCallback) playlist_update_stream,  self);
-	g_signal_connect_swapped(lomo, "queue",    (GCallback) playlist_queue_stream,   self);
-	g_signal_connect_swapped(lomo, "dequeue",  (GCallback) playlist_dequeue_stream, self);
+	priv->filter = (GtkTreeModelFilter *) gtk_tree_model_filter_new(priv->model, NULL);
+	priv->search = gel_ui_search_new(priv->filter, -1);
+	gel_ui_search_set_key_func(priv->search, (GelUISearchKeyFunc) playlist_search_key_func, self, NULL);
+	g_signal_connect_swapped(priv->search, "updated", (GCallback) playlist_filter_updated, self);
+
+	gtk_tree_view_set_model(priv->tv, priv->model);
+	playlist_update_notebook(self);
+
+	g_signal_connect_swapped(lomo, "insert",   (GCallback) playlist_update_notebook, self);
+	g_signal_connect_swapped(lomo, "remove",   (GCallback) playlist_update_notebook, self);
+	g_signal_connect_swapped(lomo, "clear",    (GCallback) playlist_update_notebook, self);
+	g_signal_connect_swapped(lomo, "change",   (GCallback) playlist_change_current,  self);
 
-	// g_signal_connect_swapped(lomo, "queue-clear", (GCallback) playlist_queue_clear,   self);
 	g_signal_connect_swapped(self->priv->tv, "row-activated",      (GCallback) playlist_change_to_activated, self);
 	g_signal_connect_swapped(self->priv->tv, "key-press-event",    (GCallback) playlist_react_to_event, self);
 	g_signal_connect_swapped(self->priv->tv, "button-press-event", (GCallback) playlist_react_to_event, self);
@@ -366,6 +359,12 @@ eina_playlist_set_stream_markup(EinaPlaylist *self, const gchar *markup)
 	gel_free_and_invalidate(priv->stream_mrkp, NULL, g_free);
 	priv->stream_mrkp = markup ? g_strdup(markup) : NULL;
 
+	if (priv->model)
+	{
+		eina_playlist_model_set_stream_markup((EinaPlaylistModel *) priv->model, priv->stream_mrkp);
+		gtk_widget_queue_draw((GtkWidget *) priv->tv);
+	}
+
 	g_object_notify((GObject *) self, "stream-markup");
 }
 
@@ -403,7 +402,7 @@ eina_playlist_get_view (EinaPlaylist *self)
  * eina_playlist_get_model:
  * @self: An #EinaPlaylist
  *
- * Gets the correspondent model (a #GtkListModel) from @self
+ * Gets the correspondent model (an #EinaPlaylistModel) from @self
  *
  * Returns: (transfer none): The model
  */
@@ -415,113 +414,13 @@ eina_playlist_get_model(EinaPlaylist *self)
 }
 
 static void
-playlist_insert_stream(EinaPlaylist *self, LomoStream *stream, gint index)
-{
-	g_return_if_fail(EINA_IS_PLAYLIST(self));
-	g_return_if_fail(LOMO_IS_STREAM(stream));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	g_return_if_fail((index >= 0) && (index < lomo_player_get_n_streams(priv->lomo)));
-
-	gchar *text  = format_stream(stream, priv->stream_mrkp);
-	gchar *value = g_markup_escape_text(text, -1);
-
-	// If this warning is showed liblomo must be reviewed
-	g_warn_if_fail(index != lomo_player_get_current(priv->lomo));
-
-	GtkTreeIter iter;
-	gtk_list_store_insert((GtkListStore *) priv->model, &iter, index);
-	gtk_list_store_set((GtkListStore *) priv->model, &iter,
-		PLAYLIST_COLUMN_MARKUP, value,
-		PLAYLIST_COLUMN_TEXT,   value,
-		-1);
-	g_free(value);
-
-	GtkNotebook *nb = gel_ui_generic_get_typed(self, GTK_NOTEBOOK, "notebook");
-	gtk_notebook_set_current_page(nb,
-		(lomo_player_get_n_streams(priv->lomo) == 0) ? TAB_PLAYLIST_EMPTY : TAB_PLAYLIST_NON_EMPTY);
-}
-
-static void
-playlist_remove_stream(EinaPlaylist *self, LomoStream *stream, gint index)
+playlist_update_notebook(EinaPlaylist *self)
 {
 	g_return_if_fail(EINA_IS_PLAYLIST(self));
-	g_return_if_fail(LOMO_IS_STREAM(stream));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	// Index must be (0 <= index <= lomo_player_get_n_streams()), remember, stream is already
-	// deleted
-	g_return_if_fail((index >= 0) && (index <= lomo_player_get_n_streams(priv->lomo)));
 
 	GtkNotebook *nb = gel_ui_generic_get_typed(self, GTK_NOTEBOOK, "notebook");
 	gtk_notebook_set_current_page(nb,
-		(lomo_player_get_n_streams(priv->lomo) == 0) ? TAB_PLAYLIST_EMPTY : TAB_PLAYLIST_NON_EMPTY);
-
-	GtkTreeIter iter;
-	g_return_if_fail(playlist_get_iter_from_index(self, &iter, index));
-
-	gtk_list_store_remove((GtkListStore *) priv->model, &iter);
-}
-
-static void
-playlist_refresh_model(EinaPlaylist *self)
-{
-	g_return_if_fail(EINA_IS_PLAYLIST(self));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	GtkNotebook *nb = gel_ui_generic_get_typed(self, GTK_NOTEBOOK, "notebook");
-	gtk_notebook_set_current_page(nb,
-		lomo_player_get_n_streams(priv->lomo) ? TAB_PLAYLIST_NON_EMPTY : TAB_PLAYLIST_EMPTY);
-
-	gtk_list_store_clear((GtkListStore *) priv->model);
-
-	const GList *streams = lomo_player_get_playlist(priv->lomo);
-	GList *l = (GList *) streams;
-	gint i = 0;
-
-	while (l)
-	{
-		playlist_insert_stream(self, (LomoStream *) l->data, i++);
-		l = l->next;
-	}
-}
-
-static void
-playlist_update_state(EinaPlaylist *self)
-{
-	g_return_if_fail(EINA_IS_PLAYLIST(self));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	gint index = lomo_player_get_current(priv->lomo);
-	if (index < 0)
-		return;
-	g_return_if_fail(index < lomo_player_get_n_streams(priv->lomo));
-
-	LomoState state = lomo_player_get_state(priv->lomo);
-
-	GtkTreeIter iter;
-	g_return_if_fail(playlist_get_iter_from_index(self, &iter, index));
-
-	gchar *stock = NULL;
-	switch (state)
-	{
-	case LOMO_STATE_STOP:  stock = "media-playback-stop-symbolic"  /* GTK_STOCK_MEDIA_STOP */ ; break;
-	case LOMO_STATE_PAUSE: stock = "media-playback-pause-symbolic" /* GTK_STOCK_MEDIA_PAUSE */; break;
-	case LOMO_STATE_PLAY:
-		stock = "media-playback-start-symbolic"; /* ((gtk_widget_get_direction((GtkWidget *) self) == GTK_TEXT_DIR_RTL) ?
-			"gtk-media-play-rtl" : "gtk-media-play-ltr"); */
-		break;
-	default:
-		g_warning(_("Unhanded state: %d"), state);
-	}
-
-	gtk_list_store_set((GtkListStore *) priv->model, &iter,
-		PLAYLIST_COLUMN_STATE, stock,
-		-1);
+		lomo_player_get_n_streams(self->priv->lomo) ? TAB_PLAYLIST_NON_EMPTY : TAB_PLAYLIST_EMPTY);
 }
 
 static void
@@ -530,76 +429,14 @@ playlist_change_current(EinaPlaylist *self, gint from, gint to)
 	g_return_if_fail(EINA_IS_PLAYLIST(self));
 
 	EinaPlaylistPrivate *priv = self->priv;
-	g_return_if_fail(from < lomo_player_get_n_streams(priv->lomo));
-	g_return_if_fail(to   < lomo_player_get_n_streams(priv->lomo));
-
-	GtkTreeIter iter;
-	gchar *state = NULL;
-
-	if ((from >= 0) && (from != to) && playlist_get_iter_from_index(self, &iter, from))
-	{
-		gchar *text = NULL;
-		gtk_tree_model_get(priv->model, &iter,
-			PLAYLIST_COLUMN_TEXT,  &text,
-			PLAYLIST_COLUMN_STATE, &state,
-			-1);
-		gtk_list_store_set((GtkListStore *) priv->model, &iter,
-			PLAYLIST_COLUMN_MARKUP, text,
-			PLAYLIST_COLUMN_STATE,  NULL,
-			-1);
-		g_free(text);
-	}
-	if ((to >= 0) && (from != to) && playlist_get_iter_from_index(self, &iter, to))
-	{
-		gchar *text = NULL;
-		gtk_tree_model_get(priv->model, &iter,
-			PLAYLIST_COLUMN_TEXT, &text,
-			-1);
-		gchar *markup = g_strdup_printf("<b>%s</b>", text);
-		gtk_list_store_set((GtkListStore *) priv->model, &iter,
-			PLAYLIST_COLUMN_MARKUP, markup,
-			PLAYLIST_COLUMN_STATE,  state,
-			-1);
-		if (state == NULL)
-			playlist_update_state(self);
-		g_free(markup);
-		g_free(text);
-
-		GtkTreePath *tree_path = gtk_tree_path_new_from_indices(to, -1);
-		gtk_tree_view_scroll_to_cell(priv->tv, tree_path, NULL, FALSE, 0.0, 0.0);
-	}
-}
-
-static void
-playlist_update_stream (EinaPlaylist *self, LomoStream *stream)
-{
-	g_return_if_fail(EINA_IS_PLAYLIST(self));
-	g_return_if_fail(LOMO_IS_STREAM(stream));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	gint index = lomo_player_get_stream_index(priv->lomo, stream);
-	g_return_if_fail((index >= 0) && (index < lomo_player_get_n_streams(priv->lomo)));
-
-	GtkTreeIter iter;
-	g_return_if_fail(playlist_get_iter_from_index(self, &iter, index));
-
-	gchar *tmp  = format_stream(stream, priv->stream_mrkp);
-	gchar *text = g_markup_escape_text(tmp, -1);
-	g_free(tmp);
-
-	gchar *markup = NULL;
+	g_return_if_fail(to < lomo_player_get_n_streams(priv->lomo));
 
-	if (index == lomo_player_get_current(priv->lomo))
-		markup = g_strdup_printf("<b>%s</b>", text);
+	if ((to < 0) || (from == to))
+		return;
 
-	gtk_list_store_set((GtkListStore *) priv->model, &iter,
-		PLAYLIST_COLUMN_TEXT,   text,
-		PLAYLIST_COLUMN_MARKUP, markup ? markup : text,
-		-1);
-	if (markup)
-		g_free(markup);
-	g_free(text);
+	GtkTreePath *tree_path = gtk_tree_path_new_from_indices(to, -1);
+	gtk_tree_view_scroll_to_cell(priv->tv, tree_path, NULL, FALSE, 0.0, 0.0);
+	gtk_tree_path_free(tree_path);
 }
 
 gint *
@@ -684,57 +521,6 @@ playlist_queue_selected (EinaPlaylist *self)
 	g_free(indices);
 }
 
-static void
-playlist_queue_stream(EinaPlaylist *self, LomoStream *stream, gint index, gint queue_index)
-{
-	g_return_if_fail(EINA_IS_PLAYLIST(self));
-	g_return_if_fail(LOMO_IS_STREAM(stream));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	g_return_if_fail((index >= 0) && (index < lomo_player_get_n_streams(priv->lomo)));
-	g_return_if_fail((queue_index >= 0) && (queue_index < lomo_player_get_n_streams(priv->lomo)));
-
-	GtkTreeIter iter;
-	g_return_if_fail(playlist_get_iter_from_index(self, &iter, index));
-
-	gchar *queue_str = g_strdup_printf("<b>%d</b>", queue_index + 1);
-	gtk_list_store_set((GtkListStore *) priv->model, &iter,
-		PLAYLIST_COLUMN_QUEUE_STR, queue_str,
-		-1);
-	g_free(queue_str);
-}
-
-static void
-playlist_dequeue_stream(EinaPlaylist *self, LomoStream *stream, gint index, gint queue_index)
-{
-	g_return_if_fail(EINA_IS_PLAYLIST(self));
-	g_return_if_fail(LOMO_IS_STREAM(stream));
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	for (guint i = queue_index; i < lomo_player_queue_get_n_streams(priv->lomo); i++)
-	{
-		gint stream_index = index;
-		if (i != queue_index)
-		{
-			LomoStream *stream = lomo_player_queue_get_nth_stream(priv->lomo, i);
-			stream_index = lomo_player_get_stream_index(priv->lomo, stream);
-		}
-
-		GtkTreeIter iter;
-		if (!playlist_get_iter_from_index(self, &iter, stream_index))
-			continue;
-
-		gchar *queue_str = ((i == queue_index) ? NULL : g_strdup_printf("<b>%d</b>", i));
-		gtk_list_store_set((GtkListStore *) priv->model, &iter,
-			PLAYLIST_COLUMN_QUEUE_STR, queue_str,
-			-1);
-		if (queue_str)
-			g_free(queue_str);
-	}
-}
-
 static void
 playlist_change_to_activated(EinaPlaylist *self,  GtkTreePath *path, GtkTreeViewColumn *column)
 {
@@ -843,57 +629,59 @@ playlist_handle_action(EinaPlaylist *self, GtkAction *action)
 		g_warning(_("Unhanded action '%s'"), name);
 }
 
-static gboolean
-playlist_get_iter_from_index(EinaPlaylist *self, GtkTreeIter *iter, gint index)
+static void
+playlist_filter_model(EinaPlaylist *self)
 {
-	g_return_val_if_fail(EINA_IS_PLAYLIST(self), FALSE);
-	g_return_val_if_fail(iter != NULL, FALSE);
-
-	EinaPlaylistPrivate *priv = self->priv;
-
-	// Delete restricions on index, sometimes index is out of range, think about
-	// ::remove and ::clear signals
-	// g_return_val_if_fail((index >= 0) && (index < lomo_player_get_n_streams(priv->lomo)), FALSE);
+	g_return_if_fail(EINA_IS_PLAYLIST(self));
 
-	GtkTreePath *path = gtk_tree_path_new_from_indices(index, -1);
-	if (!gtk_tree_model_get_iter(priv->model, iter, path))
-	{
-		gtk_tree_path_free(path);
-		g_warning(_("Unable to get GtkTreeIter for index %d"), index);
-		return FALSE;
-	}
-	gtk_tree_path_free(path);
-	return TRUE;
+	GtkEntry *entry = gel_ui_generic_get_typed(self, GTK_ENTRY, "search-entry");
+	gel_ui_search_set_query(self->priv->search, gtk_entry_get_text(entry));
 }
 
 static void
-playlist_filter_model(EinaPlaylist *self)
+playlist_filter_updated(EinaPlaylist *self)
 {
 	g_return_if_fail(EINA_IS_PLAYLIST(self));
 	EinaPlaylistPrivate *priv = self->priv;
 
-	GtkEntry *entry = gel_ui_generic_get_typed(self, GTK_ENTRY, "search-entry");
-	const gchar *text = gtk_entry_get_text(entry);
+	// Without query show the playlist model directly, avoiding filter
+	// overhead
+	GtkTreeModel *model = gel_ui_search_get_query(priv->search) ? (GtkTreeModel *) priv->filter : priv->model;
+	if (gtk_tree_view_get_model(priv->tv) != model)
+		gtk_tree_view_set_model(priv->tv, model);
+}
 
-	GtkTreeModel *curr_model = gtk_tree_view_get_model(priv->tv);
-	gel_free_and_invalidate(priv->filter_str, NULL, g_free);
+static gchar*
+playlist_search_key_func(GtkTreeModel *model, GtkTreeIter *iter, EinaPlaylist *self)
+{
+	// Match the tags themselves instead of the escaped, user formatted text
+	LomoStream *stream = NULL;
+	gtk_tree_model_get(model, iter, EINA_PLAYLIST_MODEL_COLUMN_STREAM, &stream, -1);
+	if (stream == NULL)
+		return NULL;
 
-	if (!text || (text[0] == '\0'))
+	gchar *ret = NULL;
+	if (lomo_stream_get_all_tags_flag(stream))
 	{
-		if (curr_model != priv->model)
-		{
-			gel_free_and_invalidate(priv->filter_str, NULL, g_free);
-			gtk_tree_view_set_model(priv->tv, priv->model);
-		}
-		return;
+		gchar *artist = lomo_stream_strdup_tag_value(stream, LOMO_TAG_ARTIST);
+		gchar *title  = lomo_stream_strdup_tag_value(stream, LOMO_TAG_TITLE);
+		gchar *album  = lomo_stream_strdup_tag_value(stream, LOMO_TAG_ALBUM);
+		if (artist || title || album)
+			ret = g_strjoin(" ", artist ? artist : "", title ? title : "", album ? album : "", NULL);
+		g_free(artist);
+		g_free(title);
+		g_free(album);
 	}
 
-	if (curr_model != (GtkTreeModel *) priv->filter)
-		gtk_tree_view_set_model(priv->tv, (GtkTreeModel *) priv->filter);
-
-	priv->filter_str = g_utf8_casefold(text, -1);
+	if (ret == NULL)
+	{
+		gchar *unescape_uri = g_uri_unescape_string(lomo_stream_get_uri(stream), NULL);
+		ret = g_path_get_basename(unescape_uri);
+		g_free(unescape_uri);
+	}
 
-	gtk_tree_model_filter_refilter((GtkTreeModelFilter *) priv->filter);
+	g_object_unref(stream);
+	return ret;
 }
 
 static void
@@ -935,53 +723,3 @@ playlist_search_clear(EinaPlaylist *self)
 	gtk_entry_set_text(entry, "");
 }
 
-static gboolean
-playlist_filter_cb(GtkTreeModel *model, GtkTreeIter *iter, EinaPlaylist *self)
-{
-	EinaPlaylistPrivate *priv = self->priv;
-	if (!priv->filter_str || !priv->filter_str[0])
-		return TRUE;
-
-	gchar *text;
-	gtk_tree_model_get(model, iter, PLAYLIST_COLUMN_TEXT, &text, -1);
-
-	if (!text || !text[0])
-		return FALSE;
-
-	gchar *cf = g_utf8_casefold(text, -1);
-	gboolean ret = (strstr(cf, priv->filter_str) != NULL);
-
-	g_free(text);
-	g_free(cf);
-
-	return ret;
-}
-
-static gchar *
-format_stream(LomoStream *stream, gchar *fmt)
-{
-	if (lomo_stream_get_all_tags_flag(stream))
-		return gel_str_parser(fmt, (GelStrParserFunc) format_stream_cb, stream);
-	else
-	{
-		gchar *unescape_uri = g_uri_unescape_string(lomo_stream_get_uri(stream), NULL);
-		gchar *ret = g_path_get_basename(unescape_uri);
-		g_free(unescape_uri);
-		return ret;
-	}
-}
-
-static gchar*
-format_stream_cb(gchar key, LomoStream *stream)
-{
-	gchar *tag = lomo_stream_get_tag_by_id(stream, key);
-	if ((tag == NULL) && (key == 't'))
-	{
-		gchar *tmp = g_path_get_basename(lomo_stream_get_uri(stream));
-		tag = g_uri_unescape_string(tmp, NULL);
-		g_free(tmp);
-	}
-
-	return tag;
-}
-
@@ -30,6 +30,8 @@ class StarsPlugin(GObject.Object, Eina.Activatable):
 	def do_activate(self, app):
 		self.adb = app.get_adb()
 		self.lomo = app.get_lomo()
+		self.sampler = self.adb.get_sampler()
+		self.star_playlist = None
 
 		# Create or update schema
 		curr_schema_version = self.adb.schema_get_version('stars')
@@ -80,6 +82,10 @@ class StarsPlugin(GObject.Object, Eina.Activatable):
 		dock = app.get_dock()
 		dock.remove_widget(self.dock_tab)
 
+		if self.star_playlist:
+			self.star_playlist.cancel_feed()
+		self.star_playlist = None
+		self.sampler = None
 		self.stars = None
 		self.dock_widget = None
 		self.dock_tab = None
@@ -88,28 +94,41 @@ class StarsPlugin(GObject.Object, Eina.Activatable):
 
 	def dock_action_activate_with_mount_cb(self, w, action, amount):
 		name = action.get_name()
+
+		# A previous star play may still be inserting streams
+		if self.star_playlist:
+			self.star_playlist.cancel_feed()
+			self.star_playlist = None
+
 		if name == 'star-play-action':
-			q = "SELECT sid,uri FROM stars JOIN streams USING(sid) WHERE rating >= %d ORDER BY RANDOM()" % amount
+			# All streams rated 'amount' or more, shuffled. The playlist
+			# inserts them in batches, keep it until the next action
+			rule = Eina.AdbRule.new_number(Eina.AdbRuleField.RATING, Eina.AdbRuleOp.GE, amount)
+			self.star_playlist = Eina.AdbSmartPlaylist.new(self.adb, rule)
+			self.star_playlist.set_order(Eina.AdbSmartPlaylistOrder.RANDOM)
+
+			self.lomo.clear()
+			self.star_playlist.feed(self.lomo, 0)
+			return
 		elif name == 'top-rated-play-action':
+			# Best rated streams, most played first. Only rated streams are
+			# sorted, stars is small compared to the library
 			q = """
-				SELECT a.sid,uri,rating,b.count FROM
-					(select sid,rating from stars) AS a
-				INNER JOIN
-					(SELECT count(*) as count,sid FROM recent_plays GROUP BY (sid)) AS b
-				USING (sid)
+				SELECT uri FROM stars
 				INNER JOIN streams USING(sid)
-				ORDER BY a.rating DESC
+				ORDER BY rating DESC, count DESC
 				LIMIT %d
 			""" % (amount)
+			uris = []
+			res = self.adb.query_raw(q)
+			while res.step():
+				uris.append(res.get_value(0, str))
 		elif name == 'random-play-action':
-			q = "SELECT sid,uri FROM streams WHERE sid NOT IN (SELECT sid FROM stars) ORDER BY RANDOM() LIMIT %d" % amount
+			# Unrated streams, weighted by play count
+			uris = self.sampler.sample_uris(0, 0, True, amount)
 		else:
 			raise StarsException('Unknow action: %s' % name)
 
-		uris = []
-		res = self.adb.query_raw(q)
-		while res.step():
-			uris.append(res.get_value(1, str))
 		self.lomo.clear()
 		self.lomo.insert_strv(uris, 0)
 
@@ -123,6 +142,7 @@ class StarsPlugin(GObject.Object, Eina.Activatable):
 			self.adb.query_exec_raw("DELETE FROM stars WHERE sid = %(sid)d" % data)
 		else:
 			self.adb.query_exec_raw("INSERT OR REPLACE INTO stars VALUES(%(sid)d, %(rating)d)" % data)
+		self.sampler.set_rating(data['sid'], data['rating'])
 
 	def lomo_change_cb(self, lomo, f, t):
 		stream = self.lomo.get_nth_stream(t)
@@ -24,6 +24,9 @@
 #include <gel/gel.h>
 #include "gel-marshallers.h"
 
+// Files requested per g_file_enumerator_next_files_async() call
+#define ENUMERATE_BATCH 64
+
 G_DEFINE_TYPE (GelIOScanner, gel_io_scanner, G_TYPE_OBJECT)
 
 struct _GelIOScannerPrivate {
@@ -320,7 +323,7 @@ _scanner_enumerate_children_cb(GFile *source, GAsyncResult *res, GelIOScanner *s
 		return;
 	}
 
-	g_file_enumerator_next_files_async(e, 8, G_PRIORITY_DEFAULT,
+	g_file_enumerator_next_files_async(e, ENUMERATE_BATCH, G_PRIORITY_DEFAULT,
 		priv->cancellable, (GAsyncReadyCallback) _scanner_enumerator_next_cb, self);
 }
 
@@ -366,7 +369,7 @@ _scanner_enumerator_next_cb(GFileEnumerator *e, GAsyncResult *res, GelIOScanner
 	}
 
 	g_list_free(children);
-	g_file_enumerator_next_files_async(e, 8, G_PRIORITY_DEFAULT,
+	g_file_enumerator_next_files_async(e, ENUMERATE_BATCH, G_PRIORITY_DEFAULT,
 		priv->cancellable, (GAsyncReadyCallback) _scanner_enumerator_next_cb, self);
 }
 
@@ -382,33 +385,38 @@ static void
 _scanner_run_queue(GelIOScanner *self)
 {
 	GelIOScannerPrivate *priv = self->priv;
-	if (g_queue_is_empty(priv->queue))
+
+	// Regular files are handled in place, loop until something async is
+	// started or the queue is empty
+	for (;;)
 	{
-		GList *l = priv->results = g_list_reverse(g_list_sort(priv->results, (GCompareFunc) _scanner_cmp_by_type_by_name_cb));
-		while (l)
+		if (g_queue_is_empty(priv->queue))
 		{
-			GNode *root = (GNode *) l->data;
-			_scanner_sort_children(root);
+			GList *l = priv->results = g_list_reverse(g_list_sort(priv->results, (GCompareFunc) _scanner_cmp_by_type_by_name_cb));
+			while (l)
+			{
+				GNode *root = (GNode *) l->data;
+				_scanner_sort_children(root);
+
+				l = l->next;
+			}
 
-			l = l->next;
+			g_signal_emit(self, scanner_signals[FINISH], 0, priv->results);
+			return;
 		}
+		g_cancellable_reset(priv->cancellable);
 
-		g_signal_emit(self, scanner_signals[FINISH], 0, priv->results);
-		return;
-	}
-	g_cancellable_reset(priv->cancellable);
+		GFile     *file = g_queue_pop_head(priv->queue);
+		GFileInfo *info = g_object_get_data((GObject *) file, "g-file-info");
 
-	GFile     *file = g_queue_pop_head(priv->queue);
-	GFileInfo *info = g_object_get_data((GObject *) file, "g-file-info");
+		if (info == NULL)
+		{
+			// GFileInfo is needed
+			g_file_query_info_async(file, priv->attributes, G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
+				priv->cancellable, (GAsyncReadyCallback) _scanner_query_info_cb, self);
+			return;
+		}
 
-	if (info == NULL)
-	{
-		// GFileInfo is needed
-		g_file_query_info_async(file, priv->attributes, G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
-			priv->cancellable, (GAsyncReadyCallback) _scanner_query_info_cb, self);
-	}
-	else
-	{
 		GFile *parent = g_object_get_data((GObject *) file, "g-file-parent");
 		GNode *pnode  = g_object_get_data((GObject *) parent, "x-node");
 		if ((parent == NULL) || (pnode == NULL))
@@ -427,15 +435,13 @@ _scanner_run_queue(GelIOScanner *self)
 		}
 
 		if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY)
+		{
 			g_file_enumerate_children_async(file, priv->attributes, G_FILE_QUERY_INFO_NONE, G_PRIORITY_DEFAULT,
 				priv->cancellable, (GAsyncReadyCallback) _scanner_enumerate_children_cb, self);
-		else if (g_file_info_get_file_type(info) == G_FILE_TYPE_REGULAR)
-			_scanner_run_queue(self);
-		else
-		{
-			g_warning(_("Unknow file type"));
-			_scanner_run_queue(self);
+			return;
 		}
+		else if (g_file_info_get_file_type(info) != G_FILE_TYPE_REGULAR)
+			g_warning(_("Unknow file type"));
 	}
 }
 
@@ -0,0 +1,399 @@
+/*
+ * gel/gel-matcher.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gel-matcher
+ * @title: GelMatcher
+ * @short_description: Fuzzy, scored text matching
+ *
+ * #GelMatcher scores strings against a query the way users type in search
+ * boxes: case and accents are ignored, the query is split in words and every
+ * word must be found in the string, either as a whole word, as a word prefix,
+ * as a substring, with a few typos or, as a last resort, as an abbreviation
+ * of a single word (a subsequence of it sharing its first letter).
+ *
+ * Strings are normalized once into #GelMatchKey<!-- -->s, which also carry a
+ * bitmask of the characters they contain. Most non matching keys are
+ * rejected from the mask alone, the rest go through memcmp() and strstr(),
+ * and edit distances are bounded, so matching is linear in the size of the
+ * keys.
+ */
+
+#include "gel-matcher.h"
+#include <string.h>
+
+// Longest query word allowed to have typos, and most typos allowed
+#define MAX_TOKEN 64
+#define MAX_EDITS 2
+
+// Scores for each query word
+#define SCORE_EXACT       100
+#define SCORE_PREFIX       80
+#define SCORE_SUBSTRING    60
+#define SCORE_FUZZY        40 // Minus 10 per edit
+#define SCORE_SUBSEQUENCE  10
+
+struct _GelMatchKey {
+	gchar   *text;
+	guint64  mask;
+};
+
+typedef struct {
+	gchar   *str;
+	gsize    len;
+	guint64  mask;
+	guint    edits;
+} Token;
+
+struct _GelMatcher {
+	gchar *query;
+	Token *tokens;
+	guint  n_tokens;
+};
+
+static inline guint64
+char_mask(guchar c)
+{
+	if ((c >= 'a') && (c <= 'z'))
+		return G_GUINT64_CONSTANT(1) << (c - 'a');
+	if ((c >= '0') && (c <= '9'))
+		return G_GUINT64_CONSTANT(1) << (26 + c - '0');
+	return G_GUINT64_CONSTANT(1) << (36 + (c % 28));
+}
+
+static guint64
+str_mask(const gchar *str, gsize len)
+{
+	guint64 mask = 0;
+	for (gsize i = 0; i < len; i++)
+		if (str[i] != ' ')
+			mask |= char_mask(str[i]);
+	return mask;
+}
+
+static guint
+popcount64(guint64 x)
+{
+	guint n = 0;
+	for (; x; x &= x - 1)
+		n++;
+	return n;
+}
+
+/**
+ * gel_match_normalize:
+ * @text: An UTF-8 string
+ *
+ * Normalizes @text for matching: accents are stripped, letters are
+ * lowercased, apostrophes are dropped and any other run of non alphanumeric
+ * characters becomes a single space.
+ *
+ * Returns: (transfer full): The normalized string
+ */
+gchar *
+gel_match_normalize(const gchar *text)
+{
+	g_return_val_if_fail(text != NULL, NULL);
+
+	gchar *decomposed = g_utf8_normalize(text, -1, G_NORMALIZE_NFKD);
+	if (decomposed == NULL)
+		return g_strdup("");
+
+	GString *out = g_string_sized_new(strlen(decomposed));
+	for (const gchar *p = decomposed; *p; p = g_utf8_next_char(p))
+	{
+		gunichar c = g_utf8_get_char(p);
+		if (g_unichar_ismark(c) || (c == '\'') || (c == 0x2019))
+			continue;
+
+		if (g_unichar_isalnum(c))
+			g_string_append_unichar(out, g_unichar_tolower(c));
+		else if (out->len && (out->str[out->len - 1] != ' '))
+			g_string_append_c(out, ' ');
+	}
+	if (out->len && (out->str[out->len - 1] == ' '))
+		g_string_truncate(out, out->len - 1);
+
+	g_free(decomposed);
+	return g_string_free(out, FALSE);
+}
+
+/**
+ * gel_match_key_new:
+ * @text: (allow-none): Text to match against
+ *
+ * Precomputes the key used by gel_matcher_score() for @text
+ *
+ * Returns: (transfer full): The key, free with gel_match_key_free()
+ */
+GelMatchKey *
+gel_match_key_new(const gchar *text)
+{
+	GelMatchKey *key = g_slice_new(GelMatchKey);
+	key->text = gel_match_normalize(text ? text : "");
+	key->mask = str_mask(key->text, strlen(key->text));
+	return key;
+}
+
+/**
+ * gel_match_key_free:
+ * @key: A #GelMatchKey
+ *
+ * Frees @key
+ */
+void
+gel_match_key_free(GelMatchKey *key)
+{
+	g_return_if_fail(key != NULL);
+	g_free(key->text);
+	g_slice_free(GelMatchKey, key);
+}
+
+/**
+ * gel_match_key_get_text:
+ * @key: A #GelMatchKey
+ *
+ * Gets the normalized text of @key
+ *
+ * Returns: The text
+ */
+const gchar *
+gel_match_key_get_text(const GelMatchKey *key)
+{
+	g_return_val_if_fail(key != NULL, NULL);
+	return key->text;
+}
+
+/**
+ * gel_matcher_new:
+ * @query: (allow-none): The query
+ *
+ * Compiles @query. A #GelMatcher is never modified once created so it can be
+ * used from several threads at once.
+ *
+ * Returns: (transfer full): The #GelMatcher, free with gel_matcher_free()
+ */
+GelMatcher *
+gel_matcher_new(const gchar *query)
+{
+	GelMatcher *self = g_new0(GelMatcher, 1);
+	self->query = gel_match_normalize(query ? query : "");
+
+	gchar **words = g_strsplit(self->query, " ", 0);
+	self->n_tokens = g_strv_length(words);
+	self->tokens   = g_new0(Token, self->n_tokens);
+
+	for (guint i = 0; i < self->n_tokens; i++)
+	{
+		Token *tok = &self->tokens[i];
+		tok->str  = words[i];
+		tok->len  = strlen(words[i]);
+		tok->mask = str_mask(tok->str, tok->len);
+
+		// Short words would match almost anything with a single typo
+		if ((tok->len < 4) || (tok->len > MAX_TOKEN))
+			tok->edits = 0;
+		else
+			tok->edits = (tok->len < 8) ? 1 : MAX_EDITS;
+	}
+
+	// Strings are owned by tokens now
+	g_free(words);
+
+	return self;
+}
+
+/**
+ * gel_matcher_free:
+ * @self: A #GelMatcher
+ *
+ * Frees @self
+ */
+void
+gel_matcher_free(GelMatcher *self)
+{
+	g_return_if_fail(self != NULL);
+
+	for (guint i = 0; i < self->n_tokens; i++)
+		g_free(self->tokens[i].str);
+	g_free(self->tokens);
+	g_free(self->query);
+	g_free(self);
+}
+
+/**
+ * gel_matcher_is_empty:
+ * @self: A #GelMatcher
+ *
+ * Checks if the query has no words, in which case everything matches
+ *
+ * Returns: %TRUE if empty
+ */
+gboolean
+gel_matcher_is_empty(const GelMatcher *self)
+{
+	g_return_val_if_fail(self != NULL, TRUE);
+	return (self->n_tokens == 0);
+}
+
+/**
+ * gel_matcher_get_query:
+ * @self: A #GelMatcher
+ *
+ * Gets the query, normalized as with gel_match_normalize()
+ *
+ * Returns: The query
+ */
+const gchar *
+gel_matcher_get_query(const GelMatcher *self)
+{
+	g_return_val_if_fail(self != NULL, NULL);
+	return self->query;
+}
+
+/*
+ * Smallest restricted Damerau-Levenshtein distance between q and any prefix
+ * of t, or max + 1 if it's greater than max.
+ */
+static guint
+prefix_distance(const gchar *q, gsize m, const gchar *t, gsize n, guint max)
+{
+	guint rows[3][MAX_TOKEN + MAX_EDITS + 1];
+	guint *prev2 = rows[0], *prev = rows[1], *cur = rows[2];
+
+	// Longer prefixes need more than max insertions
+	n = MIN(n, m + max);
+
+	for (gsize j = 0; j <= n; j++)
+		prev[j] = j;
+
+	for (gsize i = 1; i <= m; i++)
+	{
+		cur[0] = i;
+		guint row_min = cur[0];
+
+		for (gsize j = 1; j <= n; j++)
+		{
+			guint d = MIN(prev[j], cur[j-1]) + 1;
+			d = MIN(d, prev[j-1] + ((q[i-1] == t[j-1]) ? 0 : 1));
+			if ((i > 1) && (j > 1) && (q[i-1] == t[j-2]) && (q[i-2] == t[j-1]))
+				d = MIN(d, prev2[j-2] + 1);
+
+			cur[j] = d;
+			row_min = MIN(row_min, d);
+		}
+
+		if (row_min > max)
+			return max + 1;
+
+		guint *tmp = prev2;
+		prev2 = prev;
+		prev  = cur;
+		cur   = tmp;
+	}
+
+	guint best = max + 1;
+	for (gsize j = 0; j <= n; j++)
+		best = MIN(best, prev[j]);
+	return best;
+}
+
+static gboolean
+is_subsequence(const gchar *needle, const gchar *haystack, gsize len)
+{
+	for (gsize i = 0; (i < len) && *needle; i++)
+		if (haystack[i] == *needle)
+			needle++;
+	return (*needle == '\0');
+}
+
+static gint
+token_score(const Token *tok, const GelMatchKey *key)
+{
+	// Each character of tok missing in key needs one edit at least
+	if (popcount64(tok->mask & ~key->mask) > tok->edits)
+		return -1;
+
+	gint best = -1;
+	guint pos = 0;
+	const gchar *word = key->text;
+	while (*word)
+	{
+		const gchar *end = strchr(word, ' ');
+		gsize len = end ? (gsize) (end - word) : strlen(word);
+
+		// Earlier words weigh a bit more
+		if ((len >= tok->len) && (memcmp(word, tok->str, tok->len) == 0))
+			best = MAX(best, ((len == tok->len) ? SCORE_EXACT : SCORE_PREFIX) - (gint) MIN(pos, 10));
+
+		else if (tok->edits && (best < SCORE_FUZZY))
+		{
+			guint d = prefix_distance(tok->str, tok->len, word, len, tok->edits);
+			if (d <= tok->edits)
+				best = MAX(best, SCORE_FUZZY - 10 * (gint) d);
+		}
+
+		// Abbreviations stay inside a word, across words almost any key would
+		// contain the query
+		if ((best < 0) && (tok->len >= 3) && (len > tok->len) &&
+		    (word[0] == tok->str[0]) && is_subsequence(tok->str, word, len))
+			best = SCORE_SUBSEQUENCE;
+
+		if (end == NULL)
+			break;
+		word = end + 1;
+		pos++;
+	}
+
+	if (best >= SCORE_SUBSTRING)
+		return best;
+	if (strstr(key->text, tok->str))
+		return SCORE_SUBSTRING;
+
+	return best;
+}
+
+/**
+ * gel_matcher_score:
+ * @self: A #GelMatcher
+ * @key: A #GelMatchKey
+ *
+ * Matches @key against the query of @self
+ *
+ * Returns: The score, higher is better, or -1 if @key doesn't match. An
+ *          empty query matches every key with score 0.
+ */
+gint
+gel_matcher_score(const GelMatcher *self, const GelMatchKey *key)
+{
+	g_return_val_if_fail(self != NULL, -1);
+	g_return_val_if_fail(key  != NULL, -1);
+
+	gint score = 0;
+	for (guint i = 0; i < self->n_tokens; i++)
+	{
+		gint s = token_score(&self->tokens[i], key);
+		if (s < 0)
+			return -1;
+		score += s;
+	}
+
+	return score;
+}
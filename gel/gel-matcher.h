@@ -0,0 +1,46 @@
+/*
+ * gel/gel-matcher.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GEL_MATCHER_H
+#define _GEL_MATCHER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GelMatcher  GelMatcher;
+typedef struct _GelMatchKey GelMatchKey;
+
+gchar       *gel_match_normalize(const gchar *text);
+
+GelMatchKey *gel_match_key_new     (const gchar *text);
+void         gel_match_key_free    (GelMatchKey *key);
+const gchar *gel_match_key_get_text(const GelMatchKey *key);
+
+GelMatcher  *gel_matcher_new      (const gchar *query);
+void         gel_matcher_free     (GelMatcher *self);
+gboolean     gel_matcher_is_empty (const GelMatcher *self);
+const gchar *gel_matcher_get_query(const GelMatcher *self);
+
+gint gel_matcher_score(const GelMatcher *self, const GelMatchKey *key);
+
+G_END_DECLS
+
+#endif // _GEL_MATCHER_H
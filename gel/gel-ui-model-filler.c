@@ -0,0 +1,313 @@
+/*
+ * gel/gel-ui-model-filler.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gel-ui-model-filler
+ * @title: GelUIModelFiller
+ * @short_description: Incremental population of tree models
+ *
+ * #GelUIModelFiller calls a #GelUIModelFillerFunc from a low priority idle
+ * source, inserting as many rows as fit in a time budget per main loop
+ * iteration. While filling, the model is detached from the view so it
+ * doesn't have to track every single insertion.
+ */
+
+#include "gel-ui-model-filler.h"
+#include <gel/gel.h>
+
+G_DEFINE_TYPE (GelUIModelFiller, gel_ui_model_filler, G_TYPE_OBJECT)
+
+// Default time slice, about half a frame at 60 fps
+#define DEFAULT_BUDGET 8
+
+struct _GelUIModelFillerPrivate {
+	GtkTreeView  *view;
+	GtkTreeModel *model;
+	guint         budget;
+
+	GelUIModelFillerFunc func;
+	gpointer             data;
+	GDestroyNotify       notify;
+
+	guint         source_id;
+	guint         done, total;
+	GtkTreeModel *view_model; // Model attached to view before filling
+};
+
+enum {
+	PROGRESS,
+	FINISHED,
+	LAST_SIGNAL
+};
+static guint filler_signals[LAST_SIGNAL] = { 0 };
+
+static void     filler_stop(GelUIModelFiller *self);
+static gboolean filler_idle_cb(GelUIModelFiller *self);
+
+static void
+gel_ui_model_filler_dispose (GObject *object)
+{
+	GelUIModelFiller *self = GEL_UI_MODEL_FILLER(object);
+	GelUIModelFillerPrivate *priv = self->priv;
+
+	filler_stop(self);
+	gel_free_and_invalidate(priv->view,  NULL, g_object_unref);
+	gel_free_and_invalidate(priv->model, NULL, g_object_unref);
+
+	G_OBJECT_CLASS (gel_ui_model_filler_parent_class)->dispose (object);
+}
+
+static void
+gel_ui_model_filler_class_init (GelUIModelFillerClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GelUIModelFillerPrivate));
+	object_class->dispose = gel_ui_model_filler_dispose;
+
+	/**
+	 * GelUIModelFiller::progress:
+	 * @filler: The #GelUIModelFiller
+	 * @done: Rows inserted so far
+	 * @total: Total rows as passed to gel_ui_model_filler_start(), or 0 if
+	 *         unknown
+	 *
+	 * Emitted after each time slice
+	 */
+	filler_signals[PROGRESS] =
+		g_signal_new ("progress",
+			    G_OBJECT_CLASS_TYPE (object_class),
+			    G_SIGNAL_RUN_LAST,
+			    G_STRUCT_OFFSET (GelUIModelFillerClass, progress),
+			    NULL, NULL,
+			    gel_marshal_VOID__UINT_UINT,
+			    G_TYPE_NONE,
+			    2,
+			    G_TYPE_UINT,
+			    G_TYPE_UINT);
+
+	/**
+	 * GelUIModelFiller::finished:
+	 * @filler: The #GelUIModelFiller
+	 * @completed: %FALSE if the operation was cancelled
+	 *
+	 * Emitted once the model is filled or the operation is cancelled. The
+	 * model is already attached again to the view.
+	 */
+	filler_signals[FINISHED] =
+		g_signal_new ("finished",
+			    G_OBJECT_CLASS_TYPE (object_class),
+			    G_SIGNAL_RUN_LAST,
+			    G_STRUCT_OFFSET (GelUIModelFillerClass, finished),
+			    NULL, NULL,
+			    g_cclosure_marshal_VOID__BOOLEAN,
+			    G_TYPE_NONE,
+			    1,
+			    G_TYPE_BOOLEAN);
+}
+
+static void
+gel_ui_model_filler_init (GelUIModelFiller *self)
+{
+	self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), GEL_UI_TYPE_MODEL_FILLER, GelUIModelFillerPrivate));
+	self->priv->budget = DEFAULT_BUDGET;
+}
+
+/**
+ * gel_ui_model_filler_new:
+ * @view: (allow-none): The #GtkTreeView showing @model (or a model derived
+ *        from it)
+ * @model: The #GtkTreeModel to fill
+ *
+ * Creates a new #GelUIModelFiller
+ *
+ * Returns: (transfer full): The #GelUIModelFiller
+ */
+GelUIModelFiller*
+gel_ui_model_filler_new (GtkTreeView *view, GtkTreeModel *model)
+{
+	g_return_val_if_fail(!view || GTK_IS_TREE_VIEW(view), NULL);
+	g_return_val_if_fail(GTK_IS_TREE_MODEL(model), NULL);
+
+	GelUIModelFiller *self = g_object_new (GEL_UI_TYPE_MODEL_FILLER, NULL);
+	self->priv->view  = view ? g_object_ref(view) : NULL;
+	self->priv->model = g_object_ref(model);
+
+	return self;
+}
+
+/**
+ * gel_ui_model_filler_start:
+ * @self: A #GelUIModelFiller
+ * @func: (scope notified): Producer called once per row
+ * @data: (closure): User data for @func
+ * @notify: Called on @data when filling finishes or is cancelled
+ * @total: Number of expected rows for #GelUIModelFiller::progress, or 0
+ *
+ * Starts filling the model, cancelling any running operation first. The
+ * model is not cleared, that's up to the caller.
+ */
+void
+gel_ui_model_filler_start(GelUIModelFiller *self, GelUIModelFillerFunc func, gpointer data, GDestroyNotify notify, guint total)
+{
+	g_return_if_fail(GEL_UI_IS_MODEL_FILLER(self));
+	g_return_if_fail(func != NULL);
+
+	GelUIModelFillerPrivate *priv = self->priv;
+
+	if (gel_ui_model_filler_is_running(self))
+		gel_ui_model_filler_cancel(self);
+
+	priv->func   = func;
+	priv->data   = data;
+	priv->notify = notify;
+	priv->done   = 0;
+	priv->total  = total;
+
+	if (priv->view)
+	{
+		priv->view_model = gtk_tree_view_get_model(priv->view);
+		if (priv->view_model)
+		{
+			g_object_ref(priv->view_model);
+			gtk_tree_view_set_model(priv->view, NULL);
+		}
+	}
+
+	priv->source_id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, (GSourceFunc) filler_idle_cb, self, NULL);
+}
+
+/**
+ * gel_ui_model_filler_cancel:
+ * @self: A #GelUIModelFiller
+ *
+ * Stops a running operation, rows already inserted are kept.
+ */
+void
+gel_ui_model_filler_cancel(GelUIModelFiller *self)
+{
+	g_return_if_fail(GEL_UI_IS_MODEL_FILLER(self));
+
+	if (!gel_ui_model_filler_is_running(self))
+		return;
+
+	filler_stop(self);
+	g_signal_emit(self, filler_signals[FINISHED], 0, FALSE);
+}
+
+/**
+ * gel_ui_model_filler_is_running:
+ * @self: A #GelUIModelFiller
+ *
+ * Checks if @self is filling its model
+ *
+ * Returns: %TRUE if running
+ */
+gboolean
+gel_ui_model_filler_is_running(GelUIModelFiller *self)
+{
+	g_return_val_if_fail(GEL_UI_IS_MODEL_FILLER(self), FALSE);
+	return (self->priv->source_id != 0);
+}
+
+/**
+ * gel_ui_model_filler_set_budget:
+ * @self: A #GelUIModelFiller
+ * @msecs: Milliseconds
+ *
+ * Sets the time spent inserting rows on each main loop iteration
+ */
+void
+gel_ui_model_filler_set_budget(GelUIModelFiller *self, guint msecs)
+{
+	g_return_if_fail(GEL_UI_IS_MODEL_FILLER(self));
+	self->priv->budget = MAX(msecs, 1);
+}
+
+/**
+ * gel_ui_model_filler_get_budget:
+ * @self: A #GelUIModelFiller
+ *
+ * Gets the time spent inserting rows on each main loop iteration
+ *
+ * Returns: The budget in milliseconds
+ */
+guint
+gel_ui_model_filler_get_budget(GelUIModelFiller *self)
+{
+	g_return_val_if_fail(GEL_UI_IS_MODEL_FILLER(self), 0);
+	return self->priv->budget;
+}
+
+static void
+filler_stop(GelUIModelFiller *self)
+{
+	GelUIModelFillerPrivate *priv = self->priv;
+
+	if (priv->source_id)
+	{
+		g_source_remove(priv->source_id);
+		priv->source_id = 0;
+	}
+
+	if (priv->view_model)
+	{
+		gtk_tree_view_set_model(priv->view, priv->view_model);
+		gel_free_and_invalidate(priv->view_model, NULL, g_object_unref);
+	}
+
+	// Reset before calling notify, it may start a new operation
+	GDestroyNotify notify = priv->notify;
+	gpointer       data   = priv->data;
+	priv->func   = NULL;
+	priv->data   = NULL;
+	priv->notify = NULL;
+	if (notify)
+		notify(data);
+}
+
+static gboolean
+filler_idle_cb(GelUIModelFiller *self)
+{
+	GelUIModelFillerPrivate *priv = self->priv;
+
+	gint64 deadline = g_get_monotonic_time() + priv->budget * 1000;
+	gboolean more = TRUE;
+	while (more && (g_get_monotonic_time() < deadline))
+	{
+		if ((more = priv->func(priv->model, priv->data)))
+			priv->done++;
+
+		// Producer cancelled the operation
+		if (!priv->source_id)
+			return FALSE;
+	}
+
+	g_signal_emit(self, filler_signals[PROGRESS], 0, priv->done, priv->total);
+	if (more)
+		return TRUE;
+
+	// Source is removed by returning FALSE
+	priv->source_id = 0;
+	filler_stop(self);
+	g_signal_emit(self, filler_signals[FINISHED], 0, TRUE);
+
+	return FALSE;
+}
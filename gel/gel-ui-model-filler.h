@@ -0,0 +1,72 @@
+/*
+ * gel/gel-ui-model-filler.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GEL_UI_MODEL_FILLER
+#define _GEL_UI_MODEL_FILLER
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GEL_UI_TYPE_MODEL_FILLER gel_ui_model_filler_get_type()
+
+#define GEL_UI_MODEL_FILLER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEL_UI_TYPE_MODEL_FILLER, GelUIModelFiller))
+#define GEL_UI_MODEL_FILLER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEL_UI_TYPE_MODEL_FILLER, GelUIModelFillerClass))
+#define GEL_UI_IS_MODEL_FILLER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEL_UI_TYPE_MODEL_FILLER))
+#define GEL_UI_IS_MODEL_FILLER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEL_UI_TYPE_MODEL_FILLER))
+#define GEL_UI_MODEL_FILLER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEL_UI_TYPE_MODEL_FILLER, GelUIModelFillerClass))
+
+typedef struct _GelUIModelFillerPrivate GelUIModelFillerPrivate;
+typedef struct {
+	GObject parent;
+	GelUIModelFillerPrivate *priv;
+} GelUIModelFiller;
+
+typedef struct {
+	GObjectClass parent_class;
+	void (*progress) (GelUIModelFiller *self, guint done, guint total);
+	void (*finished) (GelUIModelFiller *self, gboolean completed);
+} GelUIModelFillerClass;
+
+/**
+ * GelUIModelFillerFunc:
+ * @model: The #GtkTreeModel being filled
+ * @data: User data
+ *
+ * Producer for #GelUIModelFiller, inserts the next row into @model.
+ *
+ * Returns: %TRUE if a row was inserted, %FALSE if there are no more rows
+ */
+typedef gboolean (*GelUIModelFillerFunc) (GtkTreeModel *model, gpointer data);
+
+GType gel_ui_model_filler_get_type (void);
+
+GelUIModelFiller* gel_ui_model_filler_new (GtkTreeView *view, GtkTreeModel *model);
+
+void     gel_ui_model_filler_start     (GelUIModelFiller *self, GelUIModelFillerFunc func, gpointer data, GDestroyNotify notify, guint total);
+void     gel_ui_model_filler_cancel    (GelUIModelFiller *self);
+gboolean gel_ui_model_filler_is_running(GelUIModelFiller *self);
+
+void  gel_ui_model_filler_set_budget(GelUIModelFiller *self, guint msecs);
+guint gel_ui_model_filler_get_budget(GelUIModelFiller *self);
+
+G_END_DECLS
+
+#endif /* _GEL_UI_MODEL_FILLER */
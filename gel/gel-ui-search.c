@@ -0,0 +1,855 @@
+/*
+ * gel/gel-ui-search.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * SECTION:gel-ui-search
+ * @title: GelUISearch
+ * @short_description: Asynchronous search over a GtkTreeModelFilter
+ *
+ * #GelUISearch drives the visibility of a #GtkTreeModelFilter from a query
+ * string. Changes to the query are debounced, then matching runs on a
+ * worker thread with a #GelMatcher over keys precomputed from one column of
+ * the child model, or from a #GelUISearchKeyFunc. A new query cancels the
+ * running match. The result, one score per row, is
+ * applied to the filter in a single gtk_tree_model_filter_refilter() call.
+ * Scores are kept and can be read with gel_ui_search_get_score() to show
+ * best matches first, for example from a #GtkTreeModelSort over the filter.
+ *
+ * Texts for the keys are read from the model in idle chunks as soon as a
+ * filter is set, and normalized on the worker the first time they are
+ * matched. Keys are kept in sync with the child model; edits made while a
+ * worker holds them are queued and replayed once it is done. Rows inserted
+ * or changed while a query is active are matched directly on the main thread.
+ */
+
+#include "gel-ui-search.h"
+#include <string.h>
+#include <gel/gel.h>
+
+G_DEFINE_TYPE (GelUISearch, gel_ui_search, G_TYPE_OBJECT)
+
+#define DEFAULT_DELAY 150
+
+// Rows matched between checks for cancellation
+#define CANCEL_CHECK_INTERVAL 4096
+
+// Rows read from the model per idle call
+#define COLLECT_CHUNK 256
+
+/*
+ * Match keys for all rows of the child model. Rows not normalized yet have a
+ * NULL key and their raw text in texts, workers fill the key and free the
+ * text. Workers hold a reference while matching, the main thread only edits
+ * it if nobody else does.
+ */
+typedef struct {
+	gint       ref;
+	GPtrArray *keys;
+	GPtrArray *texts;
+} KeySet;
+
+typedef enum {
+	KEY_EDIT_INSERT,
+	KEY_EDIT_DELETE,
+	KEY_EDIT_CHANGE
+} KeyEditType;
+
+typedef struct {
+	KeyEditType type;
+	guint       index;
+	gchar      *text;
+} KeyEdit;
+
+typedef struct {
+	GelUISearch   *self;
+	KeySet        *keys;
+	GelMatcher    *matcher;
+	guint          generation;
+	volatile gint  cancelled;
+
+	GArray        *scores;  // <gint> by row, -1 if it doesn't match
+	GHashTable    *changed; // Rows changed while matching, main thread only
+} SearchJob;
+
+struct _GelUISearchPrivate {
+	GtkTreeModelFilter *filter;
+	GtkTreeModel       *model;
+	gint                column;
+	guint               delay;
+
+	GelUISearchKeyFunc key_func;
+	gpointer           key_data;
+	GDestroyNotify     key_notify;
+
+	GelMatcher *matcher; // NULL if there is no query
+	guint       timeout_id;
+	GArray     *scores;  // <gint> Last applied match by row, kept in sync with the model
+
+	KeySet    *keys;
+	GQueue    *edits;       // KeyEdits waiting for workers to release keys
+	guint      collect_id;  // Idle reading texts, keys are partial meanwhile
+	gboolean   run_pending; // Match once keys are complete and released
+	guint      generation;  // Bumped on structural changes of model
+	SearchJob *job;
+	SearchJob *applying;    // Job whose result is being applied
+};
+
+enum {
+	UPDATED,
+	LAST_SIGNAL
+};
+static guint search_signals[LAST_SIGNAL] = { 0 };
+
+static gboolean search_visible_func(GtkTreeModel *model, GtkTreeIter *iter, GelUISearch *self);
+static void     search_cancel(GelUISearch *self);
+static void     search_run   (GelUISearch *self);
+static gboolean search_timeout_cb(GelUISearch *self);
+static void     search_reset_keys(GelUISearch *self);
+static gint     search_row_score (GelUISearch *self, GtkTreeIter *iter);
+
+static void model_row_inserted_cb   (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GelUISearch *self);
+static void model_row_deleted_cb    (GtkTreeModel *model, GtkTreePath *path, GelUISearch *self);
+static void model_row_changed_cb    (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GelUISearch *self);
+static void model_rows_reordered_cb (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer new_order, GelUISearch *self);
+
+static void
+keyset_unref(KeySet *keys)
+{
+	if (--keys->ref > 0)
+		return;
+	for (guint i = 0; i < keys->keys->len; i++)
+	{
+		if (g_ptr_array_index(keys->keys, i))
+			gel_match_key_free(g_ptr_array_index(keys->keys, i));
+	}
+	g_ptr_array_free(keys->keys, TRUE);
+	g_ptr_array_foreach(keys->texts, (GFunc) g_free, NULL);
+	g_ptr_array_free(keys->texts, TRUE);
+	g_free(keys);
+}
+
+static void
+key_edit_free(KeyEdit *edit)
+{
+	g_free(edit->text);
+	g_free(edit);
+}
+
+static void
+gel_ui_search_dispose (GObject *object)
+{
+	GelUISearch *self = GEL_UI_SEARCH(object);
+	GelUISearchPrivate *priv = self->priv;
+
+	search_cancel(self);
+
+	if (priv->model)
+	{
+		g_signal_handlers_disconnect_matched(priv->model, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+		gel_free_and_invalidate(priv->model, NULL, g_object_unref);
+	}
+	gel_free_and_invalidate(priv->filter, NULL, g_object_unref);
+	search_reset_keys(self);
+	gel_free_and_invalidate(priv->edits,   NULL, g_queue_free);
+	gel_free_and_invalidate(priv->matcher, NULL, gel_matcher_free);
+	gel_free_and_invalidate(priv->scores,  NULL, g_array_unref);
+	if (priv->key_notify)
+		priv->key_notify(priv->key_data);
+	priv->key_func   = NULL;
+	priv->key_notify = NULL;
+
+	G_OBJECT_CLASS (gel_ui_search_parent_class)->dispose (object);
+}
+
+static void
+gel_ui_search_class_init (GelUISearchClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (GelUISearchPrivate));
+	object_class->dispose = gel_ui_search_dispose;
+
+	/**
+	 * GelUISearch::updated:
+	 * @search: The #GelUISearch
+	 *
+	 * Emitted after the filter has been updated for the current query
+	 */
+	search_signals[UPDATED] =
+		g_signal_new ("updated",
+			    G_OBJECT_CLASS_TYPE (object_class),
+			    G_SIGNAL_RUN_LAST,
+			    G_STRUCT_OFFSET (GelUISearchClass, updated),
+			    NULL, NULL,
+			    g_cclosure_marshal_VOID__VOID,
+			    G_TYPE_NONE,
+			    0);
+}
+
+static void
+gel_ui_search_init (GelUISearch *self)
+{
+	self->priv = (G_TYPE_INSTANCE_GET_PRIVATE ((self), GEL_UI_TYPE_SEARCH, GelUISearchPrivate));
+	self->priv->delay = DEFAULT_DELAY;
+	self->priv->edits = g_queue_new();
+}
+
+/**
+ * gel_ui_search_new:
+ * @filter: (allow-none): A #GtkTreeModelFilter without visible function
+ * @column: Column of the child model to match against, must be of type
+ *          %G_TYPE_STRING, or -1 if keys come from gel_ui_search_set_key_func()
+ *
+ * Creates a new #GelUISearch, which takes over the visible function of
+ * @filter. See gel_ui_search_set_filter()
+ *
+ * Returns: (transfer full): The #GelUISearch
+ */
+GelUISearch*
+gel_ui_search_new (GtkTreeModelFilter *filter, gint column)
+{
+	g_return_val_if_fail(!filter || GTK_IS_TREE_MODEL_FILTER(filter), NULL);
+
+	GelUISearch *self = g_object_new (GEL_UI_TYPE_SEARCH, NULL);
+	self->priv->column = column;
+	gel_ui_search_set_filter(self, filter);
+
+	return self;
+}
+
+/**
+ * gel_ui_search_set_filter:
+ * @self: A #GelUISearch
+ * @filter: (allow-none): A #GtkTreeModelFilter without visible function
+ *
+ * Moves the search to @filter, the current query is matched against it.
+ * Filters can't be detached from their child model, models being filled in
+ * bulk are better filled without a filter and set here once complete.
+ * %NULL leaves @self without filter until one is set.
+ */
+void
+gel_ui_search_set_filter(GelUISearch *self, GtkTreeModelFilter *filter)
+{
+	g_return_if_fail(GEL_UI_IS_SEARCH(self));
+	g_return_if_fail(!filter || GTK_IS_TREE_MODEL_FILTER(filter));
+	GelUISearchPrivate *priv = self->priv;
+
+	if (filter == priv->filter)
+		return;
+
+	GtkTreeModel *model = filter ? gtk_tree_model_filter_get_model(filter) : NULL;
+	g_return_if_fail(!model || (priv->column == -1) || (gtk_tree_model_get_column_type(model, priv->column) == G_TYPE_STRING));
+
+	search_cancel(self);
+	if (priv->model)
+	{
+		g_signal_handlers_disconnect_matched(priv->model, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+		gel_free_and_invalidate(priv->model, NULL, g_object_unref);
+	}
+	gel_free_and_invalidate(priv->filter, NULL, g_object_unref);
+
+	if (filter)
+	{
+		priv->filter = g_object_ref(filter);
+		priv->model  = g_object_ref(model);
+
+		gtk_tree_model_filter_set_visible_func(filter, (GtkTreeModelFilterVisibleFunc) search_visible_func, self, NULL);
+
+		g_signal_connect(model, "row-inserted",   (GCallback) model_row_inserted_cb,   self);
+		g_signal_connect(model, "row-deleted",    (GCallback) model_row_deleted_cb,    self);
+		g_signal_connect(model, "row-changed",    (GCallback) model_row_changed_cb,    self);
+		g_signal_connect(model, "rows-reordered", (GCallback) model_rows_reordered_cb, self);
+	}
+
+	// Starts reading texts for the new model
+	search_reset_keys(self);
+	if (filter && priv->matcher)
+		search_run(self);
+}
+
+/**
+ * gel_ui_search_set_query:
+ * @self: A #GelUISearch
+ * @query: (allow-none): Text to search for
+ *
+ * Sets the query. A query without words makes all rows visible at once,
+ * otherwise the search starts once the query stays unchanged for the delay
+ * set with gel_ui_search_set_delay(). #GelUISearch::updated is emitted in both cases.
+ */
+void
+gel_ui_search_set_query(GelUISearch *self, const gchar *query)
+{
+	g_return_if_fail(GEL_UI_IS_SEARCH(self));
+	GelUISearchPrivate *priv = self->priv;
+
+	GelMatcher *matcher = gel_matcher_new(query);
+	if (gel_matcher_is_empty(matcher))
+		gel_free_and_invalidate(matcher, NULL, gel_matcher_free);
+
+	if (!g_strcmp0(matcher       ? gel_matcher_get_query(matcher)       : NULL,
+	               priv->matcher ? gel_matcher_get_query(priv->matcher) : NULL))
+	{
+		gel_free_and_invalidate(matcher, NULL, gel_matcher_free);
+		return;
+	}
+
+	gel_free_and_invalidate(priv->matcher, NULL, gel_matcher_free);
+	priv->matcher = matcher;
+
+	search_cancel(self);
+
+	// Matched once a filter is set
+	if (priv->filter == NULL)
+		return;
+
+	if (priv->matcher == NULL)
+	{
+		gel_free_and_invalidate(priv->scores, NULL, g_array_unref);
+		gtk_tree_model_filter_refilter(priv->filter);
+		g_signal_emit(self, search_signals[UPDATED], 0);
+		return;
+	}
+
+	priv->timeout_id = g_timeout_add(priv->delay, (GSourceFunc) search_timeout_cb, self);
+}
+
+/**
+ * gel_ui_search_get_query:
+ * @self: A #GelUISearch
+ *
+ * Gets the current query, normalized as with gel_match_normalize()
+ *
+ * Returns: The query or %NULL
+ */
+const gchar*
+gel_ui_search_get_query(GelUISearch *self)
+{
+	g_return_val_if_fail(GEL_UI_IS_SEARCH(self), NULL);
+	return self->priv->matcher ? gel_matcher_get_query(self->priv->matcher) : NULL;
+}
+
+/**
+ * gel_ui_search_set_key_func:
+ * @self: A #GelUISearch
+ * @func: (allow-none) (scope notified): Function building the text to match
+ *        for each row, or %NULL to use the column passed to
+ *        gel_ui_search_new()
+ * @data: (closure): User data for @func
+ * @notify: Called on @data when replaced or @self is disposed
+ *
+ * Sets how the text to match against is built from rows of the child model.
+ * Useful when the displayed column contains markup or decorations that
+ * shouldn't be matched.
+ */
+void
+gel_ui_search_set_key_func(GelUISearch *self, GelUISearchKeyFunc func, gpointer data, GDestroyNotify notify)
+{
+	g_return_if_fail(GEL_UI_IS_SEARCH(self));
+	GelUISearchPrivate *priv = self->priv;
+
+	if (priv->key_notify)
+		priv->key_notify(priv->key_data);
+
+	priv->key_func   = func;
+	priv->key_data   = data;
+	priv->key_notify = notify;
+
+	// Keys are no longer valid, a running match is restarted when done
+	search_reset_keys(self);
+	if (priv->filter && priv->matcher && !priv->timeout_id)
+		search_run(self);
+}
+
+/**
+ * gel_ui_search_set_delay:
+ * @self: A #GelUISearch
+ * @msecs: Milliseconds
+ *
+ * Sets how long the query must stay unchanged before searching
+ */
+void
+gel_ui_search_set_delay(GelUISearch *self, guint msecs)
+{
+	g_return_if_fail(GEL_UI_IS_SEARCH(self));
+	self->priv->delay = msecs;
+}
+
+/**
+ * gel_ui_search_get_delay:
+ * @self: A #GelUISearch
+ *
+ * Gets how long the query must stay unchanged before searching
+ *
+ * Returns: The delay in milliseconds
+ */
+guint
+gel_ui_search_get_delay(GelUISearch *self)
+{
+	g_return_val_if_fail(GEL_UI_IS_SEARCH(self), 0);
+	return self->priv->delay;
+}
+
+/**
+ * gel_ui_search_get_score:
+ * @self: A #GelUISearch
+ * @iter: A row of the child model of the filter
+ *
+ * Gets how well a row matches the query, as given by gel_matcher_score().
+ * Scores come from the last search applied to the filter, re-sort views
+ * ordered by them on #GelUISearch::updated.
+ *
+ * Returns: The score, higher is better. -1 if the row doesn't match, 0 if
+ *          there is no query.
+ */
+gint
+gel_ui_search_get_score(GelUISearch *self, GtkTreeIter *iter)
+{
+	g_return_val_if_fail(GEL_UI_IS_SEARCH(self), -1);
+	g_return_val_if_fail(iter != NULL, -1);
+	GelUISearchPrivate *priv = self->priv;
+
+	if (priv->matcher == NULL)
+		return 0;
+	g_return_val_if_fail(priv->model != NULL, -1);
+
+	if (priv->scores)
+	{
+		GtkTreePath *path = gtk_tree_model_get_path(priv->model, iter);
+		guint index = gtk_tree_path_get_indices(path)[0];
+		gtk_tree_path_free(path);
+
+		if (index < priv->scores->len)
+			return g_array_index(priv->scores, gint, index);
+	}
+
+	return search_row_score(self, iter);
+}
+
+/*
+ * Keys
+ */
+static gchar *
+search_row_text(GelUISearch *self, GtkTreeIter *iter)
+{
+	GelUISearchPrivate *priv = self->priv;
+
+	gchar *text = NULL;
+	if (priv->key_func)
+		text = priv->key_func(priv->model, iter, priv->key_data);
+	else if (priv->column >= 0)
+		gtk_tree_model_get(priv->model, iter, priv->column, &text, -1);
+
+	return text;
+}
+
+// g_ptr_array_insert() is not available, make room by hand
+static void
+ptr_array_insert(GPtrArray *array, guint index, gpointer data)
+{
+	g_ptr_array_add(array, NULL);
+	memmove(array->pdata + index + 1, array->pdata + index, (array->len - index - 1) * sizeof(gpointer));
+	array->pdata[index] = data;
+}
+
+/*
+ * Applies @edit to @keys, takes the text
+ */
+static void
+keyset_edit(KeySet *keys, KeyEdit *edit)
+{
+	guint index = edit->index;
+	gchar *text = edit->text;
+	edit->text = NULL;
+
+	switch (edit->type)
+	{
+	case KEY_EDIT_INSERT:
+		g_return_if_fail(index <= keys->keys->len);
+		ptr_array_insert(keys->keys,  index, NULL);
+		ptr_array_insert(keys->texts, index, text);
+		return;
+
+	case KEY_EDIT_DELETE:
+		g_return_if_fail(index < keys->keys->len);
+		if (g_ptr_array_index(keys->keys, index))
+			gel_match_key_free(g_ptr_array_index(keys->keys, index));
+		g_free(g_ptr_array_index(keys->texts, index));
+		g_ptr_array_remove_index(keys->keys,  index);
+		g_ptr_array_remove_index(keys->texts, index);
+		return;
+
+	case KEY_EDIT_CHANGE:
+		if (index >= keys->keys->len)
+		{
+			g_free(text);
+			g_return_if_reached();
+		}
+		if (g_ptr_array_index(keys->keys, index))
+			gel_match_key_free(g_ptr_array_index(keys->keys, index));
+		g_free(g_ptr_array_index(keys->texts, index));
+		g_ptr_array_index(keys->keys,  index) = NULL;
+		g_ptr_array_index(keys->texts, index) = text;
+		return;
+	}
+}
+
+/*
+ * Records a change of the model, applied now if no worker holds the keys
+ */
+static void
+search_edit_keys(GelUISearch *self, KeyEditType type, guint index, GtkTreeIter *iter)
+{
+	GelUISearchPrivate *priv = self->priv;
+	KeySet *keys = priv->keys;
+	if (keys == NULL)
+		return;
+
+	// Rows past the ones read so far are read later
+	if (priv->collect_id && (index >= keys->keys->len))
+		return;
+
+	KeyEdit edit = { type, index, iter ? search_row_text(self, iter) : NULL };
+	if (keys->ref > 1)
+		g_queue_push_tail(priv->edits, g_memdup(&edit, sizeof(KeyEdit)));
+	else
+		keyset_edit(keys, &edit);
+}
+
+static void
+search_flush_edits(GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+	if (!priv->keys || (priv->keys->ref > 1))
+		return;
+
+	KeyEdit *edit;
+	while ((edit = g_queue_pop_head(priv->edits)) != NULL)
+	{
+		keyset_edit(priv->keys, edit);
+		key_edit_free(edit);
+	}
+}
+
+static gboolean
+search_collect_cb(GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+	KeySet *keys = priv->keys;
+
+	GtkTreeIter iter;
+	gboolean valid = gtk_tree_model_iter_nth_child(priv->model, &iter, NULL, keys->keys->len);
+	for (guint i = 0; valid && (i < COLLECT_CHUNK); i++)
+	{
+		g_ptr_array_add(keys->keys,  NULL);
+		g_ptr_array_add(keys->texts, search_row_text(self, &iter));
+		valid = gtk_tree_model_iter_next(priv->model, &iter);
+	}
+	if (valid)
+		return TRUE;
+
+	priv->collect_id = 0;
+	if (priv->run_pending)
+		search_run(self);
+	return FALSE;
+}
+
+/*
+ * Drops the keys and starts reading them again from the current model
+ */
+static void
+search_reset_keys(GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+
+	if (priv->collect_id)
+	{
+		g_source_remove(priv->collect_id);
+		priv->collect_id = 0;
+	}
+	gel_free_and_invalidate(priv->keys,   NULL, keyset_unref);
+	gel_free_and_invalidate(priv->scores, NULL, g_array_unref);
+	if (priv->edits)
+	{
+		g_queue_foreach(priv->edits, (GFunc) key_edit_free, NULL);
+		g_queue_clear(priv->edits);
+	}
+	priv->generation++;
+
+	if (priv->model == NULL)
+		return;
+
+	gint n_rows = gtk_tree_model_iter_n_children(priv->model, NULL);
+	priv->keys = g_new0(KeySet, 1);
+	priv->keys->ref   = 1;
+	priv->keys->keys  = g_ptr_array_sized_new(n_rows);
+	priv->keys->texts = g_ptr_array_sized_new(n_rows);
+	priv->collect_id = g_idle_add_full(G_PRIORITY_LOW, (GSourceFunc) search_collect_cb, self, NULL);
+}
+
+/*
+ * Jobs
+ */
+static void
+search_job_free(SearchJob *job)
+{
+	keyset_unref(job->keys);
+	g_hash_table_destroy(job->changed);
+	gel_free_and_invalidate(job->scores, NULL, g_array_unref);
+	gel_matcher_free(job->matcher);
+	g_object_unref(job->self);
+	g_free(job);
+}
+
+static void
+search_apply(GelUISearch *self, SearchJob *job)
+{
+	GelUISearchPrivate *priv = self->priv;
+
+	// Scores are in place before the filter and views sorted by them update
+	gel_free_and_invalidate(priv->scores, NULL, g_array_unref);
+	priv->scores = job->scores;
+	job->scores  = NULL;
+
+	priv->applying = job;
+	gtk_tree_model_filter_refilter(priv->filter);
+	priv->applying = NULL;
+
+	g_signal_emit(self, search_signals[UPDATED], 0);
+}
+
+static gboolean
+search_job_done_cb(SearchJob *job)
+{
+	GelUISearch *self = job->self;
+	GelUISearchPrivate *priv = self->priv;
+
+	g_object_ref(self);
+	if ((priv->job == job) && !g_atomic_int_get(&job->cancelled))
+	{
+		priv->job = NULL;
+
+		// Rows were inserted or removed while matching, indexes don't match
+		if (job->generation != priv->generation)
+			priv->run_pending = TRUE;
+		else
+			search_apply(self, job);
+	}
+	search_job_free(job);
+
+	// Keys are released, catch up with the model
+	search_flush_edits(self);
+	if (priv->run_pending && !priv->job && priv->matcher && priv->filter)
+		search_run(self);
+	g_object_unref(self);
+
+	return FALSE;
+}
+
+static gpointer
+search_worker(SearchJob *job)
+{
+	GPtrArray *keys  = job->keys->keys;
+	GPtrArray *texts = job->keys->texts;
+
+	guint n = keys->len;
+	job->scores = g_array_sized_new(FALSE, TRUE, sizeof(gint), n);
+	g_array_set_size(job->scores, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		if ((i % CANCEL_CHECK_INTERVAL == 0) && g_atomic_int_get(&job->cancelled))
+			break;
+
+		GelMatchKey *key = g_ptr_array_index(keys, i);
+		if (key == NULL)
+		{
+			key = gel_match_key_new(g_ptr_array_index(texts, i));
+			g_free(g_ptr_array_index(texts, i));
+			g_ptr_array_index(texts, i) = NULL;
+			g_ptr_array_index(keys,  i) = key;
+		}
+		g_array_index(job->scores, gint, i) = gel_matcher_score(job->matcher, key);
+	}
+
+	g_idle_add((GSourceFunc) search_job_done_cb, job);
+	return NULL;
+}
+
+static void
+search_cancel(GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+
+	priv->run_pending = FALSE;
+	if (priv->timeout_id)
+	{
+		g_source_remove(priv->timeout_id);
+		priv->timeout_id = 0;
+	}
+
+	// The job frees itself from the main loop
+	if (priv->job)
+	{
+		g_atomic_int_set(&priv->job->cancelled, 1);
+		priv->job = NULL;
+	}
+}
+
+static void
+search_run(GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+
+	search_cancel(self);
+	g_return_if_fail(priv->matcher != NULL);
+	g_return_if_fail(priv->filter  != NULL);
+
+	// Keys are still being read, or a cancelled worker still holds them.
+	// Either one runs the match when done.
+	if (priv->collect_id || (priv->keys->ref > 1))
+	{
+		priv->run_pending = TRUE;
+		return;
+	}
+
+	SearchJob *job = g_new0(SearchJob, 1);
+	job->self       = g_object_ref(self);
+	job->keys       = priv->keys;
+	job->matcher    = gel_matcher_new(gel_matcher_get_query(priv->matcher));
+	job->generation = priv->generation;
+	job->changed    = g_hash_table_new(g_direct_hash, g_direct_equal);
+	priv->keys->ref++;
+	priv->job = job;
+
+	GError *error = NULL;
+	if (!g_thread_supported() || !g_thread_create((GThreadFunc) search_worker, job, FALSE, &error))
+	{
+		if (error)
+		{
+			g_warning("Unable to create search thread: %s", error->message);
+			g_error_free(error);
+		}
+		search_worker(job);
+	}
+}
+
+static gboolean
+search_timeout_cb(GelUISearch *self)
+{
+	self->priv->timeout_id = 0;
+	search_run(self);
+	return FALSE;
+}
+
+/*
+ * Visibility
+ */
+static gboolean
+search_visible_func(GtkTreeModel *model, GtkTreeIter *iter, GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+	if (priv->matcher == NULL)
+		return TRUE;
+
+	SearchJob *job = priv->applying;
+	if (job && priv->scores)
+	{
+		GtkTreePath *path = gtk_tree_model_get_path(model, iter);
+		guint index = gtk_tree_path_get_indices(path)[0];
+		gtk_tree_path_free(path);
+
+		if (index < priv->scores->len)
+		{
+			// Rows changed while matching are scored again
+			if (g_hash_table_lookup(job->changed, GUINT_TO_POINTER(index + 1)))
+				g_array_index(priv->scores, gint, index) = search_row_score(self, iter);
+			return g_array_index(priv->scores, gint, index) >= 0;
+		}
+	}
+
+	// Row is unknown to the last match, test it directly
+	return search_row_score(self, iter) >= 0;
+}
+
+static gint
+search_row_score(GelUISearch *self, GtkTreeIter *iter)
+{
+	gchar *text = search_row_text(self, iter);
+	GelMatchKey *key = gel_match_key_new(text);
+	gint ret = gel_matcher_score(self->priv->matcher, key);
+	gel_match_key_free(key);
+	g_free(text);
+
+	return ret;
+}
+
+/*
+ * Model tracking
+ */
+static void
+model_row_inserted_cb(GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+	guint index = gtk_tree_path_get_indices(path)[0];
+
+	priv->generation++;
+	search_edit_keys(self, KEY_EDIT_INSERT, index, iter);
+
+	if (priv->scores && (index <= priv->scores->len))
+	{
+		gint score = priv->matcher ? search_row_score(self, iter) : -1;
+		g_array_insert_val(priv->scores, index, score);
+	}
+}
+
+static void
+model_row_deleted_cb(GtkTreeModel *model, GtkTreePath *path, GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+	guint index = gtk_tree_path_get_indices(path)[0];
+
+	priv->generation++;
+	search_edit_keys(self, KEY_EDIT_DELETE, index, NULL);
+
+	if (priv->scores && (index < priv->scores->len))
+		g_array_remove_index(priv->scores, index);
+}
+
+static void
+model_row_changed_cb(GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, GelUISearch *self)
+{
+	GelUISearchPrivate *priv = self->priv;
+	guint index = gtk_tree_path_get_indices(path)[0];
+
+	// Don't let a running match overwrite the state of this row
+	if (priv->job)
+		g_hash_table_insert(priv->job->changed, GUINT_TO_POINTER(index + 1), GUINT_TO_POINTER(1));
+
+	search_edit_keys(self, KEY_EDIT_CHANGE, index, iter);
+
+	if (priv->scores && priv->matcher && (index < priv->scores->len))
+		g_array_index(priv->scores, gint, index) = search_row_score(self, iter);
+}
+
+static void
+model_rows_reordered_cb(GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer new_order, GelUISearch *self)
+{
+	search_reset_keys(self);
+}
@@ -0,0 +1,77 @@
+/*
+ * gel/gel-ui-search.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GEL_UI_SEARCH
+#define _GEL_UI_SEARCH
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GEL_UI_TYPE_SEARCH gel_ui_search_get_type()
+
+#define GEL_UI_SEARCH(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEL_UI_TYPE_SEARCH, GelUISearch))
+#define GEL_UI_SEARCH_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass),  GEL_UI_TYPE_SEARCH, GelUISearchClass))
+#define GEL_UI_IS_SEARCH(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEL_UI_TYPE_SEARCH))
+#define GEL_UI_IS_SEARCH_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  GEL_UI_TYPE_SEARCH))
+#define GEL_UI_SEARCH_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEL_UI_TYPE_SEARCH, GelUISearchClass))
+
+typedef struct _GelUISearchPrivate GelUISearchPrivate;
+typedef struct {
+	GObject parent;
+	GelUISearchPrivate *priv;
+} GelUISearch;
+
+typedef struct {
+	GObjectClass parent_class;
+	void (*updated) (GelUISearch *self);
+} GelUISearchClass;
+
+/**
+ * GelUISearchKeyFunc:
+ * @model: The child model of the filter
+ * @iter: A row of @model
+ * @data: User data
+ *
+ * Builds the text matched against the query for a row
+ *
+ * Returns: (transfer full): The text or %NULL
+ */
+typedef gchar* (*GelUISearchKeyFunc) (GtkTreeModel *model, GtkTreeIter *iter, gpointer data);
+
+GType gel_ui_search_get_type (void);
+
+GelUISearch* gel_ui_search_new (GtkTreeModelFilter *filter, gint column);
+
+void gel_ui_search_set_filter(GelUISearch *self, GtkTreeModelFilter *filter);
+
+void         gel_ui_search_set_query(GelUISearch *self, const gchar *query);
+const gchar* gel_ui_search_get_query(GelUISearch *self);
+
+void gel_ui_search_set_key_func(GelUISearch *self, GelUISearchKeyFunc func, gpointer data, GDestroyNotify notify);
+
+void  gel_ui_search_set_delay(GelUISearch *self, guint msecs);
+guint gel_ui_search_get_delay(GelUISearch *self);
+
+gint gel_ui_search_get_score(GelUISearch *self, GtkTreeIter *iter);
+
+G_END_DECLS
+
+#endif /* _GEL_UI_SEARCH */
@@ -26,6 +26,8 @@
 #include <gel/gel-ui-generic.h>
 #include <gel/gel-ui-utils.h>
 #include <gel/gel-ui-scale.h>
+#include <gel/gel-ui-model-filler.h>
+#include <gel/gel-ui-search.h>
 
 #endif
 
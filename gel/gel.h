@@ -26,6 +26,7 @@
 
 #include <gel/gel-marshallers.h>
 #include <gel/gel-misc.h>
+#include <gel/gel-matcher.h>
 #include <gel/gel-str-parser.h>
 
 #endif // _GEL_H
@@ -177,7 +177,6 @@ lomo_em_art_backend_run_real(backend_run_t *pack)
 
 	LomoEMArtBackend *backend = pack->backend;
 	LomoEMArtSearch  *search  = pack->search;
-	g_free(pack);
 
 	g_return_val_if_fail(LOMO_IS_EM_ART_BACKEND(backend), FALSE);
 	g_return_val_if_fail(LOMO_IS_EM_ART_SEARCH(search), FALSE);
@@ -221,7 +220,8 @@ lomo_em_art_backend_run(LomoEMArtBackend *backend, LomoEMArtSearch *search)
 
 	g_hash_table_insert(priv->dict,
 		search,
-		GUINT_TO_POINTER(g_idle_add((GSourceFunc) lomo_em_art_backend_run_real, pack)));
+		GUINT_TO_POINTER(g_idle_add_full(G_PRIORITY_DEFAULT_IDLE,
+			(GSourceFunc) lomo_em_art_backend_run_real, pack, g_free)));
 }
 
 /**
@@ -247,10 +247,11 @@ lomo_em_art_backend_cancel(LomoEMArtBackend *backend, LomoEMArtSearch *search)
 
 	LomoEMArtBackendPrivate *priv = GET_PRIVATE(backend);
 
-	gpointer pstate = g_hash_table_lookup(priv->dict, search);
-	g_return_if_fail(pstate == NULL);
+	gpointer pstate = NULL;
+	g_return_if_fail(g_hash_table_lookup_extended(priv->dict, search, NULL, &pstate));
 
-	// Real job
+	// Real job: a search scheduled but not yet started only needs to remove
+	// its idle source, running ones are cancelled by the backend
 	guint state = GPOINTER_TO_UINT(pstate);
 	if (state > 0)
 		g_source_remove(state);
@@ -43,25 +43,48 @@ static gchar *_infolder_regexes_str[] = {
 };
 static GRegex *_infolder_regexes[4] = { NULL };
 
-void
-lomo_em_art_infolder_sync_backend_search(LomoEMArtBackend *backend, LomoEMArtSearch *search, gpointer data)
+static void
+infolder_regexes_init(void)
 {
-	// Create regexes
-	if (_infolder_regexes[0] == NULL)
+	if (_infolder_regexes[0] != NULL)
+		return;
+
+	for (guint i = 0; _infolder_regexes_str[i] != NULL; i++)
 	{
-		for (guint i = 0; _infolder_regexes_str[i] != NULL; i++)
+		GError *error = NULL;
+		_infolder_regexes[i] = g_regex_new(_infolder_regexes_str[i],
+			G_REGEX_CASELESS|G_REGEX_DOTALL|G_REGEX_DOLLAR_ENDONLY|G_REGEX_OPTIMIZE|G_REGEX_NO_AUTO_CAPTURE,
+			0, &error);
+		if (!_infolder_regexes[i])
 		{
-			GError *error = NULL;
-			_infolder_regexes[i] = g_regex_new(_infolder_regexes_str[i],
-				G_REGEX_CASELESS|G_REGEX_DOTALL|G_REGEX_DOLLAR_ENDONLY|G_REGEX_OPTIMIZE|G_REGEX_NO_AUTO_CAPTURE,
-				0, &error);
-			if (!_infolder_regexes[i])
-			{
-				g_warning(N_("Unable to compile regex '%s': %s"), _infolder_regexes_str[i], error->message);
-				g_error_free(error);
-			}
+			g_warning(N_("Unable to compile regex '%s': %s"), _infolder_regexes_str[i], error->message);
+			g_error_free(error);
 		}
 	}
+}
+
+/*
+ * infolder_score:
+ * @name: Filename to check
+ * @best: Score to beat
+ *
+ * Returns: Score for @name (lower is better) or G_MAXINT if @name is not
+ *          better than @best
+ */
+static gint
+infolder_score(const gchar *name, gint best)
+{
+	// Regexes are sorted by preference, only check the ones that can win
+	for (gint i = 0; (i < G_N_ELEMENTS(_infolder_regexes)) && (i < best); i++)
+		if (_infolder_regexes[i] && g_regex_match(_infolder_regexes[i], name, 0, NULL))
+			return i;
+	return G_MAXINT;
+}
+
+void
+lomo_em_art_infolder_sync_backend_search(LomoEMArtBackend *backend, LomoEMArtSearch *search, gpointer data)
+{
+	infolder_regexes_init();
 
 	LomoStream *stream = lomo_em_art_search_get_stream(search);
 	const gchar *uri = lomo_stream_get_uri(stream);
@@ -100,15 +123,13 @@ lomo_em_art_infolder_sync_backend_search(LomoEMArtBackend *backend, LomoEMArtSea
 	GList *iter = children;
 	gchar *winner = NULL;
 	gint score = G_MAXINT;
-	while (iter)
+	while (iter && (score > 0))
 	{
-		for (guint i = 0; i < G_N_ELEMENTS(_infolder_regexes); i++)
+		gint s = infolder_score((gchar *) iter->data, score);
+		if (s < score)
 		{
-			if (_infolder_regexes[i] && g_regex_match(_infolder_regexes[i], (gchar *) iter->data, 0, NULL) && (score > i))
-			{
-				winner = iter->data;
-				score = i;
-			}
+			winner = iter->data;
+			score = s;
 		}
 		iter = iter->next;
 	}
@@ -135,6 +156,299 @@ lomo_em_art_infolder_sync_backend_search(LomoEMArtBackend *backend, LomoEMArtSea
 	lomo_em_art_backend_finish(backend, search);
 }
 
+// --
+// infolder (async) backend
+// --
+
+// Number of directory results to remember, covers for an album are requested
+// once per track so this only needs to be larger than the number of albums
+// in flight
+#define INFOLDER_MEMO_SIZE 128
+#define INFOLDER_BATCH_SIZE 64
+
+typedef struct {
+	LomoEMArtBackend *backend;
+	LomoEMArtSearch  *search;
+} InfolderWaiter;
+
+typedef struct {
+	gchar        *key;         // URI of the directory
+	GFile        *dir;
+	GCancellable *cancellable;
+	GList        *waiters;     // InfolderWaiter
+	gchar        *winner;
+	gint          score;
+} InfolderScan;
+
+static GHashTable *_infolder_scans = NULL; // key -> InfolderScan
+static GHashTable *_infolder_memo  = NULL; // key -> winner URI or ""
+static GQueue     *_infolder_memo_keys = NULL;
+
+static void infolder_enumerate_cb (GFile *dir, GAsyncResult *res, InfolderScan *scan);
+static void infolder_next_files_cb(GFileEnumerator *e, GAsyncResult *res, InfolderScan *scan);
+
+static void
+infolder_finish_search(LomoEMArtBackend *backend, LomoEMArtSearch *search, const gchar *cover_uri)
+{
+	if (cover_uri && cover_uri[0])
+	{
+		GValue v = { 0 };
+		g_value_set_static_string(g_value_init(&v, G_TYPE_STRING), cover_uri);
+		lomo_em_art_search_set_result(search, &v);
+		g_value_reset(&v);
+	}
+	lomo_em_art_backend_finish(backend, search);
+}
+
+static void
+infolder_memo_store(const gchar *key, const gchar *cover_uri)
+{
+	if (_infolder_memo == NULL)
+	{
+		_infolder_memo = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+		_infolder_memo_keys = g_queue_new();
+	}
+
+	if (g_hash_table_lookup(_infolder_memo, key))
+		return;
+
+	// Forget the oldest directory
+	if (g_queue_get_length(_infolder_memo_keys) >= INFOLDER_MEMO_SIZE)
+		g_hash_table_remove(_infolder_memo, g_queue_pop_head(_infolder_memo_keys));
+
+	gchar *k = g_strdup(key);
+	g_hash_table_insert(_infolder_memo, k, g_strdup(cover_uri ? cover_uri : ""));
+	g_queue_push_tail(_infolder_memo_keys, k);
+}
+
+static void
+infolder_scan_free(InfolderScan *scan)
+{
+	// Cancelled scans are already out of the table and a new scan for the
+	// same folder may be there
+	if (g_hash_table_lookup(_infolder_scans, scan->key) == scan)
+		g_hash_table_remove(_infolder_scans, scan->key);
+
+	// Nobody should be waiting at this point, but never leave a search
+	// unfinished
+	GList *waiters = scan->waiters;
+	scan->waiters = NULL;
+	for (GList *l = waiters; l != NULL; l = l->next)
+	{
+		InfolderWaiter *w = (InfolderWaiter *) l->data;
+		lomo_em_art_backend_finish(w->backend, w->search);
+	}
+	gel_list_deep_free(waiters, g_free);
+
+	g_object_unref(scan->cancellable);
+	g_object_unref(scan->dir);
+	g_free(scan->winner);
+	g_free(scan->key);
+	g_free(scan);
+}
+
+static void
+infolder_scan_done(InfolderScan *scan)
+{
+	gchar *cover_uri = NULL;
+	if (scan->winner)
+	{
+		GFile *f = g_file_get_child(scan->dir, scan->winner);
+		cover_uri = g_file_get_uri(f);
+		g_object_unref(f);
+	}
+	infolder_memo_store(scan->key, cover_uri);
+
+	// Detach waiters before finishing, finish can start new searches
+	GList *waiters = scan->waiters;
+	scan->waiters = NULL;
+	infolder_scan_free(scan);
+
+	for (GList *l = waiters; l != NULL; l = l->next)
+	{
+		InfolderWaiter *w = (InfolderWaiter *) l->data;
+		infolder_finish_search(w->backend, w->search, cover_uri);
+	}
+	gel_list_deep_free(waiters, g_free);
+	g_free(cover_uri);
+}
+
+static void
+infolder_enumerate_cb(GFile *dir, GAsyncResult *res, InfolderScan *scan)
+{
+	GError *error = NULL;
+	GFileEnumerator *e = g_file_enumerate_children_finish(dir, res, &error);
+	if (e == NULL)
+	{
+		if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			infolder_scan_free(scan);
+		else
+			infolder_scan_done(scan);
+		g_error_free(error);
+		return;
+	}
+
+	g_file_enumerator_next_files_async(e, INFOLDER_BATCH_SIZE, G_PRIORITY_LOW, scan->cancellable,
+		(GAsyncReadyCallback) infolder_next_files_cb, scan);
+}
+
+static void
+infolder_next_files_cb(GFileEnumerator *e, GAsyncResult *res, InfolderScan *scan)
+{
+	GError *error = NULL;
+	GList *infos = g_file_enumerator_next_files_finish(e, res, &error);
+
+	if (error != NULL)
+	{
+		gboolean cancelled = g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+		g_error_free(error);
+		g_file_enumerator_close_async(e, G_PRIORITY_LOW, NULL, NULL, NULL);
+		g_object_unref(e);
+		if (cancelled)
+			infolder_scan_free(scan);
+		else
+			infolder_scan_done(scan);
+		return;
+	}
+
+	for (GList *l = infos; l != NULL; l = l->next)
+	{
+		const gchar *name = g_file_info_get_name(G_FILE_INFO(l->data));
+		gint s = infolder_score(name, scan->score);
+		if (s < scan->score)
+		{
+			g_free(scan->winner);
+			scan->winner = g_strdup(name);
+			scan->score  = s;
+		}
+	}
+	gboolean eof = (infos == NULL);
+	gel_list_deep_free(infos, g_object_unref);
+
+	// Nothing can beat a perfect match, stop reading
+	if (eof || (scan->score == 0))
+	{
+		g_file_enumerator_close_async(e, G_PRIORITY_LOW, NULL, NULL, NULL);
+		g_object_unref(e);
+		infolder_scan_done(scan);
+		return;
+	}
+
+	g_file_enumerator_next_files_async(e, INFOLDER_BATCH_SIZE, G_PRIORITY_LOW, scan->cancellable,
+		(GAsyncReadyCallback) infolder_next_files_cb, scan);
+}
+
+/**
+ * lomo_em_art_infolder_backend_search:
+ * @backend: A #LomoEMArtBackend
+ * @search: A #LomoEMArtSearch
+ * @data: Unused
+ *
+ * Asynchronous version of lomo_em_art_infolder_sync_backend_search(). The
+ * stream's folder is enumerated with GIO without blocking the main loop and
+ * the result is remembered per folder, so all the streams from the same album
+ * share a single scan.
+ */
+void
+lomo_em_art_infolder_backend_search(LomoEMArtBackend *backend, LomoEMArtSearch *search, gpointer data)
+{
+	infolder_regexes_init();
+	if (_infolder_scans == NULL)
+		_infolder_scans = g_hash_table_new(g_str_hash, g_str_equal);
+
+	LomoStream *stream = lomo_em_art_search_get_stream(search);
+	GFile *file = g_file_new_for_uri(lomo_stream_get_uri(stream));
+
+	// Only local files have a meaningful folder
+	GFile *dir = g_file_has_uri_scheme(file, "file") ? g_file_get_parent(file) : NULL;
+	g_object_unref(file);
+	if (dir == NULL)
+	{
+		lomo_em_art_backend_finish(backend, search);
+		return;
+	}
+
+	gchar *key = g_file_get_uri(dir);
+
+	// Folder was already scanned
+	const gchar *memo = _infolder_memo ? g_hash_table_lookup(_infolder_memo, key) : NULL;
+	if (memo != NULL)
+	{
+		debug("Folder %s is memoized: '%s'", key, memo);
+		g_object_unref(dir);
+		g_free(key);
+		infolder_finish_search(backend, search, memo);
+		return;
+	}
+
+	InfolderWaiter *w = g_new0(InfolderWaiter, 1);
+	w->backend = backend;
+	w->search  = search;
+
+	// Folder scan is in progress, join it
+	InfolderScan *scan = g_hash_table_lookup(_infolder_scans, key);
+	if (scan != NULL)
+	{
+		scan->waiters = g_list_prepend(scan->waiters, w);
+		g_object_unref(dir);
+		g_free(key);
+		return;
+	}
+
+	scan = g_new0(InfolderScan, 1);
+	scan->key         = key;
+	scan->dir         = dir;
+	scan->cancellable = g_cancellable_new();
+	scan->waiters     = g_list_prepend(NULL, w);
+	scan->score       = G_MAXINT;
+	g_hash_table_insert(_infolder_scans, scan->key, scan);
+
+	g_file_enumerate_children_async(dir, G_FILE_ATTRIBUTE_STANDARD_NAME,
+		G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW, scan->cancellable,
+		(GAsyncReadyCallback) infolder_enumerate_cb, scan);
+}
+
+/**
+ * lomo_em_art_infolder_backend_cancel:
+ * @backend: A #LomoEMArtBackend
+ * @search: A #LomoEMArtSearch
+ * @data: Unused
+ *
+ * Cancels @search started with lomo_em_art_infolder_backend_search(). The
+ * underlying folder scan is stopped only if no other search is waiting for it.
+ */
+void
+lomo_em_art_infolder_backend_cancel(LomoEMArtBackend *backend, LomoEMArtSearch *search, gpointer data)
+{
+	if (_infolder_scans == NULL)
+		return;
+
+	GHashTableIter iter;
+	InfolderScan *scan;
+	g_hash_table_iter_init(&iter, _infolder_scans);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *) &scan))
+	{
+		for (GList *l = scan->waiters; l != NULL; l = l->next)
+		{
+			InfolderWaiter *w = (InfolderWaiter *) l->data;
+			if (w->search != search)
+				continue;
+
+			scan->waiters = g_list_delete_link(scan->waiters, l);
+			g_free(w);
+
+			// Scan will be freed from its callback. Take it out of the table
+			// now so new searches for this folder don't join a dead scan
+			if (scan->waiters == NULL)
+			{
+				g_hash_table_iter_remove(&iter);
+				g_cancellable_cancel(scan->cancellable);
+			}
+			return;
+		}
+	}
+}
+
 void
 lomo_em_art_embeded_metadata_backend_search(LomoEMArtBackend *backend, LomoEMArtSearch *search, gpointer data)
 {
@@ -163,7 +477,11 @@ lomo_em_art_embeded_metadata_backend_search(LomoEMArtBackend *backend, LomoEMArt
 		if (!g_str_has_prefix(gst_structure_get_name(s), "image/"))
 			continue;
 
-		GInputStream *stream = g_memory_input_stream_new_from_data (g_memdup(buffer->data, buffer->size), buffer->size, g_free);
+		// Wrap buffer memory without copying it, the stream owns a reference
+		// to the buffer so data outlives the tag
+		GInputStream *stream = g_memory_input_stream_new_from_data (buffer->data, buffer->size, NULL);
+		g_object_set_data_full((GObject *) stream, "lomo-em-art-buffer",
+			gst_buffer_ref(buffer), (GDestroyNotify) gst_buffer_unref);
 
 		GValue v = { 0 };
 		g_value_init(&v, G_TYPE_INPUT_STREAM);
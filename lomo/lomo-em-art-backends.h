@@ -24,6 +24,10 @@
 
 void lomo_em_art_infolder_sync_backend_search(LomoEMArtBackend *backend,
 	LomoEMArtSearch *search, gpointer data);
+void lomo_em_art_infolder_backend_search(LomoEMArtBackend *backend,
+	LomoEMArtSearch *search, gpointer data);
+void lomo_em_art_infolder_backend_cancel(LomoEMArtBackend *backend,
+	LomoEMArtSearch *search, gpointer data);
 void lomo_em_art_embeded_metadata_backend_search(LomoEMArtBackend *backend,
 	LomoEMArtSearch *search, gpointer data);
 
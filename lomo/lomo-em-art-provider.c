@@ -26,6 +26,7 @@ enum {
 	COVER_N_STRINGS
 };
 static gchar *cover_strings[COVER_N_STRINGS] = { NULL };
+static gboolean drop_embedded_tags = FALSE;
 
 static void lomo_weak_ref_cb(LomoEMArtProvider *self, LomoPlayer *lomo);
 
@@ -69,7 +70,7 @@ lomo_em_art_provider_init (LomoEMArtProvider *self)
 	LomoEMArtClass *art_class = LOMO_EM_ART_CLASS(G_OBJECT_GET_CLASS(self->priv->art));
 
 	lomo_em_art_class_add_backend(art_class, "infolder",
-		lomo_em_art_infolder_sync_backend_search, NULL,
+		lomo_em_art_infolder_backend_search, lomo_em_art_infolder_backend_cancel,
 		NULL, NULL);
 	lomo_em_art_class_add_backend(art_class, "embeded",
 		lomo_em_art_embeded_metadata_backend_search, NULL,
@@ -126,6 +127,33 @@ lomo_em_art_provider_set_loading_cover(const gchar *loading_uri)
 	cover_strings[LOADING_COVER] = g_strdup(loading_uri);
 }
 
+/**
+ * lomo_em_art_provider_set_drop_embedded_tags:
+ * @drop: Whether to drop tags
+ *
+ * If @drop is %TRUE raw image tags ("image" and "preview-image") are removed
+ * from streams once their art has been resolved from them. The art data keeps
+ * a reference to the image so it is held in memory only once.
+ */
+void
+lomo_em_art_provider_set_drop_embedded_tags(gboolean drop)
+{
+	drop_embedded_tags = drop;
+}
+
+/**
+ * lomo_em_art_provider_get_drop_embedded_tags:
+ *
+ * See lomo_em_art_provider_set_drop_embedded_tags()
+ *
+ * Returns: %TRUE if raw image tags are dropped
+ */
+gboolean
+lomo_em_art_provider_get_drop_embedded_tags(void)
+{
+	return drop_embedded_tags;
+}
+
 /**
  * lomo_em_art_provider_get_default_cover:
  *
@@ -233,6 +261,13 @@ art_search_cb(LomoEMArtSearch *search, gpointer data)
 	if (res)
 	{
 		lomo_stream_set_extended_metadata(stream, LOMO_STREAM_EM_ART_DATA, res);
+
+		// Only the embedded backend produces input streams
+		if (drop_embedded_tags && G_VALUE_HOLDS(res, G_TYPE_INPUT_STREAM))
+		{
+			lomo_stream_set_tag(stream, "image", NULL);
+			lomo_stream_set_tag(stream, "preview-image", NULL);
+		}
 	}
 	else
 	{
@@ -34,6 +34,9 @@ void lomo_em_art_provider_set_loading_cover(const gchar *loading_uri);
 const gchar *lomo_em_art_provider_get_default_cover(void);
 const gchar *lomo_em_art_provider_get_loading_cover(void);
 
+void     lomo_em_art_provider_set_drop_embedded_tags(gboolean drop);
+gboolean lomo_em_art_provider_get_drop_embedded_tags(void);
+
 /**
  * LOMO_STREAM_EM_ART_DATA:
  *
@@ -263,7 +263,7 @@ void
 lomo_em_art_cancel(LomoEMArt *art, LomoEMArtSearch *search)
 {
 	g_return_if_fail(LOMO_IS_EM_ART(art));
-	g_return_if_fail(LOMO_IS_EM_ART(search));
+	g_return_if_fail(LOMO_IS_EM_ART_SEARCH(search));
 
 	g_return_if_fail(art == LOMO_EM_ART(lomo_em_art_search_get_domain(search)));
 
@@ -272,7 +272,7 @@ lomo_em_art_cancel(LomoEMArt *art, LomoEMArtSearch *search)
 	LomoEMArtBackend *backend   = LOMO_EM_ART_BACKEND(((GList *)lomo_em_art_search_get_bpointer(search))->data);
 
 	g_return_if_fail(LOMO_IS_EM_ART_BACKEND(backend));
-	g_return_if_fail(g_list_find(art_class->priv->backends, backend) == NULL);
+	g_return_if_fail(g_list_find(art_class->priv->backends, backend) != NULL);
 
 	lomo_em_art_backend_cancel(backend, search);
 	priv->searches = g_list_remove(priv->searches, search);
@@ -94,6 +94,18 @@ void tag_cb
 	g_free(t);
 }
 
+void tags_changed_cb
+(LomoPlayer *self, LomoStream *stream, GArray *tags)
+{
+	gchar *t = format_stream(stream);
+	GString *str = g_string_new(NULL);
+	for (guint i = 0; i < tags->len; i++)
+		g_string_append_printf(str, "%s[%s]", i ? " " : "", g_quark_to_string(g_array_index(tags, GQuark, i)));
+	g_debug("tags-changed event [%s] %s", t, str->str);
+	g_string_free(str, TRUE);
+	g_free(t);
+}
+
 void all_tags_cb
 (LomoPlayer *self, LomoStream *stream)
 {
@@ -180,6 +192,7 @@ lomo_player_start_logger(LomoPlayer *lomo)
 		{ "queue-clear", (GCallback) queue_clear_cb},
 		{ "error", (GCallback) error_cb},
 		{ "tag", (GCallback) tag_cb},
+		{ "tags-changed", (GCallback) tags_changed_cb},
 		{ "all-tags", (GCallback) all_tags_cb},
 		{ "pre-change", (GCallback) pre_change_cb },
 		{ "change", (GCallback) change_cb}
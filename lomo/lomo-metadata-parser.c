@@ -36,17 +36,28 @@ G_DEFINE_TYPE (LomoMetadataParser, lomo_metadata_parser, G_TYPE_OBJECT)
 enum
 {
 	TAG,
+	TAGS_CHANGED,
 	ALL_TAGS,
 	LAST_SIGNAL
 };
 guint lomo_metadata_parser_signals[LAST_SIGNAL] = { 0 };
 
+enum
+{
+	PROP_0,
+	PROP_COALESCE
+};
+
 static gboolean
 bus_watcher(GstBus *bus, GstMessage *message, LomoMetadataParser *self);
 static void
 foreach_tag_cb(const GstTagList *list, const gchar *tag, LomoMetadataParser *self);
 static gboolean
 run_queue(LomoMetadataParser *self);
+static void
+tag_changed(LomoMetadataParser *self, const gchar *tag);
+static void
+flush_changed_tags(LomoMetadataParser *self);
 
 struct _LomoMetadataParserPrivate {
 	GstElement *pipeline; // Our processing pipeline
@@ -61,8 +72,65 @@ struct _LomoMetadataParserPrivate {
 	// Watchers
 	guint       bus_id;
 	guint       idle_id;
+
+	// Coalescing of tag notifications
+	LomoMetadataParserCoalesce coalesce;
+	GArray                    *changed; // GQuarks of pending tags
 };
 
+/**
+ * LomoMetadataParserCoalesceEnumType
+ */
+GType
+lomo_metadata_parser_coalesce_get_type(void)
+{
+	static GType etype = 0;
+	if (etype == 0)
+	{
+		static const GEnumValue values[] =
+		{
+			{ LOMO_METADATA_PARSER_COALESCE_NONE,    "LOMO_METADATA_PARSER_COALESCE_NONE",    "none"    },
+			{ LOMO_METADATA_PARSER_COALESCE_MESSAGE, "LOMO_METADATA_PARSER_COALESCE_MESSAGE", "message" },
+			{ LOMO_METADATA_PARSER_COALESCE_STREAM,  "LOMO_METADATA_PARSER_COALESCE_STREAM",  "stream"  },
+			{ 0, NULL, NULL }
+		};
+		etype = g_enum_register_static ("LomoMetadataParserCoalesce", values);
+	}
+	return etype;
+}
+
+static void
+lomo_metadata_parser_get_property (GObject *object, guint property_id, GValue *value, GParamSpec *pspec)
+{
+	LomoMetadataParser *self = LOMO_METADATA_PARSER(object);
+
+	switch (property_id)
+	{
+	case PROP_COALESCE:
+		g_value_set_enum(value, lomo_metadata_parser_get_coalesce(self));
+		break;
+
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
+static void
+lomo_metadata_parser_set_property (GObject *object, guint property_id, const GValue *value, GParamSpec *pspec)
+{
+	LomoMetadataParser *self = LOMO_METADATA_PARSER(object);
+
+	switch (property_id)
+	{
+	case PROP_COALESCE:
+		lomo_metadata_parser_set_coalesce(self, g_value_get_enum(value));
+		break;
+
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+	}
+}
+
 static void
 lomo_metadata_parser_dispose (GObject *object)
 {
@@ -80,6 +148,11 @@ lomo_metadata_parser_dispose (GObject *object)
 		g_queue_free(priv->queue);
 		priv->queue = NULL;
 	}
+	if (priv->changed)
+	{
+		g_array_unref(priv->changed);
+		priv->changed = NULL;
+	}
 	if (G_OBJECT_CLASS (lomo_metadata_parser_parent_class)->dispose)
 		G_OBJECT_CLASS (lomo_metadata_parser_parent_class)->dispose(object);
 }
@@ -95,7 +168,9 @@ lomo_metadata_parser_class_init (LomoMetadataParserClass *klass)
 	 * @stream: (type Lomo.Stream): The stream where the tag was found
 	 * @tag: The #LomoTag found
 	 *
-	 * Emitted for every tag found in the @stream
+	 * Emitted for every tag found in the @stream. Not emitted if
+	 * #LomoMetadataParser:coalesce is other than
+	 * %LOMO_METADATA_PARSER_COALESCE_NONE
 	 */
 	lomo_metadata_parser_signals[TAG] =
 		g_signal_new ("tag",
@@ -108,6 +183,27 @@ lomo_metadata_parser_class_init (LomoMetadataParserClass *klass)
 			G_TYPE_OBJECT,
 			G_TYPE_STRING);
 
+	/**
+	 * LomoMetadataParser::tags-changed:
+	 * @parser: The parser
+	 * @stream: (type Lomo.Stream): The stream where tags were found
+	 * @tags: (type GLib.Array) (element-type GQuark): Quarks of the changed
+	 *        tags
+	 *
+	 * Emitted once for every batch of tags found in the @stream, batches are
+	 * defined by #LomoMetadataParser:coalesce
+	 */
+	lomo_metadata_parser_signals[TAGS_CHANGED] =
+		g_signal_new ("tags-changed",
+			G_OBJECT_CLASS_TYPE (object_class), G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET (LomoMetadataParserClass, tags_changed),
+			NULL, NULL,
+			lomo_marshal_VOID__OBJECT_BOXED,
+			G_TYPE_NONE,
+			2,
+			G_TYPE_OBJECT,
+			G_TYPE_ARRAY);
+
 	/**
 	 * LomoMetadataParser::all-tags:
 	 * @parser: The parser
@@ -128,7 +224,19 @@ lomo_metadata_parser_class_init (LomoMetadataParserClass *klass)
 
 	g_type_class_add_private (klass, sizeof (LomoMetadataParserPrivate));
 
-	object_class->dispose = lomo_metadata_parser_dispose;
+	object_class->get_property = lomo_metadata_parser_get_property;
+	object_class->set_property = lomo_metadata_parser_set_property;
+	object_class->dispose      = lomo_metadata_parser_dispose;
+
+	/**
+	 * LomoMetadataParser:coalesce:
+	 *
+	 * How tag discovery is reported, see #LomoMetadataParserCoalesce
+	 */
+	g_object_class_install_property(object_class, PROP_COALESCE,
+		g_param_spec_enum("coalesce", "coalesce", "Tag coalescing mode",
+		LOMO_TYPE_METADATA_PARSER_COALESCE, LOMO_METADATA_PARSER_COALESCE_NONE,
+		G_PARAM_READWRITE|G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -139,6 +247,8 @@ lomo_metadata_parser_init (LomoMetadataParser *self)
 	priv->queue    = g_queue_new();
 	priv->stream   = NULL;
 	priv->failure  = priv->got_state_signal = priv->got_new_clock_signal = FALSE;
+	priv->coalesce = LOMO_METADATA_PARSER_COALESCE_NONE;
+	priv->changed  = g_array_new(FALSE, FALSE, sizeof(GQuark));
 }
 
 /**
@@ -229,6 +339,49 @@ lomo_metadata_parser_clear(LomoMetadataParser *self)
 
 	priv->failure = priv->got_state_signal = priv->got_new_clock_signal = FALSE;
 	priv->stream = NULL;
+	g_array_set_size(priv->changed, 0);
+}
+
+/**
+ * lomo_metadata_parser_get_coalesce:
+ * @self: The parser
+ *
+ * Gets the value of the #LomoMetadataParser:coalesce property
+ *
+ * Returns: The coalescing mode
+ */
+LomoMetadataParserCoalesce
+lomo_metadata_parser_get_coalesce(LomoMetadataParser *self)
+{
+	g_return_val_if_fail(LOMO_IS_METADATA_PARSER(self), LOMO_METADATA_PARSER_COALESCE_NONE);
+	return self->priv->coalesce;
+}
+
+/**
+ * lomo_metadata_parser_set_coalesce:
+ * @self: The parser
+ * @coalesce: A #LomoMetadataParserCoalesce
+ *
+ * Sets how tag discovery is reported. With
+ * %LOMO_METADATA_PARSER_COALESCE_NONE #LomoMetadataParser::tag is emitted for
+ * every tag, other modes group tags and emit
+ * #LomoMetadataParser::tags-changed once per batch.
+ */
+void
+lomo_metadata_parser_set_coalesce(LomoMetadataParser *self, LomoMetadataParserCoalesce coalesce)
+{
+	g_return_if_fail(LOMO_IS_METADATA_PARSER(self));
+	g_return_if_fail(coalesce <= LOMO_METADATA_PARSER_COALESCE_STREAM);
+
+	LomoMetadataParserPrivate *priv = self->priv;
+	if (priv->coalesce == coalesce)
+		return;
+
+	// Don't lose tags pending from the previous mode
+	flush_changed_tags(self);
+
+	priv->coalesce = coalesce;
+	g_object_notify((GObject *) self, "coalesce");
 }
 
 static void
@@ -244,6 +397,7 @@ reset_internals(LomoMetadataParser *self)
 	priv->failure = FALSE;
 	priv->got_state_signal = FALSE;
 	priv->got_new_clock_signal = FALSE;
+	g_array_set_size(priv->changed, 0);
 
 	/* Generate pipeline */
 	priv->pipeline = gst_element_factory_make ("playbin", "playbin");
@@ -283,6 +437,8 @@ bus_watcher (GstBus *bus, GstMessage *message, LomoMetadataParser *self)
 		gst_message_parse_tag(message, &tags);
 		gst_tag_list_foreach(tags, (GstTagForeachFunc) foreach_tag_cb, (gpointer) self);
 		gst_tag_list_free(tags);
+		if (priv->coalesce == LOMO_METADATA_PARSER_COALESCE_MESSAGE)
+			flush_changed_tags(self);
 		break;
 
 	case GST_MESSAGE_STATE_CHANGED:
@@ -339,7 +495,8 @@ disconnect:
 	gst_element_set_state(priv->pipeline, GST_STATE_NULL);
 
 	// Final emission for URI, not sure why
-	g_signal_emit(self, lomo_metadata_parser_signals[TAG], 0,  priv->stream, LOMO_TAG_URI);
+	tag_changed(self, LOMO_TAG_URI);
+	flush_changed_tags(self);
 
 	// Emission for all-tags signal on LomoMetadataParser
 	// XXX: Stream should also emit all-tags
@@ -366,11 +523,46 @@ foreach_tag_cb(const GstTagList *list, const gchar *tag, LomoMetadataParser *sel
 	else
 	{
 		lomo_stream_set_tag(priv->stream, tag, &value);
-		g_signal_emit(self, lomo_metadata_parser_signals[TAG], 0, priv->stream, tag);
+		tag_changed(self, tag);
 		g_value_unset(&value);
 	}
 }
 
+static void
+tag_changed(LomoMetadataParser *self, const gchar *tag)
+{
+	LomoMetadataParserPrivate *priv = self->priv;
+
+	if (priv->coalesce == LOMO_METADATA_PARSER_COALESCE_NONE)
+	{
+		g_signal_emit(self, lomo_metadata_parser_signals[TAG], 0, priv->stream, tag);
+		return;
+	}
+
+	// Tag lists are short, a linear scan is enough to avoid duplicates
+	GQuark q = g_quark_from_string(tag);
+	for (guint i = 0; i < priv->changed->len; i++)
+		if (g_array_index(priv->changed, GQuark, i) == q)
+			return;
+	g_array_append_val(priv->changed, q);
+}
+
+static void
+flush_changed_tags(LomoMetadataParser *self)
+{
+	LomoMetadataParserPrivate *priv = self->priv;
+
+	if ((priv->stream == NULL) || (priv->changed->len == 0))
+		return;
+
+	// Swap the array, handlers can trigger new tags
+	GArray *changed = priv->changed;
+	priv->changed = g_array_new(FALSE, FALSE, sizeof(GQuark));
+
+	g_signal_emit(self, lomo_metadata_parser_signals[TAGS_CHANGED], 0, priv->stream, changed);
+	g_array_unref(changed);
+}
+
 static gboolean
 run_queue(LomoMetadataParser *self)
 {
@@ -44,8 +44,9 @@ typedef struct {
 	/* <private> */
 	GObjectClass parent_class;
 
-	void (*tag)      (LomoMetadataParser *self, LomoStream *stream, const gchar *tag);
-	void (*all_tags) (LomoMetadataParser *self, LomoStream *stream);
+	void (*tag)          (LomoMetadataParser *self, LomoStream *stream, const gchar *tag);
+	void (*tags_changed) (LomoMetadataParser *self, LomoStream *stream, GArray *tags);
+	void (*all_tags)     (LomoMetadataParser *self, LomoStream *stream);
 } LomoMetadataParserClass;
 
 /**
@@ -63,12 +64,38 @@ typedef enum {
 	LOMO_METADATA_PARSER_PRIO_N_PRIOS
 } LomoMetadataParserPrio;
 
+/**
+ * LomoMetadataParserCoalesce:
+ * @LOMO_METADATA_PARSER_COALESCE_NONE: Emit #LomoMetadataParser::tag for
+ *                                      every single tag (default)
+ * @LOMO_METADATA_PARSER_COALESCE_MESSAGE: Emit one
+ *                                         #LomoMetadataParser::tags-changed
+ *                                         for each #GstTagList found
+ * @LOMO_METADATA_PARSER_COALESCE_STREAM: Emit one
+ *                                        #LomoMetadataParser::tags-changed
+ *                                        per stream, just before
+ *                                        #LomoMetadataParser::all-tags
+ *
+ * Defines how tag discovery is reported to listeners
+ */
+typedef enum {
+	LOMO_METADATA_PARSER_COALESCE_NONE = 0,
+	LOMO_METADATA_PARSER_COALESCE_MESSAGE,
+	LOMO_METADATA_PARSER_COALESCE_STREAM
+} LomoMetadataParserCoalesce;
+
+#define LOMO_TYPE_METADATA_PARSER_COALESCE lomo_metadata_parser_coalesce_get_type()
+
 GType lomo_metadata_parser_get_type (void);
+GType lomo_metadata_parser_coalesce_get_type (void);
 
 LomoMetadataParser* lomo_metadata_parser_new(void);
 void                lomo_metadata_parser_parse(LomoMetadataParser *self, LomoStream *stream, LomoMetadataParserPrio prio);
 void                lomo_metadata_parser_clear(LomoMetadataParser *self);
 
+LomoMetadataParserCoalesce lomo_metadata_parser_get_coalesce(LomoMetadataParser *self);
+void                       lomo_metadata_parser_set_coalesce(LomoMetadataParser *self, LomoMetadataParserCoalesce coalesce);
+
 G_END_DECLS
 
 #endif // _LOMO_METADATA_PARSER
@@ -5,6 +5,7 @@
 #include "lomo/lomo-metadata-parser.h"
 #include "lomo/lomo-em-art-provider.h"
 #include "lomo/lomo-stats.h"
+#include "lomo/lomo-snapshot.h"
 #include "lomo/lomo-util.h"
 #include "lomo/lomo-logger.h"
 #include "lomo-marshallers.h"
@@ -55,7 +56,8 @@ enum {
 	PROPERTY_AUTO_PLAY,
 	PROPERTY_CAN_GO_PREVIOUS,
 	PROPERTY_CAN_GO_NEXT,
-	PROPERTY_GAPLESS_MODE
+	PROPERTY_GAPLESS_MODE,
+	PROPERTY_TAG_COALESCE
 };
 
 enum {
@@ -69,6 +71,7 @@ enum {
 	EOS,
 
 	TAG,
+	TAGS_CHANGED,
 	ALL_TAGS,
 	ERROR,
 
@@ -166,6 +169,7 @@ static void     player_emit_state_change(LomoPlayer *self);
 static gboolean player_run_hooks(LomoPlayer *self, LomoPlayerHookType type, gpointer ret, ...);
 
 static void     meta_tag_cb     (LomoMetadataParser *parser, LomoStream *stream, const gchar *tag, LomoPlayer *self);
+static void     meta_tags_changed_cb(LomoMetadataParser *parser, LomoStream *stream, GArray *tags, LomoPlayer *self);
 static void     meta_all_tags_cb(LomoMetadataParser *parser, LomoStream *stream, LomoPlayer *self);
 static void     about_to_finish_cb(GstElement *pipeline, LomoPlayer *self);
 static gboolean player_bus_watcher(GstBus *bus, GstMessage *message, LomoPlayer *self);
@@ -231,6 +235,10 @@ player_get_property (GObject *object, guint property_id, GValue *value, GParamSp
 		g_value_set_boolean(value, lomo_player_get_gapless_mode(self));
 		break;
 
+	case PROPERTY_TAG_COALESCE:
+		g_value_set_enum(value, lomo_player_get_tag_coalesce(self));
+		break;
+
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 	}
@@ -288,6 +296,10 @@ player_set_property (GObject *object, guint property_id, const GValue *value, GP
 		lomo_player_set_gapless_mode(self, g_value_get_boolean(value));
 		break;
 
+	case PROPERTY_TAG_COALESCE:
+		lomo_player_set_tag_coalesce(self, g_value_get_enum(value));
+		break;
+
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
 	}
@@ -536,6 +548,27 @@ lomo_player_class_init (LomoPlayerClass *klass)
 			2,
 			G_TYPE_OBJECT,
 			G_TYPE_STRING);
+	/**
+	 * LomoPlayer::tags-changed:
+	 * @lomo: the object that received the signal
+	 * @stream: (type LomoStream): #LomoStream that gives new tags
+	 * @tags: (type GLib.Array) (element-type GQuark): Quarks of the
+	 *        discovered tags
+	 *
+	 * Emitted once for a batch of tags found in a stream when
+	 * #LomoPlayer:tag-coalesce is not %LOMO_METADATA_PARSER_COALESCE_NONE.
+	 */
+	player_signals[TAGS_CHANGED] =
+		g_signal_new ("tags-changed",
+			G_OBJECT_CLASS_TYPE (object_class),
+			G_SIGNAL_RUN_LAST,
+			G_STRUCT_OFFSET (LomoPlayerClass, tags_changed),
+			NULL, NULL,
+			lomo_marshal_VOID__OBJECT_BOXED,
+			G_TYPE_NONE,
+			2,
+			G_TYPE_OBJECT,
+			G_TYPE_ARRAY);
 	/**
 	 * LomoPlayer::all-tags:
 	 * @lomo: the object that received the signal
@@ -807,6 +840,16 @@ lomo_player_class_init (LomoPlayerClass *klass)
 	g_object_class_install_property(object_class, PROPERTY_GAPLESS_MODE,
 		g_param_spec_boolean("gapless-mode", "gapless-mode", "Gapless mode",
 		TRUE, G_PARAM_READWRITE|G_PARAM_CONSTRUCT|G_PARAM_STATIC_STRINGS));
+	/**
+	 * LomoPlayer:tag-coalesce:
+	 *
+	 * Controls if discovered tags are reported one by one using
+	 * #LomoPlayer::tag or in batches using #LomoPlayer::tags-changed
+	 */
+	g_object_class_install_property(object_class, PROPERTY_TAG_COALESCE,
+		g_param_spec_enum("tag-coalesce", "tag-coalesce", "Tag coalescing mode",
+		LOMO_TYPE_METADATA_PARSER_COALESCE, LOMO_METADATA_PARSER_COALESCE_NONE,
+		G_PARAM_READWRITE|G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -844,8 +887,9 @@ lomo_player_init (LomoPlayer *self)
 	// Shadow values
 	priv->_shadow_state     = LOMO_STATE_INVALID;
 
-	g_signal_connect(priv->meta, "tag",      (GCallback) meta_tag_cb, self);
-	g_signal_connect(priv->meta, "all-tags", (GCallback) meta_all_tags_cb, self);
+	g_signal_connect(priv->meta, "tag",          (GCallback) meta_tag_cb, self);
+	g_signal_connect(priv->meta, "tags-changed", (GCallback) meta_tags_changed_cb, self);
+	g_signal_connect(priv->meta, "all-tags",     (GCallback) meta_all_tags_cb, self);
 
 	#ifdef LOMO_PLAYER_E_API
 	g_signal_connect(self, "notify", (GCallback) player_notify_cb, NULL);
@@ -1006,6 +1050,42 @@ lomo_player_set_gapless_mode(LomoPlayer *self, gboolean gapless_mode)
 	g_object_notify((GObject *) self, "gapless-mode");
 }
 
+/**
+ * lomo_player_get_tag_coalesce:
+ * @self: A #LomoPlayer
+ *
+ * Gets the value of the #LomoPlayer:tag-coalesce property
+ *
+ * Returns: The coalescing mode
+ */
+LomoMetadataParserCoalesce
+lomo_player_get_tag_coalesce(LomoPlayer *self)
+{
+	g_return_val_if_fail(LOMO_IS_PLAYER(self), LOMO_METADATA_PARSER_COALESCE_NONE);
+	return lomo_metadata_parser_get_coalesce(self->priv->meta);
+}
+
+/**
+ * lomo_player_set_tag_coalesce:
+ * @self: A #LomoPlayer
+ * @coalesce: A #LomoMetadataParserCoalesce
+ *
+ * Sets how tags discovered by the internal parser are reported, see
+ * lomo_metadata_parser_set_coalesce()
+ */
+void
+lomo_player_set_tag_coalesce(LomoPlayer *self, LomoMetadataParserCoalesce coalesce)
+{
+	g_return_if_fail(LOMO_IS_PLAYER(self));
+
+	LomoPlayerPrivate *priv = self->priv;
+	if (lomo_metadata_parser_get_coalesce(priv->meta) == coalesce)
+		return;
+
+	lomo_metadata_parser_set_coalesce(priv->meta, coalesce);
+	g_object_notify((GObject *) self, "tag-coalesce");
+}
+
 /**
  * lomo_player_get_state:
  * @self: The #LomoPlayer
@@ -1822,10 +1902,11 @@ lomo_player_insert_multiple(LomoPlayer *self, GList *streams, gint position)
 			continue;
 		}
 
-		// Insert and auto-parse
+		// Insert and auto-parse, streams inserted with all their tags
+		// (ie. from a playlist with metadata) don't need parsing
 		lomo_playlist_insert(self->priv->playlist, stream, position++);
 		g_signal_emit(self, player_signals[INSERT], 0, stream, position - 1);
-		if (lomo_player_get_auto_parse(self))
+		if (lomo_player_get_auto_parse(self) && !lomo_stream_get_all_tags_flag(stream))
 			lomo_metadata_parser_parse(self->priv->meta, stream, LOMO_METADATA_PARSER_PRIO_DEFAULT);
 
 		// Fire change after the first insert
@@ -2113,6 +2194,86 @@ lomo_player_queue_clear(LomoPlayer *self)
 	g_signal_emit(G_OBJECT(self), player_signals[QUEUE_CLEAR], 0);
 }
 
+/**
+ * lomo_player_save_snapshot:
+ * @self: a #LomoPlayer
+ * @filename: File to write to
+ * @data_keys: (array zero-terminated=1) (allow-none): Keys of per-stream
+ *             object data to save along with the tags, data must be a #GValue
+ * @error: Location for a #GError
+ *
+ * Saves a compact binary snapshot of the playlist: streams with their tags
+ * and length, current index, random order and queue. See
+ * lomo_player_restore_snapshot()
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+lomo_player_save_snapshot(LomoPlayer *self, const gchar *filename, const gchar *const *data_keys, GError **error)
+{
+	g_return_val_if_fail(LOMO_IS_PLAYER(self), FALSE);
+	g_return_val_if_fail(filename != NULL, FALSE);
+	LomoPlayerPrivate *priv = self->priv;
+
+	return lomo_snapshot_write(filename,
+		lomo_playlist_get_playlist(priv->playlist),
+		lomo_playlist_get_random_playlist(priv->playlist),
+		priv->queue->head,
+		lomo_player_get_current(self),
+		data_keys, error);
+}
+
+/**
+ * lomo_player_restore_snapshot:
+ * @self: a #LomoPlayer
+ * @filename: File to read from
+ * @error: Location for a #GError
+ *
+ * Replaces the playlist with the one saved by lomo_player_save_snapshot().
+ * Streams are restored fully tagged so they are not parsed again, order,
+ * queue and current stream are restored too.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+lomo_player_restore_snapshot(LomoPlayer *self, const gchar *filename, GError **error)
+{
+	g_return_val_if_fail(LOMO_IS_PLAYER(self), FALSE);
+	g_return_val_if_fail(filename != NULL, FALSE);
+	LomoPlayerPrivate *priv = self->priv;
+
+	LomoSnapshot *snapshot = lomo_snapshot_read(filename, error);
+	if (!snapshot)
+		return FALSE;
+
+	if (lomo_player_get_n_streams(self) > 0)
+		lomo_player_clear(self);
+	lomo_player_insert_multiple(self, snapshot->streams, -1);
+
+	// Hooks can reject some streams, then indexes don't match
+	if ((guint) lomo_player_get_n_streams(self) != snapshot->n_streams)
+	{
+		lomo_snapshot_free(snapshot);
+		return TRUE;
+	}
+
+	lomo_playlist_set_random_order(priv->playlist, snapshot->random, snapshot->n_streams);
+	for (guint i = 0; i < snapshot->n_queue; i++)
+		lomo_player_queue(self, snapshot->queue[i]);
+
+	GError *err = NULL;
+	if ((snapshot->current >= 0) &&
+		(snapshot->current != lomo_player_get_current(self)) &&
+		!lomo_player_set_current(self, snapshot->current, &err))
+	{
+		g_warning(N_("Error creating pipeline: %s"), err->message);
+		g_error_free(err);
+	}
+
+	lomo_snapshot_free(snapshot);
+	return TRUE;
+}
+
 /**
  * lomo_player_hook_add:
  * @self: a #LomoPlayer
@@ -2254,6 +2415,11 @@ player_run_hooks(LomoPlayer *self, LomoPlayerHookType type, gpointer ret, ...)
 		event.tag    = va_arg(args, const gchar*);
 		break;
 
+	case LOMO_PLAYER_HOOK_TAGS_CHANGED:
+		event.stream = va_arg(args, LomoStream*);
+		event.tags   = va_arg(args, GArray*);
+		break;
+
 	case LOMO_PLAYER_HOOK_ALL_TAGS:
 		event.stream = va_arg(args, LomoStream*);
 		break;
@@ -2295,6 +2461,17 @@ meta_tag_cb(LomoMetadataParser *parser, LomoStream *stream, const gchar *tag, Lo
 	g_signal_emit(self, player_signals[TAG], 0, stream, tag);
 }
 
+static void
+meta_tags_changed_cb(LomoMetadataParser *parser, LomoStream *stream, GArray *tags, LomoPlayer *self)
+{
+	// Run hook
+	if (player_run_hooks(self, LOMO_PLAYER_HOOK_TAGS_CHANGED, NULL, stream, tags))
+		return;
+
+	// Exec signal
+	g_signal_emit(self, player_signals[TAGS_CHANGED], 0, stream, tags);
+}
+
 static void
 meta_all_tags_cb(LomoMetadataParser *parser, LomoStream *stream, LomoPlayer *self)
 {
@@ -2543,7 +2720,8 @@ player_notify_cb(LomoPlayer *self, GParamSpec *pspec, gpointer user_data)
 		"can-go-next",
 		"auto-play",
 		"auto-parse",
-		"gapless-mode"
+		"gapless-mode",
+		"tag-coalesce"
 		};
 
 	LomoPlayerPrivate *priv = self->priv;
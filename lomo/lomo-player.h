@@ -4,6 +4,7 @@
 #include <glib-object.h>
 #include <gst/gst.h>
 #include <lomo/lomo-stream.h>
+#include <lomo/lomo-metadata-parser.h>
 
 G_BEGIN_DECLS
 
@@ -41,6 +42,7 @@ typedef struct {
 
 	void (*error)         (LomoPlayer *self, LomoStream *stream, GError *error);
 	void (*tag)           (LomoPlayer *self, LomoStream *stream, const gchar *tag);
+	void (*tags_changed)  (LomoPlayer *self, LomoStream *stream, GArray *tags);
 	void (*all_tags)      (LomoPlayer *self, LomoStream *stream);
 
 	/* Maybe E-API */
@@ -190,6 +192,7 @@ typedef enum {
  * @LOMO_PLAYER_HOOK_ERROR: Error hook
  * @LOMO_PLAYER_HOOK_TAG: Tag hook
  * @LOMO_PLAYER_HOOK_ALL_TAGS: All tags hook
+ * @LOMO_PLAYER_HOOK_TAGS_CHANGED: Tags changed hook
  *
  * Determines the type of hook
  **/
@@ -212,7 +215,8 @@ typedef enum {
 	LOMO_PLAYER_HOOK_EOS,
 	LOMO_PLAYER_HOOK_ERROR,
 	LOMO_PLAYER_HOOK_TAG,
-	LOMO_PLAYER_HOOK_ALL_TAGS
+	LOMO_PLAYER_HOOK_ALL_TAGS,
+	LOMO_PLAYER_HOOK_TAGS_CHANGED
 } LomoPlayerHookType;
 
 /**
@@ -221,13 +225,14 @@ typedef enum {
  * @old: Old position (seek type event)
  * @new: New position (seek type event)
  * @volume: Volumen value (volume type event)
- * @stream: Stream object (insert, remove, queue, dequeue, tag and all_tags
- *          event types)
+ * @stream: Stream object (insert, remove, queue, dequeue, tag, tags_changed
+ *          and all_tags event types)
  * @pos: Position (insert and remove event types)
  * @queue_pos: Queue position (queue and dequeue event types)
  * @from: From position (change event type)
  * @to: From position (change event type)
  * @tag: Tag value (tag event type)
+ * @tags: #GArray of #GQuark (tags_changed event type)
  * @value: %TRUE or %FALSE (randonm, repeat and mute event types)
  * @error: A #GError (error event type)
  *
@@ -238,11 +243,12 @@ typedef struct {
 	LomoPlayerHookType type;
 	gint64 old, new;    // seek
 	gint volume;        // volume
-	LomoStream *stream; // insert, remove, queue, dequeue, tag, all_tags
+	LomoStream *stream; // insert, remove, queue, dequeue, tag, tags_changed, all_tags
 	gint pos;           // insert, remove
 	gint queue_pos;     // queue, dequeue
 	gint from, to;      // change
 	const gchar *tag;   // tag
+	GArray *tags;       // tags_changed
 	gboolean value;     // random, repeat, mute
 	GError *error;      // error
 } LomoPlayerHookEvent;
@@ -280,6 +286,9 @@ void     lomo_player_set_auto_play(LomoPlayer *self, gboolean auto_play);
 gboolean lomo_player_get_gapless_mode(LomoPlayer *self);
 void     lomo_player_set_gapless_mode(LomoPlayer *self, gboolean gapless_mode);
 
+LomoMetadataParserCoalesce lomo_player_get_tag_coalesce(LomoPlayer *self);
+void                       lomo_player_set_tag_coalesce(LomoPlayer *self, LomoMetadataParserCoalesce coalesce);
+
 /* state */
 LomoState lomo_player_get_state(LomoPlayer *self);
 gboolean  lomo_player_set_state(LomoPlayer *self, LomoState state, GError **error);
@@ -334,6 +343,9 @@ gint        lomo_player_queue_get_stream_index (LomoPlayer *self, LomoStream *st
 LomoStream* lomo_player_queue_get_nth_stream   (LomoPlayer *self, gint queue_index);
 void        lomo_player_queue_clear            (LomoPlayer *self);
 
+gboolean lomo_player_save_snapshot   (LomoPlayer *self, const gchar *filename, const gchar *const *data_keys, GError **error);
+gboolean lomo_player_restore_snapshot(LomoPlayer *self, const gchar *filename, GError **error);
+
 void lomo_player_hook_add(LomoPlayer *self, LomoPlayerHook func, gpointer data);
 void lomo_player_hook_remove(LomoPlayer *self, LomoPlayerHook func);
 
@@ -131,6 +131,50 @@ lomo_playlist_get_random_playlist (LomoPlaylist *self)
 	return (const GList *) self->priv->random_list;
 }
 
+/**
+ * lomo_playlist_set_random_order:
+ * @self: a #LomoPlaylist
+ * @order: (array length=n): Indexes of the streams in random order
+ * @n: Number of elements in @order, must match the number of streams
+ *
+ * Replaces the random order of the playlist, used to restore a previously
+ * saved order. @order must be a permutation of the playlist indexes.
+ *
+ * Returns: %TRUE if @order was applied
+ */
+gboolean
+lomo_playlist_set_random_order(LomoPlaylist *self, const guint *order, guint n)
+{
+	g_return_val_if_fail(LOMO_IS_PLAYLIST(self), FALSE);
+	g_return_val_if_fail(order != NULL, FALSE);
+	LomoPlaylistPrivate *priv = self->priv;
+
+	if (n != (guint) priv->total)
+		return FALSE;
+
+	LomoStream **streams = g_new(LomoStream *, MAX(n, 1));
+	guint i = 0;
+	for (GList *l = priv->list; l; l = l->next)
+		streams[i++] = (LomoStream *) l->data;
+
+	GList *random = NULL;
+	for (i = n; i > 0; i--)
+	{
+		if (order[i - 1] >= n)
+		{
+			g_list_free(random);
+			g_free(streams);
+			g_return_val_if_reached(FALSE);
+		}
+		random = g_list_prepend(random, streams[order[i - 1]]);
+	}
+	g_free(streams);
+
+	g_list_free(priv->random_list);
+	priv->random_list = random;
+	return TRUE;
+}
+
 /*
  * lomo_playlist_get_n_streams:
  * @self: a #LomoPlaylist
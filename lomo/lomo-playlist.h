@@ -43,6 +43,7 @@ void     lomo_playlist_clear       (LomoPlaylist *self);
 
 const GList* lomo_playlist_get_playlist(LomoPlaylist *self);
 const GList* lomo_playlist_get_random_playlist (LomoPlaylist *self);
+gboolean     lomo_playlist_set_random_order   (LomoPlaylist *self, const guint *order, guint n);
 
 LomoStream* lomo_playlist_get_nth_stream  (LomoPlaylist *self, gint index);
 gint        lomo_playlist_get_stream_index(LomoPlaylist *self, LomoStream *stream);
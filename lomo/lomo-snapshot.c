@@ -0,0 +1,538 @@
+/*
+ * lomo/lomo-snapshot.c
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Binary snapshot of a playlist.
+ *
+ * The file is a fixed header followed by fixed size sections, all of them
+ * aligned to 8 bytes so they can be used straight from a mapped file:
+ *
+ *   SnapshotHeader
+ *   SnapshotStream[n_streams]
+ *   SnapshotTag[n_tags]          tags of all streams, grouped by stream
+ *   guint32[n_streams]           random order
+ *   guint32[n_queue]             queue
+ *   gchar[strings_size]          pool of NUL-terminated strings
+ *
+ * Strings are referenced by offset into the pool and are deduplicated, so
+ * repeated artists, albums and tag names are stored once. Integers are
+ * native endian, a byte order mark rejects files from other machines.
+ */
+
+#include "lomo-snapshot.h"
+#include <string.h>
+#include <glib/gi18n.h>
+#include <gel/gel.h>
+
+#define DEBUG 0
+#define DEBUG_PREFIX "LomoSnapshot"
+#if DEBUG
+#	define debug(...) g_debug(DEBUG_PREFIX " " __VA_ARGS__)
+#else
+#	define debug(...) ;
+#endif
+
+#define SNAPSHOT_MAGIC      "LOMOSNAP"
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_ALIGN(x)   (((x) + 7) & ~((guint64) 7))
+
+enum {
+	SNAPSHOT_STREAM_ALL_TAGS = 1 << 0,
+	SNAPSHOT_STREAM_FAILED   = 1 << 1
+};
+
+typedef enum {
+	SNAPSHOT_VALUE_STRING = 1,
+	SNAPSHOT_VALUE_INT,
+	SNAPSHOT_VALUE_UINT,
+	SNAPSHOT_VALUE_INT64,
+	SNAPSHOT_VALUE_UINT64,
+	SNAPSHOT_VALUE_BOOLEAN,
+	SNAPSHOT_VALUE_DOUBLE,
+
+	// Not a tag but object data, see lomo_snapshot_write()
+	SNAPSHOT_VALUE_DATA = 1 << 8
+} SnapshotValueType;
+
+typedef struct {
+	gchar   magic[8];
+	guint32 version;
+	guint32 byte_order;
+	gint32  current;
+	guint32 n_streams;
+	guint32 n_tags;
+	guint32 n_queue;
+	guint32 strings_size;
+	guint32 reserved;
+	guint64 streams_offset;
+	guint64 tags_offset;
+	guint64 random_offset;
+	guint64 queue_offset;
+	guint64 strings_offset;
+} SnapshotHeader;
+
+typedef struct {
+	guint32 uri;
+	guint32 flags;
+	guint32 first_tag;
+	guint32 n_tags;
+	gint64  length;
+} SnapshotStream;
+
+typedef struct {
+	guint32 key;
+	guint32 type;
+	union {
+		gint64  i;
+		guint64 u;
+		gdouble d;
+		guint32 s;
+	} value;
+} SnapshotTag;
+
+GEL_DEFINE_QUARK_FUNC(lomo_snapshot)
+
+/*
+ * Writer
+ */
+typedef struct {
+	GByteArray *data;
+	GHashTable *offsets;
+} StringPool;
+
+static guint32
+string_pool_add(StringPool *pool, const gchar *str)
+{
+	gpointer offset;
+	if (g_hash_table_lookup_extended(pool->offsets, str, NULL, &offset))
+		return GPOINTER_TO_UINT(offset);
+
+	guint32 ret = pool->data->len;
+	g_byte_array_append(pool->data, (const guint8 *) str, strlen(str) + 1);
+	g_hash_table_insert(pool->offsets, g_strdup(str), GUINT_TO_POINTER(ret));
+	return ret;
+}
+
+static gboolean
+snapshot_tag_from_value(SnapshotTag *tag, const GValue *value, StringPool *pool)
+{
+	switch (G_TYPE_FUNDAMENTAL(G_VALUE_TYPE(value)))
+	{
+	case G_TYPE_STRING:
+		if (!g_value_get_string(value))
+			return FALSE;
+		tag->type = SNAPSHOT_VALUE_STRING;
+		tag->value.s = string_pool_add(pool, g_value_get_string(value));
+		return TRUE;
+	case G_TYPE_INT:
+		tag->type = SNAPSHOT_VALUE_INT;
+		tag->value.i = g_value_get_int(value);
+		return TRUE;
+	case G_TYPE_UINT:
+		tag->type = SNAPSHOT_VALUE_UINT;
+		tag->value.u = g_value_get_uint(value);
+		return TRUE;
+	case G_TYPE_INT64:
+		tag->type = SNAPSHOT_VALUE_INT64;
+		tag->value.i = g_value_get_int64(value);
+		return TRUE;
+	case G_TYPE_UINT64:
+		tag->type = SNAPSHOT_VALUE_UINT64;
+		tag->value.u = g_value_get_uint64(value);
+		return TRUE;
+	case G_TYPE_BOOLEAN:
+		tag->type = SNAPSHOT_VALUE_BOOLEAN;
+		tag->value.i = g_value_get_boolean(value);
+		return TRUE;
+	case G_TYPE_DOUBLE:
+		tag->type = SNAPSHOT_VALUE_DOUBLE;
+		tag->value.d = g_value_get_double(value);
+		return TRUE;
+	default:
+		// Dates, buffers, images...: left for the metadata parser
+		return FALSE;
+	}
+}
+
+static void
+snapshot_indexes(GByteArray *out, const GList *streams, GHashTable *index_map)
+{
+	for (const GList *l = streams; l; l = l->next)
+	{
+		guint32 index = GPOINTER_TO_UINT(g_hash_table_lookup(index_map, l->data)) - 1;
+		g_byte_array_append(out, (const guint8 *) &index, sizeof(index));
+	}
+}
+
+static void
+snapshot_pad(GByteArray *out)
+{
+	static const guint8 zeros[8] = { 0 };
+	g_byte_array_append(out, zeros, SNAPSHOT_ALIGN(out->len) - out->len);
+}
+
+/*
+ * lomo_snapshot_write:
+ * @filename: File to write to
+ * @streams: (element-type Lomo.Stream): Playlist
+ * @random: (element-type Lomo.Stream): Random order of @streams
+ * @queue: (element-type Lomo.Stream): Queued streams, all of them from @streams
+ * @current: Current index or -1
+ * @data_keys: (allow-none): %NULL-terminated list of object data keys to save
+ *             with each stream, data must be a #GValue (like tags)
+ * @error: Location for a #GError
+ *
+ * Writes atomically a snapshot of the playlist into @filename.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+lomo_snapshot_write(const gchar *filename,
+	const GList *streams, const GList *random, const GList *queue, gint current,
+	const gchar *const *data_keys, GError **error)
+{
+	g_return_val_if_fail(filename != NULL, FALSE);
+
+	StringPool pool = {
+		g_byte_array_new(),
+		g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL)
+	};
+	GArray *stream_records = g_array_new(FALSE, TRUE, sizeof(SnapshotStream));
+	GArray *tag_records    = g_array_new(FALSE, TRUE, sizeof(SnapshotTag));
+	GHashTable *index_map  = g_hash_table_new(NULL, NULL);
+
+	guint32 n = 0;
+	for (const GList *l = streams; l; l = l->next, n++)
+	{
+		LomoStream *stream = LOMO_STREAM(l->data);
+		g_hash_table_insert(index_map, stream, GUINT_TO_POINTER(n + 1));
+
+		SnapshotStream record = {
+			.uri       = string_pool_add(&pool, lomo_stream_get_uri(stream)),
+			.flags     = (lomo_stream_get_all_tags_flag(stream) ? SNAPSHOT_STREAM_ALL_TAGS : 0) |
+			             (lomo_stream_get_failed_flag(stream)   ? SNAPSHOT_STREAM_FAILED   : 0),
+			.first_tag = tag_records->len,
+			.n_tags    = 0,
+			.length    = lomo_stream_get_length(stream)
+		};
+
+		GList *tags = lomo_stream_get_tags(stream);
+		for (GList *t = tags; t; t = t->next)
+		{
+			const gchar *key = (const gchar *) t->data;
+			if (g_str_equal(key, LOMO_TAG_URI))
+				continue;
+
+			SnapshotTag tag = { .key = 0 };
+			if (!snapshot_tag_from_value(&tag, lomo_stream_get_tag(stream, key), &pool))
+				continue;
+			tag.key = string_pool_add(&pool, key);
+			g_array_append_val(tag_records, tag);
+			record.n_tags++;
+		}
+		gel_list_deep_free(tags, g_free);
+
+		for (guint i = 0; data_keys && data_keys[i]; i++)
+		{
+			const GValue *value = g_object_get_data((GObject *) stream, data_keys[i]);
+			SnapshotTag tag = { .key = 0 };
+			if (!value || !G_IS_VALUE(value) || !snapshot_tag_from_value(&tag, value, &pool))
+				continue;
+			tag.key   = string_pool_add(&pool, data_keys[i]);
+			tag.type |= SNAPSHOT_VALUE_DATA;
+			g_array_append_val(tag_records, tag);
+			record.n_tags++;
+		}
+
+		g_array_append_val(stream_records, record);
+	}
+
+	SnapshotHeader header = {
+		.version    = LOMO_SNAPSHOT_VERSION,
+		.byte_order = SNAPSHOT_BYTE_ORDER,
+		.current    = current,
+		.n_streams  = n,
+		.n_tags     = tag_records->len,
+		.n_queue    = g_list_length((GList *) queue),
+		.strings_size = pool.data->len
+	};
+	memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+
+	GByteArray *out = g_byte_array_sized_new(sizeof(header) +
+		stream_records->len * sizeof(SnapshotStream) +
+		tag_records->len * sizeof(SnapshotTag) +
+		(n + header.n_queue) * sizeof(guint32) + 16 +
+		pool.data->len);
+	g_byte_array_append(out, (const guint8 *) &header, sizeof(header));
+
+	header.streams_offset = out->len;
+	g_byte_array_append(out, (const guint8 *) stream_records->data, stream_records->len * sizeof(SnapshotStream));
+
+	header.tags_offset = out->len;
+	g_byte_array_append(out, (const guint8 *) tag_records->data, tag_records->len * sizeof(SnapshotTag));
+
+	header.random_offset = out->len;
+	snapshot_indexes(out, random, index_map);
+	snapshot_pad(out);
+
+	header.queue_offset = out->len;
+	snapshot_indexes(out, queue, index_map);
+	snapshot_pad(out);
+
+	header.strings_offset = out->len;
+	g_byte_array_append(out, pool.data->data, pool.data->len);
+
+	// Now offsets are known
+	memcpy(out->data, &header, sizeof(header));
+
+	gboolean ret = g_file_set_contents(filename, (const gchar *) out->data, out->len, error);
+	debug("Written %u streams, %u tags, %u bytes to '%s'", n, tag_records->len, out->len, filename);
+
+	g_byte_array_free(out, TRUE);
+	g_hash_table_destroy(index_map);
+	g_array_free(tag_records, TRUE);
+	g_array_free(stream_records, TRUE);
+	g_hash_table_destroy(pool.offsets);
+	g_byte_array_free(pool.data, TRUE);
+
+	return ret;
+}
+
+/*
+ * Reader
+ */
+static gboolean
+snapshot_section_is_valid(gsize length, guint64 offset, guint64 size)
+{
+	return ((offset % 8) == 0) && (offset >= sizeof(SnapshotHeader)) &&
+		(offset <= length) && (size <= length - offset);
+}
+
+static const gchar *
+snapshot_string(const gchar *strings, guint32 size, guint32 offset)
+{
+	return (offset < size) ? strings + offset : NULL;
+}
+
+static void
+snapshot_destroy_gvalue(GValue *value)
+{
+	g_value_unset(value);
+	g_free(value);
+}
+
+static gboolean
+snapshot_tag_to_value(const SnapshotTag *tag, const gchar *strings, guint32 strings_size, GValue *value)
+{
+	switch (tag->type & ~SNAPSHOT_VALUE_DATA)
+	{
+	case SNAPSHOT_VALUE_STRING:
+	{
+		const gchar *str = snapshot_string(strings, strings_size, tag->value.s);
+		if (!str)
+			return FALSE;
+		g_value_set_static_string(g_value_init(value, G_TYPE_STRING), str);
+		return TRUE;
+	}
+	case SNAPSHOT_VALUE_INT:
+		g_value_set_int(g_value_init(value, G_TYPE_INT), (gint) tag->value.i);
+		return TRUE;
+	case SNAPSHOT_VALUE_UINT:
+		g_value_set_uint(g_value_init(value, G_TYPE_UINT), (guint) tag->value.u);
+		return TRUE;
+	case SNAPSHOT_VALUE_INT64:
+		g_value_set_int64(g_value_init(value, G_TYPE_INT64), tag->value.i);
+		return TRUE;
+	case SNAPSHOT_VALUE_UINT64:
+		g_value_set_uint64(g_value_init(value, G_TYPE_UINT64), tag->value.u);
+		return TRUE;
+	case SNAPSHOT_VALUE_BOOLEAN:
+		g_value_set_boolean(g_value_init(value, G_TYPE_BOOLEAN), tag->value.i != 0);
+		return TRUE;
+	case SNAPSHOT_VALUE_DOUBLE:
+		g_value_set_double(g_value_init(value, G_TYPE_DOUBLE), tag->value.d);
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static guint *
+snapshot_read_indexes(const guint32 *data, guint n, guint n_streams, gboolean permutation)
+{
+	guint *ret = g_new(guint, MAX(n, 1));
+	guint8 *seen = permutation ? g_new0(guint8, MAX(n_streams, 1)) : NULL;
+
+	for (guint i = 0; i < n; i++)
+	{
+		if ((data[i] >= n_streams) || (seen && seen[data[i]]))
+		{
+			g_free(seen);
+			g_free(ret);
+			return NULL;
+		}
+		if (seen)
+			seen[data[i]] = 1;
+		ret[i] = data[i];
+	}
+	g_free(seen);
+	return ret;
+}
+
+/*
+ * lomo_snapshot_read:
+ * @filename: File to read from
+ * @error: Location for a #GError
+ *
+ * Maps @filename and builds the streams stored on it in one pass. All offsets
+ * and indexes are checked, a damaged or foreign file is reported as an error.
+ *
+ * Returns: (transfer full): A #LomoSnapshot, free with lomo_snapshot_free()
+ */
+LomoSnapshot *
+lomo_snapshot_read(const gchar *filename, GError **error)
+{
+	g_return_val_if_fail(filename != NULL, NULL);
+
+	GMappedFile *mapped = g_mapped_file_new(filename, FALSE, error);
+	if (!mapped)
+		return NULL;
+
+	const gchar *data = g_mapped_file_get_contents(mapped);
+	gsize      length = g_mapped_file_get_length(mapped);
+	const SnapshotHeader *header = (const SnapshotHeader *) data;
+
+	if ((length < sizeof(SnapshotHeader)) ||
+		memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) ||
+		(header->byte_order != SNAPSHOT_BYTE_ORDER))
+	{
+		g_set_error(error, lomo_snapshot_quark(), LOMO_SNAPSHOT_ERROR_INVALID,
+			N_("'%s' is not a playlist snapshot"), filename);
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+
+	if (header->version != LOMO_SNAPSHOT_VERSION)
+	{
+		g_set_error(error, lomo_snapshot_quark(), LOMO_SNAPSHOT_ERROR_VERSION,
+			N_("Unsupported snapshot version %u"), header->version);
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+
+	if (!snapshot_section_is_valid(length, header->streams_offset, (guint64) header->n_streams * sizeof(SnapshotStream)) ||
+		!snapshot_section_is_valid(length, header->tags_offset,    (guint64) header->n_tags    * sizeof(SnapshotTag))    ||
+		!snapshot_section_is_valid(length, header->random_offset,  (guint64) header->n_streams * sizeof(guint32))        ||
+		!snapshot_section_is_valid(length, header->queue_offset,   (guint64) header->n_queue   * sizeof(guint32))        ||
+		!snapshot_section_is_valid(length, header->strings_offset, header->strings_size) ||
+		(header->strings_size && (data[header->strings_offset + header->strings_size - 1] != '\0')) ||
+		(header->current < -1) || (header->current >= (gint64) header->n_streams))
+	{
+		g_set_error(error, lomo_snapshot_quark(), LOMO_SNAPSHOT_ERROR_INVALID,
+			N_("Snapshot '%s' is damaged"), filename);
+		g_mapped_file_unref(mapped);
+		return NULL;
+	}
+
+	const SnapshotStream *streams = (const SnapshotStream *) (data + header->streams_offset);
+	const SnapshotTag    *tags    = (const SnapshotTag *)    (data + header->tags_offset);
+	const gchar          *strings = data + header->strings_offset;
+
+	LomoSnapshot *ret = g_new0(LomoSnapshot, 1);
+	ret->n_streams = header->n_streams;
+	ret->n_queue   = header->n_queue;
+	ret->current   = header->current;
+	ret->random    = snapshot_read_indexes((const guint32 *) (data + header->random_offset), header->n_streams, header->n_streams, TRUE);
+	ret->queue     = snapshot_read_indexes((const guint32 *) (data + header->queue_offset),  header->n_queue,   header->n_streams, FALSE);
+
+	gboolean valid = (ret->random != NULL) && (ret->queue != NULL);
+	for (guint i = 0; valid && (i < header->n_streams); i++)
+	{
+		const SnapshotStream *record = &streams[i];
+		const gchar *uri = snapshot_string(strings, header->strings_size, record->uri);
+		if (!uri ||
+			(record->first_tag > header->n_tags) ||
+			(record->n_tags > header->n_tags - record->first_tag))
+		{
+			valid = FALSE;
+			break;
+		}
+
+		LomoStream *stream = lomo_stream_new(uri);
+		for (guint j = 0; j < record->n_tags; j++)
+		{
+			const SnapshotTag *tag = &tags[record->first_tag + j];
+			const gchar *key = snapshot_string(strings, header->strings_size, tag->key);
+
+			GValue v = { 0 };
+			if (!key || !snapshot_tag_to_value(tag, strings, header->strings_size, &v))
+				continue;
+
+			if (tag->type & SNAPSHOT_VALUE_DATA)
+			{
+				GValue *copy = g_value_init(g_new0(GValue, 1), G_VALUE_TYPE(&v));
+				g_value_copy(&v, copy);
+				g_object_set_data_full((GObject *) stream, key, copy, (GDestroyNotify) snapshot_destroy_gvalue);
+			}
+			else
+				lomo_stream_set_tag(stream, key, &v);
+			g_value_unset(&v);
+		}
+
+		if (record->length >= 0)
+			lomo_stream_set_length(stream, record->length);
+		if (record->flags & SNAPSHOT_STREAM_FAILED)
+			lomo_stream_set_failed_flag(stream, TRUE);
+		if (record->flags & SNAPSHOT_STREAM_ALL_TAGS)
+			lomo_stream_set_all_tags_flag(stream, TRUE);
+
+		ret->streams = g_list_prepend(ret->streams, stream);
+	}
+	ret->streams = g_list_reverse(ret->streams);
+	g_mapped_file_unref(mapped);
+
+	if (!valid)
+	{
+		g_set_error(error, lomo_snapshot_quark(), LOMO_SNAPSHOT_ERROR_INVALID,
+			N_("Snapshot '%s' is damaged"), filename);
+		lomo_snapshot_free(ret);
+		return NULL;
+	}
+
+	debug("Read %u streams from '%s'", ret->n_streams, filename);
+	return ret;
+}
+
+/*
+ * lomo_snapshot_free:
+ * @snapshot: A #LomoSnapshot
+ *
+ * Frees @snapshot and drops its references to the streams
+ */
+void
+lomo_snapshot_free(LomoSnapshot *snapshot)
+{
+	g_return_if_fail(snapshot != NULL);
+
+	gel_list_deep_free(snapshot->streams, g_object_unref);
+	g_free(snapshot->random);
+	g_free(snapshot->queue);
+	g_free(snapshot);
+}
@@ -0,0 +1,63 @@
+/*
+ * lomo/lomo-snapshot.h
+ *
+ * Copyright (C) 2004-2011 Eina
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License
+ * along with this program.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LOMO_SNAPSHOT_H__
+#define __LOMO_SNAPSHOT_H__
+
+#include <lomo/lomo-stream.h>
+
+G_BEGIN_DECLS
+
+#define LOMO_SNAPSHOT_VERSION 1
+
+typedef enum {
+	LOMO_SNAPSHOT_ERROR_INVALID = 1,
+	LOMO_SNAPSHOT_ERROR_VERSION
+} LomoSnapshotError;
+
+/*
+ * LomoSnapshot:
+ * @streams: (element-type Lomo.Stream): Streams, owned by the snapshot
+ * @n_streams: Number of streams
+ * @random: Random order as indexes into @streams, @n_streams elements
+ * @queue: Queue as indexes into @streams
+ * @n_queue: Number of elements in @queue
+ * @current: Current index or -1
+ */
+typedef struct {
+	GList *streams;
+	guint  n_streams;
+	guint *random;
+	guint *queue;
+	guint  n_queue;
+	gint   current;
+} LomoSnapshot;
+
+gboolean lomo_snapshot_write(const gchar *filename,
+	const GList *streams, const GList *random, const GList *queue, gint current,
+	const gchar *const *data_keys, GError **error);
+
+LomoSnapshot* lomo_snapshot_read(const gchar *filename, GError **error);
+void          lomo_snapshot_free(LomoSnapshot *snapshot);
+
+G_END_DECLS
+
+#endif /* __LOMO_SNAPSHOT_H__ */
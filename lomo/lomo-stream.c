@@ -290,9 +290,9 @@ lomo_stream_get_tag(LomoStream *self, const gchar *tag)
  * lomo_stream_set_tag:
  * @self: A #LomoStream
  * @tag: A #LomoTag
- * @value: (transfer none): A #GValue for the value
+ * @value: (transfer none) (allow-none): A #GValue for the value or %NULL
  *
- * Sets the value for @tag
+ * Sets the value for @tag, if @value is %NULL @tag is removed from @self
  */
 void
 lomo_stream_set_tag(LomoStream *self, const gchar *tag, const GValue *value)
@@ -304,10 +304,14 @@ lomo_stream_set_tag(LomoStream *self, const gchar *tag, const GValue *value)
 
 	LomoStreamPrivate *priv = self->priv;
 
-	GValue *v = g_value_init(g_new0(GValue, 1), G_VALUE_TYPE(value));
-	g_value_copy(value, v);
-
-	g_object_set_data_full((GObject *) self, tag, v, (GDestroyNotify) destroy_gvalue);
+	if (value)
+	{
+		GValue *v = g_value_init(g_new0(GValue, 1), G_VALUE_TYPE(value));
+		g_value_copy(value, v);
+		g_object_set_data_full((GObject *) self, tag, v, (GDestroyNotify) destroy_gvalue);
+	}
+	else
+		g_object_set_data((GObject *) self, tag, NULL);
 
 	GList *link = g_list_find_custom(priv->tags, tag, (GCompareFunc) strcmp);
 